@@ -0,0 +1,613 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR MIT
+ * Refer to the file 'LICENSE' in the nvxx distribution for license terms.
+ */
+
+/*
+ * nvxx_bench: microbenchmarks for libnvxx.
+ *
+ * Each benchmark is run with an increasing number of iterations until it takes
+ * at least the minimum time (-t, in seconds, default 0.2).  The results are
+ * written to stdout as JSON, giving the time, the number of allocations and
+ * the number of bytes allocated per operation.  -f runs only the benchmarks
+ * whose name contains the given string.
+ *
+ * Benchmark names are "<operation>/<n>", where n is the number of keys in the
+ * nvlist (or, for nv_serialize, nv_pack, nv_deserialize and nv_unpack_into,
+ * the size of the array in the object).
+ */
+
+#include <sys/types.h>
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <format>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <err.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "nvxx.h"
+
+/*
+ * Allocation counting.  FreeBSD's libc exports the allocator as __malloc()
+ * and so on, so that the standard names can be interposed.  Replacing them
+ * here counts every allocation, including those made inside libnv and by
+ * operator new.  The benchmarks are single-threaded, so the counters are not
+ * atomic.
+ */
+
+namespace {
+
+struct alloc_stats {
+	std::uint64_t count = 0;
+	std::uint64_t bytes = 0;
+};
+
+alloc_stats allocs;
+
+} // anonymous namespace
+
+extern "C" {
+
+void *__malloc(std::size_t);
+void *__calloc(std::size_t, std::size_t);
+void *__realloc(void *, std::size_t);
+
+void *
+malloc(std::size_t size)
+{
+	++allocs.count;
+	allocs.bytes += size;
+	return (__malloc(size));
+}
+
+void *
+calloc(std::size_t n, std::size_t size)
+{
+	++allocs.count;
+	allocs.bytes += n * size;
+	return (__calloc(n, size));
+}
+
+void *
+realloc(void *ptr, std::size_t size)
+{
+	++allocs.count;
+	allocs.bytes += size;
+	return (__realloc(ptr, size));
+}
+
+} // extern "C"
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+/*
+ * Prevent the compiler from optimising away a value which is never used.
+ */
+template<typename _T>
+void
+keep(_T const &value)
+{
+	asm volatile("" : : "g"(&value) : "memory");
+}
+
+/*
+ * Passed to each benchmark, which does any setup, then calls start(), runs
+ * the given number of iterations, and calls stop().
+ */
+struct timer {
+	explicit timer(std::uint64_t iterations_)
+		: iterations(iterations_)
+	{
+	}
+
+	void start() {
+		start_allocs = allocs;
+		started = clock_type::now();
+	}
+
+	void stop() {
+		elapsed = clock_type::now() - started;
+		nallocs = allocs.count - start_allocs.count;
+		nbytes = allocs.bytes - start_allocs.bytes;
+	}
+
+	std::uint64_t iterations;
+	clock_type::time_point started;
+	clock_type::duration elapsed{};
+	alloc_stats start_allocs;
+	std::uint64_t nallocs = 0;
+	std::uint64_t nbytes = 0;
+};
+
+struct benchmark {
+	std::string name;
+	std::function<void (timer &)> run;
+};
+
+/*
+ * Run a benchmark until it takes at least min_time, and print the result.
+ */
+void
+measure(benchmark const &bm, std::chrono::duration<double> min_time)
+{
+	auto iterations = std::uint64_t{1};
+
+	for (;;) {
+		auto t = timer(iterations);
+		bm.run(t);
+
+		auto elapsed = std::chrono::duration<double>(t.elapsed);
+		if (elapsed >= min_time || iterations >= (std::uint64_t{1} << 40)) {
+			auto n = static_cast<double>(iterations);
+			std::fputs(std::format(
+				"    {{\"name\": \"{}\", \"iterations\": {}, "
+				"\"ns_per_op\": {:.2f}, \"allocs_per_op\": {:.2f}, "
+				"\"bytes_per_op\": {:.2f}}}",
+				bm.name, iterations,
+				elapsed.count() * 1e9 / n,
+				static_cast<double>(t.nallocs) / n,
+				static_cast<double>(t.nbytes) / n).c_str(),
+				stdout);
+			return;
+		}
+
+		// aim for 1.5 times the minimum, but at most 10x the last run
+		auto scale = elapsed.count() > 0
+			? min_time.count() * 1.5 / elapsed.count()
+			: 10.0;
+		iterations = static_cast<std::uint64_t>(
+			static_cast<double>(iterations) * std::clamp(scale, 2.0, 10.0));
+	}
+}
+
+std::vector<std::string>
+make_keys(std::size_t n)
+{
+	auto keys = std::vector<std::string>();
+	for (auto i = std::size_t{0}; i < n; ++i)
+		keys.push_back(std::format("key{}", i));
+	return (keys);
+}
+
+/*
+ * The per-type operations.  For null values, which cannot be fetched or
+ * taken, get and take are exists and free.
+ */
+struct type_ops {
+	std::string_view name;
+	void (*add)(bsd::nv_list &, std::string_view);
+	void (*get)(bsd::const_nv_list const &, std::string_view);
+	bool (*exists)(bsd::const_nv_list const &, std::string_view);
+	void (*take)(bsd::nv_list &, std::string_view);
+};
+
+int devnull = -1;
+
+bsd::nv_list const &
+child_list()
+{
+	static auto const nvl = [] {
+		auto ret = bsd::nv_list();
+		ret.add_number("number", 42);
+		ret.add_string("string", "value");
+		return (ret);
+	}();
+	return (nvl);
+}
+
+constexpr auto numbers = std::array<std::uint64_t, 8>{1, 2, 3, 4, 5, 6, 7, 8};
+constexpr auto bools = std::array<bool, 8>{true, false, true, false,
+					   true, false, true, false};
+constexpr auto strings = std::array<std::string_view, 4>{
+	"one", "two", "three", "four"};
+auto const bytes = std::vector<std::byte>(64, std::byte{0x5a});
+
+type_ops const all_types[] = {
+	{
+		"null",
+		[] (auto &nvl, auto key) { nvl.add_null(key); },
+		[] (auto const &nvl, auto key) { keep(nvl.exists_null(key)); },
+		[] (auto const &nvl, auto key) { return nvl.exists_null(key); },
+		[] (auto &nvl, auto key) { nvl.free_null(key); },
+	},
+	{
+		"bool",
+		[] (auto &nvl, auto key) { nvl.add_bool(key, true); },
+		[] (auto const &nvl, auto key) { keep(nvl.get_bool(key)); },
+		[] (auto const &nvl, auto key) { return nvl.exists_bool(key); },
+		[] (auto &nvl, auto key) { keep(nvl.take_bool(key)); },
+	},
+	{
+		"number",
+		[] (auto &nvl, auto key) { nvl.add_number(key, 42); },
+		[] (auto const &nvl, auto key) { keep(nvl.get_number(key)); },
+		[] (auto const &nvl, auto key) { return nvl.exists_number(key); },
+		[] (auto &nvl, auto key) { keep(nvl.take_number(key)); },
+	},
+	{
+		"string",
+		[] (auto &nvl, auto key) { nvl.add_string(key, "a string value"); },
+		[] (auto const &nvl, auto key) { keep(nvl.get_string(key)); },
+		[] (auto const &nvl, auto key) { return nvl.exists_string(key); },
+		[] (auto &nvl, auto key) { keep(nvl.take_string(key)); },
+	},
+	{
+		"nvlist",
+		[] (auto &nvl, auto key) { nvl.add_nvlist(key, child_list()); },
+		[] (auto const &nvl, auto key) { keep(nvl.get_nvlist(key)); },
+		[] (auto const &nvl, auto key) { return nvl.exists_nvlist(key); },
+		[] (auto &nvl, auto key) { keep(nvl.take_nvlist(key)); },
+	},
+	{
+		"descriptor",
+		[] (auto &nvl, auto key) { nvl.add_descriptor(key, devnull); },
+		[] (auto const &nvl, auto key) { keep(nvl.get_descriptor(key)); },
+		[] (auto const &nvl, auto key) { return nvl.exists_descriptor(key); },
+		[] (auto &nvl, auto key) { keep(nvl.take_descriptor(key)); },
+	},
+	{
+		"binary",
+		[] (auto &nvl, auto key) { nvl.add_binary(key, bytes); },
+		[] (auto const &nvl, auto key) { keep(nvl.get_binary(key)); },
+		[] (auto const &nvl, auto key) { return nvl.exists_binary(key); },
+		[] (auto &nvl, auto key) { keep(nvl.take_binary(key)); },
+	},
+	{
+		"bool_array",
+		[] (auto &nvl, auto key) { nvl.add_bool_array(key, bools); },
+		[] (auto const &nvl, auto key) { keep(nvl.get_bool_array(key)); },
+		[] (auto const &nvl, auto key) { return nvl.exists_bool_array(key); },
+		[] (auto &nvl, auto key) { keep(nvl.take_bool_array(key)); },
+	},
+	{
+		"number_array",
+		[] (auto &nvl, auto key) { nvl.add_number_array(key, numbers); },
+		[] (auto const &nvl, auto key) { keep(nvl.get_number_array(key)); },
+		[] (auto const &nvl, auto key) { return nvl.exists_number_array(key); },
+		[] (auto &nvl, auto key) { keep(nvl.take_number_array(key)); },
+	},
+	{
+		"string_array",
+		[] (auto &nvl, auto key) { nvl.add_string_array(key, strings); },
+		[] (auto const &nvl, auto key) { keep(nvl.get_string_array(key)); },
+		[] (auto const &nvl, auto key) { return nvl.exists_string_array(key); },
+		[] (auto &nvl, auto key) { keep(nvl.take_string_array(key)); },
+	},
+	{
+		"nvlist_array",
+		[] (auto &nvl, auto key) {
+			auto const children = std::array<bsd::const_nv_list, 2>{
+				child_list(), child_list()};
+			nvl.add_nvlist_array(key, children);
+		},
+		[] (auto const &nvl, auto key) { keep(nvl.get_nvlist_array(key)); },
+		[] (auto const &nvl, auto key) { return nvl.exists_nvlist_array(key); },
+		[] (auto &nvl, auto key) { keep(nvl.take_nvlist_array(key)); },
+	},
+	{
+		"descriptor_array",
+		[] (auto &nvl, auto key) {
+			auto const fds = std::array<int, 2>{devnull, devnull};
+			nvl.add_descriptor_array(key, fds);
+		},
+		[] (auto const &nvl, auto key) { keep(nvl.get_descriptor_array(key)); },
+		[] (auto const &nvl, auto key) { return nvl.exists_descriptor_array(key); },
+		[] (auto &nvl, auto key) { keep(nvl.take_descriptor_array(key)); },
+	},
+};
+
+bsd::nv_list
+make_list(type_ops const &type, std::vector<std::string> const &keys)
+{
+	auto nvl = bsd::nv_list();
+	for (auto const &key : keys)
+		type.add(nvl, key);
+	return (nvl);
+}
+
+bsd::nv_list
+make_number_list(std::size_t n)
+{
+	auto nvl = bsd::nv_list();
+	for (auto const &key : make_keys(n))
+		nvl.add_number(key, 42);
+	return (nvl);
+}
+
+/*
+ * The object used for the nv_serialize benchmarks.
+ */
+struct object {
+	std::uint64_t number{};
+	std::string string;
+	std::vector<std::uint64_t> array;
+};
+
+} // anonymous namespace
+
+template<>
+struct bsd::nv_schema<object> {
+	auto get() {
+		return	bsd::nv_field("number", &object::number)
+			>> bsd::nv_field("string", &object::string)
+			>> bsd::nv_field("array", &object::array);
+	}
+};
+
+namespace {
+
+/*
+ * add_<type>/n: add a value; every n adds, start again with a new nvlist.
+ * get_<type>/n, exists_<type>/n: look up one of the n keys in turn.
+ * take_<type>/n: take one of the n keys and add it back, so this measures
+ * both.
+ */
+void
+add_type_benchmarks(std::vector<benchmark> &bms, type_ops const &type,
+		    std::size_t n)
+{
+	auto suffix = std::format("{}/{}", type.name, n);
+
+	bms.push_back({"add_" + suffix, [&type, n] (timer &t) {
+		auto keys = make_keys(n);
+		auto nvl = bsd::nv_list();
+
+		t.start();
+		for (auto i = std::uint64_t{0}; i < t.iterations; ++i) {
+			if (i % n == 0)
+				nvl = bsd::nv_list();
+			type.add(nvl, keys[i % n]);
+		}
+		t.stop();
+	}});
+
+	bms.push_back({"get_" + suffix, [&type, n] (timer &t) {
+		auto keys = make_keys(n);
+		auto nvl = make_list(type, keys);
+		auto cnvl = bsd::const_nv_list(nvl);
+
+		t.start();
+		for (auto i = std::uint64_t{0}; i < t.iterations; ++i)
+			type.get(cnvl, keys[i % n]);
+		t.stop();
+	}});
+
+	bms.push_back({"exists_" + suffix, [&type, n] (timer &t) {
+		auto keys = make_keys(n);
+		auto nvl = make_list(type, keys);
+		auto cnvl = bsd::const_nv_list(nvl);
+
+		t.start();
+		for (auto i = std::uint64_t{0}; i < t.iterations; ++i)
+			keep(type.exists(cnvl, keys[i % n]));
+		t.stop();
+	}});
+
+	bms.push_back({"take_" + suffix, [&type, n] (timer &t) {
+		auto keys = make_keys(n);
+		auto nvl = make_list(type, keys);
+
+		t.start();
+		for (auto i = std::uint64_t{0}; i < t.iterations; ++i) {
+			type.take(nvl, keys[i % n]);
+			type.add(nvl, keys[i % n]);
+		}
+		t.stop();
+	}});
+}
+
+void
+add_list_benchmarks(std::vector<benchmark> &bms, std::size_t n)
+{
+	bms.push_back({std::format("iterate/{}", n), [n] (timer &t) {
+		auto nvl = make_number_list(n);
+
+		t.start();
+		for (auto i = std::uint64_t{0}; i < t.iterations; ++i)
+			for (auto &&[name, value] : nvl)
+				keep(name);
+		t.stop();
+	}});
+
+	bms.push_back({std::format("pack/{}", n), [n] (timer &t) {
+		auto nvl = make_number_list(n);
+
+		t.start();
+		for (auto i = std::uint64_t{0}; i < t.iterations; ++i)
+			keep(nvl.pack());
+		t.stop();
+	}});
+
+	bms.push_back({std::format("unpack/{}", n), [n] (timer &t) {
+		auto packed = make_number_list(n).pack();
+
+		t.start();
+		for (auto i = std::uint64_t{0}; i < t.iterations; ++i)
+			keep(bsd::nv_list::unpack(packed));
+		t.stop();
+	}});
+
+	bms.push_back({std::format("clone/{}", n), [n] (timer &t) {
+		auto nvl = make_number_list(n);
+
+		t.start();
+		for (auto i = std::uint64_t{0}; i < t.iterations; ++i)
+			keep(bsd::nv_list(nvl));
+		t.stop();
+	}});
+
+	bms.push_back({std::format("send_recv/{}", n), [n] (timer &t) {
+		auto nvl = make_number_list(n);
+
+		int fds[2];
+		if (::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == -1)
+			err(1, "socketpair");
+
+		// make sure a whole nvlist fits in the socket buffer
+		auto bufsize = 1 << 20;
+		for (auto fd : fds) {
+			(void)::setsockopt(fd, SOL_SOCKET, SO_SNDBUF,
+					   &bufsize, sizeof(bufsize));
+			(void)::setsockopt(fd, SOL_SOCKET, SO_RCVBUF,
+					   &bufsize, sizeof(bufsize));
+		}
+
+		t.start();
+		for (auto i = std::uint64_t{0}; i < t.iterations; ++i) {
+			nvl.send(fds[0]);
+			keep(bsd::nv_list::recv(fds[1]));
+		}
+		t.stop();
+
+		(void)::close(fds[0]);
+		(void)::close(fds[1]);
+	}});
+
+	bms.push_back({std::format("nv_serialize/{}", n), [n] (timer &t) {
+		auto obj = object{42, "a string value",
+				  std::vector<std::uint64_t>(n, 42)};
+
+		t.start();
+		for (auto i = std::uint64_t{0}; i < t.iterations; ++i)
+			keep(bsd::nv_serialize(obj));
+		t.stop();
+	}});
+
+	bms.push_back({std::format("nv_serialize_pack/{}", n), [n] (timer &t) {
+		auto obj = object{42, "a string value",
+				  std::vector<std::uint64_t>(n, 42)};
+
+		t.start();
+		for (auto i = std::uint64_t{0}; i < t.iterations; ++i)
+			keep(bsd::nv_serialize(obj).pack());
+		t.stop();
+	}});
+
+	bms.push_back({std::format("nv_pack/{}", n), [n] (timer &t) {
+		auto obj = object{42, "a string value",
+				  std::vector<std::uint64_t>(n, 42)};
+		auto buf = std::vector<std::byte>(bsd::nv_packed_size(obj));
+
+		t.start();
+		for (auto i = std::uint64_t{0}; i < t.iterations; ++i)
+			keep(bsd::nv_pack(obj, buf));
+		t.stop();
+	}});
+
+	bms.push_back({std::format("nv_deserialize/{}", n), [n] (timer &t) {
+		auto nvl = bsd::nv_serialize(object{
+			42, "a string value", std::vector<std::uint64_t>(n, 42)});
+
+		t.start();
+		for (auto i = std::uint64_t{0}; i < t.iterations; ++i) {
+			auto obj = object{};
+			bsd::nv_deserialize(nvl, obj);
+			keep(obj);
+		}
+		t.stop();
+	}});
+
+	bms.push_back({std::format("nv_unpack_deserialize/{}", n),
+		       [n] (timer &t) {
+		auto data = bsd::nv_pack(object{
+			42, "a string value", std::vector<std::uint64_t>(n, 42)});
+
+		t.start();
+		for (auto i = std::uint64_t{0}; i < t.iterations; ++i) {
+			auto obj = object{};
+			bsd::nv_deserialize(bsd::nv_list::unpack(data), obj);
+			keep(obj);
+		}
+		t.stop();
+	}});
+
+	bms.push_back({std::format("nv_unpack_into/{}", n), [n] (timer &t) {
+		auto data = bsd::nv_pack(object{
+			42, "a string value", std::vector<std::uint64_t>(n, 42)});
+
+		t.start();
+		for (auto i = std::uint64_t{0}; i < t.iterations; ++i) {
+			auto obj = object{};
+			bsd::nv_unpack_into(obj, data);
+			keep(obj);
+		}
+		t.stop();
+	}});
+}
+
+void
+usage()
+{
+	std::fprintf(stderr, "usage: nvxx_bench [-t seconds] [-f filter]\n");
+	std::exit(1);
+}
+
+} // anonymous namespace
+
+int
+main(int argc, char **argv)
+{
+	auto min_time = std::chrono::duration<double>(0.2);
+	auto filter = std::string_view();
+	int ch;
+
+	while ((ch = ::getopt(argc, argv, "f:t:")) != -1) {
+		switch (ch) {
+		case 'f':
+			filter = optarg;
+			break;
+
+		case 't':
+			min_time = std::chrono::duration<double>(
+					std::strtod(optarg, nullptr));
+			break;
+
+		default:
+			usage();
+		}
+	}
+
+	if (argc != optind)
+		usage();
+
+	if ((devnull = ::open("/dev/null", O_RDWR | O_CLOEXEC)) == -1)
+		err(1, "/dev/null");
+
+	auto bms = std::vector<benchmark>();
+	for (auto n : {1u, 16u, 256u}) {
+		for (auto const &type : all_types)
+			add_type_benchmarks(bms, type, n);
+		add_list_benchmarks(bms, n);
+	}
+
+	std::printf("{\n  \"benchmarks\": [\n");
+
+	auto first = true;
+	for (auto const &bm : bms) {
+		if (!filter.empty() && bm.name.find(filter) == bm.name.npos)
+			continue;
+
+		if (!first)
+			std::printf(",\n");
+		first = false;
+
+		std::fflush(stdout);
+		measure(bm, min_time);
+	}
+
+	std::printf("\n  ]\n}\n");
+	return (0);
+}
@@ -0,0 +1,513 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR MIT
+ * Refer to the file 'LICENSE' in the nvxx distribution for license terms.
+ */
+
+/*
+ * nvxx-bench-ipc: an IPC throughput and latency benchmark for libnvxx.
+ *
+ * Each of one or more pairs (-p) of producer and consumer exchanges a fixed
+ * number of messages (-n) over its own connection, which is either a
+ * socketpair or an AF_UNIX socket bound to a path (-T socketpair|unix).
+ * The producer and consumer run as threads of this process or in separate
+ * processes (-m thread|process).
+ *
+ * In send mode (-o send) the producer sends messages with send() and the
+ * consumer receives them with recv(); the latency of each message is the time
+ * from just before it was sent until it had been received.  In xfer mode
+ * (-o xfer) the producer is a client which sends each message with xfer(),
+ * and the consumer is a server which replies to each message with a small
+ * nvlist; the latency is the round-trip time of xfer().
+ *
+ * The message has -k keys (alternately numbers and strings), a binary value
+ * of -b bytes, -D descriptors, and an nvlist nested -d levels deep, each
+ * level of which also has -k keys.
+ *
+ * The result is written to stdout as JSON.
+ */
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <format>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <err.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "nvxx.h"
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+enum struct run_mode { thread, process };
+enum struct transport { socketpair, local };
+enum struct operation { send, xfer };
+
+struct options {
+	run_mode mode = run_mode::thread;
+	transport trans = transport::socketpair;
+	operation op = operation::send;
+	unsigned pairs = 1;
+	std::uint64_t messages = 100000;
+	unsigned keys = 8;
+	unsigned depth = 0;
+	std::size_t binary = 0;
+	unsigned descriptors = 0;
+};
+
+int devnull = -1;
+
+std::uint64_t
+now_ns()
+{
+	return (static_cast<std::uint64_t>(
+		std::chrono::duration_cast<std::chrono::nanoseconds>(
+			clock_type::now().time_since_epoch()).count()));
+}
+
+/*
+ * Build one level of the message.  The binary value and the descriptors are
+ * only added at the top level.
+ */
+bsd::nv_list
+make_message(options const &opts, unsigned depth, bool top)
+{
+	auto nvl = bsd::nv_list();
+
+	for (auto i = 0u; i < opts.keys; ++i) {
+		auto key = std::format("key{}", i);
+		if (i % 2 == 0)
+			nvl.add_number(key, i);
+		else
+			nvl.add_string(key, "a string value");
+	}
+
+	if (top && opts.binary > 0)
+		nvl.add_binary("data", std::vector<std::byte>(
+				       opts.binary, std::byte{0x5a}));
+
+	if (top && opts.descriptors > 0)
+		nvl.add_descriptor_array("fds", std::vector<int>(
+						 opts.descriptors, devnull));
+
+	if (depth > 0)
+		nvl.add_nvlist("child", make_message(opts, depth - 1, false));
+
+	return (nvl);
+}
+
+/*
+ * The two ends of one connection.  Whichever end measures latency is run in
+ * this process; in process mode, the other end is run in a child.
+ */
+struct connection {
+	int producer = -1;
+	int consumer = -1;
+};
+
+std::vector<connection>
+connect_pairs(options const &opts, std::filesystem::path const &sockpath)
+{
+	auto conns = std::vector<connection>();
+
+	int lsock = -1;
+	auto sun = sockaddr_un{};
+
+	if (opts.trans == transport::local) {
+		sun.sun_family = AF_UNIX;
+		if (sockpath.native().size() >= sizeof(sun.sun_path))
+			errx(1, "socket path too long");
+		std::ranges::copy(sockpath.native(), sun.sun_path);
+
+		if ((lsock = ::socket(AF_UNIX, SOCK_STREAM, 0)) == -1)
+			err(1, "socket");
+		if (::bind(lsock, reinterpret_cast<sockaddr *>(&sun),
+			   sizeof(sun)) == -1)
+			err(1, "bind: %s", sockpath.c_str());
+		if (::listen(lsock, static_cast<int>(opts.pairs)) == -1)
+			err(1, "listen");
+	}
+
+	for (auto i = 0u; i < opts.pairs; ++i) {
+		auto conn = connection{};
+
+		if (opts.trans == transport::socketpair) {
+			int fds[2];
+			if (::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == -1)
+				err(1, "socketpair");
+			conn.producer = fds[0];
+			conn.consumer = fds[1];
+		} else {
+			conn.producer = ::socket(AF_UNIX, SOCK_STREAM, 0);
+			if (conn.producer == -1)
+				err(1, "socket");
+			if (::connect(conn.producer,
+				      reinterpret_cast<sockaddr *>(&sun),
+				      sizeof(sun)) == -1)
+				err(1, "connect: %s", sockpath.c_str());
+			if ((conn.consumer = ::accept(lsock, nullptr,
+						      nullptr)) == -1)
+				err(1, "accept");
+		}
+
+		conns.push_back(conn);
+	}
+
+	if (lsock != -1)
+		(void)::close(lsock);
+
+	return (conns);
+}
+
+/*
+ * send mode: the producer stamps each message with the time it was sent.
+ */
+void
+produce(options const &opts, int fd)
+{
+	auto msg = make_message(opts, opts.depth, true);
+	msg.add_number("ts", 0);
+
+	for (auto i = std::uint64_t{0}; i < opts.messages; ++i) {
+		msg.free_number("ts");
+		msg.add_number("ts", now_ns());
+		msg.send(fd);
+	}
+}
+
+void
+consume(options const &opts, int fd, std::vector<std::uint64_t> &latencies)
+{
+	latencies.reserve(opts.messages);
+
+	for (auto i = std::uint64_t{0}; i < opts.messages; ++i) {
+		auto msg = bsd::nv_list::recv(fd);
+		latencies.push_back(now_ns() - msg.get_number("ts"));
+	}
+}
+
+/*
+ * xfer mode: the client times each round trip, and the server replies to
+ * each request.
+ */
+void
+client(options const &opts, int fd, std::vector<std::uint64_t> &latencies)
+{
+	auto const msg = make_message(opts, opts.depth, true);
+	latencies.reserve(opts.messages);
+
+	for (auto i = std::uint64_t{0}; i < opts.messages; ++i) {
+		// xfer() consumes the request, so send a copy.
+		auto req = bsd::nv_list(msg);
+
+		auto const start = now_ns();
+		auto reply = std::move(req).xfer(fd);
+		latencies.push_back(now_ns() - start);
+
+		if (!reply.exists_bool("ok"))
+			errx(1, "invalid reply from server");
+	}
+}
+
+void
+server(options const &opts, int fd)
+{
+	auto reply = bsd::nv_list();
+	reply.add_bool("ok", true);
+
+	for (auto i = std::uint64_t{0}; i < opts.messages; ++i) {
+		[[maybe_unused]] auto req = bsd::nv_list::recv(fd);
+		reply.send(fd);
+	}
+}
+
+/*
+ * Run a function, exiting with an error message if it throws.
+ */
+template<typename _F>
+void
+run_or_die(_F &&fn)
+{
+	try {
+		std::forward<_F>(fn)();
+	} catch (std::exception const &e) {
+		errx(1, "%s", e.what());
+	}
+}
+
+// The end of the connection which does not measure latency.
+void
+run_passive(options const &opts, connection const &conn)
+{
+	run_or_die([&] {
+		if (opts.op == operation::send)
+			produce(opts, conn.producer);
+		else
+			server(opts, conn.consumer);
+	});
+}
+
+// The end of the connection which measures latency.
+void
+run_active(options const &opts, connection const &conn,
+	   std::vector<std::uint64_t> &latencies)
+{
+	run_or_die([&] {
+		if (opts.op == operation::send)
+			consume(opts, conn.consumer, latencies);
+		else
+			client(opts, conn.producer, latencies);
+	});
+}
+
+std::uint64_t
+percentile(std::vector<std::uint64_t> const &sorted, double fraction)
+{
+	if (sorted.empty())
+		return (0);
+
+	auto const rank = static_cast<std::size_t>(
+		fraction * static_cast<double>(sorted.size() - 1));
+	return (sorted[rank]);
+}
+
+std::string_view
+mode_name(run_mode mode)
+{
+	return (mode == run_mode::thread ? "thread" : "process");
+}
+
+std::string_view
+transport_name(transport trans)
+{
+	return (trans == transport::socketpair ? "socketpair" : "unix");
+}
+
+std::string_view
+operation_name(operation op)
+{
+	return (op == operation::send ? "send" : "xfer");
+}
+
+unsigned long
+parse_number(char const *arg, char const *what)
+{
+	char *end;
+	errno = 0;
+	auto const value = std::strtoul(arg, &end, 10);
+	if (errno != 0 || end == arg || *end != '\0')
+		errx(1, "invalid %s: %s", what, arg);
+	return (value);
+}
+
+void
+usage()
+{
+	std::fprintf(stderr,
+		"usage: nvxx-bench-ipc [-m thread|process] "
+		"[-T socketpair|unix] [-o send|xfer]\n"
+		"                      [-p pairs] [-n messages] [-k keys] "
+		"[-d depth] [-b bytes]\n"
+		"                      [-D descriptors]\n");
+	std::exit(1);
+}
+
+} // anonymous namespace
+
+int
+main(int argc, char **argv)
+{
+	auto opts = options{};
+	int ch;
+
+	while ((ch = ::getopt(argc, argv, "b:D:d:k:m:n:o:p:T:")) != -1) {
+		switch (ch) {
+		case 'b':
+			opts.binary = parse_number(optarg, "binary size");
+			break;
+
+		case 'D':
+			opts.descriptors = static_cast<unsigned>(
+				parse_number(optarg, "descriptor count"));
+			break;
+
+		case 'd':
+			opts.depth = static_cast<unsigned>(
+				parse_number(optarg, "depth"));
+			break;
+
+		case 'k':
+			opts.keys = static_cast<unsigned>(
+				parse_number(optarg, "key count"));
+			break;
+
+		case 'm': {
+			auto const arg = std::string_view(optarg);
+
+			if (arg == "thread")
+				opts.mode = run_mode::thread;
+			else if (arg == "process")
+				opts.mode = run_mode::process;
+			else
+				usage();
+			break;
+		}
+
+		case 'n':
+			opts.messages = parse_number(optarg, "message count");
+			break;
+
+		case 'o': {
+			auto const arg = std::string_view(optarg);
+
+			if (arg == "send")
+				opts.op = operation::send;
+			else if (arg == "xfer")
+				opts.op = operation::xfer;
+			else
+				usage();
+			break;
+		}
+
+		case 'p':
+			opts.pairs = static_cast<unsigned>(
+				parse_number(optarg, "pair count"));
+			if (opts.pairs == 0)
+				usage();
+			break;
+
+		case 'T': {
+			auto const arg = std::string_view(optarg);
+
+			if (arg == "socketpair")
+				opts.trans = transport::socketpair;
+			else if (arg == "unix")
+				opts.trans = transport::local;
+			else
+				usage();
+			break;
+		}
+
+		default:
+			usage();
+		}
+	}
+
+	if (argc != optind)
+		usage();
+
+	if ((devnull = ::open("/dev/null", O_RDWR | O_CLOEXEC)) == -1)
+		err(1, "/dev/null");
+
+	auto sockdir = std::filesystem::path();
+	if (opts.trans == transport::local) {
+		char tmpl[] = "/tmp/nvxx-bench-ipc.XXXXXX";
+		if (::mkdtemp(tmpl) == nullptr)
+			err(1, "mkdtemp");
+		sockdir = tmpl;
+	}
+
+	auto const conns = connect_pairs(opts, sockdir / "sock");
+	if (!sockdir.empty())
+		std::filesystem::remove_all(sockdir);
+
+	auto const msgsize = make_message(opts, opts.depth, true).packed_size();
+
+	auto latencies = std::vector<std::vector<std::uint64_t>>(opts.pairs);
+	auto threads = std::vector<std::thread>();
+	auto children = std::vector<pid_t>();
+
+	auto const start = clock_type::now();
+
+	// fork before starting any threads.
+	for (auto const &conn : conns) {
+		if (opts.mode == run_mode::thread) {
+			threads.emplace_back([&opts, &conn] {
+				run_passive(opts, conn);
+			});
+			continue;
+		}
+
+		auto const pid = ::fork();
+		if (pid == -1)
+			err(1, "fork");
+
+		if (pid == 0) {
+			run_passive(opts, conn);
+			::_exit(0);
+		}
+
+		children.push_back(pid);
+	}
+
+	for (auto i = 0u; i < opts.pairs; ++i)
+		threads.emplace_back([&opts, &conn = conns[i],
+				      &lat = latencies[i]] {
+			run_active(opts, conn, lat);
+		});
+
+	for (auto &thr : threads)
+		thr.join();
+
+	auto const elapsed = std::chrono::duration<double>(
+		clock_type::now() - start).count();
+
+	for (auto pid : children) {
+		int status;
+		if (::waitpid(pid, &status, 0) == -1)
+			err(1, "waitpid");
+		if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+			errx(1, "child process %d failed", static_cast<int>(pid));
+	}
+
+	auto all = std::vector<std::uint64_t>();
+	for (auto const &lat : latencies)
+		all.insert(all.end(), lat.begin(), lat.end());
+	std::ranges::sort(all);
+
+	auto const total = static_cast<double>(opts.messages)
+		* static_cast<double>(opts.pairs);
+
+	std::fputs(std::format(
+		"{{\n"
+		"  \"mode\": \"{}\", \"transport\": \"{}\", "
+		"\"operation\": \"{}\",\n"
+		"  \"pairs\": {}, \"messages\": {}, \"keys\": {}, "
+		"\"depth\": {}, \"binary\": {}, \"descriptors\": {},\n"
+		"  \"message_bytes\": {}, \"seconds\": {:.3f},\n"
+		"  \"messages_per_sec\": {:.0f}, \"mb_per_sec\": {:.2f},\n"
+		"  \"latency_ns\": {{\"min\": {}, \"p50\": {}, \"p99\": {}, "
+		"\"p999\": {}, \"max\": {}}}\n"
+		"}}\n",
+		mode_name(opts.mode), transport_name(opts.trans),
+		operation_name(opts.op),
+		opts.pairs, opts.messages, opts.keys,
+		opts.depth, opts.binary, opts.descriptors,
+		msgsize, elapsed,
+		total / elapsed,
+		total * static_cast<double>(msgsize) / elapsed / 1e6,
+		all.empty() ? 0 : all.front(),
+		percentile(all, 0.5), percentile(all, 0.99),
+		percentile(all, 0.999),
+		all.empty() ? 0 : all.back()).c_str(),
+		stdout);
+
+	return (0);
+}
@@ -5,6 +5,7 @@
 
 #include <cerrno>
 #include <cassert>
+#include <type_traits>
 
 #include "nvxx.h"
 
@@ -14,35 +15,17 @@ namespace bsd {
  * const_nv_list
  */
 
-const_nv_list::const_nv_list() noexcept
-	: __nv_list_base(nullptr, __detail::__nvlist_owning::__non_owning)
-{
-}
+// get_nvlist_array() and the iterators copy these around by value.
+static_assert(std::is_trivially_copyable_v<const_nv_list>);
+static_assert(sizeof(const_nv_list) == sizeof(::nvlist_t *));
+static_assert(sizeof(nv_list) == sizeof(::nvlist_t *));
 
 // const_cast is safe here since a non-owning nvlist is never modified.
 const_nv_list::const_nv_list(::nvlist_t const *nvl) noexcept
-	: __nv_list_base(const_cast<::nvlist_t *>(nvl),
-			 __detail::__nvlist_owning::__non_owning)
-{
-}
-
-const_nv_list::const_nv_list(const_nv_list const &other) noexcept
-	: __nv_list_base(other.__m_nv,
-			 __detail::__nvlist_owning::__non_owning)
+	: __const_nv_list(const_cast<::nvlist_t *>(nvl))
 {
 }
 
-const_nv_list &
-const_nv_list::operator=(const_nv_list const &other) noexcept
-{
-	if (this != &other) {
-		/* This is not a leak since we never own the nvlist_t. */
-		__m_nv = other.__m_nv;
-	}
-
-	return (*this);
-}
-
 const_nv_list &
 const_nv_list::operator=(nv_list const &other) noexcept
 {
@@ -51,74 +34,22 @@ const_nv_list::operator=(nv_list const &other) noexcept
 	return (*this);
 }
 
-::nvlist_t const *
-const_nv_list::ptr() const
-{
-	__throw_if_null();
-	return (__m_nv);
-}
-
 namespace __detail {
 
-std::error_code
-__const_nv_list::error() const
-{
-	__throw_if_null();
-
-	if (auto const err = ::nvlist_error(__m_nv); err != 0)
-		return (std::make_error_code(std::errc(err)));
-	return {};
-}
-
-bool
-__const_nv_list::exists_type(std::string_view key, int type) const
-{
-	__throw_if_error();
-	__check_string_null(key, "nv_list keys may not contain NUL");
-
-	return (::nvlist_exists_type(__m_nv, std::string(key).c_str(), type));
-}
-
-bool
-__const_nv_list::exists(std::string_view key) const
-{
-	return exists_type(key, NV_TYPE_NONE);
-}
-
-
-bool
-__const_nv_list::empty() const
-{
-	__throw_if_error();
-	return (::nvlist_empty(__m_nv));
-}
-
-int
-__const_nv_list::flags() const
-{
-	__throw_if_error();
-	return (::nvlist_flags(__m_nv));
-}
-
-bool
-__const_nv_list::in_array() const noexcept
-{
-	return (::nvlist_in_array(__m_nv));
-}
-
-__const_nv_list::operator bool() const noexcept
-{
-	return ((__m_nv != nullptr) && (::nvlist_error(__m_nv) == 0));
-}
-
 void
 __const_nv_list::send(int fd) const
 {
+	__NVXX_STATS_CALL(send);
 	__throw_if_error();
 
-	if (auto ret = ::nvlist_send(fd, __m_nv); ret != 0)
+	auto trace = __trace_scope(nv_trace_op::send, fd, __m_nv);
+	auto const ret = ::nvlist_send(fd, __m_nv);
+	auto const err = ret != 0 ? errno : 0;
+	trace.end(err);
+
+	if (ret != 0)
 		throw std::system_error(
-			std::make_error_code(static_cast<std::errc>(errno)));
+			std::make_error_code(static_cast<std::errc>(err)));
 
 	return;
 }
@@ -144,163 +75,43 @@ __const_nv_list::packed_size() const noexcept
 std::vector<std::byte>
 __const_nv_list::pack() const
 {
+	__NVXX_STATS_CALL(pack);
 	__throw_if_error();
 
 	auto size = std::size_t{};
 
-	if (auto *data = nvlist_pack(__m_nv, &size); data != nullptr) {
+	auto trace = __trace_scope(nv_trace_op::pack, -1, __m_nv);
+	auto *data = nvlist_pack(__m_nv, &size);
+	trace.end(data != nullptr ? 0 : ::nvlist_error(__m_nv));
+
+	if (data != nullptr) {
 		auto bytes = __ptr_guard(static_cast<std::byte *>(data));
+		__NVXX_STATS_ALLOC(pack, size);
 		return {bytes.__ptr, bytes.__ptr + size};
 	}
 
 	throw std::system_error(error());
 }
 
-/*
- * null operations
- */
-
-bool
-__const_nv_list::exists_null(std::string_view key) const
-{
-	return (exists_type(key, NV_TYPE_NULL));
-}
-
-/*
- * bool operations
- */
-
-bool
-__const_nv_list::exists_bool(std::string_view key) const
-{
-	return (exists_type(key, NV_TYPE_BOOL));
-}
-
-bool
-__const_nv_list::get_bool(std::string_view key) const
-{
-	__throw_if_error();
-	__check_string_null(key, "nv_list keys may not contain NUL");
-
-	auto skey = std::string(key);
-
-	if (!::nvlist_exists_bool(__m_nv, skey.c_str()))
-		throw nv_key_not_found(skey);
-
-	return (::nvlist_get_bool(__m_nv, skey.c_str()));
-}
-
-bool
-__const_nv_list::exists_bool_array(std::string_view key) const
-{
-	return (exists_type(key, NV_TYPE_BOOL_ARRAY));
-}
-
-std::span<bool const>
-__const_nv_list::get_bool_array(std::string_view key) const
-{
-	__throw_if_error();
-	__check_string_null(key, "nv_list keys may not contain NUL");
-
-	auto skey = std::string(key);
-
-	if (!::nvlist_exists_bool_array(__m_nv, skey.c_str()))
-		throw nv_key_not_found(skey);
-
-	auto nitems = std::size_t{};
-	auto *data = ::nvlist_get_bool_array(__m_nv, skey.c_str(), &nitems);
-	return {data, nitems};
-}
-
-/*
- * number operations
- */
-
-bool
-__const_nv_list::exists_number(std::string_view key) const
-{
-	return (exists_type(key, NV_TYPE_NUMBER));
-}
-
-std::uint64_t
-__const_nv_list::get_number(std::string_view key) const
-{
-	__throw_if_error();
-	__check_string_null(key, "nv_list keys may not contain NUL");
-
-	auto skey = std::string(key);
-
-	if (!::nvlist_exists_number(__m_nv, skey.c_str()))
-		throw nv_key_not_found(skey);
-
-	return (::nvlist_get_number(__m_nv, skey.c_str()));
-}
-
-bool
-__const_nv_list::exists_number_array(std::string_view key) const
-{
-	return (exists_type(key, NV_TYPE_NUMBER_ARRAY));
-}
-
-std::span<std::uint64_t const>
-__const_nv_list::get_number_array(std::string_view key) const
-{
-	__throw_if_error();
-	__check_string_null(key, "nv_list keys may not contain NUL");
-
-	auto skey = std::string(key);
-
-	if (!::nvlist_exists_number_array(__m_nv, skey.c_str()))
-		throw nv_key_not_found(skey);
-
-	auto nitems = std::size_t{};
-	auto *data = ::nvlist_get_number_array(__m_nv, skey.c_str(), &nitems);
-	return {data, nitems};
-}
-
 /*
  * string operations
  */
 
-bool
-__const_nv_list::exists_string(std::string_view key) const
-{
-	return (exists_type(key, NV_TYPE_STRING));
-}
-
-std::string_view
-__const_nv_list::get_string(std::string_view key) const
-{
-	__throw_if_error();
-	__check_string_null(key, "nv_list keys may not contain NUL");
-
-	auto skey = std::string(key);
-
-	if (!::nvlist_exists_string(__m_nv, skey.c_str()))
-		throw nv_key_not_found(skey);
-
-	return (::nvlist_get_string(__m_nv, skey.c_str()));
-}
-
-bool
-__const_nv_list::exists_string_array(std::string_view key) const
-{
-	return (exists_type(key, NV_TYPE_STRING_ARRAY));
-}
-
 std::vector<std::string_view>
 __const_nv_list::get_string_array(std::string_view key) const
 {
+	__NVXX_STATS_CALL(get);
 	__throw_if_error();
 	__check_string_null(key, "nv_list keys may not contain NUL");
 
-	auto skey = std::string(key);
+	auto const skey = __nv_key(key);
 
 	if (!::nvlist_exists_string_array(__m_nv, skey.c_str()))
-		throw nv_key_not_found(skey);
+		__throw_key_not_found(key);
 
 	auto nitems = std::size_t{};
 	auto *data = nvlist_get_string_array(__m_nv, skey.c_str(), &nitems);
+	__NVXX_STATS_ALLOC(get, nitems * sizeof(std::string_view));
 	return (std::span(data, data + nitems)
 		| construct<std::string_view>()
 		| std::ranges::to<std::vector>());
@@ -310,122 +121,24 @@ __const_nv_list::get_string_array(std::string_view key) const
  * nv_list operations
  */
 
-bool
-__const_nv_list::exists_nvlist(std::string_view key) const
-{
-	return (exists_type(key, NV_TYPE_NVLIST));
-}
-
-const_nv_list
-__const_nv_list::get_nvlist(std::string_view key) const
-{
-	__throw_if_error();
-	__check_string_null(key, "nv_list keys may not contain NUL");
-
-	auto skey = std::string(key);
-
-	if (!::nvlist_exists_nvlist(__m_nv, skey.c_str()))
-		throw nv_key_not_found(skey);
-
-	auto nvl = ::nvlist_get_nvlist(__m_nv, skey.c_str());
-	return (const_nv_list(nvl));
-}
-
-bool
-__const_nv_list::exists_nvlist_array(std::string_view key) const
-{
-	return (exists_type(key, NV_TYPE_NVLIST_ARRAY));
-}
-
 std::vector<const_nv_list>
 __const_nv_list::get_nvlist_array(std::string_view key) const
 {
+	__NVXX_STATS_CALL(get);
 	__throw_if_error();
 	__check_string_null(key, "nv_list keys may not contain NUL");
 
-	auto skey = std::string(key);
+	auto const skey = __nv_key(key);
 
 	if (!::nvlist_exists_nvlist_array(__m_nv, skey.c_str()))
-		throw nv_key_not_found(skey);
+		__throw_key_not_found(key);
 
 	auto nitems = std::size_t{};
 	auto *data = nvlist_get_nvlist_array(__m_nv, skey.c_str(), &nitems);
+	__NVXX_STATS_ALLOC(get, nitems * sizeof(const_nv_list));
 	return {std::from_range,
 		std::span(data, nitems) | construct<const_nv_list>()};
 }
 
-/*
- * descriptor operations
- */
-
-int
-__const_nv_list::get_descriptor(std::string_view key) const
-{
-	__throw_if_error();
-	__check_string_null(key, "nv_list keys may not contain NUL");
-
-	auto skey = std::string(key);
-
-	if (!::nvlist_exists_descriptor(__m_nv, skey.c_str()))
-		throw nv_key_not_found(skey);
-
-	return (::nvlist_get_descriptor(__m_nv, skey.c_str()));
-}
-
-std::span<int const>
-__const_nv_list::get_descriptor_array(std::string_view key) const
-{
-	__throw_if_error();
-	__check_string_null(key, "nv_list keys may not contain NUL");
-
-	auto skey = std::string(key);
-
-	if (!::nvlist_exists_descriptor_array(__m_nv, skey.c_str()))
-		throw nv_key_not_found(skey);
-
-	auto nitems = std::size_t{};
-	auto *data = ::nvlist_get_descriptor_array(
-			__m_nv, std::string(key).c_str(), &nitems);
-	return {data, nitems};
-}
-
-bool
-__const_nv_list::exists_descriptor(std::string_view key) const
-{
-	return (exists_type(key, NV_TYPE_DESCRIPTOR));
-}
-
-bool
-__const_nv_list::exists_descriptor_array(std::string_view key) const
-{
-	return (exists_type(key, NV_TYPE_DESCRIPTOR_ARRAY));
-}
-
-/*
- * binary operations
- */
-
-bool
-__const_nv_list::exists_binary(std::string_view key) const
-{
-	return (exists_type(key, NV_TYPE_BINARY));
-}
-
-std::span<std::byte const>
-__const_nv_list::get_binary(std::string_view key) const
-{
-	__throw_if_error();
-	__check_string_null(key, "nv_list keys may not contain NUL");
-
-	auto skey = std::string(key);
-
-	if (!::nvlist_exists_binary(__m_nv, skey.c_str()))
-		throw nv_key_not_found(skey);
-
-	auto size = std::size_t{};
-	auto *data = nvlist_get_binary(__m_nv, skey.c_str(), &size);
-	return {static_cast<std::byte const *>(data), size};
-}
-
 } // namespace bsd::__detail
 } // namespace bsd
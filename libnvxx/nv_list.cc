@@ -5,6 +5,9 @@
 
 #include <cerrno>
 #include <cassert>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
 
 #include "nvxx.h"
 
@@ -15,8 +18,7 @@ namespace bsd {
  */
 
 nv_list::nv_list(int flags)
-	: __nv_list_base(::nvlist_create(flags),
-			 __detail::__nvlist_owning::__owning)
+	: __nv_list(::nvlist_create(flags))
 {
 	if (__m_nv == nullptr)
 		throw std::system_error(
@@ -24,7 +26,7 @@ nv_list::nv_list(int flags)
 }
 
 nv_list::nv_list(::nvlist_t *nvl)
-	: __nv_list_base(nvl, __detail::__nvlist_owning::__owning)
+	: __nv_list(nvl)
 {
 	if (nvl == nullptr)
 		throw std::logic_error("attempt to create an nv_list from "
@@ -32,8 +34,9 @@ nv_list::nv_list(::nvlist_t *nvl)
 }
 
 nv_list::nv_list(const_nv_list const &other)
-	: __nv_list_base(nullptr, __detail::__nvlist_owning::__owning)
 {
+	__NVXX_STATS_CALL(clone);
+
 	if (auto err = other.error(); err)
 		throw nv_error_state(err);
 
@@ -48,9 +51,14 @@ nv_list::nv_list(nv_list const &other)
 }
 
 nv_list::nv_list(nv_list &&other) noexcept
-	: __nv_list_base(std::exchange(other.__m_nv, nullptr),
-			 __detail::__nvlist_owning::__owning)
+	: __nv_list(std::exchange(other.__m_nv, nullptr))
+{
+}
+
+nv_list::~nv_list()
 {
+	if (__m_nv != nullptr)
+		::nvlist_destroy(__m_nv);
 }
 
 nv_list &
@@ -65,12 +73,14 @@ nv_list::operator=(nv_list const &other)
 nv_list &
 nv_list::operator=(const_nv_list const &other)
 {
+	__NVXX_STATS_CALL(clone);
+
 	auto *clone = nvlist_clone(other.ptr());
 	if (clone == nullptr)
 		throw std::system_error(std::error_code(errno, std::system_category()));
-	__free_nv();
+	if (__m_nv != nullptr)
+		::nvlist_destroy(__m_nv);
 	__m_nv = clone;
-	__m_owning = __detail::__nvlist_owning::__owning;
 
 	return (*this);
 }
@@ -79,27 +89,14 @@ nv_list &
 nv_list::operator=(nv_list &&other) noexcept
 {
 	if (this != &other) {
+		if (__m_nv != nullptr)
+			::nvlist_destroy(__m_nv);
 		__m_nv = std::exchange(other.__m_nv, nullptr);
-		__m_owning = __detail::__nvlist_owning::__owning;
 	}
 
 	return (*this);
 }
 
-::nvlist_t *
-nv_list::ptr()
-{
-	__throw_if_null();
-	return (__m_nv);
-}
-
-::nvlist_t const *
-nv_list::ptr() const
-{
-	__throw_if_null();
-	return (__m_nv);
-}
-
 ::nvlist_t *
 nv_list::release() &&
 {
@@ -109,33 +106,82 @@ nv_list::release() &&
 nv_list
 nv_list::unpack(std::span<std::byte const> data, int flags)
 {
-	if (auto nv = ::nvlist_unpack(std::ranges::data(data),
-				      std::ranges::size(data),
-				      flags);
-	    nv != nullptr) {
+	__NVXX_STATS_CALL(unpack);
+
+	auto trace = __detail::__trace_scope(nv_trace_op::unpack,
+					     std::ranges::size(data));
+	auto *nv = ::nvlist_unpack(std::ranges::data(data),
+				   std::ranges::size(data),
+				   flags);
+	auto const err = nv != nullptr ? 0 : errno;
+	trace.end(err);
+
+	if (nv != nullptr)
 		return (nv_list(nv));
-	}
 
 	throw std::system_error(
-		std::error_code(errno, std::system_category()));
+		std::error_code(err, std::system_category()));
 }
 
 nv_list
 nv_list::recv(int fd, int flags)
 {
-	if (auto *nv = ::nvlist_recv(fd, flags); nv != nullptr)
+	__NVXX_STATS_CALL(recv);
+
+	auto trace = __detail::__trace_scope(nv_trace_op::recv, fd, nullptr);
+	auto *nv = ::nvlist_recv(fd, flags);
+	auto const err = nv != nullptr ? 0 : errno;
+	trace.end(err, nv);
+
+	if (nv != nullptr)
 		return (nv_list(nv));
 
 	throw std::system_error(
-		std::error_code(errno, std::system_category()));
+		std::error_code(err, std::system_category()));
 }
 
 namespace __detail {
 
+namespace {
+
+/*
+ * Report the error left in the nvlist by an add or move operation.  This is
+ * kept out of line, and out of the hot text, so that the add functions
+ * contain only the call and a test of the error state.
+ */
+[[noreturn, gnu::cold, gnu::noinline]] void
+throw_add_error(std::string_view key, int err)
+{
+	if (err == EEXIST)
+		throw nv_key_exists(std::string(key));
+
+	throw std::system_error(std::error_code(err, std::generic_category()));
+}
+
+} // anonymous namespace
+
 /*
  * __nv_list
  */
 
+/*
+ * Add a single value by calling __fn(nvlist, key), then report any error it
+ * left in the nvlist.  All of the add and move functions go through here.
+ */
+template<typename _F>
+void
+__nv_list::__add(std::string_view key, _F &&fn)
+{
+	__NVXX_STATS_CALL(add);
+	__throw_if_error();
+	__check_string_null(key, "nv_list keys may not contain NUL");
+
+	std::forward<_F>(fn)(__m_nv, __nv_key(key).c_str());
+
+	if (auto err = ::nvlist_error(__m_nv); err != 0) [[unlikely]]
+		throw_add_error(key, err);
+}
+
 void
 __nv_list::set_error(std::errc error)
 {
@@ -153,17 +199,22 @@ __nv_list::operator const_nv_list() const
 nv_list
 __nv_list::xfer(int fd, int flags) &&
 {
+	__NVXX_STATS_CALL(send);
+	__NVXX_STATS_CALL(recv);
 	__throw_if_error();
 
+	auto trace = __trace_scope(nv_trace_op::xfer, fd, __m_nv);
 	auto *nv = ::nvlist_xfer(fd, __m_nv, flags);
 	// nvlist_xfer always destroys the original list
 	__m_nv = nullptr;
+	auto const err = nv != nullptr ? 0 : errno;
+	trace.end(err, nv);
 
 	if (nv != nullptr)
 		return (nv_list(nv));
 
 	throw std::system_error(
-		std::error_code(errno, std::system_category()));
+		std::error_code(err, std::system_category()));
 }
 
 void
@@ -178,10 +229,10 @@ __nv_list::free_type(std::string_view key, int type)
 	__throw_if_error();
 	__check_string_null(key, "nv_list keys may not contain NUL");
 
-	auto skey = std::string(key);
+	auto const skey = __nv_key(key);
 
 	if (!::nvlist_exists_type(__m_nv, skey.c_str(), type))
-		throw nv_key_not_found(skey);
+		__throw_key_not_found(key);
 
 	::nvlist_free_type(__m_nv, skey.c_str(), type);
 }
@@ -193,24 +244,9 @@ __nv_list::free_type(std::string_view key, int type)
 void
 __nv_list::add_null(std::string_view key)
 {
-	__throw_if_error();
-	__check_string_null(key, "nv_list keys may not contain NUL");
-
-	auto skey = std::string(key);
-
-	::nvlist_add_null(__m_nv, skey.c_str());
-
-	switch (auto err = ::nvlist_error(__m_nv)) {
-	case 0:
-		return;
-
-	case EEXIST:
-		throw nv_key_exists(skey);
-
-	default:
-		throw std::system_error(
-			std::error_code(err, std::generic_category()));
-	}
+	__add(key, [&] (::nvlist_t *nvl, char const *k) {
+		::nvlist_add_null(nvl, k);
+	});
 }
 
 void
@@ -226,36 +262,22 @@ __nv_list::free_null(std::string_view key)
 void
 __nv_list::add_bool(std::string_view key, bool value)
 {
-	__throw_if_error();
-	__check_string_null(key, "nv_list keys may not contain NUL");
-
-	auto skey = std::string(key);
-
-	::nvlist_add_bool(__m_nv, skey.c_str(), value);
-
-	switch (auto err = ::nvlist_error(__m_nv)) {
-	case 0:
-		return;
-
-	case EEXIST:
-		throw nv_key_exists(skey);
-
-	default:
-		throw std::system_error(
-			std::error_code(err, std::generic_category()));
-	}
+	__add(key, [&] (::nvlist_t *nvl, char const *k) {
+		::nvlist_add_bool(nvl, k, value);
+	});
 }
 
 bool
 __nv_list::take_bool(std::string_view key)
 {
+	__NVXX_STATS_CALL(take);
 	__throw_if_error();
 	__check_string_null(key, "nv_list keys may not contain NUL");
 
-	auto skey = std::string(key);
+	auto const skey = __nv_key(key);
 
 	if (!::nvlist_exists_bool(__m_nv, skey.c_str()))
-		throw nv_key_not_found(skey);
+		__throw_key_not_found(key);
 
 	return (::nvlist_take_bool(__m_nv, skey.c_str()));
 }
@@ -269,12 +291,14 @@ __nv_list::free_bool(std::string_view key)
 std::vector<bool>
 __nv_list::take_bool_array(std::string_view key)
 {
+	__NVXX_STATS_CALL(take);
 	__throw_if_error();
 	__check_string_null(key, "nv_list keys may not contain NUL");
 
 	auto nitems = std::size_t{};
 	auto ptr = __ptr_guard(::nvlist_take_bool_array(
-			__m_nv, std::string(key).c_str(), &nitems));
+			__m_nv, __nv_key(key).c_str(), &nitems));
+	__NVXX_STATS_ALLOC(take, nitems);
 	return (std::vector<bool>(ptr.__ptr, ptr.__ptr + nitems));
 }
 
@@ -282,37 +306,21 @@ void
 __nv_list::add_bool_array(std::string_view key,
 			  std::span<bool const> value)
 {
-	__throw_if_error();
-	__check_string_null(key, "nv_list keys may not contain NUL");
-
-	auto skey = std::string(key);
-
-	::nvlist_add_bool_array(__m_nv, skey.c_str(),
-				std::ranges::data(value),
-				std::ranges::size(value));
-
-	switch (auto err = ::nvlist_error(__m_nv)) {
-	case 0:
-		return;
-
-	case EEXIST:
-		throw nv_key_exists(skey);
-
-	default:
-		throw std::system_error(
-			std::error_code(err, std::generic_category()));
-	}
+	__add(key, [&] (::nvlist_t *nvl, char const *k) {
+		::nvlist_add_bool_array(nvl, k,
+					std::ranges::data(value),
+					std::ranges::size(value));
+	});
 }
 
 void
 __nv_list::move_bool_array(std::string_view key, std::span<bool> value)
 {
-	__throw_if_error();
-	__check_string_null(key, "nv_list keys may not contain NUL");
-
-	::nvlist_move_bool_array(__m_nv, std::string(key).c_str(),
-				 std::ranges::data(value),
-				 std::ranges::size(value));
+	__add(key, [&] (::nvlist_t *nvl, char const *k) {
+		::nvlist_move_bool_array(nvl, k,
+					 std::ranges::data(value),
+					 std::ranges::size(value));
+	});
 }
 
 void
@@ -321,7 +329,7 @@ __nv_list::append_bool_array(std::string_view key, bool value)
 	__throw_if_error();
 	__check_string_null(key, "nv_list keys may not contain NUL");
 
-	::nvlist_append_bool_array(__m_nv, std::string(key).c_str(), value);
+	::nvlist_append_bool_array(__m_nv, __nv_key(key).c_str(), value);
 }
 
 void
@@ -337,36 +345,22 @@ __nv_list::free_bool_array(std::string_view key)
 void
 __nv_list::add_number(std::string_view key, std::uint64_t value)
 {
-	__throw_if_error();
-	__check_string_null(key, "nv_list keys may not contain NUL");
-
-	auto skey = std::string(key);
-
-	::nvlist_add_number(__m_nv, skey.c_str(), value);
-
-	switch (auto err = ::nvlist_error(__m_nv)) {
-	case 0:
-		return;
-
-	case EEXIST:
-		throw nv_key_exists(skey);
-
-	default:
-		throw std::system_error(
-			std::error_code(err, std::generic_category()));
-	}
+	__add(key, [&] (::nvlist_t *nvl, char const *k) {
+		::nvlist_add_number(nvl, k, value);
+	});
 }
 
 std::uint64_t
 __nv_list::take_number(std::string_view key)
 {
+	__NVXX_STATS_CALL(take);
 	__throw_if_error();
 	__check_string_null(key, "nv_list keys may not contain NUL");
 
-	auto skey = std::string(key);
+	auto const skey = __nv_key(key);
 
 	if (!::nvlist_exists_number(__m_nv, skey.c_str()))
-		throw nv_key_not_found(skey);
+		__throw_key_not_found(key);
 
 	return (::nvlist_take_number(__m_nv, skey.c_str()));
 }
@@ -380,14 +374,16 @@ __nv_list::free_number(std::string_view key)
 std::vector<std::uint64_t>
 __nv_list::take_number_array(std::string_view key)
 {
+	__NVXX_STATS_CALL(take);
 	__throw_if_error();
 	__check_string_null(key, "nv_list keys may not contain NUL");
 
 	auto nitems = std::size_t{};
 	auto ptr = __ptr_guard(
 		::nvlist_take_number_array(__m_nv,
-					   std::string(key).c_str(),
+					   __nv_key(key).c_str(),
 					   &nitems));
+	__NVXX_STATS_ALLOC(take, nitems * sizeof(std::uint64_t));
 	return {ptr.__ptr, ptr.__ptr + nitems};
 }
 
@@ -395,38 +391,22 @@ void
 __nv_list::add_number_array(std::string_view key,
 			    std::span<std::uint64_t const> value)
 {
-	__throw_if_error();
-	__check_string_null(key, "nv_list keys may not contain NUL");
-
-	auto skey = std::string(key);
-
-	::nvlist_add_number_array(__m_nv, skey.c_str(),
-				  std::ranges::data(value),
-				  std::ranges::size(value));
-
-	switch (auto err = ::nvlist_error(__m_nv)) {
-	case 0:
-		return;
-
-	case EEXIST:
-		throw nv_key_exists(skey);
-
-	default:
-		throw std::system_error(
-			std::error_code(err, std::generic_category()));
-	}
+	__add(key, [&] (::nvlist_t *nvl, char const *k) {
+		::nvlist_add_number_array(nvl, k,
+					  std::ranges::data(value),
+					  std::ranges::size(value));
+	});
 }
 
 void
 __nv_list::move_number_array(std::string_view key,
 			     std::span<std::uint64_t> value)
 {
-	__throw_if_error();
-	__check_string_null(key, "nv_list keys may not contain NUL");
-
-	::nvlist_move_number_array(__m_nv, std::string(key).c_str(),
-				   std::ranges::data(value),
-				   std::ranges::size(value));
+	__add(key, [&] (::nvlist_t *nvl, char const *k) {
+		::nvlist_move_number_array(nvl, k,
+					   std::ranges::data(value),
+					   std::ranges::size(value));
+	});
 }
 
 void
@@ -435,7 +415,7 @@ __nv_list::append_number_array(std::string_view key, std::uint64_t value)
 	__throw_if_error();
 	__check_string_null(key, "nv_list keys may not contain NUL");
 
-	::nvlist_append_number_array(__m_nv, std::string(key).c_str(), value);
+	::nvlist_append_number_array(__m_nv, __nv_key(key).c_str(), value);
 }
 
 void
@@ -448,51 +428,67 @@ __nv_list::free_number_array(std::string_view key)
  * string operations
  */
 
+/*
+ * nvlist_add_stringf() copies the string directly, but its precision is an
+ * int, so a longer string is copied into a NUL-terminated buffer first.
+ */
 void
-__nv_list::add_string(std::string_view key, std::string_view value)
+__nvlist_add_string(::nvlist_t *nvl, char const *key,
+		    std::string_view value) noexcept
 {
-	__throw_if_error();
-	__check_string_null(key, "nv_list keys may not contain NUL");
-	__check_string_null(value, "nv_list string values may not contain NUL");
-
-	auto skey = std::string(key);
-
-	::nvlist_add_string(__m_nv, skey.c_str(), std::string(value).c_str());
+	if (value.size() <= INT_MAX) [[likely]] {
+		::nvlist_add_stringf(nvl, key, "%.*s",
+				     static_cast<int>(value.size()),
+				     value.data());
+		return;
+	}
 
-	switch (auto err = ::nvlist_error(__m_nv)) {
-	case 0:
+	auto *str = static_cast<char *>(std::malloc(value.size() + 1));
+	if (str == nullptr) {
+		::nvlist_set_error(nvl, ENOMEM);
 		return;
+	}
 
-	case EEXIST:
-		throw nv_key_exists(skey);
+	std::memcpy(str, value.data(), value.size());
+	str[value.size()] = '\0';
+	::nvlist_move_string(nvl, key, str);
+}
 
-	default:
-		throw std::system_error(
-			std::error_code(err, std::generic_category()));
-	}
+void
+__nv_list::add_string(std::string_view key, std::string_view value)
+{
+	__add(key, [&] (::nvlist_t *nvl, char const *k) {
+		__check_string_null(value,
+				    "nv_list string values may not contain NUL");
+
+		__nvlist_add_string(nvl, k, value);
+	});
 }
 
 void
 __nv_list::move_string(std::string_view key, char *value)
 {
-	__throw_if_error();
-	__check_string_null(key, "nv_list keys may not contain NUL");
-
-	::nvlist_move_string(__m_nv, std::string(key).c_str(), value);
+	__add(key, [&] (::nvlist_t *nvl, char const *k) {
+		::nvlist_move_string(nvl, k, value);
+	});
 }
 
 std::string
 __nv_list::take_string(std::string_view key)
 {
+	__NVXX_STATS_CALL(take);
 	__throw_if_error();
 	__check_string_null(key, "nv_list keys may not contain NUL");
 
-	auto skey = std::string(key);
+	auto const skey = __nv_key(key);
 
 	if (!::nvlist_exists_string(__m_nv, skey.c_str()))
-		throw nv_key_not_found(skey);
+		__throw_key_not_found(key);
 
-	return (::nvlist_take_string(__m_nv, skey.c_str()));
+	auto ptr = __ptr_guard(::nvlist_take_string(__m_nv, skey.c_str()));
+	auto str = std::string(ptr.__ptr);
+	__NVXX_STATS_ALLOC(take, str.size() + 1);
+	return (str);
 }
 
 void
@@ -505,51 +501,36 @@ void
 __nv_list::add_string_array(std::string_view key,
 			    std::span<std::string_view const> value)
 {
-	__throw_if_error();
-	__check_string_null(key, "nv_list keys may not contain NUL");
-
-	for (auto &str: value)
-		__check_string_null(str, "nv_list string values may not contain NUL");
+	__add(key, [&] (::nvlist_t *nvl, char const *k) {
+		for (auto &str: value)
+			__check_string_null(str,
+				"nv_list string values may not contain NUL");
 
-	auto skey = std::string(key);
+		// nvlist_add_string_array expects an array of NUL-terminated
+		// C strings.
 
-	// nvlist_add_string_array expects an array of NUL-terminated
-	// C strings.
-
-	auto strings = value
-		| construct<std::string>()
-		| std::ranges::to<std::vector>();
+		auto strings = value
+			| construct<std::string>()
+			| std::ranges::to<std::vector>();
 
-	auto ptrs = strings
-		| std::views::transform(&std::string::c_str)
-		| std::ranges::to<std::vector>();
-
-	::nvlist_add_string_array(__m_nv, skey.c_str(),
-				  ptrs.data(), ptrs.size());
-
-	switch (auto err = ::nvlist_error(__m_nv)) {
-	case 0:
-		return;
+		auto ptrs = strings
+			| std::views::transform(&std::string::c_str)
+			| std::ranges::to<std::vector>();
 
-	case EEXIST:
-		throw nv_key_exists(skey);
-
-	default:
-		throw std::system_error(
-			std::error_code(err, std::generic_category()));
-	}
+		::nvlist_add_string_array(nvl, k,
+					  ptrs.data(), ptrs.size());
+	});
 }
 
 void
 __nv_list::move_string_array(std::string_view key,
 			     std::span<char *> value)
 {
-	__throw_if_error();
-	__check_string_null(key, "nv_list keys may not contain NUL");
-
-	::nvlist_move_string_array(__m_nv, std::string(key).c_str(),
-				   std::ranges::data(value),
-				   std::ranges::size(value));
+	__add(key, [&] (::nvlist_t *nvl, char const *k) {
+		::nvlist_move_string_array(nvl, k,
+					   std::ranges::data(value),
+					   std::ranges::size(value));
+	});
 }
 
 void
@@ -560,19 +541,21 @@ __nv_list::append_string_array(std::string_view key, std::string_view value)
 	__check_string_null(value, "nv_list string values may not contain NUL");
 
 	::nvlist_append_string_array(__m_nv, 
-				     std::string(key).c_str(), 
+				     __nv_key(key).c_str(), 
 				     std::string(value).c_str());
 }
 
 std::vector<std::string>
 __nv_list::take_string_array(std::string_view key)
 {
+	__NVXX_STATS_CALL(take);
 	__throw_if_error();
 	__check_string_null(key, "nv_list keys may not contain NUL");
 
 	auto nitems = std::size_t{};
-	auto *data = nvlist_take_string_array(__m_nv, std::string(key).c_str(),
+	auto *data = nvlist_take_string_array(__m_nv, __nv_key(key).c_str(),
 					      &nitems);
+	__NVXX_STATS_ALLOC(take, nitems * sizeof(std::string));
 	return (std::span(data, data + nitems)
 		| construct<std::string>()
 		| std::ranges::to<std::vector>());
@@ -591,55 +574,39 @@ __nv_list::free_string_array(std::string_view key)
 void
 __nv_list::add_nvlist(std::string_view key, const_nv_list const &other)
 {
-	__throw_if_error();
-	__check_string_null(key, "nv_list keys may not contain NUL");
-
-	auto skey = std::string(key);
-
-	::nvlist_add_nvlist(__m_nv, skey.c_str(), other.__m_nv);
-
-	switch (auto err = ::nvlist_error(__m_nv)) {
-	case 0:
-		return;
-
-	case EEXIST:
-		throw nv_key_exists(skey);
-
-	default:
-		throw std::system_error(
-			std::error_code(err, std::generic_category()));
-	}
+	__add(key, [&] (::nvlist_t *nvl, char const *k) {
+		::nvlist_add_nvlist(nvl, k, other.__m_nv);
+	});
 }
 
 void
 __nv_list::move_nvlist(std::string_view key, nv_list &&value)
 {
-	__throw_if_error();
-	__check_string_null(key, "nv_list keys may not contain NUL");
-
-	::nvlist_move_nvlist(__m_nv, std::string(key).c_str(),
-			     std::exchange(value.__m_nv, nullptr));
+	__add(key, [&] (::nvlist_t *nvl, char const *k) {
+		::nvlist_move_nvlist(nvl, k,
+				     std::exchange(value.__m_nv, nullptr));
+	});
 }
 
 void
 __nv_list::move_nvlist(std::string_view key, ::nvlist_t *value)
 {
-	__throw_if_error();
-	__check_string_null(key, "nv_list keys may not contain NUL");
-
-	::nvlist_move_nvlist(__m_nv, std::string(key).c_str(), value);
+	__add(key, [&] (::nvlist_t *nvl, char const *k) {
+		::nvlist_move_nvlist(nvl, k, value);
+	});
 }
 
 nv_list
 __nv_list::take_nvlist(std::string_view key)
 {
+	__NVXX_STATS_CALL(take);
 	__throw_if_error();
 	__check_string_null(key, "nv_list keys may not contain NUL");
 
-	auto skey = std::string(key);
+	auto const skey = __nv_key(key);
 
 	if (!::nvlist_exists_nvlist(__m_nv, skey.c_str()))
-		throw nv_key_not_found(skey);
+		__throw_key_not_found(key);
 
 	auto nvl = nvlist_take_nvlist(__m_nv, skey.c_str());
 	return (nv_list(nvl));
@@ -655,70 +622,39 @@ void
 __nv_list::add_nvlist_array(std::string_view key,
 			    std::span<const_nv_list const> value)
 {
-	__throw_if_error();
-	__check_string_null(key, "nv_list keys may not contain NUL");
-
-	auto skey = std::string(key);
-
-	auto ptrs = value
-		| std::views::transform(&const_nv_list::__m_nv)
-		| std::ranges::to<std::vector>();
+	__add(key, [&] (::nvlist_t *nvl, char const *k) {
+		auto ptrs = value
+			| std::views::transform(&const_nv_list::__m_nv)
+			| std::ranges::to<std::vector>();
 
-	::nvlist_add_nvlist_array(__m_nv, skey.c_str(),
-				  ptrs.data(), ptrs.size());
-
-	switch (auto err = ::nvlist_error(__m_nv)) {
-	case 0:
-		return;
-
-	case EEXIST:
-		throw nv_key_exists(skey);
-
-	default:
-		throw std::system_error(
-			std::error_code(err, std::generic_category()));
-	}
+		::nvlist_add_nvlist_array(nvl, k,
+					  ptrs.data(), ptrs.size());
+	});
 }
 
 void
 __nv_list::add_nvlist_array(std::string_view key,
 			    std::span<nv_list const> value)
 {
-	__throw_if_error();
-	__check_string_null(key, "nv_list keys may not contain NUL");
-
-	auto skey = std::string(key);
-
-	auto ptrs = value
-		| std::views::transform(&nv_list::__m_nv)
-		| std::ranges::to<std::vector>();
-
-	::nvlist_add_nvlist_array(__m_nv, skey.c_str(),
-				  ptrs.data(), ptrs.size());
-
-	switch (auto err = ::nvlist_error(__m_nv)) {
-	case 0:
-		return;
+	__add(key, [&] (::nvlist_t *nvl, char const *k) {
+		auto ptrs = value
+			| std::views::transform(&nv_list::__m_nv)
+			| std::ranges::to<std::vector>();
 
-	case EEXIST:
-		throw nv_key_exists(skey);
-
-	default:
-		throw std::system_error(
-			std::error_code(err, std::generic_category()));
-	}
+		::nvlist_add_nvlist_array(nvl, k,
+					  ptrs.data(), ptrs.size());
+	});
 }
 
 void
 __nv_list::move_nvlist_array(std::string_view key,
 			     std::span<::nvlist_t *> value)
 {
-	__throw_if_error();
-	__check_string_null(key, "nv_list keys may not contain NUL");
-
-	::nvlist_move_nvlist_array(__m_nv, std::string(key).c_str(),
-				   std::ranges::data(value),
-				   std::ranges::size(value));
+	__add(key, [&] (::nvlist_t *nvl, char const *k) {
+		::nvlist_move_nvlist_array(nvl, k,
+					   std::ranges::data(value),
+					   std::ranges::size(value));
+	});
 }
 
 void
@@ -728,21 +664,23 @@ __nv_list::append_nvlist_array(std::string_view key,
 	__throw_if_error();
 	__check_string_null(key, "nv_list keys may not contain NUL");
 
-	::nvlist_append_nvlist_array(__m_nv, std::string(key).c_str(),
+	::nvlist_append_nvlist_array(__m_nv, __nv_key(key).c_str(),
 				     value.__m_nv);
 }
 
 std::vector<nv_list>
 __nv_list::take_nvlist_array(std::string_view key)
 {
+	__NVXX_STATS_CALL(take);
 	__throw_if_error();
 	__check_string_null(key, "nv_list keys may not contain NUL");
 
 	auto nitems = std::size_t{};
 	auto ptr = __ptr_guard(
 		::nvlist_take_nvlist_array(__m_nv,
-					   std::string(key).c_str(),
+					   __nv_key(key).c_str(),
 					   &nitems));
+	__NVXX_STATS_ALLOC(take, nitems * sizeof(nv_list));
 	return {std::from_range,
 		std::span(ptr.__ptr, nitems) | construct<nv_list>()};
 }
@@ -760,45 +698,28 @@ __nv_list::free_nvlist_array(std::string_view key)
 nv_fd
 __nv_list::take_descriptor(std::string_view key)
 {
+	__NVXX_STATS_CALL(take);
 	__throw_if_error();
 	__check_string_null(key, "nv_list keys may not contain NUL");
 
-	auto fd = ::nvlist_take_descriptor(__m_nv, std::string(key).c_str());
+	auto fd = ::nvlist_take_descriptor(__m_nv, __nv_key(key).c_str());
 	return (nv_fd(fd));
 }
 
 void
 __nv_list::add_descriptor(std::string_view key, int value)
 {
-	__throw_if_error();
-	__check_string_null(key, "nv_list keys may not contain NUL");
-
-	auto skey = std::string(key);
-
-	::nvlist_add_descriptor(__m_nv, skey.c_str(), value);
-
-	switch (auto err = ::nvlist_error(__m_nv)) {
-	case 0:
-		return;
-
-	case EEXIST:
-		throw nv_key_exists(skey);
-
-	default:
-		throw std::system_error(
-			std::error_code(err, std::generic_category()));
-	}
+	__add(key, [&] (::nvlist_t *nvl, char const *k) {
+		::nvlist_add_descriptor(nvl, k, value);
+	});
 }
 
 void
 __nv_list::move_descriptor(std::string_view key, nv_fd &&fd)
 {
-	__throw_if_error();
-	__check_string_null(key, "nv_list keys may not contain NUL");
-
-	::nvlist_move_descriptor(__m_nv,
-				 std::string(key).c_str(),
-				 std::move(fd).release());
+	__add(key, [&] (::nvlist_t *nvl, char const *k) {
+		::nvlist_move_descriptor(nvl, k, std::move(fd).release());
+	});
 }
 
 void
@@ -814,7 +735,7 @@ __nv_list::append_descriptor_array(std::string_view key, int value)
 	__check_string_null(key, "nv_list keys may not contain NUL");
 
 	::nvlist_append_descriptor_array(__m_nv,
-					 std::string(key).c_str(),
+					 __nv_key(key).c_str(),
 					 value);
 }
 
@@ -822,37 +743,21 @@ void
 __nv_list::add_descriptor_array(std::string_view key,
 				std::span<int const> value)
 {
-	__throw_if_error();
-	__check_string_null(key, "nv_list keys may not contain NUL");
-
-	auto skey = std::string(key);
-
-	::nvlist_add_descriptor_array(__m_nv, skey.c_str(),
-				      std::ranges::data(value),
-				      std::ranges::size(value));
-
-	switch (auto err = ::nvlist_error(__m_nv)) {
-	case 0:
-		return;
-
-	case EEXIST:
-		throw nv_key_exists(skey);
-
-	default:
-		throw std::system_error(
-			std::error_code(err, std::generic_category()));
-	}
+	__add(key, [&] (::nvlist_t *nvl, char const *k) {
+		::nvlist_add_descriptor_array(nvl, k,
+					      std::ranges::data(value),
+					      std::ranges::size(value));
+	});
 }
 
 void
 __nv_list::move_descriptor_array(std::string_view key, std::span<int> value)
 {
-	__throw_if_error();
-	__check_string_null(key, "nv_list keys may not contain NUL");
-
-	::nvlist_add_descriptor_array(__m_nv, std::string(key).c_str(),
-				      std::ranges::data(value),
-				      std::ranges::size(value));
+	__add(key, [&] (::nvlist_t *nvl, char const *k) {
+		::nvlist_move_descriptor_array(nvl, k,
+					      std::ranges::data(value),
+					      std::ranges::size(value));
+	});
 }
 
 void
@@ -864,6 +769,7 @@ __nv_list::free_descriptor_array(std::string_view key)
 std::vector<nv_fd>
 __nv_list::take_descriptor_array(std::string_view key)
 {
+	__NVXX_STATS_CALL(take);
 	__throw_if_error();
 	__check_string_null(key, "nv_list keys may not contain NUL");
 
@@ -872,7 +778,7 @@ __nv_list::take_descriptor_array(std::string_view key)
 	 * want to remove the array from the nvlist if vector allocation fails.
 	 */
 
-	auto skey = std::string(key);
+	auto const skey = __nv_key(key);
 
 	auto nitems = std::size_t{};
 	auto ptr = ::nvlist_get_descriptor_array(__m_nv, skey.c_str(), &nitems);
@@ -885,6 +791,7 @@ __nv_list::take_descriptor_array(std::string_view key)
 	 */
 	auto ret = std::vector<nv_fd>{};
 	ret.reserve(fds.size());
+	__NVXX_STATS_ALLOC(take, fds.size() * sizeof(nv_fd));
 
 	std::ranges::copy(fds | construct<nv_fd>, std::back_inserter(ret));
 
@@ -899,37 +806,21 @@ __nv_list::take_descriptor_array(std::string_view key)
 void
 __nv_list::add_binary(std::string_view key, std::span<std::byte const> value)
 {
-	__throw_if_error();
-	__check_string_null(key, "nv_list keys may not contain NUL");
-
-	auto skey = std::string(key);
-
-	::nvlist_add_binary(__m_nv, skey.c_str(),
-			    std::ranges::data(value),
-			    std::ranges::size(value));
-
-	switch (auto err = ::nvlist_error(__m_nv)) {
-	case 0:
-		return;
-
-	case EEXIST:
-		throw nv_key_exists(skey);
-
-	default:
-		throw std::system_error(
-			std::error_code(err, std::generic_category()));
-	}
+	__add(key, [&] (::nvlist_t *nvl, char const *k) {
+		::nvlist_add_binary(nvl, k,
+				    std::ranges::data(value),
+				    std::ranges::size(value));
+	});
 }
 
 void
 __nv_list::move_binary(std::string_view key, std::span<std::byte> value)
 {
-	__throw_if_error();
-	__check_string_null(key, "nv_list keys may not contain NUL");
-
-	::nvlist_move_binary(__m_nv, std::string(key).c_str(),
-			     std::ranges::data(value),
-			     std::ranges::size(value));
+	__add(key, [&] (::nvlist_t *nvl, char const *k) {
+		::nvlist_move_binary(nvl, k,
+				     std::ranges::data(value),
+				     std::ranges::size(value));
+	});
 }
 
 void
@@ -941,17 +832,19 @@ __nv_list::free_binary(std::string_view key)
 std::vector<std::byte>
 __nv_list::take_binary(std::string_view key)
 {
+	__NVXX_STATS_CALL(take);
 	__throw_if_error();
 	__check_string_null(key, "nv_list keys may not contain NUL");
 
-	auto skey = std::string(key);
+	auto const skey = __nv_key(key);
 
 	if (!::nvlist_exists_binary(__m_nv, skey.c_str()))
-		throw nv_key_not_found(skey);
+		__throw_key_not_found(key);
 
 	auto size = std::size_t{};
 	auto *data = ::nvlist_take_binary(__m_nv, skey.c_str(), &size);
 	auto ptr = __ptr_guard(static_cast<std::byte *>(data));
+	__NVXX_STATS_ALLOC(take, size);
 	return {ptr.__ptr, ptr.__ptr + size};
 }
 
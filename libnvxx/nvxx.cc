@@ -5,58 +5,237 @@
 
 #include <cerrno>
 #include <cassert>
+#include <cstdlib>
 
 #include "nvxx.h"
 
 namespace bsd::__detail {
 
 /*
- * __nv_list_base
+ * cold paths for the inline accessors
  */
 
-__nv_list_base::__nv_list_base(nvlist_t *nv, __nvlist_owning owning)
-	: __m_nv(nv)
-	, __m_owning(owning)
+void
+__throw_null_nv_list()
 {
+	throw std::logic_error("attempt to access a null nv_list");
 }
 
-__nv_list_base::~__nv_list_base()
+void
+__throw_error_state(int error)
 {
-	__free_nv();
+	throw nv_error_state(std::error_code(error, std::generic_category()));
 }
 
 void
-__nv_list_base::__free_nv() noexcept
+__throw_runtime_error(std::string_view what)
 {
-	if ((__m_nv != nullptr) &&
-	    (__m_owning == __nvlist_owning::__owning))
-		::nvlist_destroy(__m_nv);
-	__m_nv = nullptr;
+	throw std::runtime_error(std::string(what));
 }
 
 void
-__nv_list_base::__throw_if_error() const
+__throw_key_not_found(std::string_view key)
+{
+	throw nv_key_not_found(std::string(key));
+}
+
+/*
+ * pair helpers
+ */
+
+void
+__copy_pair(::nvlist_t *dst, char const *key, int type, void const *cookie)
 {
-	__throw_if_null();
+	auto nitems = std::size_t{};
+
+	switch (type) {
+	case NV_TYPE_NULL:
+		::nvlist_add_null(dst, key);
+		break;
+
+	case NV_TYPE_BOOL:
+		::nvlist_add_bool(dst, key, ::cnvlist_get_bool(cookie));
+		break;
+
+	case NV_TYPE_NUMBER:
+		::nvlist_add_number(dst, key, ::cnvlist_get_number(cookie));
+		break;
+
+	case NV_TYPE_STRING:
+		::nvlist_add_string(dst, key, ::cnvlist_get_string(cookie));
+		break;
+
+	case NV_TYPE_NVLIST:
+		::nvlist_add_nvlist(dst, key, ::cnvlist_get_nvlist(cookie));
+		break;
+
+	case NV_TYPE_DESCRIPTOR:
+		::nvlist_add_descriptor(dst, key,
+					::cnvlist_get_descriptor(cookie));
+		break;
+
+	case NV_TYPE_BINARY: {
+		auto const *data = ::cnvlist_get_binary(cookie, &nitems);
+		::nvlist_add_binary(dst, key, data, nitems);
+		break;
+	}
+
+	case NV_TYPE_BOOL_ARRAY: {
+		auto const *data = ::cnvlist_get_bool_array(cookie, &nitems);
+		::nvlist_add_bool_array(dst, key, data, nitems);
+		break;
+	}
+
+	case NV_TYPE_NUMBER_ARRAY: {
+		auto const *data = ::cnvlist_get_number_array(cookie, &nitems);
+		::nvlist_add_number_array(dst, key, data, nitems);
+		break;
+	}
 
-	if (auto err = ::nvlist_error(__m_nv); err != 0)
-		throw nv_error_state(std::error_code(err, std::generic_category()));
+	case NV_TYPE_STRING_ARRAY: {
+		auto const *data = ::cnvlist_get_string_array(cookie, &nitems);
+		::nvlist_add_string_array(dst, key, data, nitems);
+		break;
+	}
+
+	case NV_TYPE_NVLIST_ARRAY: {
+		auto const *data = ::cnvlist_get_nvlist_array(cookie, &nitems);
+		::nvlist_add_nvlist_array(dst, key, data, nitems);
+		break;
+	}
+
+	case NV_TYPE_DESCRIPTOR_ARRAY: {
+		auto const *data = ::cnvlist_get_descriptor_array(cookie,
+								  &nitems);
+		::nvlist_add_descriptor_array(dst, key, data, nitems);
+		break;
+	}
+
+	default:
+		std::abort();
+	}
 }
 
 void
-__nv_list_base::__throw_if_null() const
+__move_pair(::nvlist_t *dst, char const *key, int type, void *cookie)
 {
-	if (__m_nv == nullptr)
-		throw std::logic_error("attempt to access a null nv_list");
+	// the key may belong to the pair we are about to take
+	auto skey = std::string(key);
+	key = skey.c_str();
+
+	auto nitems = std::size_t{};
+
+	switch (type) {
+	case NV_TYPE_NULL:
+		::cnvlist_free_null(cookie);
+		::nvlist_add_null(dst, key);
+		break;
+
+	case NV_TYPE_BOOL:
+		::nvlist_add_bool(dst, key, ::cnvlist_take_bool(cookie));
+		break;
+
+	case NV_TYPE_NUMBER:
+		::nvlist_add_number(dst, key, ::cnvlist_take_number(cookie));
+		break;
+
+	case NV_TYPE_STRING:
+		::nvlist_move_string(dst, key, ::cnvlist_take_string(cookie));
+		break;
+
+	case NV_TYPE_NVLIST:
+		::nvlist_move_nvlist(dst, key, ::cnvlist_take_nvlist(cookie));
+		break;
+
+	case NV_TYPE_DESCRIPTOR:
+		::nvlist_move_descriptor(dst, key,
+					 ::cnvlist_take_descriptor(cookie));
+		break;
+
+	case NV_TYPE_BINARY: {
+		auto *data = ::cnvlist_take_binary(cookie, &nitems);
+		::nvlist_move_binary(dst, key, data, nitems);
+		break;
+	}
+
+	case NV_TYPE_BOOL_ARRAY: {
+		auto *data = ::cnvlist_take_bool_array(cookie, &nitems);
+		::nvlist_move_bool_array(dst, key, data, nitems);
+		break;
+	}
+
+	case NV_TYPE_NUMBER_ARRAY: {
+		auto *data = ::cnvlist_take_number_array(cookie, &nitems);
+		::nvlist_move_number_array(dst, key, data, nitems);
+		break;
+	}
+
+	case NV_TYPE_STRING_ARRAY: {
+		auto *data = ::cnvlist_take_string_array(cookie, &nitems);
+		::nvlist_move_string_array(dst, key, data, nitems);
+		break;
+	}
+
+	case NV_TYPE_NVLIST_ARRAY: {
+		auto *data = ::cnvlist_take_nvlist_array(cookie, &nitems);
+		::nvlist_move_nvlist_array(dst, key, data, nitems);
+		break;
+	}
+
+	case NV_TYPE_DESCRIPTOR_ARRAY: {
+		auto *data = ::cnvlist_take_descriptor_array(cookie, &nitems);
+		::nvlist_move_descriptor_array(dst, key, data, nitems);
+		break;
+	}
+
+	default:
+		std::abort();
+	}
 }
 
 void
-__nv_list_base::__check_string_null(std::string_view str,
-				    std::string_view error) const
+__free_pair(int type, void *cookie)
 {
-	if (str.find('\0') == str.npos)
-		return;
-	throw std::runtime_error(std::string(error));
+	switch (type) {
+	case NV_TYPE_NULL:
+		::cnvlist_free_null(cookie);
+		break;
+	case NV_TYPE_BOOL:
+		::cnvlist_free_bool(cookie);
+		break;
+	case NV_TYPE_NUMBER:
+		::cnvlist_free_number(cookie);
+		break;
+	case NV_TYPE_STRING:
+		::cnvlist_free_string(cookie);
+		break;
+	case NV_TYPE_NVLIST:
+		::cnvlist_free_nvlist(cookie);
+		break;
+	case NV_TYPE_DESCRIPTOR:
+		::cnvlist_free_descriptor(cookie);
+		break;
+	case NV_TYPE_BINARY:
+		::cnvlist_free_binary(cookie);
+		break;
+	case NV_TYPE_BOOL_ARRAY:
+		::cnvlist_free_bool_array(cookie);
+		break;
+	case NV_TYPE_NUMBER_ARRAY:
+		::cnvlist_free_number_array(cookie);
+		break;
+	case NV_TYPE_STRING_ARRAY:
+		::cnvlist_free_string_array(cookie);
+		break;
+	case NV_TYPE_NVLIST_ARRAY:
+		::cnvlist_free_nvlist_array(cookie);
+		break;
+	case NV_TYPE_DESCRIPTOR_ARRAY:
+		::cnvlist_free_descriptor_array(cookie);
+		break;
+	default:
+		std::abort();
+	}
 }
 
 } // namespace bsd::__detail
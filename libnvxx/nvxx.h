@@ -13,19 +13,46 @@
 #include <sys/nv.h>
 #include <sys/cnv.h>
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <expected>
+#include <functional>
 #include <ranges>
 #include <span>
 #include <system_error>
 #include <vector>
+#include <optional>
+#include <tuple>
 #include <stdexcept>
 #include <format>
+#include <algorithm>
+#include <utility>
 
 #include <unistd.h>
 
+#include "nvxx_config.h"
 #include "nvxx_util.h"
+#include "nvxx_stats.h"
+#include "nvxx_trace.h"
 #include "nvxx_base.h"
+#include "nvxx_inline.h"
 #include "nvxx_iterator.h"
+#include "nvxx_access.h"
+#include "nvxx_builder.h"
+#include "nvxx_appender.h"
 #include "nvxx_serialize.h"
+#include "nvxx_compare.h"
+#include "nvxx_diff.h"
+#include "nvxx_merge.h"
+#include "nvxx_frozen.h"
+#include "nvxx_memory.h"
+#include "nvxx_shared.h"
+#include "nvxx_tree.h"
+#include "nvxx_journal.h"
+#include "nvxx_json.h"
+#include "nvxx_msgpack.h"
+#include "nvxx_cbor.h"
 
 #endif	/* !_NVXX_H_INCLUDED */
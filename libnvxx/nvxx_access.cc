@@ -0,0 +1,240 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR MIT
+ * Refer to the file 'LICENSE' in the nvxx distribution for license terms.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <optional>
+
+#include "nvxx.h"
+
+namespace bsd {
+
+namespace {
+
+template<typename _T>
+using result = std::expected<_T, nv_path_error>;
+
+auto
+fail(nv_path_errc code, std::size_t seg)
+{
+	return (std::unexpected(nv_path_error{code, seg}));
+}
+
+struct pair_ref {
+	int type;
+	void const *cookie;
+};
+
+/*
+ * Find the first pair with the given key.  Unlike calling nvlist_exists_*()
+ * followed by nvlist_get_*(), this scans the nvlist once, and tells us the
+ * type of the pair if it has the wrong type.
+ */
+std::optional<pair_ref>
+find(::nvlist_t const *nvl, char const *key)
+{
+	auto type = int{};
+	auto *cookie = static_cast<void *>(nullptr);
+
+	while (auto const *name = ::nvlist_next(nvl, &type, &cookie))
+		if (std::strcmp(name, key) == 0)
+			return (pair_ref{type, cookie});
+
+	return {};
+}
+
+// the value of the pair itself.
+template<typename _T>
+result<_T>
+value(pair_ref pair, std::size_t seg)
+{
+	if constexpr (std::same_as<_T, nv_list_value_t>) {
+		return (__detail::__make_value(pair.type, pair.cookie));
+	} else {
+		if (pair.type != __detail::__type_of<_T>)
+			return (fail(nv_path_errc::type_mismatch, seg));
+		return (std::get<_T>(__detail::__make_value(pair.type,
+							    pair.cookie)));
+	}
+}
+
+// convert an array element to the type at() returns for it.
+auto wrap(bool v) { return (v); }
+auto wrap(std::uint64_t v) { return (v); }
+auto wrap(int v) { return (v); }
+auto wrap(char const *v) { return (std::string_view(v)); }
+auto wrap(::nvlist_t const *v) { return (const_nv_list(v)); }
+
+template<typename _T, typename _E>
+result<_T>
+element_of(_E const *array, std::size_t nitems,
+	   std::size_t index, std::size_t seg)
+{
+	using value_type = decltype(wrap(array[0]));
+
+	if constexpr (std::same_as<_T, nv_list_value_t>
+		      || std::same_as<_T, value_type>) {
+		if (index >= nitems)
+			return (fail(nv_path_errc::out_of_range, seg));
+		return (_T(wrap(array[index])));
+	} else {
+		return (fail(nv_path_errc::type_mismatch, seg));
+	}
+}
+
+// an element of the array stored in the pair.
+template<typename _T>
+result<_T>
+element(pair_ref pair, std::size_t index, std::size_t seg)
+{
+	auto n = std::size_t{};
+
+	switch (pair.type) {
+	case NV_TYPE_BOOL_ARRAY:
+		return (element_of<_T>(
+			::cnvlist_get_bool_array(pair.cookie, &n),
+			n, index, seg));
+
+	case NV_TYPE_NUMBER_ARRAY:
+		return (element_of<_T>(
+			::cnvlist_get_number_array(pair.cookie, &n),
+			n, index, seg));
+
+	case NV_TYPE_STRING_ARRAY:
+		return (element_of<_T>(
+			::cnvlist_get_string_array(pair.cookie, &n),
+			n, index, seg));
+
+	case NV_TYPE_NVLIST_ARRAY:
+		return (element_of<_T>(
+			::cnvlist_get_nvlist_array(pair.cookie, &n),
+			n, index, seg));
+
+	case NV_TYPE_DESCRIPTOR_ARRAY:
+		return (element_of<_T>(
+			::cnvlist_get_descriptor_array(pair.cookie, &n),
+			n, index, seg));
+
+	default:
+		return (fail(nv_path_errc::type_mismatch, seg));
+	}
+}
+
+} // anonymous namespace
+
+namespace __detail {
+
+void
+__find_many(::nvlist_t const *nvl, std::span<__field_ref> fields)
+{
+	/*
+	 * Sort the fields by key, so that each pair in the nvlist is matched
+	 * with a binary search rather than by comparing it with every field.
+	 */
+	std::ranges::sort(fields, {}, &__field_ref::__key);
+
+	auto nfound = std::size_t{0};
+	auto type = int{};
+	auto *cookie = static_cast<void *>(nullptr);
+
+	while (nfound < fields.size()) {
+		auto const *name = ::nvlist_next(nvl, &type, &cookie);
+		if (name == nullptr)
+			break;
+
+		auto [first, last] = std::ranges::equal_range(
+			fields, std::string_view(name), {},
+			&__field_ref::__key);
+
+		for (auto &field : std::ranges::subrange(first, last)) {
+			// with NV_FLAG_NO_UNIQUE, the first pair wins.
+			if (field.__cookie != nullptr)
+				continue;
+
+			field.__type = type;
+			field.__cookie = cookie;
+			++nfound;
+		}
+	}
+}
+
+template<typename _T>
+auto
+__const_nv_list::at(nv_path_view path) const
+	-> std::expected<_T, nv_path_error>
+{
+	__throw_if_error();
+
+	constexpr auto no_index = __path_segment::__no_index;
+	auto const *nvl = static_cast<::nvlist_t const *>(__m_nv);
+
+	for (auto seg = std::size_t{0};; ++seg) {
+		auto pair = find(nvl, path.__key(seg));
+		if (!pair)
+			return (fail(nv_path_errc::not_found, seg));
+
+		auto index = path.__index(seg);
+
+		if (seg + 1 == path.size()) {
+			if (index == no_index)
+				return (value<_T>(*pair, seg));
+			return (element<_T>(*pair, index, seg));
+		}
+
+		// this is not the last segment, so it must be an nvlist.
+		if (index == no_index) {
+			if (pair->type != NV_TYPE_NVLIST)
+				return (fail(nv_path_errc::type_mismatch, seg));
+
+			nvl = ::cnvlist_get_nvlist(pair->cookie);
+		} else {
+			if (pair->type != NV_TYPE_NVLIST_ARRAY)
+				return (fail(nv_path_errc::type_mismatch, seg));
+
+			auto n = std::size_t{};
+			auto const *array = ::cnvlist_get_nvlist_array(
+				pair->cookie, &n);
+			if (index >= n)
+				return (fail(nv_path_errc::out_of_range, seg));
+
+			nvl = array[index];
+		}
+	}
+}
+
+template auto __const_nv_list::at<nullptr_t>(nv_path_view) const
+	-> std::expected<nullptr_t, nv_path_error>;
+template auto __const_nv_list::at<bool>(nv_path_view) const
+	-> std::expected<bool, nv_path_error>;
+template auto __const_nv_list::at<std::uint64_t>(nv_path_view) const
+	-> std::expected<std::uint64_t, nv_path_error>;
+template auto __const_nv_list::at<std::string_view>(nv_path_view) const
+	-> std::expected<std::string_view, nv_path_error>;
+template auto __const_nv_list::at<const_nv_list>(nv_path_view) const
+	-> std::expected<const_nv_list, nv_path_error>;
+template auto __const_nv_list::at<int>(nv_path_view) const
+	-> std::expected<int, nv_path_error>;
+template auto __const_nv_list::at<std::span<std::byte const>>(
+	nv_path_view) const
+	-> std::expected<std::span<std::byte const>, nv_path_error>;
+template auto __const_nv_list::at<std::span<bool const>>(nv_path_view) const
+	-> std::expected<std::span<bool const>, nv_path_error>;
+template auto __const_nv_list::at<std::span<std::uint64_t const>>(
+	nv_path_view) const
+	-> std::expected<std::span<std::uint64_t const>, nv_path_error>;
+template auto __const_nv_list::at<std::vector<std::string_view>>(
+	nv_path_view) const
+	-> std::expected<std::vector<std::string_view>, nv_path_error>;
+template auto __const_nv_list::at<std::span<int const>>(nv_path_view) const
+	-> std::expected<std::span<int const>, nv_path_error>;
+template auto __const_nv_list::at<std::vector<const_nv_list>>(
+	nv_path_view) const
+	-> std::expected<std::vector<const_nv_list>, nv_path_error>;
+template auto __const_nv_list::at<nv_list_value_t>(nv_path_view) const
+	-> std::expected<nv_list_value_t, nv_path_error>;
+
+} // namespace bsd::__detail
+
+} // namespace bsd
@@ -0,0 +1,383 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR MIT
+ * Refer to the file 'LICENSE' in the nvxx distribution for license terms.
+ */
+
+#ifndef	_NVXX_ACCESS_H_INCLUDED
+#define _NVXX_ACCESS_H_INCLUDED
+
+#ifndef _NVXX_H_INCLUDED
+# error include <nvxx.h> instead of including this header directly
+#endif
+
+#include <array>
+
+/*
+ * nv_path: a parsed path to a value inside nested nvlists, for use with
+ * const_nv_list::at().
+ *
+ * A path is a sequence of keys separated by '.', each of which may be followed
+ * by an array index in brackets, e.g. "a.b.c[3].d".  Every key except the last
+ * must name an nvlist, or if it has an index, an nvlist array.  The last key
+ * may name a value of any type, or if it has an index, an element of an array
+ * of any type.  Keys which contain '.', '[' or ']' cannot be named by a path.
+ *
+ * A path can be parsed at runtime (nv_path) or at compile time
+ * (nv_fixed_path, or the _nvpath literal).  Either is converted to an
+ * nv_path_view, which is what at() takes.
+ *
+ * at<_T>() may be called with any of the types in nv_list_value_t, which are
+ * the types returned by the get_*() functions (nullptr_t for a null value and
+ * int for a descriptor); or with nv_list_value_t itself to return a value of
+ * any type.  If the last segment has an index, _T is the element type of the
+ * array: bool, std::uint64_t, std::string_view, const_nv_list or int.
+ *
+ * Each segment is found with a single scan of its nvlist, and at() does not
+ * allocate unless _T is std::vector.
+ */
+
+namespace bsd {
+
+/*
+ * A string could not be parsed as an nv_path.
+ */
+struct nv_path_invalid : nv_error {
+	nv_path_invalid(std::string_view __path, std::size_t __pos,
+			std::string_view __what)
+		: nv_error("invalid nvlist path \"{0}\" at offset {1}: {2}",
+			   __path, __pos, __what)
+	{
+	}
+};
+
+/*
+ * Why a path lookup failed.
+ */
+enum struct nv_path_errc {
+	not_found,	/* a key does not exist */
+	type_mismatch,	/* a key exists, but has the wrong type */
+	out_of_range,	/* an array index is past the end of the array */
+};
+
+/*
+ * The error returned by const_nv_list::at().  segment is the index of the
+ * path segment (key and optional array index) at which the lookup failed.
+ */
+struct nv_path_error {
+	nv_path_errc code;
+	std::size_t segment;
+
+	bool operator==(nv_path_error const &) const = default;
+};
+
+namespace __detail {
+
+struct __path_segment {
+	static constexpr auto __no_index = static_cast<std::size_t>(-1);
+
+	std::size_t __key;	/* offset of the NUL-terminated key */
+	std::size_t __index;	/* array index, or __no_index */
+};
+
+/*
+ * Parse a path, writing each key followed by a NUL into __keys (which must
+ * have space for __path.size() + 1 characters) and calling __push with each
+ * segment.  This is constexpr so that nv_fixed_path can parse its path at
+ * compile time, where a throw is a compile-time error.
+ */
+constexpr void
+__parse_path(std::string_view __path, char *__keys, auto &&__push)
+{
+	auto __pos = std::size_t{0};
+	auto __out = std::size_t{0};
+
+	for (;;) {
+		auto __start = __out;
+
+		while (__pos < __path.size()
+		       && __path[__pos] != '.'
+		       && __path[__pos] != '['
+		       && __path[__pos] != ']') {
+			if (__path[__pos] == '\0')
+				throw nv_path_invalid(__path, __pos,
+						      "keys may not contain NUL");
+			__keys[__out++] = __path[__pos++];
+		}
+
+		if (__out == __start)
+			throw nv_path_invalid(__path, __pos, "expected a key");
+		__keys[__out++] = '\0';
+
+		auto __index = __path_segment::__no_index;
+
+		if (__pos < __path.size() && __path[__pos] == '[') {
+			auto __ndigits = 0;
+			__index = 0;
+
+			for (++__pos; __pos < __path.size()
+				      && __path[__pos] >= '0'
+				      && __path[__pos] <= '9'; ++__pos) {
+				auto __digit = static_cast<std::size_t>(
+					__path[__pos] - '0');
+				if (__index > (__path_segment::__no_index - 1
+					       - __digit) / 10)
+					throw nv_path_invalid(__path, __pos,
+						"array index is too large");
+				__index = __index * 10 + __digit;
+				++__ndigits;
+			}
+
+			if (__ndigits == 0 || __pos == __path.size()
+			    || __path[__pos] != ']')
+				throw nv_path_invalid(__path, __pos,
+						      "expected an array index");
+			++__pos;
+		}
+
+		__push(__path_segment{__start, __index});
+
+		if (__pos == __path.size())
+			return;
+
+		if (__path[__pos] != '.')
+			throw nv_path_invalid(__path, __pos, "expected '.'");
+		++__pos;
+	}
+}
+
+} // namespace bsd::__detail
+
+/*
+ * A non-owning reference to a parsed path.  The path it was created from must
+ * outlive it.
+ */
+struct nv_path_view {
+	constexpr nv_path_view(char const *__keys,
+			       std::span<__detail::__path_segment const> __segs)
+		noexcept
+		: __m_keys(__keys)
+		, __m_segments(__segs)
+	{
+	}
+
+	/*
+	 * Return the number of segments in the path.
+	 */
+	[[nodiscard]] constexpr std::size_t size() const noexcept {
+		return (__m_segments.size());
+	}
+
+	[[nodiscard]] constexpr char const *
+	__key(std::size_t __n) const noexcept {
+		return (__m_keys + __m_segments[__n].__key);
+	}
+
+	[[nodiscard]] constexpr std::size_t
+	__index(std::size_t __n) const noexcept {
+		return (__m_segments[__n].__index);
+	}
+
+private:
+	char const *__m_keys;
+	std::span<__detail::__path_segment const> __m_segments;
+};
+
+/*
+ * A path parsed at runtime.  If the path is malformed, the constructor throws
+ * nv_path_invalid.
+ */
+struct nv_path {
+	explicit nv_path(std::string_view __path)
+		: __m_keys(__path.size() + 1, '\0')
+	{
+		__detail::__parse_path(__path, __m_keys.data(),
+			[this] (__detail::__path_segment __seg) {
+				__m_segments.push_back(__seg);
+			});
+	}
+
+	operator nv_path_view() const noexcept {
+		return (nv_path_view(__m_keys.data(), __m_segments));
+	}
+
+	[[nodiscard]] std::size_t size() const noexcept {
+		return (__m_segments.size());
+	}
+
+private:
+	std::string __m_keys;
+	std::vector<__detail::__path_segment> __m_segments;
+};
+
+/*
+ * A path parsed at compile time from a string literal, which requires no
+ * allocation.  A malformed path is a compile-time error.
+ */
+template<std::size_t _N>
+struct nv_fixed_path {
+	consteval nv_fixed_path(char const (&__path)[_N]) {
+		__detail::__parse_path(std::string_view(__path, _N - 1),
+				       __m_keys,
+			[this] (__detail::__path_segment __seg) {
+				__m_segments[__m_size++] = __seg;
+			});
+	}
+
+	constexpr operator nv_path_view() const noexcept {
+		return (nv_path_view(__m_keys,
+				     std::span(__m_segments, __m_size)));
+	}
+
+	[[nodiscard]] constexpr std::size_t size() const noexcept {
+		return (__m_size);
+	}
+
+private:
+	char __m_keys[_N]{};
+	__detail::__path_segment __m_segments[_N]{};
+	std::size_t __m_size = 0;
+};
+
+namespace __detail {
+
+template<std::size_t _N>
+struct __path_literal {
+	consteval __path_literal(char const (&__s)[_N]) {
+		std::ranges::copy(__s, __data);
+	}
+
+	char __data[_N];
+};
+
+} // namespace bsd::__detail
+
+inline namespace nv_literals {
+
+/*
+ * "a.b[1].c"_nvpath is equivalent to nv_fixed_path("a.b[1].c").
+ */
+template<__detail::__path_literal _S>
+consteval auto
+operator""_nvpath()
+{
+	return (nv_fixed_path<sizeof(_S.__data)>(_S.__data));
+}
+
+} // inline namespace bsd::nv_literals
+
+/*
+ * get_many: look up several keys with a single pass over an nvlist.
+ *
+ * Each key is given as an nv_key<_T>, where _T is one of the types accepted
+ * by at<_T>(), and the result is a tuple of std::optional<_T>:
+ *
+ *	auto [host, port] = nvl.get_many(
+ *		bsd::nv_key<std::string_view>("host"),
+ *		bsd::nv_key<std::uint64_t>("port"));
+ *
+ * A key which does not exist, or which has a type other than _T, is returned
+ * as std::nullopt.  If the nvlist contains more than one pair with the same
+ * key, the first is used.
+ */
+
+template<typename _T>
+struct nv_key {
+	constexpr nv_key(std::string_view __key_) noexcept
+		: key(__key_)
+	{
+	}
+
+	std::string_view key;
+};
+
+namespace __detail {
+
+/*
+ * The nvlist type of each type returned by a get-like function.
+ */
+template<typename _T>
+inline constexpr int __type_of = NV_TYPE_NONE;
+
+template<> inline constexpr int __type_of<nullptr_t> = NV_TYPE_NULL;
+template<> inline constexpr int __type_of<bool> = NV_TYPE_BOOL;
+template<> inline constexpr int __type_of<std::uint64_t> = NV_TYPE_NUMBER;
+template<> inline constexpr int __type_of<std::string_view> = NV_TYPE_STRING;
+template<> inline constexpr int __type_of<const_nv_list> = NV_TYPE_NVLIST;
+template<> inline constexpr int __type_of<int> = NV_TYPE_DESCRIPTOR;
+template<> inline constexpr int __type_of<std::span<std::byte const>> =
+	NV_TYPE_BINARY;
+template<> inline constexpr int __type_of<std::span<bool const>> =
+	NV_TYPE_BOOL_ARRAY;
+template<> inline constexpr int __type_of<std::span<std::uint64_t const>> =
+	NV_TYPE_NUMBER_ARRAY;
+template<> inline constexpr int __type_of<std::vector<std::string_view>> =
+	NV_TYPE_STRING_ARRAY;
+template<> inline constexpr int __type_of<std::span<int const>> =
+	NV_TYPE_DESCRIPTOR_ARRAY;
+template<> inline constexpr int __type_of<std::vector<const_nv_list>> =
+	NV_TYPE_NVLIST_ARRAY;
+
+struct __field_ref {
+	std::string_view __key;
+	std::size_t __pos;		/* position in the argument list */
+	int __type = NV_TYPE_NONE;	/* the type of the pair, if found */
+	void const *__cookie = nullptr;	/* the pair, if found */
+};
+
+/*
+ * Find the pair for each field in a single pass over the nvlist.  The fields
+ * are reordered.
+ */
+void __find_many(::nvlist_t const *, std::span<__field_ref>);
+
+template<typename _T>
+std::optional<_T>
+__field_value(__field_ref const &__ref)
+{
+	if (__ref.__cookie == nullptr)
+		return {};
+
+	if constexpr (std::same_as<_T, nv_list_value_t>) {
+		return (__make_value(__ref.__type, __ref.__cookie));
+	} else {
+		if (__ref.__type != __type_of<_T>)
+			return {};
+		return (std::get<_T>(__make_value(__ref.__type,
+						  __ref.__cookie)));
+	}
+}
+
+template<typename... _Ts>
+auto
+__const_nv_list::get_many(nv_key<_Ts> const &...__fields) const
+	-> std::tuple<std::optional<_Ts>...>
+{
+	__throw_if_error();
+
+	constexpr auto __n = sizeof...(_Ts);
+	auto __pos = std::size_t{0};
+	auto __refs = std::array<__field_ref, __n>{
+		__field_ref{__fields.key, __pos++}...
+	};
+
+	for (auto const &__ref : __refs)
+		__check_string_null(__ref.__key,
+				    "nv_list keys may not contain NUL");
+
+	__find_many(__m_nv, __refs);
+
+	auto __by_pos = std::array<__field_ref const *, __n>{};
+	for (auto const &__ref : __refs)
+		__by_pos[__ref.__pos] = &__ref;
+
+	return ([&]<std::size_t... _Is>(std::index_sequence<_Is...>) {
+		return (std::tuple<std::optional<_Ts>...>(
+			__field_value<_Ts>(*__by_pos[_Is])...));
+	}(std::index_sequence_for<_Ts...>()));
+}
+
+} // namespace bsd::__detail
+
+} // namespace bsd
+
+#endif	/* !_NVXX_ACCESS_H_INCLUDED */
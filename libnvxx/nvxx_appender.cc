@@ -0,0 +1,292 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR MIT
+ * Refer to the file 'LICENSE' in the nvxx distribution for license terms.
+ */
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include "nvxx.h"
+
+namespace bsd {
+
+namespace {
+
+/*
+ * The nvlist functions for each element type.  free() releases an element
+ * which was never added to the nvlist.
+ */
+template<typename _E>
+struct ops;
+
+template<>
+struct ops<bool> {
+	static constexpr auto exists = ::nvlist_exists_bool_array;
+	static constexpr auto take = ::nvlist_take_bool_array;
+	static constexpr auto move = ::nvlist_move_bool_array;
+	static void free(bool) noexcept {}
+};
+
+template<>
+struct ops<std::uint64_t> {
+	static constexpr auto exists = ::nvlist_exists_number_array;
+	static constexpr auto take = ::nvlist_take_number_array;
+	static constexpr auto move = ::nvlist_move_number_array;
+	static void free(std::uint64_t) noexcept {}
+};
+
+template<>
+struct ops<char *> {
+	static constexpr auto exists = ::nvlist_exists_string_array;
+	static constexpr auto take = ::nvlist_take_string_array;
+	static constexpr auto move = ::nvlist_move_string_array;
+	static void free(char *str) noexcept { std::free(str); }
+};
+
+template<>
+struct ops<::nvlist_t *> {
+	static constexpr auto exists = ::nvlist_exists_nvlist_array;
+	static constexpr auto take = ::nvlist_take_nvlist_array;
+	static constexpr auto move = ::nvlist_move_nvlist_array;
+	static void free(::nvlist_t *nvl) noexcept { ::nvlist_destroy(nvl); }
+};
+
+template<>
+struct ops<int> {
+	static constexpr auto exists = ::nvlist_exists_descriptor_array;
+	static constexpr auto take = ::nvlist_take_descriptor_array;
+	static constexpr auto move = ::nvlist_move_descriptor_array;
+	static void free(int fd) noexcept { (void)::close(fd); }
+};
+
+[[noreturn]] void
+throw_errno(int err)
+{
+	throw std::system_error(std::error_code(err, std::generic_category()));
+}
+
+} // anonymous namespace
+
+template<typename _T>
+nv_array_appender<_T>::nv_array_appender(nv_list &nvl, std::string_view key)
+	: __m_nvl(&nvl)
+	, __m_key(key)
+{
+	if (__m_key.find('\0') != __m_key.npos)
+		throw std::runtime_error("nv_list keys may not contain NUL");
+}
+
+template<typename _T>
+nv_array_appender<_T>::~nv_array_appender()
+{
+	try {
+		flush();
+	} catch (...) {
+		// flush() has already released the buffer.
+	}
+}
+
+template<typename _T>
+std::size_t
+nv_array_appender<_T>::size() const noexcept
+{
+	return (__m_size);
+}
+
+template<typename _T>
+void
+nv_array_appender<_T>::reserve(std::size_t n)
+{
+	if (n <= __m_capacity)
+		return;
+
+	if (n > SIZE_MAX / sizeof(element_type))
+		throw_errno(ENOMEM);
+
+	auto *data = std::realloc(__m_data, n * sizeof(element_type));
+	if (data == nullptr)
+		throw_errno(ENOMEM);
+
+	__m_data = static_cast<element_type *>(data);
+	__m_capacity = n;
+}
+
+template<typename _T>
+void
+nv_array_appender<_T>::__push(element_type value)
+{
+	if (__m_size == __m_capacity) {
+		try {
+			reserve(__m_capacity == 0 ? 16 : __m_capacity * 2);
+		} catch (...) {
+			ops<element_type>::free(value);
+			throw;
+		}
+	}
+
+	__m_data[__m_size++] = value;
+}
+
+template<typename _T>
+void
+nv_array_appender<_T>::push_back(bool value)
+requires std::same_as<_T, bool>
+{
+	__push(value);
+}
+
+template<typename _T>
+void
+nv_array_appender<_T>::push_back(std::uint64_t value)
+requires std::same_as<_T, std::uint64_t>
+{
+	__push(value);
+}
+
+template<typename _T>
+void
+nv_array_appender<_T>::push_back(std::string_view value)
+requires std::same_as<_T, std::string>
+{
+	if (value.find('\0') != value.npos)
+		throw std::runtime_error(
+			"nv_list string values may not contain NUL");
+
+	auto *str = ::strndup(value.data(), value.size());
+	if (str == nullptr)
+		throw_errno(errno);
+
+	__push(str);
+}
+
+template<typename _T>
+void
+nv_array_appender<_T>::push_back(const_nv_list const &value)
+requires std::same_as<_T, nv_list>
+{
+	if (auto err = value.error(); err)
+		throw nv_error_state(err);
+
+	auto *nvl = ::nvlist_clone(value.ptr());
+	if (nvl == nullptr)
+		throw_errno(errno);
+
+	__push(nvl);
+}
+
+template<typename _T>
+void
+nv_array_appender<_T>::push_back(nv_list &&value)
+requires std::same_as<_T, nv_list>
+{
+	if (auto err = value.error(); err)
+		throw nv_error_state(err);
+
+	__push(std::move(value).release());
+}
+
+template<typename _T>
+void
+nv_array_appender<_T>::push_back(int value)
+requires std::same_as<_T, nv_fd>
+{
+	auto fd = ::dup(value);
+	if (fd == -1)
+		throw_errno(errno);
+
+	__push(fd);
+}
+
+template<typename _T>
+void
+nv_array_appender<_T>::push_back(nv_fd &&value)
+requires std::same_as<_T, nv_fd>
+{
+	__push(std::move(value).release());
+}
+
+template<typename _T>
+void
+nv_array_appender<_T>::__clear() noexcept
+{
+	for (auto i = std::size_t{0}; i < __m_size; ++i)
+		ops<element_type>::free(__m_data[i]);
+
+	std::free(__m_data);
+	__m_data = nullptr;
+	__m_size = __m_capacity = 0;
+}
+
+template<typename _T>
+void
+nv_array_appender<_T>::flush()
+{
+	using op = ops<element_type>;
+
+	if (__m_size == 0)
+		return;
+
+	// error() throws std::logic_error if the nv_list was moved from.
+	try {
+		if (auto err = __m_nvl->error(); err)
+			throw nv_error_state(err);
+	} catch (...) {
+		__clear();
+		throw;
+	}
+
+	auto *nvl = __m_nvl->ptr();
+	auto const *key = __m_key.c_str();
+
+	auto *data = std::exchange(__m_data, nullptr);
+	auto size = std::exchange(__m_size, 0);
+	__m_capacity = 0;
+
+	/*
+	 * If the array already exists, take it, extend it and put it back,
+	 * which copies only the elements being appended.
+	 */
+	if (op::exists(nvl, key)) {
+		auto nold = std::size_t{};
+		auto *old = op::take(nvl, key, &nold);
+		auto *joined = static_cast<element_type *>(
+			std::realloc(old, (nold + size) * sizeof(element_type)));
+
+		if (joined == nullptr) {
+			op::move(nvl, key, old, nold);
+			__m_data = data;
+			__m_size = __m_capacity = size;
+			__clear();
+			throw_errno(ENOMEM);
+		}
+
+		std::memcpy(joined + nold, data, size * sizeof(element_type));
+		std::free(data);
+		data = joined;
+		size += nold;
+	}
+
+	// nvlist_move_*_array() takes ownership even on failure.
+	op::move(nvl, key, data, size);
+
+	switch (auto err = ::nvlist_error(nvl)) {
+	case 0:
+		return;
+
+	case EEXIST:
+		throw nv_key_exists(__m_key);
+
+	default:
+		throw_errno(err);
+	}
+}
+
+template struct nv_array_appender<bool>;
+template struct nv_array_appender<std::uint64_t>;
+template struct nv_array_appender<std::string>;
+template struct nv_array_appender<nv_list>;
+template struct nv_array_appender<nv_fd>;
+
+} // namespace bsd
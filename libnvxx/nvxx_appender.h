@@ -0,0 +1,129 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR MIT
+ * Refer to the file 'LICENSE' in the nvxx distribution for license terms.
+ */
+
+#ifndef	_NVXX_APPENDER_H_INCLUDED
+#define _NVXX_APPENDER_H_INCLUDED
+
+#ifndef _NVXX_H_INCLUDED
+# error include <nvxx.h> instead of including this header directly
+#endif
+
+/*
+ * nv_array_appender: build an array in an nvlist one element at a time.
+ *
+ * nvlist_append_*_array() reallocates the array on every call, so building an
+ * array of n elements with the append_*_array() functions takes O(n^2) time.
+ * An nv_array_appender instead collects the elements in a buffer which grows
+ * geometrically, and adds them to the nvlist in one step with
+ * nvlist_move_*_array() when flush() is called or the appender is destroyed.
+ * If the key already holds an array of the same type, the new elements are
+ * appended to it.
+ *
+ * The type argument is the type of the array: bool, std::uint64_t,
+ * std::string, nv_list or nv_fd.
+ */
+
+namespace bsd {
+
+namespace __detail {
+
+template<typename _T>
+struct __appender_traits;
+
+template<>
+struct __appender_traits<bool> {
+	using element_type = bool;
+};
+
+template<>
+struct __appender_traits<std::uint64_t> {
+	using element_type = std::uint64_t;
+};
+
+template<>
+struct __appender_traits<std::string> {
+	using element_type = char *;
+};
+
+template<>
+struct __appender_traits<nv_list> {
+	using element_type = ::nvlist_t *;
+};
+
+template<>
+struct __appender_traits<nv_fd> {
+	using element_type = int;
+};
+
+} // namespace bsd::__detail
+
+template<typename _T>
+struct nv_array_appender {
+	using element_type = typename __detail::__appender_traits<_T>::element_type;
+
+	/*
+	 * Create an appender for the array with the given key.  The nv_list
+	 * must outlive the appender.
+	 */
+	nv_array_appender(nv_list &, std::string_view __key);
+
+	nv_array_appender(nv_array_appender const &) = delete;
+	nv_array_appender &operator=(nv_array_appender const &) = delete;
+
+	/*
+	 * Flush any buffered elements.  Since a destructor cannot throw, any
+	 * error is ignored, except that the nvlist may be left in the error
+	 * state; call flush() first to detect errors.
+	 */
+	~nv_array_appender();
+
+	/*
+	 * Buffer an element to be appended to the array.  Strings are copied,
+	 * nvlists are cloned unless moved, and descriptors are duplicated
+	 * unless moved.  On failure, throws std::system_error.
+	 */
+	void push_back(bool) requires std::same_as<_T, bool>;
+	void push_back(std::uint64_t) requires std::same_as<_T, std::uint64_t>;
+	void push_back(std::string_view) requires std::same_as<_T, std::string>;
+	void push_back(const_nv_list const &) requires std::same_as<_T, nv_list>;
+	void push_back(nv_list &&) requires std::same_as<_T, nv_list>;
+	void push_back(int) requires std::same_as<_T, nv_fd>;
+	void push_back(nv_fd &&) requires std::same_as<_T, nv_fd>;
+
+	/*
+	 * Make sure the buffer has space for at least the given number of
+	 * elements in total without reallocating.
+	 */
+	void reserve(std::size_t);
+
+	/*
+	 * Return the number of buffered elements.
+	 */
+	[[nodiscard]] std::size_t size() const noexcept;
+
+	/*
+	 * Add the buffered elements to the array in the nvlist.  If the
+	 * nvlist is in the error state, throws nv_error_state; if the nv_list
+	 * was moved from, throws std::logic_error; if the key exists with a
+	 * different type, throws nv_key_exists; on any other failure, throws
+	 * std::system_error.  The buffer is empty afterwards, even if an
+	 * exception was thrown.
+	 */
+	void flush();
+
+private:
+	void __push(element_type);
+	void __clear() noexcept;
+
+	nv_list *__m_nvl;
+	std::string __m_key;
+	element_type *__m_data = nullptr;
+	std::size_t __m_size = 0;
+	std::size_t __m_capacity = 0;
+};
+
+} // namespace bsd
+
+#endif	/* !_NVXX_APPENDER_H_INCLUDED */
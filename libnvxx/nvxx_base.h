@@ -14,6 +14,11 @@ namespace bsd {
 
 struct nv_list;
 struct const_nv_list;
+struct nv_frozen;
+struct nv_memory_usage;
+struct nv_path_view;
+struct nv_path_error;
+template<typename _T> struct nv_key;
 
 /*
  * Generic base error type.
@@ -70,38 +75,71 @@ struct nv_key_exists : nv_error {
 
 namespace __detail {
 
-enum struct __nvlist_owning {
-	__owning,
-	__non_owning
-};
+/*
+ * Helpers for operating on a single pair, given the cookie returned by
+ * nvlist_next().  Errors are left in the destination nvlist's error state.
+ */
+
+// add a copy of the pair's value to dst under the given key.
+void __copy_pair(::nvlist_t *__dst, char const *__key, int __type,
+		 void const *__cookie);
 
+// remove the pair from its nvlist and add its value to dst without copying.
+void __move_pair(::nvlist_t *__dst, char const *__key, int __type,
+		 void *__cookie);
+
+// remove the pair from its nvlist and free it.
+void __free_pair(int __type, void *__cookie);
+
+/*
+ * Out-of-line throw helpers for the inline accessors in nvxx_inline.h, so that
+ * the inlined code contains only the fast path and a call.
+ */
+[[noreturn, gnu::cold]] void __throw_null_nv_list();
+[[noreturn, gnu::cold]] void __throw_error_state(int);
+[[noreturn, gnu::cold]] void __throw_runtime_error(std::string_view);
+[[noreturn, gnu::cold]] void __throw_key_not_found(std::string_view);
+
+/*
+ * The handle types form a single, non-virtual chain:
+ *
+ *	__nv_list_base <- __const_nv_list <- const_nv_list
+ *	                                  <- __nv_list <- nv_list
+ *
+ * so that every handle is a single pointer, and const_nv_list is trivially
+ * copyable.  Ownership belongs to nv_list alone, which destroys the nvlist in
+ * its own destructor.
+ */
 struct __nv_list_base {
 protected:
 	friend struct bsd::const_nv_list;
 
-	__nv_list_base(int __flags = 0);
-	__nv_list_base(::nvlist_t *, __nvlist_owning);
-
-	__nv_list_base(__nv_list_base const &) = delete;
-	__nv_list_base(__nv_list_base &&) noexcept = delete;
+	constexpr __nv_list_base() noexcept = default;
+	explicit constexpr __nv_list_base(::nvlist_t *__nv) noexcept
+		: __m_nv(__nv)
+	{
+	}
 
-	__nv_list_base &operator=(__nv_list_base const &) = delete;
-	__nv_list_base &operator=(__nv_list_base &&) noexcept = delete;
+	__nv_list_base(__nv_list_base const &) noexcept = default;
+	__nv_list_base &operator=(__nv_list_base const &) noexcept = default;
 
-	~__nv_list_base();
-	void __free_nv() noexcept;
+	~__nv_list_base() = default;
 
 	void __throw_if_error() const;
 	void __throw_if_null() const;
 	void __check_string_null(std::string_view, std::string_view) const;
 
-	::nvlist_t *__m_nv{};
-	__nvlist_owning __m_owning;
+	::nvlist_t *__m_nv = nullptr;
 };
 
-struct __const_nv_list : virtual __nv_list_base {
+struct __const_nv_list : __nv_list_base {
 	friend struct __nv_list;
 
+protected:
+	using __nv_list_base::__nv_list_base;
+
+public:
+
 	/*
 	 * Write the contents of this nvlist to the given fd or file pointer in
 	 * a human-readable format suitable for debugging.
@@ -124,6 +162,19 @@ struct __const_nv_list : virtual __nv_list_base {
 	 */
 	[[nodiscard]] std::vector<std::byte> pack() const;
 
+	/*
+	 * Return an estimate of the heap memory used by this nvlist and
+	 * everything it contains, with a breakdown for each nested nvlist.
+	 * See nvxx_memory.h.
+	 */
+	[[nodiscard]] nv_memory_usage memory_usage() const;
+
+	/*
+	 * Return an nv_frozen containing an immutable copy of this nvlist,
+	 * optimised for lookups.  See nvxx_frozen.h.
+	 */
+	[[nodiscard]] nv_frozen freeze() const;
+
 	/*
 	 * Return the error code associated with this nvlist, if any, by
 	 * calling nvlist_error().
@@ -197,11 +248,40 @@ struct __const_nv_list : virtual __nv_list_base {
 	[[nodiscard]] auto get_string_array(std::string_view) const -> std::vector<std::string_view>;
 	[[nodiscard]] auto get_nvlist_array(std::string_view) const -> std::vector<const_nv_list>;
 	[[nodiscard]] auto get_descriptor_array(std::string_view) const -> std::span<int const>;
+
+	/* at */
+
+	/*
+	 * Return the value at the given path, which is converted to _T as
+	 * described in nvxx_access.h.  If the path does not exist or names a
+	 * value of the wrong type, returns an nv_path_error.  If this nvlist is
+	 * in the error state, throws nv_error_state.
+	 */
+	template<typename _T>
+	[[nodiscard]] auto at(nv_path_view) const
+		-> std::expected<_T, nv_path_error>;
+
+	/* get_many */
+
+	/*
+	 * Look up several keys with a single pass over the nvlist, and return
+	 * a tuple containing the value of each key, or std::nullopt if the key
+	 * does not exist or has the wrong type; see nvxx_access.h.  If this
+	 * nvlist is in the error state, throws nv_error_state.
+	 */
+	template<typename... _Ts>
+	[[nodiscard]] auto get_many(nv_key<_Ts> const &...) const
+		-> std::tuple<std::optional<_Ts>...>;
 };
 
-struct __nv_list : virtual __nv_list_base {
+struct __nv_list : __const_nv_list {
 	friend struct const_nv_list;
 
+protected:
+	using __const_nv_list::__const_nv_list;
+
+public:
+
 	/*
 	 * Set the error code on this nvlist to the given value.
 	 */
@@ -295,6 +375,10 @@ struct __nv_list : virtual __nv_list_base {
 	void append_string_array(std::string_view, std::string_view);
 	void append_nvlist_array(std::string_view, const_nv_list const &);
 	void append_descriptor_array(std::string_view, int);
+
+private:
+	template<typename _F>
+	void __add(std::string_view, _F &&);
 };
 
 } // namespace bsd::__detail
@@ -303,16 +387,13 @@ struct __nv_list : virtual __nv_list_base {
  * const_nv_list is an immutable, non-owning reference to an nvlist.
  * it will not free the nvlist_t on destruction.
  */
-struct const_nv_list final
-	: virtual __detail::__nv_list_base
-	, __detail::__const_nv_list
-{
+struct const_nv_list final : __detail::__const_nv_list {
 	/*
 	 * Default constructing a const_nv_list leaves it in the empty state;
 	 * it can be assigned to or destructed but no other operations are
 	 * valid.
 	 */
-	const_nv_list() noexcept;
+	constexpr const_nv_list() noexcept = default;
 
 	/*
 	 * Create an nv_list object that refers to an existing nvlist_t.  The
@@ -328,7 +409,7 @@ struct const_nv_list final
 	 * lifetime.  If the other nvlist is empty, this nvlist will also be
 	 * empty.
 	 */
-	const_nv_list(const_nv_list const &) noexcept;
+	const_nv_list(const_nv_list const &) noexcept = default;
 
 	/*
 	 * Cause this const_nv_list to refer to the same nvlist as the RHS.
@@ -336,7 +417,7 @@ struct const_nv_list final
 	 * lifetime.  If the RHS nvlist is empty, this nvlist will also be
 	 * empty.
 	 */
-	const_nv_list &operator=(const_nv_list const &) noexcept;
+	const_nv_list &operator=(const_nv_list const &) noexcept = default;
 	const_nv_list &operator=(nv_list const &) noexcept;
 
 	/*
@@ -351,11 +432,7 @@ struct const_nv_list final
  * nv_list is a mutable, owning reference to an nvlist.  it will free the
  * nvlist_t on destruction, invalidating any const_nv_lists created from it.
  */
-struct nv_list final
-	: virtual __detail::__nv_list_base
-	, __detail::__const_nv_list
-	, __detail::__nv_list
-{
+struct nv_list final : __detail::__nv_list {
 	/*
 	 * Create a new, empty nv_list.  On failure, throws std::system_error.
 	 * The flags argument is passed to nvlist_create().
@@ -386,6 +463,12 @@ struct nv_list final
 	 */
 	nv_list(nv_list &&) noexcept;
 
+	/*
+	 * Destroy the nvlist with nvlist_destroy(), unless this nv_list has
+	 * been moved from or released.
+	 */
+	~nv_list();
+
 	/*
 	 * Replace the wrapped nv_list with a copy of the RHS nv_list using
 	 * nvlist_clone().  On failure, throws std::system_error.
@@ -444,56 +527,147 @@ struct nv_list final
 	 */
 	[[nodiscard]] static auto recv(int __fd, int __flags = 0) -> nv_list;
 
+	/*
+	 * The range adders pass a contiguous range of the exact element type
+	 * straight to the C API.  Otherwise, the range is copied once into a
+	 * malloc()ed array which the nvlist takes ownership of; if it is not
+	 * sized, the array grows as the range is read.  Descriptors and
+	 * strings, which the C API copies anyway, are collected into a vector.
+	 */
+
 	void add_bool_range(std::string_view __key,
 			    std::ranges::range auto &&__value)
 	{
-		/*
-		 * since vector<bool> is not a contiguous_range,
-		 * we need to do two copies here.
-		 */
-
-		auto __v = std::vector<bool>(std::from_range, __value);
-		auto __p = std::make_unique<bool[]>(__v.size());
-		std::ranges::copy(__v, __p.get());
-		add_bool_array(__key, std::span(__p.get(), __v.size()));
+		using _R = decltype(__value);
+
+		if constexpr (__detail::__contiguous_range_of<_R, bool>) {
+			add_bool_array(__key, std::span<bool const>(__value));
+		} else if constexpr (std::ranges::sized_range<_R>) {
+			if (std::ranges::empty(__value))
+				return (add_bool_array(__key, {}));
+
+			// check first, so the array cannot leak.
+			__throw_if_error();
+			__check_string_null(__key,
+					    "nv_list keys may not contain NUL");
+			move_bool_array(__key,
+					__detail::__malloc_copy<bool>(__value));
+		} else {
+			__throw_if_error();
+			__check_string_null(__key,
+					    "nv_list keys may not contain NUL");
+			auto __arr = __detail::__malloc_collect<bool>(__value);
+			if (__arr.empty())
+				return (add_bool_array(__key, {}));
+			move_bool_array(__key, __arr);
+		}
 	}
 
 	void add_number_range(std::string_view __key,
 			      std::ranges::range auto &&__value)
 	{
-		auto __arr = std::vector<std::uint64_t>(
-					std::from_range, __value);
-		add_number_array(__key, __arr);
+		using _R = decltype(__value);
+
+		if constexpr (__detail::__contiguous_range_of<_R, std::uint64_t>) {
+			add_number_array(__key,
+					 std::span<std::uint64_t const>(__value));
+		} else if constexpr (std::ranges::sized_range<_R>) {
+			if (std::ranges::empty(__value))
+				return (add_number_array(__key, {}));
+
+			__throw_if_error();
+			__check_string_null(__key,
+					    "nv_list keys may not contain NUL");
+			move_number_array(__key,
+				__detail::__malloc_copy<std::uint64_t>(__value));
+		} else {
+			__throw_if_error();
+			__check_string_null(__key,
+					    "nv_list keys may not contain NUL");
+			auto __arr = __detail::__malloc_collect<std::uint64_t>(
+				__value);
+			if (__arr.empty())
+				return (add_number_array(__key, {}));
+			move_number_array(__key, __arr);
+		}
 	}
 
 	void add_descriptor_range(std::string_view __key,
 				  std::ranges::range auto &&__value)
 	{
-		auto __arr = std::vector<int>(std::from_range, __value);
-		add_descriptor_array(__key, __arr);
+		using _R = decltype(__value);
+
+		/*
+		 * nvlist_add_descriptor_array() duplicates the descriptors,
+		 * so there is no move path here.
+		 */
+		if constexpr (__detail::__contiguous_range_of<_R, int>) {
+			add_descriptor_array(__key, std::span<int const>(__value));
+		} else {
+			auto __arr = std::vector<int>(std::from_range, __value);
+			add_descriptor_array(__key, __arr);
+		}
 	}
 
 	void add_string_range(std::string_view __key,
 			      std::ranges::range auto &&__value)
 	{
-		auto __arr = std::vector<std::string_view>(
-				std::from_range, __value);
-		add_string_array(__key, __arr);
+		using _R = decltype(__value);
+
+		if constexpr (__detail::__contiguous_range_of<_R,
+						std::string_view>) {
+			add_string_array(__key,
+				std::span<std::string_view const>(__value));
+		} else {
+			auto __arr = std::vector<std::string_view>(
+					std::from_range, __value);
+			add_string_array(__key, __arr);
+		}
 	}
 
 	void add_binary_range(std::string_view __key,
 			      std::ranges::range auto &&__value)
 	{
-		auto __arr = std::vector<std::byte>(std::from_range, __value);
-		add_binary(__key, __arr);
+		using _R = decltype(__value);
+
+		if constexpr (__detail::__contiguous_range_of<_R, std::byte>) {
+			add_binary(__key, std::span<std::byte const>(__value));
+		} else if constexpr (std::ranges::sized_range<_R>) {
+			if (std::ranges::empty(__value))
+				return (add_binary(__key, {}));
+
+			__throw_if_error();
+			__check_string_null(__key,
+					    "nv_list keys may not contain NUL");
+			move_binary(__key,
+				    __detail::__malloc_copy<std::byte>(__value));
+		} else {
+			__throw_if_error();
+			__check_string_null(__key,
+					    "nv_list keys may not contain NUL");
+			auto __arr = __detail::__malloc_collect<std::byte>(
+				__value);
+			if (__arr.empty())
+				return (add_binary(__key, {}));
+			move_binary(__key, __arr);
+		}
 	}
 
 	void add_nvlist_range(std::string_view __key,
 			      std::ranges::range auto &&__value)
 	{
-		auto __arr = std::vector<const_nv_list>(
-				std::from_range, __value);
-		add_nvlist_array(__key, __arr);
+		using _R = decltype(__value);
+
+		if constexpr (__detail::__contiguous_range_of<_R, const_nv_list>) {
+			add_nvlist_array(__key,
+				std::span<const_nv_list const>(__value));
+		} else if constexpr (__detail::__contiguous_range_of<_R, nv_list>) {
+			add_nvlist_array(__key, std::span<nv_list const>(__value));
+		} else {
+			auto __arr = std::vector<const_nv_list>(
+					std::from_range, __value);
+			add_nvlist_array(__key, __arr);
+		}
 	}
 };
 
@@ -0,0 +1,413 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR MIT
+ * Refer to the file 'LICENSE' in the nvxx distribution for license terms.
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <unordered_set>
+
+#include "nvxx.h"
+
+namespace bsd {
+
+namespace {
+
+constexpr auto key_nul_error = "nv_list keys may not contain NUL";
+constexpr auto string_nul_error = "nv_list string values may not contain NUL";
+
+bool
+has_nul(std::string_view str)
+{
+	return (str.find('\0') != str.npos);
+}
+
+/*
+ * A NUL-terminated copy of a key.  Short keys are copied into an inline
+ * buffer with memccpy(), which finds a NUL in the same pass.
+ */
+struct key_copy {
+	explicit key_copy(std::string_view key) {
+		if (key.size() < sizeof(buf)) {
+			valid = ::memccpy(buf, key.data(), '\0',
+					  key.size()) == nullptr;
+			buf[key.size()] = '\0';
+			str = buf;
+		} else {
+			valid = !has_nul(key);
+			long_key.assign(key);
+			str = long_key.c_str();
+		}
+	}
+
+	key_copy(key_copy const &) = delete;
+	key_copy &operator=(key_copy const &) = delete;
+
+	char buf[128];
+	std::string long_key;
+	char const *str;
+	bool valid;
+};
+
+/*
+ * Compare keys as the destination nvlist of commit() will: without regard to
+ * case if it has NV_FLAG_IGNORE_CASE, as libnv does with strcasecmp().
+ */
+char
+fold(char c, bool ignore_case)
+{
+	if (ignore_case && c >= 'A' && c <= 'Z')
+		return (static_cast<char>(c - 'A' + 'a'));
+	return (c);
+}
+
+struct key_hash {
+	bool ignore_case;
+
+	std::size_t operator()(std::string_view key) const noexcept {
+		// FNV-1a
+		auto h = std::size_t{0xcbf29ce484222325};
+		for (auto c : key)
+			h = (h ^ static_cast<unsigned char>(
+				fold(c, ignore_case))) * 0x100000001b3;
+		return (h);
+	}
+};
+
+struct key_equal {
+	bool ignore_case;
+
+	bool operator()(std::string_view a, std::string_view b) const noexcept {
+		return (std::ranges::equal(a, b, [&] (char x, char y) {
+			return (fold(x, ignore_case) == fold(y, ignore_case));
+		}));
+	}
+};
+
+} // anonymous namespace
+
+nv_list_builder::nv_list_builder(int flags)
+	: __m_list(flags)
+{
+}
+
+nv_list_builder::nv_list_builder(nv_list_builder &&) noexcept = default;
+
+nv_list_builder &
+nv_list_builder::operator=(nv_list_builder &&) noexcept = default;
+
+nv_list_builder::~nv_list_builder() = default;
+
+nv_list_builder::operator bool() const noexcept
+{
+	return (static_cast<bool>(__m_list));
+}
+
+/*
+ * Record an error which libnv itself does not detect.  As in libnv, only the
+ * first error is kept, and putting the nvlist in the error state makes it
+ * ignore later values.
+ */
+void
+nv_list_builder::__fail(char const *what)
+{
+	auto *nvl = __m_list.ptr();
+
+	if (::nvlist_error(nvl) != 0)
+		return;
+
+	::nvlist_set_error(nvl, EINVAL);
+	__m_what = what;
+}
+
+void
+nv_list_builder::__throw_if_failed() const
+{
+	switch (auto err = __m_list.error().value()) {
+	case 0:
+		return;
+
+	case EEXIST:
+		// libnv doesn't record which key it was.
+		throw nv_key_exists(std::string());
+
+	default:
+		if (__m_what != nullptr)
+			throw std::runtime_error(__m_what);
+		throw std::system_error(
+			std::error_code(err, std::generic_category()));
+	}
+}
+
+/*
+ * Add a single value by calling __fn(nvlist, key).  Nothing is checked here
+ * except that the key has no NUL, which is found while it is copied: once
+ * the nvlist is in the error state libnv ignores further values, so the
+ * error is read once by build() or commit().
+ */
+template<typename _F>
+nv_list_builder &
+nv_list_builder::__add(std::string_view key, _F &&fn)
+{
+	auto k = key_copy(key);
+
+	if (!k.valid) [[unlikely]]
+		__fail(key_nul_error);
+	else
+		std::forward<_F>(fn)(__m_list.ptr(), k.str);
+
+	return (*this);
+}
+
+nv_list_builder &
+nv_list_builder::add_null(std::string_view key)
+{
+	return (__add(key, [] (::nvlist_t *nvl, char const *k) {
+		::nvlist_add_null(nvl, k);
+	}));
+}
+
+nv_list_builder &
+nv_list_builder::add_bool(std::string_view key, bool value)
+{
+	return (__add(key, [=] (::nvlist_t *nvl, char const *k) {
+		::nvlist_add_bool(nvl, k, value);
+	}));
+}
+
+nv_list_builder &
+nv_list_builder::add_number(std::string_view key, std::uint64_t value)
+{
+	return (__add(key, [=] (::nvlist_t *nvl, char const *k) {
+		::nvlist_add_number(nvl, k, value);
+	}));
+}
+
+nv_list_builder &
+nv_list_builder::add_string(std::string_view key, std::string_view value)
+{
+	auto k = key_copy(key);
+	if (!k.valid) [[unlikely]] {
+		__fail(key_nul_error);
+		return (*this);
+	}
+
+	/*
+	 * Copy the value and check it for NUL in one pass, and give the copy
+	 * to the nvlist rather than have it copy the value again.
+	 */
+	auto *nvl = __m_list.ptr();
+	auto *str = static_cast<char *>(std::malloc(value.size() + 1));
+	if (str == nullptr) {
+		::nvlist_set_error(nvl, ENOMEM);
+		return (*this);
+	}
+
+	if (::memccpy(str, value.data(), '\0', value.size()) != nullptr) {
+		std::free(str);
+		__fail(string_nul_error);
+		return (*this);
+	}
+
+	str[value.size()] = '\0';
+	// nvlist_move_string() takes ownership even on failure.
+	::nvlist_move_string(nvl, k.str, str);
+	return (*this);
+}
+
+nv_list_builder &
+nv_list_builder::add_nvlist(std::string_view key, const_nv_list const &value)
+{
+	return (__add(key, [&] (::nvlist_t *nvl, char const *k) {
+		::nvlist_add_nvlist(nvl, k, value.ptr());
+	}));
+}
+
+nv_list_builder &
+nv_list_builder::add_descriptor(std::string_view key, int value)
+{
+	return (__add(key, [=] (::nvlist_t *nvl, char const *k) {
+		::nvlist_add_descriptor(nvl, k, value);
+	}));
+}
+
+nv_list_builder &
+nv_list_builder::add_binary(std::string_view key,
+			    std::span<std::byte const> value)
+{
+	return (__add(key, [=] (::nvlist_t *nvl, char const *k) {
+		::nvlist_add_binary(nvl, k, value.data(), value.size());
+	}));
+}
+
+nv_list_builder &
+nv_list_builder::add_bool_array(std::string_view key,
+				std::span<bool const> value)
+{
+	return (__add(key, [=] (::nvlist_t *nvl, char const *k) {
+		::nvlist_add_bool_array(nvl, k, value.data(), value.size());
+	}));
+}
+
+nv_list_builder &
+nv_list_builder::add_number_array(std::string_view key,
+				  std::span<std::uint64_t const> value)
+{
+	return (__add(key, [=] (::nvlist_t *nvl, char const *k) {
+		::nvlist_add_number_array(nvl, k, value.data(), value.size());
+	}));
+}
+
+nv_list_builder &
+nv_list_builder::add_string_array(std::string_view key,
+				  std::span<std::string_view const> value)
+{
+	if (std::ranges::any_of(value, has_nul)) {
+		__fail(string_nul_error);
+		return (*this);
+	}
+
+	return (__add(key, [=] (::nvlist_t *nvl, char const *k) {
+		// nvlist_add_string_array expects NUL-terminated C strings.
+		auto strings = value
+			| __detail::construct<std::string>()
+			| std::ranges::to<std::vector>();
+
+		auto ptrs = strings
+			| std::views::transform(&std::string::c_str)
+			| std::ranges::to<std::vector>();
+
+		::nvlist_add_string_array(nvl, k, ptrs.data(), ptrs.size());
+	}));
+}
+
+nv_list_builder &
+nv_list_builder::add_nvlist_array(std::string_view key,
+				  std::span<const_nv_list const> value)
+{
+	return (__add(key, [=] (::nvlist_t *nvl, char const *k) {
+		auto ptrs = value
+			| std::views::transform(&const_nv_list::ptr)
+			| std::ranges::to<std::vector>();
+
+		::nvlist_add_nvlist_array(nvl, k, ptrs.data(), ptrs.size());
+	}));
+}
+
+nv_list_builder &
+nv_list_builder::add_descriptor_array(std::string_view key,
+				      std::span<int const> value)
+{
+	return (__add(key, [=] (::nvlist_t *nvl, char const *k) {
+		::nvlist_add_descriptor_array(nvl, k,
+					      value.data(), value.size());
+	}));
+}
+
+nv_list_builder &
+nv_list_builder::add(entry const &e)
+{
+	auto const &key = e.key;
+
+	return (std::visit([&] <typename _T> (_T const &value)
+				-> nv_list_builder & {
+		if constexpr (std::same_as<_T, nullptr_t>)
+			return (add_null(key));
+		else if constexpr (std::same_as<_T, bool>)
+			return (add_bool(key, value));
+		else if constexpr (std::same_as<_T, std::uint64_t>)
+			return (add_number(key, value));
+		else if constexpr (std::same_as<_T, std::string_view>)
+			return (add_string(key, value));
+		else if constexpr (std::same_as<_T, const_nv_list>)
+			return (add_nvlist(key, value));
+		else if constexpr (std::same_as<_T, std::span<std::byte const>>)
+			return (add_binary(key, value));
+		else if constexpr (std::same_as<_T, std::span<bool const>>)
+			return (add_bool_array(key, value));
+		else if constexpr (std::same_as<_T,
+						std::span<std::uint64_t const>>)
+			return (add_number_array(key, value));
+		else if constexpr (std::same_as<_T,
+					std::span<std::string_view const>>)
+			return (add_string_array(key, value));
+		else
+			return (add_nvlist_array(key, value));
+	}, e.value));
+}
+
+nv_list_builder &
+nv_list_builder::add(std::initializer_list<entry> entries)
+{
+	for (auto const &e : entries)
+		add(e);
+	return (*this);
+}
+
+nv_list
+nv_list_builder::build() &&
+{
+	__throw_if_failed();
+	return (std::move(__m_list));
+}
+
+void
+nv_list_builder::commit(nv_list &nvl) &&
+{
+	__throw_if_failed();
+
+	if (auto err = nvl.error(); err)
+		throw nv_error_state(err);
+
+	auto *dst = nvl.ptr();
+	auto *src = __m_list.ptr();
+	auto type = int{};
+	auto *cookie = static_cast<void *>(nullptr);
+
+	/*
+	 * Check every key before modifying the destination, so that a
+	 * duplicate key leaves it unchanged.  The keys of the builder are
+	 * checked against each other too, since the builder may have been
+	 * created with different flags from the destination.
+	 */
+	if (auto const flags = ::nvlist_flags(dst);
+	    !(flags & NV_FLAG_NO_UNIQUE)) {
+		auto const ignore_case = (flags & NV_FLAG_IGNORE_CASE) != 0;
+		auto keys = std::unordered_set<std::string_view,
+					       key_hash, key_equal>(
+			0, key_hash{ignore_case}, key_equal{ignore_case});
+
+		while (auto const *name = ::nvlist_next(dst, &type, &cookie))
+			keys.insert(name);
+
+		cookie = nullptr;
+		while (auto const *name = ::nvlist_next(src, &type, &cookie))
+			if (!keys.insert(name).second)
+				throw nv_key_exists(std::string(name));
+	}
+
+	cookie = nullptr;
+	auto const *name = ::nvlist_next(src, &type, &cookie);
+
+	while (name != nullptr) {
+		// find the next pair before this one is moved out of src
+		auto next_type = int{};
+		auto *next_cookie = cookie;
+		auto const *next_name = ::nvlist_next(src, &next_type,
+						      &next_cookie);
+
+		__detail::__move_pair(dst, name, type, cookie);
+
+		name = next_name;
+		type = next_type;
+		cookie = next_cookie;
+	}
+
+	if (auto err = ::nvlist_error(dst); err != 0)
+		throw std::system_error(
+			std::error_code(err, std::generic_category()));
+}
+
+} // namespace bsd
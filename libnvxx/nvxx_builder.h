@@ -0,0 +1,216 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR MIT
+ * Refer to the file 'LICENSE' in the nvxx distribution for license terms.
+ */
+
+#ifndef	_NVXX_BUILDER_H_INCLUDED
+#define _NVXX_BUILDER_H_INCLUDED
+
+#ifndef _NVXX_H_INCLUDED
+# error include <nvxx.h> instead of including this header directly
+#endif
+
+#include <initializer_list>
+#include <variant>
+
+/*
+ * nv_list_builder: build an nvlist from many values, and check for errors
+ * once at the end rather than after each value.
+ *
+ * The add functions do not throw (other than std::bad_alloc), and do no
+ * more than copy the key and add the value.  Instead, the first error is
+ * recorded, later values are ignored, and the error is thrown by build() or
+ * commit().  Values are added to a private nvlist, so commit() can check
+ * them all before it modifies the destination nvlist.
+ */
+
+namespace bsd {
+
+struct nv_list_builder {
+	/*
+	 * A key and a value of any type except a descriptor, for use with
+	 * the bulk add() functions.  An integer other than bool is added as
+	 * a number.
+	 */
+	struct entry {
+		using value_type = std::variant<
+			nullptr_t,
+			bool,
+			std::uint64_t,
+			std::string_view,
+			const_nv_list,
+			std::span<std::byte const>,
+			std::span<bool const>,
+			std::span<std::uint64_t const>,
+			std::span<std::string_view const>,
+			std::span<const_nv_list const>>;
+
+		entry(std::string_view __key_, nullptr_t)
+			: key(__key_), value(nullptr) {}
+
+		entry(std::string_view __key_, bool __value)
+			: key(__key_), value(__value) {}
+
+		template<std::integral _T>
+		requires (!std::same_as<_T, bool>)
+		entry(std::string_view __key_, _T __value)
+			: key(__key_)
+			, value(static_cast<std::uint64_t>(__value)) {}
+
+		entry(std::string_view __key_, std::string_view __value)
+			: key(__key_), value(__value) {}
+
+		entry(std::string_view __key_, char const *__value)
+			: key(__key_), value(std::string_view(__value)) {}
+
+		entry(std::string_view __key_, const_nv_list const &__value)
+			: key(__key_), value(__value) {}
+
+		entry(std::string_view __key_, nv_list const &__value)
+			: key(__key_), value(const_nv_list(__value)) {}
+
+		entry(std::string_view __key_,
+		      std::span<std::byte const> __value)
+			: key(__key_), value(__value) {}
+
+		entry(std::string_view __key_, std::span<bool const> __value)
+			: key(__key_), value(__value) {}
+
+		entry(std::string_view __key_,
+		      std::span<std::uint64_t const> __value)
+			: key(__key_), value(__value) {}
+
+		entry(std::string_view __key_,
+		      std::span<std::string_view const> __value)
+			: key(__key_), value(__value) {}
+
+		entry(std::string_view __key_,
+		      std::span<const_nv_list const> __value)
+			: key(__key_), value(__value) {}
+
+		std::string_view key;
+		value_type value;
+	};
+
+	/*
+	 * Create a builder for a new nvlist.  The flags argument is passed to
+	 * nvlist_create().  On failure, throws std::system_error.
+	 */
+	explicit nv_list_builder(int __flags = 0);
+
+	nv_list_builder(nv_list_builder const &) = delete;
+	nv_list_builder(nv_list_builder &&) noexcept;
+
+	nv_list_builder &operator=(nv_list_builder const &) = delete;
+	nv_list_builder &operator=(nv_list_builder &&) noexcept;
+
+	~nv_list_builder();
+
+	/*
+	 * Add a value.  These behave like the nv_list functions of the same
+	 * name, except that errors are deferred until build() or commit().
+	 */
+	nv_list_builder &add_null(std::string_view);
+	nv_list_builder &add_bool(std::string_view, bool);
+	nv_list_builder &add_number(std::string_view, std::uint64_t);
+	nv_list_builder &add_string(std::string_view, std::string_view);
+	nv_list_builder &add_nvlist(std::string_view, const_nv_list const &);
+	nv_list_builder &add_descriptor(std::string_view, int);
+	nv_list_builder &add_binary(std::string_view,
+				    std::span<std::byte const>);
+
+	nv_list_builder &add_bool_array(std::string_view,
+					std::span<bool const>);
+	nv_list_builder &add_number_array(std::string_view,
+					  std::span<std::uint64_t const>);
+	nv_list_builder &add_string_array(std::string_view,
+					  std::span<std::string_view const>);
+	nv_list_builder &add_nvlist_array(std::string_view,
+					  std::span<const_nv_list const>);
+	nv_list_builder &add_descriptor_array(std::string_view,
+					      std::span<int const>);
+
+	/*
+	 * Add a value of any type.
+	 */
+	nv_list_builder &add(entry const &);
+
+	/*
+	 * Add several values of any type, e.g.:
+	 *
+	 *	builder.add({ {"host", "alpha"}, {"port", 80} });
+	 */
+	nv_list_builder &add(std::initializer_list<entry>);
+
+	/*
+	 * Add each element of a tuple of key-value pairs, e.g.:
+	 *
+	 *	builder.add(std::tuple(std::pair("host", "alpha"),
+	 *			       std::pair("port", 80)));
+	 */
+	template<typename... _Ts>
+	nv_list_builder &add(std::tuple<_Ts...> const &__values) {
+		std::apply([this] (auto const &...__pairs) {
+			(add(entry(std::get<0>(__pairs),
+				   std::get<1>(__pairs))), ...);
+		}, __values);
+		return (*this);
+	}
+
+	/*
+	 * Add each element of a range of key-value pairs, such as a
+	 * std::map<std::string, std::uint64_t>.
+	 */
+	template<std::ranges::input_range _R>
+	nv_list_builder &add_range(_R &&__range) {
+		for (auto &&[__key, __value] : __range)
+			add(entry(__key, __value));
+		return (*this);
+	}
+
+	/*
+	 * Return true if no error has been recorded.
+	 */
+	[[nodiscard]] explicit operator bool() const noexcept;
+
+	/*
+	 * Return the built nvlist.  If an error was recorded, throws the
+	 * exception that the corresponding nv_list function would have thrown:
+	 * nv_key_exists for a duplicate key, std::runtime_error for a key or
+	 * string containing NUL, otherwise std::system_error.  libnv detects
+	 * a duplicate key without saying which it was, so the key member of
+	 * nv_key_exists is empty.
+	 *
+	 * The builder is left in a moved-from state.
+	 */
+	[[nodiscard]] nv_list build() &&;
+
+	/*
+	 * Add the built pairs to an existing nvlist.  The checks are done
+	 * before the nvlist is modified, so if an exception is thrown (as for
+	 * build(), or nv_key_exists if a key would appear twice in the
+	 * nvlist, as decided by its flags), the nvlist is unchanged.  The
+	 * exception is memory exhaustion while the pairs are being moved,
+	 * which leaves the nvlist with only some of the pairs and in the
+	 * error state.  If the nvlist is already in the error state, throws
+	 * nv_error_state.
+	 *
+	 * Each pair is moved, not copied, but commit() still allocates once
+	 * per pair; to build a new nvlist, use build() instead.
+	 */
+	void commit(nv_list &) &&;
+
+private:
+	void __fail(char const *__what);
+	void __throw_if_failed() const;
+
+	template<typename _F>
+	nv_list_builder &__add(std::string_view __key, _F &&__fn);
+
+	nv_list __m_list;
+	char const *__m_what = nullptr;
+};
+
+} // namespace bsd
+
+#endif	/* !_NVXX_BUILDER_H_INCLUDED */
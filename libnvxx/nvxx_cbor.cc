@@ -0,0 +1,439 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR MIT
+ * Refer to the file 'LICENSE' in the nvxx distribution for license terms.
+ */
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "nvxx.h"
+
+namespace bsd {
+
+namespace {
+
+// Maps nested more deeply than this are rejected.
+constexpr unsigned max_depth = 512;
+
+// The tag which marks self-described CBOR, which is ignored.
+constexpr std::uint64_t self_described = 55799;
+
+// The "break" stop code which ends an indefinite-length item.
+constexpr std::uint8_t stop = 0xff;
+
+// The major types, which are the top three bits of the initial byte.
+enum major_type : std::uint8_t {
+	major_unsigned	= 0,
+	major_negative	= 1,
+	major_bytes	= 2,
+	major_text	= 3,
+	major_array	= 4,
+	major_map	= 5,
+	major_tag	= 6,
+	major_simple	= 7,
+};
+
+/*
+ * The kinds of CBOR value which the parser distinguishes between.
+ */
+enum struct kind {
+	null, boolean, integer, negative, bytes, text, array, map,
+	unsupported,
+};
+
+/*
+ * The head of a data item.  For an indefinite-length item, argument is 0.
+ */
+struct head {
+	std::uint8_t	type;
+	bool		indefinite;
+	std::uint64_t	argument;
+};
+
+/*
+ * A recursive-descent parser which adds values to the nv_list as they are
+ * parsed.  Definite-length strings are passed to the nv_list directly from
+ * the input; indefinite-length strings are joined into a string owned by the
+ * parser first.
+ */
+struct parser {
+	std::span<std::byte const> data;
+	int flags;
+	std::size_t pos = 0;
+	unsigned depth = 0;
+	std::deque<std::string> joined = {};
+
+	[[noreturn]] void fail(std::string_view what) const {
+		throw nv_cbor_error(pos, what);
+	}
+
+	[[noreturn]] void fail_at(std::size_t at, std::string_view what) const {
+		throw nv_cbor_error(at, what);
+	}
+
+	std::size_t remaining() const noexcept {
+		return (data.size() - pos);
+	}
+
+	std::uint8_t peek() const {
+		if (remaining() == 0)
+			fail("unexpected end of input");
+		return (std::to_integer<std::uint8_t>(data[pos]));
+	}
+
+	std::uint8_t next() {
+		auto const c = peek();
+		++pos;
+		return (c);
+	}
+
+	// Consume the break stop code if it is next.
+	bool at_stop() {
+		if (peek() != stop)
+			return (false);
+		++pos;
+		return (true);
+	}
+
+	std::uint64_t be(unsigned size) {
+		if (remaining() < size)
+			fail("unexpected end of input");
+
+		auto value = std::uint64_t{0};
+		while (size-- > 0)
+			value = (value << 8)
+				| std::to_integer<std::uint64_t>(data[pos++]);
+		return (value);
+	}
+
+	std::span<std::byte const> bytes(std::uint64_t size) {
+		if (remaining() < size)
+			fail("unexpected end of input");
+
+		auto const ret = data.subspan(pos, size);
+		pos += size;
+		return (ret);
+	}
+
+	nv_list parse_document();
+	head parse_head();
+	kind peek_kind();
+	nv_list parse_map();
+	void parse_member(nv_list &, std::string_view key, std::size_t at);
+	void parse_array(nv_list &, std::string_view key);
+	std::span<std::byte const> parse_string(std::uint8_t type);
+	std::string_view parse_text();
+};
+
+nv_list
+parser::parse_document()
+{
+	if (remaining() == 0 || peek_kind() != kind::map)
+		fail("expected a map");
+
+	auto nvl = parse_map();
+
+	if (remaining() != 0)
+		fail("unexpected data after the map");
+
+	return (nvl);
+}
+
+head
+parser::parse_head()
+{
+	auto const start = pos;
+	auto const initial = next();
+	auto const type = static_cast<std::uint8_t>(initial >> 5);
+	auto const info = static_cast<std::uint8_t>(initial & 0x1f);
+
+	if (info < 24)
+		return {type, false, info};
+
+	if (info <= 27)
+		return {type, false, be(1u << (info - 24))};
+
+	if (info == 31) {
+		switch (type) {
+		case major_bytes:
+		case major_text:
+		case major_array:
+		case major_map:
+			return {type, true, 0};
+
+		case major_simple:
+			fail_at(start, "unexpected break");
+		}
+	}
+
+	fail_at(start, "invalid additional information");
+}
+
+/*
+ * Return the kind of the next value, skipping any self-described CBOR tags
+ * before it.
+ */
+kind
+parser::peek_kind()
+{
+	while ((peek() >> 5) == major_tag) {
+		auto const start = pos;
+		if (parse_head().argument != self_described)
+			fail_at(start, "tagged values cannot be stored "
+				"in an nvlist");
+	}
+
+	auto const initial = peek();
+	switch (initial >> 5) {
+	case major_unsigned:	return (kind::integer);
+	case major_negative:	return (kind::negative);
+	case major_bytes:	return (kind::bytes);
+	case major_text:	return (kind::text);
+	case major_array:	return (kind::array);
+	case major_map:		return (kind::map);
+	}
+
+	switch (initial) {
+	case 0xf4: case 0xf5:	return (kind::boolean);
+	case 0xf6:		return (kind::null);
+	default:		return (kind::unsupported);
+	}
+}
+
+nv_list
+parser::parse_map()
+{
+	if (++depth > max_depth)
+		fail("maps nested too deeply");
+
+	auto const h = parse_head();
+	auto nvl = nv_list(flags);
+
+	for (auto i = std::uint64_t{0}; h.indefinite || i < h.argument; ++i) {
+		if (h.indefinite && at_stop())
+			break;
+
+		auto const at = pos;
+		if (peek_kind() != kind::text)
+			fail("map keys must be text strings");
+
+		auto const key = parse_text();
+		if (key.find('\0') != key.npos)
+			fail_at(at, "nvlist keys may not contain NUL");
+
+		parse_member(nvl, key, at);
+	}
+
+	--depth;
+	return (nvl);
+}
+
+void
+parser::parse_member(nv_list &nvl, std::string_view key, std::size_t at)
+{
+	try {
+		switch (peek_kind()) {
+		case kind::null:
+			++pos;
+			nvl.add_null(key);
+			return;
+
+		case kind::boolean:
+			nvl.add_bool(key, next() == 0xf5);
+			return;
+
+		case kind::integer:
+			nvl.add_number(key, parse_head().argument);
+			return;
+
+		case kind::negative:
+			fail("negative integers cannot be stored in an nvlist");
+
+		case kind::text: {
+			auto const start = pos;
+			auto const str = parse_text();
+			if (str.find('\0') != str.npos)
+				fail_at(start, "nvlist strings may not "
+					"contain NUL");
+			nvl.add_string(key, str);
+			return;
+		}
+
+		case kind::bytes:
+			nvl.add_binary(key, parse_string(major_bytes));
+			return;
+
+		case kind::map:
+			nvl.move_nvlist(key, parse_map());
+			return;
+
+		case kind::array:
+			parse_array(nvl, key);
+			return;
+
+		case kind::unsupported:
+			fail("floats and simple values cannot be stored "
+			     "in an nvlist");
+		}
+	} catch (nv_key_exists const &) {
+		fail_at(at, "duplicate key");
+	}
+}
+
+void
+parser::parse_array(nv_list &nvl, std::string_view key)
+{
+	auto const h = parse_head();
+
+	if (h.indefinite ? at_stop() : h.argument == 0) {
+		nvl.add_number_array(key, {});
+		return;
+	}
+
+	/*
+	 * Each element is at least one byte, which bounds the size of the
+	 * vectors for a malicious count.
+	 */
+	if (!h.indefinite && h.argument > remaining())
+		fail("unexpected end of input");
+
+	/*
+	 * The type of the array is the type of its first element, and every
+	 * other element must have the same type.
+	 */
+	auto const type = peek_kind();
+	auto const size = static_cast<std::size_t>(h.argument);
+	auto numbers = std::vector<std::uint64_t>();
+	auto bools = std::vector<bool>();
+	auto strings = std::vector<std::string_view>();
+	auto lists = std::vector<nv_list>();
+
+	switch (type) {
+	case kind::integer:	numbers.reserve(size); break;
+	case kind::boolean:	bools.reserve(size); break;
+	case kind::text:	strings.reserve(size); break;
+	case kind::map:		lists.reserve(size); break;
+	default:		break;
+	}
+
+	for (auto i = std::size_t{0}; h.indefinite || i < size; ++i) {
+		if (h.indefinite && at_stop())
+			break;
+
+		auto const k = peek_kind();
+
+		if (k == kind::array)
+			fail("nested arrays cannot be stored in an nvlist");
+		if (k == kind::null)
+			fail("arrays containing null cannot be stored "
+			     "in an nvlist");
+		if (k == kind::bytes)
+			fail("arrays of byte strings cannot be stored "
+			     "in an nvlist");
+		if (k == kind::negative)
+			fail("negative integers cannot be stored in an nvlist");
+		if (k == kind::unsupported)
+			fail("floats and simple values cannot be stored "
+			     "in an nvlist");
+		if (k != type)
+			fail("arrays of mixed types cannot be stored "
+			     "in an nvlist");
+
+		switch (k) {
+		case kind::integer:
+			numbers.push_back(parse_head().argument);
+			break;
+
+		case kind::boolean:
+			bools.push_back(next() == 0xf5);
+			break;
+
+		case kind::text: {
+			auto const start = pos;
+			auto const str = parse_text();
+			if (str.find('\0') != str.npos)
+				fail_at(start, "nvlist strings may not "
+					"contain NUL");
+			strings.push_back(str);
+			break;
+		}
+
+		case kind::map:
+			lists.push_back(parse_map());
+			break;
+
+		default:
+			std::abort();
+		}
+	}
+
+	switch (type) {
+	case kind::map: {
+		// move the lists into the nvlist rather than copying them.
+		auto ptrs = __detail::__malloc_copy<::nvlist_t *>(
+			lists | std::views::transform([] (nv_list &l) {
+				return (std::move(l).release());
+			}));
+		nvl.move_nvlist_array(key, ptrs);
+		break;
+	}
+
+	case kind::text:
+		nvl.add_string_range(key, strings);
+		break;
+
+	case kind::boolean:
+		nvl.add_bool_range(key, bools);
+		break;
+
+	default:
+		nvl.add_number_array(key, numbers);
+		break;
+	}
+}
+
+/*
+ * Parse a byte or text string.  An indefinite-length string is a sequence of
+ * definite-length chunks of the same type, which are joined.
+ */
+std::span<std::byte const>
+parser::parse_string(std::uint8_t type)
+{
+	auto const h = parse_head();
+	if (!h.indefinite)
+		return (bytes(h.argument));
+
+	auto &str = joined.emplace_back();
+	while (!at_stop()) {
+		auto const start = pos;
+		auto const chunk = parse_head();
+		if (chunk.type != type || chunk.indefinite)
+			fail_at(start, "invalid chunk in an indefinite-length "
+				"string");
+
+		auto const data = bytes(chunk.argument);
+		str.append(reinterpret_cast<char const *>(data.data()),
+			   data.size());
+	}
+
+	return (std::as_bytes(std::span(str)));
+}
+
+std::string_view
+parser::parse_text()
+{
+	auto const str = parse_string(major_text);
+	return {reinterpret_cast<char const *>(str.data()), str.size()};
+}
+
+} // anonymous namespace
+
+nv_list
+nv_from_cbor(std::span<std::byte const> data, int flags)
+{
+	auto p = parser{.data = data, .flags = flags};
+	return (p.parse_document());
+}
+
+} // namespace bsd
@@ -0,0 +1,244 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR MIT
+ * Refer to the file 'LICENSE' in the nvxx distribution for license terms.
+ */
+
+#ifndef	_NVXX_CBOR_H_INCLUDED
+#define _NVXX_CBOR_H_INCLUDED
+
+#ifndef _NVXX_H_INCLUDED
+# error include <nvxx.h> instead of including this header directly
+#endif
+
+#include <cstdint>
+#include <iterator>
+
+/*
+ * CBOR (RFC 8949) import and export of nvlists.
+ *
+ * An nvlist is written as a CBOR map with text string keys, with its pairs in
+ * the order returned by nvlist_next().  Values are mapped as follows:
+ *
+ *	null			null
+ *	bool			true or false
+ *	number			an unsigned integer
+ *	string			a text string
+ *	nvlist			a map
+ *	descriptor		the descriptor number
+ *	binary			a byte string
+ *	arrays			an array of the above
+ *
+ * Only definite-length items are written, and integers and lengths are
+ * written in the shortest form which holds them.
+ *
+ * nv_from_cbor() performs the reverse mapping, except that descriptors cannot
+ * be distinguished from numbers.  Indefinite-length items are accepted, as is
+ * the self-described CBOR tag (55799).  Since an nvlist cannot store them,
+ * negative integers, floats, undefined and other simple values, other tags,
+ * maps with keys which are not text strings, arrays of mixed types, arrays
+ * containing null, byte strings or other arrays, and text strings containing
+ * NUL are rejected.  An empty array is stored as an empty number array.
+ */
+
+namespace bsd {
+
+/*
+ * nv_from_cbor() was given invalid CBOR, or CBOR which cannot be represented
+ * as an nvlist.  offset is the offset in the input of the error.
+ */
+struct nv_cbor_error : nv_error {
+	std::size_t offset;
+
+	nv_cbor_error(std::size_t __offset, std::string_view __what)
+		: nv_error("invalid CBOR at offset {0}: {1}", __offset, __what)
+		, offset(__offset)
+	{
+	}
+};
+
+namespace __detail {
+
+/*
+ * Write the head of a data item: the major type and an argument, which is
+ * the value of an integer or the size of a string, array or map.
+ */
+template<std::output_iterator<std::byte> _O>
+_O
+__cbor_head(unsigned __major, std::uint64_t __arg, _O __out)
+{
+	auto __size = 0u;
+	auto __info = __arg;
+
+	if (__arg > 0xffffffff) {
+		__size = 8;
+		__info = 27;
+	} else if (__arg > 0xffff) {
+		__size = 4;
+		__info = 26;
+	} else if (__arg > 0xff) {
+		__size = 2;
+		__info = 25;
+	} else if (__arg > 23) {
+		__size = 1;
+		__info = 24;
+	}
+
+	*__out++ = static_cast<std::byte>((__major << 5) | __info);
+	while (__size-- > 0)
+		*__out++ = static_cast<std::byte>(__arg >> (__size * 8));
+	return (__out);
+}
+
+template<std::output_iterator<std::byte> _O>
+_O
+__cbor_text(std::string_view __str, _O __out)
+{
+	__out = __cbor_head(3, __str.size(), std::move(__out));
+	return (std::ranges::copy(std::as_bytes(std::span(__str)),
+				  std::move(__out)).out);
+}
+
+template<std::output_iterator<std::byte> _O>
+_O __cbor_map(::nvlist_t const *, _O);
+
+template<std::output_iterator<std::byte> _O>
+_O
+__cbor_value(int __type, void const *__cookie, _O __out)
+{
+	auto __nitems = std::size_t{};
+
+	switch (__type) {
+	case NV_TYPE_NULL:
+		*__out++ = std::byte{0xf6};
+		return (__out);
+
+	case NV_TYPE_BOOL:
+		*__out++ = ::cnvlist_get_bool(__cookie)
+			? std::byte{0xf5} : std::byte{0xf4};
+		return (__out);
+
+	case NV_TYPE_NUMBER:
+		return (__cbor_head(0, ::cnvlist_get_number(__cookie),
+				    std::move(__out)));
+
+	case NV_TYPE_STRING:
+		return (__cbor_text(::cnvlist_get_string(__cookie),
+				    std::move(__out)));
+
+	case NV_TYPE_NVLIST:
+		return (__cbor_map(::cnvlist_get_nvlist(__cookie),
+				   std::move(__out)));
+
+	case NV_TYPE_DESCRIPTOR:
+		return (__cbor_head(0, static_cast<std::uint64_t>(
+			::cnvlist_get_descriptor(__cookie)), std::move(__out)));
+
+	case NV_TYPE_BINARY: {
+		auto const *__data = static_cast<std::byte const *>(
+			::cnvlist_get_binary(__cookie, &__nitems));
+		__out = __cbor_head(2, __nitems, std::move(__out));
+		return (std::ranges::copy(__data, __data + __nitems,
+					  std::move(__out)).out);
+	}
+
+	case NV_TYPE_BOOL_ARRAY: {
+		auto const *__data = ::cnvlist_get_bool_array(__cookie,
+							      &__nitems);
+		__out = __cbor_head(4, __nitems, std::move(__out));
+		for (auto __b : std::span(__data, __nitems))
+			*__out++ = __b ? std::byte{0xf5} : std::byte{0xf4};
+		return (__out);
+	}
+
+	case NV_TYPE_NUMBER_ARRAY: {
+		auto const *__data = ::cnvlist_get_number_array(__cookie,
+								&__nitems);
+		__out = __cbor_head(4, __nitems, std::move(__out));
+		for (auto __n : std::span(__data, __nitems))
+			__out = __cbor_head(0, __n, std::move(__out));
+		return (__out);
+	}
+
+	case NV_TYPE_STRING_ARRAY: {
+		auto const *__data = ::cnvlist_get_string_array(__cookie,
+								&__nitems);
+		__out = __cbor_head(4, __nitems, std::move(__out));
+		for (auto const *__s : std::span(__data, __nitems))
+			__out = __cbor_text(__s, std::move(__out));
+		return (__out);
+	}
+
+	case NV_TYPE_NVLIST_ARRAY: {
+		auto const *__data = ::cnvlist_get_nvlist_array(__cookie,
+								&__nitems);
+		__out = __cbor_head(4, __nitems, std::move(__out));
+		for (auto const *__nvl : std::span(__data, __nitems))
+			__out = __cbor_map(__nvl, std::move(__out));
+		return (__out);
+	}
+
+	case NV_TYPE_DESCRIPTOR_ARRAY: {
+		auto const *__data = ::cnvlist_get_descriptor_array(__cookie,
+								    &__nitems);
+		__out = __cbor_head(4, __nitems, std::move(__out));
+		for (auto __fd : std::span(__data, __nitems))
+			__out = __cbor_head(0, static_cast<std::uint64_t>(__fd),
+					    std::move(__out));
+		return (__out);
+	}
+
+	default:
+		std::abort();
+	}
+}
+
+template<std::output_iterator<std::byte> _O>
+_O
+__cbor_map(::nvlist_t const *__nvl, _O __out)
+{
+	void *__cookie = nullptr;
+	int __type;
+
+	// a definite-length map is prefixed with its size, so count the pairs.
+	auto __size = std::size_t{0};
+	while (::nvlist_next(__nvl, &__type, &__cookie) != nullptr)
+		++__size;
+
+	__out = __cbor_head(5, __size, std::move(__out));
+
+	__cookie = nullptr;
+	while (auto const *__key = ::nvlist_next(__nvl, &__type, &__cookie)) {
+		__out = __cbor_text(__key, std::move(__out));
+		__out = __cbor_value(__type, __cookie, std::move(__out));
+	}
+
+	return (__out);
+}
+
+} // namespace bsd::__detail
+
+/*
+ * Write the nvlist to the output iterator as a CBOR map, and return the
+ * iterator.  If the nvlist is in the error state, throws nv_error_state.
+ */
+template<std::output_iterator<std::byte> _O>
+_O
+nv_to_cbor(const_nv_list const &__nvl, _O __out)
+{
+	if (auto const __err = __nvl.error(); __err)
+		throw nv_error_state(__err);
+
+	return (__detail::__cbor_map(__nvl.ptr(), std::move(__out)));
+}
+
+/*
+ * Parse a CBOR map and return it as an nv_list created with the given flags.
+ * If the input is not valid CBOR, or cannot be represented as an nvlist,
+ * throws nv_cbor_error.  If the nvlist was not created with NV_FLAG_NO_UNIQUE,
+ * duplicate keys are an error.
+ */
+[[nodiscard]] nv_list nv_from_cbor(std::span<std::byte const>, int __flags = 0);
+
+} // namespace bsd
+
+#endif	/* !_NVXX_CBOR_H_INCLUDED */
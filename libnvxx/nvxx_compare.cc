@@ -0,0 +1,446 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR MIT
+ * Refer to the file 'LICENSE' in the nvxx distribution for license terms.
+ */
+
+#include <sys/endian.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <memory_resource>
+
+#include "nvxx.h"
+
+namespace bsd {
+
+namespace {
+
+/*
+ * Equality.
+ */
+
+struct pair_ref {
+	char const *name;
+	int type;
+	void *cookie;
+};
+
+bool
+pair_less(pair_ref const &a, pair_ref const &b)
+{
+	if (auto cmp = std::strcmp(a.name, b.name); cmp != 0)
+		return (cmp < 0);
+	return (a.type < b.type);
+}
+
+bool
+same_key(pair_ref const &a, pair_ref const &b)
+{
+	return (a.type == b.type && std::strcmp(a.name, b.name) == 0);
+}
+
+bool
+same_file(int a, int b)
+{
+	if (a == b)
+		return (true);
+
+	struct ::stat sa{}, sb{};
+	if (::fstat(a, &sa) == -1 || ::fstat(b, &sb) == -1)
+		return (false);
+
+	return (sa.st_dev == sb.st_dev && sa.st_ino == sb.st_ino);
+}
+
+bool lists_equal(::nvlist_t const *, ::nvlist_t const *);
+
+template<typename T>
+bool
+arrays_equal(T const *a, std::size_t na, T const *b, std::size_t nb)
+{
+	return (na == nb && std::memcmp(a, b, na * sizeof(T)) == 0);
+}
+
+bool
+values_equal(int type, void const *a, void const *b)
+{
+	auto na = std::size_t{}, nb = std::size_t{};
+
+	switch (type) {
+	case NV_TYPE_NULL:
+		return (true);
+
+	case NV_TYPE_BOOL:
+		return (::cnvlist_get_bool(a) == ::cnvlist_get_bool(b));
+
+	case NV_TYPE_NUMBER:
+		return (::cnvlist_get_number(a) == ::cnvlist_get_number(b));
+
+	case NV_TYPE_STRING:
+		return (std::strcmp(::cnvlist_get_string(a),
+				    ::cnvlist_get_string(b)) == 0);
+
+	case NV_TYPE_NVLIST:
+		return (lists_equal(::cnvlist_get_nvlist(a),
+				    ::cnvlist_get_nvlist(b)));
+
+	case NV_TYPE_DESCRIPTOR:
+		return (same_file(::cnvlist_get_descriptor(a),
+				  ::cnvlist_get_descriptor(b)));
+
+	case NV_TYPE_BINARY: {
+		auto const *da = static_cast<unsigned char const *>(
+				::cnvlist_get_binary(a, &na));
+		auto const *db = static_cast<unsigned char const *>(
+				::cnvlist_get_binary(b, &nb));
+		return (arrays_equal(da, na, db, nb));
+	}
+
+	case NV_TYPE_BOOL_ARRAY: {
+		auto const *da = ::cnvlist_get_bool_array(a, &na);
+		auto const *db = ::cnvlist_get_bool_array(b, &nb);
+		return (na == nb && std::equal(da, da + na, db));
+	}
+
+	case NV_TYPE_NUMBER_ARRAY: {
+		auto const *da = ::cnvlist_get_number_array(a, &na);
+		auto const *db = ::cnvlist_get_number_array(b, &nb);
+		return (arrays_equal(da, na, db, nb));
+	}
+
+	case NV_TYPE_STRING_ARRAY: {
+		auto const *da = ::cnvlist_get_string_array(a, &na);
+		auto const *db = ::cnvlist_get_string_array(b, &nb);
+		return (na == nb && std::equal(da, da + na, db,
+			[] (char const *x, char const *y) {
+				return (std::strcmp(x, y) == 0);
+			}));
+	}
+
+	case NV_TYPE_NVLIST_ARRAY: {
+		auto const *da = ::cnvlist_get_nvlist_array(a, &na);
+		auto const *db = ::cnvlist_get_nvlist_array(b, &nb);
+		return (na == nb && std::equal(da, da + na, db, lists_equal));
+	}
+
+	case NV_TYPE_DESCRIPTOR_ARRAY: {
+		auto const *da = ::cnvlist_get_descriptor_array(a, &na);
+		auto const *db = ::cnvlist_get_descriptor_array(b, &nb);
+		return (na == nb && std::equal(da, da + na, db, same_file));
+	}
+
+	default:
+		std::abort();
+	}
+}
+
+std::size_t
+count_pairs(::nvlist_t const *nvl)
+{
+	auto n = std::size_t{};
+	auto type = int{};
+	auto *cookie = static_cast<void *>(nullptr);
+
+	while (::nvlist_next(nvl, &type, &cookie) != nullptr)
+		++n;
+	return (n);
+}
+
+bool
+lists_equal(::nvlist_t const *a, ::nvlist_t const *b)
+{
+	if (a == b)
+		return (true);
+
+	auto n = count_pairs(a);
+	if (n != count_pairs(b))
+		return (false);
+
+	/*
+	 * Sort the pairs of both lists by key and type, then compare them in
+	 * order.  Most nvlists are small enough that this does not allocate.
+	 */
+	auto buf = std::array<std::byte, 2048>{};
+	auto mr = std::pmr::monotonic_buffer_resource(buf.data(), buf.size());
+
+	auto collect = [&] (::nvlist_t const *nvl) {
+		auto pairs = std::pmr::vector<pair_ref>(&mr);
+		pairs.reserve(n);
+
+		auto type = int{};
+		auto *cookie = static_cast<void *>(nullptr);
+		while (auto const *name = ::nvlist_next(nvl, &type, &cookie))
+			pairs.push_back({name, type, cookie});
+
+		std::ranges::sort(pairs, pair_less);
+		return (pairs);
+	};
+
+	auto pa = collect(a);
+	auto pb = collect(b);
+
+	for (auto i = std::size_t{}; i < n;) {
+		if (!same_key(pa[i], pb[i]))
+			return (false);
+
+		// find the run of pairs with this key and type
+		auto j = i + 1;
+		while (j < n && same_key(pa[i], pa[j]))
+			++j;
+
+		if (j < n && same_key(pa[i], pb[j]))
+			return (false);
+		if (!same_key(pa[i], pb[j - 1]))
+			return (false);
+
+		if (j - i == 1) {
+			if (!values_equal(pa[i].type, pa[i].cookie,
+					  pb[i].cookie))
+				return (false);
+			i = j;
+			continue;
+		}
+
+		/*
+		 * Duplicate keys (NV_FLAG_NO_UNIQUE) may appear in any order,
+		 * so match each value in a against an unused value in b.
+		 */
+		auto used = std::pmr::vector<bool>(j - i, false, &mr);
+		for (auto x = i; x < j; ++x) {
+			auto found = false;
+
+			for (auto y = i; y < j && !found; ++y) {
+				if (used[y - i] || !values_equal(pa[x].type,
+								 pa[x].cookie,
+								 pb[y].cookie))
+					continue;
+				used[y - i] = found = true;
+			}
+
+			if (!found)
+				return (false);
+		}
+
+		i = j;
+	}
+
+	return (true);
+}
+
+/*
+ * Hashing.  The mixing function and the byte hash follow the structure of
+ * wyhash: a 64x64->128 bit multiply folded back to 64 bits, consuming 16
+ * bytes per multiply.  All multi-byte reads are little-endian so that the
+ * hash does not depend on the host.
+ */
+
+constexpr std::uint64_t p0 = 0xa0761d6478bd642f;
+constexpr std::uint64_t p1 = 0xe7037ed1a0b428db;
+constexpr std::uint64_t p2 = 0x8ebc6af09c88c6e3;
+constexpr std::uint64_t p3 = 0x589965cc75374cc3;
+
+std::uint64_t
+mix(std::uint64_t a, std::uint64_t b)
+{
+	auto r = static_cast<unsigned __int128>(a) * b;
+	return (static_cast<std::uint64_t>(r)
+		^ static_cast<std::uint64_t>(r >> 64));
+}
+
+std::uint64_t
+hash_bytes(void const *data, std::size_t n, std::uint64_t seed)
+{
+	auto const *p = static_cast<unsigned char const *>(data);
+	auto a = std::uint64_t{}, b = std::uint64_t{};
+
+	seed ^= mix(seed ^ p0, p1);
+
+	if (n <= 16) {
+		if (n >= 4) {
+			auto off = (n >> 3) << 2;
+			a = (std::uint64_t{::le32dec(p)} << 32)
+				| ::le32dec(p + off);
+			b = (std::uint64_t{::le32dec(p + n - 4)} << 32)
+				| ::le32dec(p + n - 4 - off);
+		} else if (n > 0) {
+			a = (std::uint64_t{p[0]} << 16)
+				| (std::uint64_t{p[n >> 1]} << 8)
+				| p[n - 1];
+		}
+	} else {
+		auto i = n;
+		for (; i > 16; i -= 16, p += 16)
+			seed = mix(::le64dec(p) ^ p1, ::le64dec(p + 8) ^ seed);
+		a = ::le64dec(p + i - 16);
+		b = ::le64dec(p + i - 8);
+	}
+
+	a ^= p1;
+	b ^= seed;
+	return (mix(p1 ^ n, mix(a, b) ^ p2));
+}
+
+std::uint64_t
+hash_string(char const *str, std::uint64_t seed)
+{
+	return (hash_bytes(str, std::strlen(str), seed));
+}
+
+/*
+ * Arrays whose elements are hashed individually are combined in order.
+ */
+std::uint64_t
+combine(std::uint64_t h, std::uint64_t v)
+{
+	return (mix(h ^ p2, v ^ p3));
+}
+
+std::uint64_t
+hash_descriptor(int fd)
+{
+	struct ::stat sb{};
+	if (::fstat(fd, &sb) == -1)
+		return (mix(static_cast<std::uint64_t>(fd) ^ p0, p1));
+
+	return (mix(static_cast<std::uint64_t>(sb.st_dev) ^ p0,
+		    static_cast<std::uint64_t>(sb.st_ino) ^ p1));
+}
+
+std::uint64_t hash_list(::nvlist_t const *, std::uint64_t);
+
+std::uint64_t
+hash_value(int type, void *cookie, std::uint64_t seed)
+{
+	auto n = std::size_t{};
+	auto h = seed;
+
+	switch (type) {
+	case NV_TYPE_NULL:
+		return (0);
+
+	case NV_TYPE_BOOL:
+		return (::cnvlist_get_bool(cookie) ? 1 : 0);
+
+	case NV_TYPE_NUMBER:
+		return (::cnvlist_get_number(cookie));
+
+	case NV_TYPE_STRING:
+		return (hash_string(::cnvlist_get_string(cookie), seed));
+
+	case NV_TYPE_NVLIST:
+		return (hash_list(::cnvlist_get_nvlist(cookie), seed));
+
+	case NV_TYPE_DESCRIPTOR:
+		return (hash_descriptor(::cnvlist_get_descriptor(cookie)));
+
+	case NV_TYPE_BINARY: {
+		auto const *data = ::cnvlist_get_binary(cookie, &n);
+		return (hash_bytes(data, n, seed));
+	}
+
+	case NV_TYPE_BOOL_ARRAY: {
+		auto const *data = ::cnvlist_get_bool_array(cookie, &n);
+		static_assert(sizeof(bool) == 1);
+		return (hash_bytes(data, n, seed));
+	}
+
+	case NV_TYPE_NUMBER_ARRAY: {
+		auto const *data = ::cnvlist_get_number_array(cookie, &n);
+		/*
+		 * On little-endian hosts the array can be hashed in place;
+		 * elsewhere, hash a little-endian copy of it.
+		 */
+		if constexpr (std::endian::native == std::endian::little) {
+			return (hash_bytes(data, n * sizeof(*data), seed));
+		} else {
+			auto copy = std::vector<std::uint64_t>(n);
+			for (auto i = std::size_t{}; i < n; ++i)
+				::le64enc(&copy[i], data[i]);
+			return (hash_bytes(copy.data(),
+					   n * sizeof(*data), seed));
+		}
+	}
+
+	case NV_TYPE_STRING_ARRAY: {
+		auto const *data = ::cnvlist_get_string_array(cookie, &n);
+		for (auto const *str : std::span(data, n))
+			h = combine(h, hash_string(str, seed));
+		return (h);
+	}
+
+	case NV_TYPE_NVLIST_ARRAY: {
+		auto const *data = ::cnvlist_get_nvlist_array(cookie, &n);
+		for (auto const *nvl : std::span(data, n))
+			h = combine(h, hash_list(nvl, seed));
+		return (h);
+	}
+
+	case NV_TYPE_DESCRIPTOR_ARRAY: {
+		auto const *data = ::cnvlist_get_descriptor_array(cookie, &n);
+		for (auto fd : std::span(data, n))
+			h = combine(h, hash_descriptor(fd));
+		return (h);
+	}
+
+	default:
+		std::abort();
+	}
+}
+
+std::uint64_t
+hash_list(::nvlist_t const *nvl, std::uint64_t seed)
+{
+	/*
+	 * The pair hashes are summed, so the order of the pairs does not
+	 * affect the result.
+	 */
+	auto sum = std::uint64_t{};
+	auto n = std::uint64_t{};
+	auto type = int{};
+	auto *cookie = static_cast<void *>(nullptr);
+
+	while (auto const *name = ::nvlist_next(nvl, &type, &cookie)) {
+		auto key = hash_string(name, seed ^ static_cast<unsigned>(type));
+		sum += mix(key ^ p0, hash_value(type, cookie, seed) ^ p3);
+		++n;
+	}
+
+	return (mix(sum ^ p2, n ^ seed ^ p1));
+}
+
+::nvlist_t const *
+checked_ptr(const_nv_list const &nvl)
+{
+	if (auto err = nvl.error(); err)
+		throw nv_error_state(err);
+	return (nvl.ptr());
+}
+
+} // anonymous namespace
+
+namespace __detail {
+
+bool
+__value_equal(int type, void const *a, void const *b)
+{
+	return (values_equal(type, a, b));
+}
+
+} // namespace bsd::__detail
+
+bool
+operator==(const_nv_list const &a, const_nv_list const &b)
+{
+	return (lists_equal(checked_ptr(a), checked_ptr(b)));
+}
+
+std::uint64_t
+nv_hash(const_nv_list const &nvl, std::uint64_t seed)
+{
+	return (hash_list(checked_ptr(nvl), seed));
+}
+
+} // namespace bsd
@@ -0,0 +1,77 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR MIT
+ * Refer to the file 'LICENSE' in the nvxx distribution for license terms.
+ */
+
+#ifndef	_NVXX_COMPARE_H_INCLUDED
+#define _NVXX_COMPARE_H_INCLUDED
+
+#ifndef _NVXX_H_INCLUDED
+# error include <nvxx.h> instead of including this header directly
+#endif
+
+#include <cstdint>
+#include <functional>
+
+/*
+ * Deep comparison and hashing of nvlists.
+ */
+
+namespace bsd {
+
+namespace __detail {
+
+/*
+ * Compare the values of two pairs of the given type, given the cookies
+ * returned by nvlist_next(), as operator== does.
+ */
+bool __value_equal(int __type, void const *, void const *);
+
+} // namespace bsd::__detail
+
+/*
+ * Returns true if the two nvlists contain the same pairs, regardless of the
+ * order in which the pairs were added.  Two pairs are the same if they have
+ * the same key, type and value.  Nested nvlists are compared recursively;
+ * arrays, including nvlist arrays, are compared element by element in order.
+ * Two descriptors are equal if they refer to the same file, as determined by
+ * fstat(2).  The flags of the nvlists are not compared.
+ *
+ * If either nvlist is in the error state, throws nv_error_state.
+ */
+[[nodiscard]] bool operator==(const_nv_list const &, const_nv_list const &);
+
+/*
+ * Return a 64-bit hash of the contents of the nvlist.  Nvlists which compare
+ * equal with operator== have the same hash.  The hash does not depend on the
+ * order of the pairs in the nvlist, the host byte order, or the process, so
+ * it may be stored or sent to other hosts; however, descriptors are hashed by
+ * their device and inode numbers, which are only meaningful on the local
+ * host.
+ *
+ * If the nvlist is in the error state, throws nv_error_state.
+ */
+[[nodiscard]] std::uint64_t nv_hash(const_nv_list const &,
+				    std::uint64_t __seed = 0);
+
+} // namespace bsd
+
+/*
+ * Allow nvlists to be used as keys in unordered containers.
+ */
+
+template<>
+struct std::hash<bsd::const_nv_list> {
+	std::size_t operator()(bsd::const_nv_list const &__nvl) const {
+		return (static_cast<std::size_t>(bsd::nv_hash(__nvl)));
+	}
+};
+
+template<>
+struct std::hash<bsd::nv_list> {
+	std::size_t operator()(bsd::nv_list const &__nvl) const {
+		return (static_cast<std::size_t>(bsd::nv_hash(__nvl)));
+	}
+};
+
+#endif	/* !_NVXX_COMPARE_H_INCLUDED */
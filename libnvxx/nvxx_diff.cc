@@ -0,0 +1,302 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR MIT
+ * Refer to the file 'LICENSE' in the nvxx distribution for license terms.
+ */
+
+#include <unordered_map>
+
+#include "nvxx.h"
+
+namespace bsd {
+
+namespace {
+
+constexpr auto set_key = "set";
+constexpr auto remove_key = "remove";
+constexpr auto patch_key = "patch";
+
+void
+throw_if_error(::nvlist_t const *nvl)
+{
+	if (auto err = ::nvlist_error(nvl); err != 0)
+		throw std::system_error(
+			std::error_code(err, std::generic_category()));
+}
+
+::nvlist_t const *
+checked_ptr(const_nv_list const &nvl)
+{
+	if (auto err = nvl.error(); err)
+		throw nv_error_state(err);
+	return (nvl.ptr());
+}
+
+std::size_t
+count_pairs(::nvlist_t const *nvl)
+{
+	auto n = std::size_t{};
+	auto type = int{};
+	auto *cookie = static_cast<void *>(nullptr);
+
+	while (::nvlist_next(nvl, &type, &cookie) != nullptr)
+		++n;
+	return (n);
+}
+
+nv_list
+diff(::nvlist_t const *oldp, ::nvlist_t const *newp)
+{
+	if ((::nvlist_flags(oldp) | ::nvlist_flags(newp)) & NV_FLAG_NO_UNIQUE)
+		throw std::invalid_argument("nv_diff: nvlists with "
+					    "NV_FLAG_NO_UNIQUE are not supported");
+
+	struct old_pair {
+		int type;
+		void const *cookie;
+		bool seen;
+	};
+
+	/*
+	 * Index the old nvlist by key, so each key in the new nvlist can be
+	 * found in constant time rather than with nvlist_exists().
+	 */
+	auto index = std::unordered_map<std::string_view, old_pair>();
+	index.reserve(count_pairs(oldp));
+
+	auto type = int{};
+	auto *cookie = static_cast<void *>(nullptr);
+
+	while (auto const *name = ::nvlist_next(oldp, &type, &cookie))
+		index.emplace(name, old_pair{type, cookie, false});
+
+	auto set = nv_list();
+	auto patches = nv_list();
+	auto removed = std::vector<std::string_view>();
+
+	cookie = nullptr;
+	while (auto const *name = ::nvlist_next(newp, &type, &cookie)) {
+		auto it = index.find(name);
+
+		if (it != index.end()) {
+			auto &old = it->second;
+			old.seen = true;
+
+			if (old.type == type && type == NV_TYPE_NVLIST) {
+				auto child = diff(::cnvlist_get_nvlist(old.cookie),
+						  ::cnvlist_get_nvlist(cookie));
+				if (!child.empty())
+					patches.move_nvlist(name, std::move(child));
+				continue;
+			}
+
+			if (old.type == type
+			    && __detail::__value_equal(type, old.cookie, cookie))
+				continue;
+		}
+
+		__detail::__copy_pair(set.ptr(), name, type, cookie);
+	}
+
+	throw_if_error(set.ptr());
+
+	// walk the old nvlist rather than the index to keep the key order.
+	cookie = nullptr;
+	while (auto const *name = ::nvlist_next(oldp, &type, &cookie))
+		if (!index.at(name).seen)
+			removed.push_back(name);
+
+	auto patch = nv_list();
+
+	if (!set.empty())
+		patch.move_nvlist(set_key, std::move(set));
+	if (!removed.empty())
+		patch.add_string_array(remove_key, removed);
+	if (!patches.empty())
+		patch.move_nvlist(patch_key, std::move(patches));
+
+	return (patch);
+}
+
+/*
+ * The three parts of a patch, any of which may be absent.
+ */
+struct patch_parts {
+	::nvlist_t const *set = nullptr;
+	::nvlist_t const *patches = nullptr;
+	std::span<char const * const> removed;
+};
+
+patch_parts
+split_patch(::nvlist_t const *patch)
+{
+	auto parts = patch_parts{};
+	auto type = int{};
+	auto *cookie = static_cast<void *>(nullptr);
+
+	while (auto const *name = ::nvlist_next(patch, &type, &cookie)) {
+		auto key = std::string_view(name);
+
+		if (key == set_key && type == NV_TYPE_NVLIST)
+			parts.set = ::cnvlist_get_nvlist(cookie);
+		else if (key == patch_key && type == NV_TYPE_NVLIST)
+			parts.patches = ::cnvlist_get_nvlist(cookie);
+		else if (key == remove_key && type == NV_TYPE_STRING_ARRAY) {
+			auto nremoved = std::size_t{};
+			auto const *removed = ::cnvlist_get_string_array(
+				cookie, &nremoved);
+			parts.removed = std::span(removed, nremoved);
+		} else
+			throw nv_patch_invalid(
+				std::format("unexpected key \"{}\"", key));
+	}
+
+	return (parts);
+}
+
+/*
+ * Check that the patch is well-formed and that every nested patch names an
+ * nvlist, without modifying nvl, so that apply() cannot fail part way
+ * through for either reason.  As in apply(), a nested patch applies to the
+ * first pair with its name.
+ */
+void
+check(::nvlist_t const *nvl, ::nvlist_t const *patch)
+{
+	auto const parts = split_patch(patch);
+	if (parts.patches == nullptr)
+		return;
+
+	struct first_pair {
+		int type;
+		void *cookie;
+	};
+
+	auto index = std::unordered_map<std::string_view, first_pair>();
+	auto type = int{};
+	auto *cookie = static_cast<void *>(nullptr);
+
+	while (auto const *name = ::nvlist_next(nvl, &type, &cookie))
+		index.emplace(name, first_pair{type, cookie});
+
+	cookie = nullptr;
+	while (auto const *name = ::nvlist_next(parts.patches, &type,
+						&cookie)) {
+		if (type != NV_TYPE_NVLIST)
+			throw nv_patch_invalid(std::format(
+				"patch for \"{}\" is not an nvlist", name));
+
+		auto it = index.find(name);
+		if (it == index.end() || it->second.type != NV_TYPE_NVLIST)
+			throw nv_key_not_found(std::string(name));
+
+		check(::cnvlist_get_nvlist(it->second.cookie),
+		      ::cnvlist_get_nvlist(cookie));
+	}
+}
+
+/*
+ * Apply a patch which has been checked by check().
+ */
+void
+apply(::nvlist_t *nvl, ::nvlist_t const *patch)
+{
+	auto const parts = split_patch(patch);
+
+	enum struct action { free, patch };
+
+	struct target {
+		action act;
+		::nvlist_t const *patch;
+		bool seen;
+	};
+
+	/*
+	 * Index the keys named by the patch, then make a single pass over the
+	 * nvlist.  Both removed and replaced keys are freed here; the new
+	 * values are added afterwards.
+	 */
+	auto index = std::unordered_map<std::string_view, target>();
+	auto type = int{};
+	auto *cookie = static_cast<void *>(nullptr);
+
+	for (auto const *key : parts.removed)
+		index.insert_or_assign(key, target{action::free, nullptr, false});
+
+	if (parts.set != nullptr) {
+		while (auto const *name = ::nvlist_next(parts.set, &type,
+							&cookie))
+			index.insert_or_assign(name,
+				target{action::free, nullptr, false});
+	}
+
+	if (parts.patches != nullptr) {
+		cookie = nullptr;
+		while (auto const *name = ::nvlist_next(parts.patches, &type,
+							&cookie))
+			index.insert_or_assign(name, target{action::patch,
+				::cnvlist_get_nvlist(cookie), false});
+	}
+
+	cookie = nullptr;
+	auto const *name = ::nvlist_next(nvl, &type, &cookie);
+
+	while (name != nullptr) {
+		// find the next pair before we free this one
+		auto next_type = int{};
+		auto *next_cookie = cookie;
+		auto const *next_name = ::nvlist_next(nvl, &next_type,
+						      &next_cookie);
+
+		if (auto it = index.find(name); it != index.end()
+		    && !it->second.seen) {
+			auto &tgt = it->second;
+			tgt.seen = true;
+
+			if (tgt.act == action::free) {
+				__detail::__free_pair(type, cookie);
+			} else {
+				/*
+				 * Patch the nested nvlist in place, so that
+				 * it is never detached from nvl.
+				 */
+				auto *child = const_cast<::nvlist_t *>(
+					::cnvlist_get_nvlist(cookie));
+				apply(child, tgt.patch);
+			}
+		}
+
+		name = next_name;
+		type = next_type;
+		cookie = next_cookie;
+	}
+
+	if (parts.set != nullptr) {
+		cookie = nullptr;
+		while (auto const *sname = ::nvlist_next(parts.set, &type,
+							 &cookie))
+			__detail::__copy_pair(nvl, sname, type, cookie);
+	}
+
+	throw_if_error(nvl);
+}
+
+} // anonymous namespace
+
+nv_list
+nv_diff(const_nv_list const &oldl, const_nv_list const &newl)
+{
+	return (diff(checked_ptr(oldl), checked_ptr(newl)));
+}
+
+void
+nv_apply(nv_list &nvl, const_nv_list const &patch)
+{
+	if (auto err = nvl.error(); err)
+		throw nv_error_state(err);
+
+	auto const *patchp = checked_ptr(patch);
+	check(nvl.ptr(), patchp);
+	apply(nvl.ptr(), patchp);
+}
+
+} // namespace bsd
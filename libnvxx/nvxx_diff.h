@@ -0,0 +1,65 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR MIT
+ * Refer to the file 'LICENSE' in the nvxx distribution for license terms.
+ */
+
+#ifndef	_NVXX_DIFF_H_INCLUDED
+#define _NVXX_DIFF_H_INCLUDED
+
+#ifndef _NVXX_H_INCLUDED
+# error include <nvxx.h> instead of including this header directly
+#endif
+
+/*
+ * nv_diff: compute the difference between two nvlists as a patch, which can
+ * later be applied to the first nvlist to produce the second.
+ *
+ * A patch is itself an nvlist, so it can be packed and sent like any other.
+ * It contains up to three keys:
+ *
+ *   "set"	an nvlist of pairs which were added or whose value changed;
+ *   "remove"	a string array of keys which were removed;
+ *   "patch"	an nvlist mapping the key of each nested nvlist which exists
+ *		in both nvlists but differs to a patch for that nvlist.
+ *
+ * Keys with no entries are omitted, so an empty patch means the nvlists are
+ * equal.
+ */
+
+namespace bsd {
+
+/*
+ * An nvlist passed to nv_apply() is not a valid patch.
+ */
+struct nv_patch_invalid : nv_error {
+	nv_patch_invalid(std::string_view __what)
+		: nv_error("invalid nvlist patch: {0}", __what)
+	{
+	}
+};
+
+/*
+ * Return a patch which transforms __old into __new.  Values are compared as
+ * by operator==.  This runs in time linear in the size of both nvlists.
+ *
+ * Keys are assumed to be unique; if either nvlist was created with
+ * NV_FLAG_NO_UNIQUE, throws std::invalid_argument.  If either nvlist is in
+ * the error state, throws nv_error_state.
+ */
+[[nodiscard]] nv_list nv_diff(const_nv_list const &__old,
+			      const_nv_list const &__new);
+
+/*
+ * Apply a patch returned by nv_diff() to the given nvlist in place.  Keys
+ * named in "remove" which do not exist are ignored.  If a key named in
+ * "patch" does not exist or is not an nvlist, throws nv_key_not_found; if the
+ * patch is malformed, throws nv_patch_invalid.  The patch is checked before
+ * the nvlist is modified, so in either case the nvlist is unchanged.  If
+ * another error occurs, throws std::system_error, and the nvlist may have
+ * been partially patched.
+ */
+void nv_apply(nv_list &, const_nv_list const &__patch);
+
+} // namespace bsd
+
+#endif	/* !_NVXX_DIFF_H_INCLUDED */
@@ -0,0 +1,924 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR MIT
+ * Refer to the file 'LICENSE' in the nvxx distribution for license terms.
+ */
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+
+#include <fcntl.h>
+
+#include "nvxx.h"
+
+namespace bsd {
+
+namespace {
+
+using __detail::__frozen_entry;
+using __detail::__frozen_list;
+
+constexpr std::size_t cache_line = 64;
+
+static_assert(sizeof(__frozen_entry) == 32 || sizeof(void *) != 8);
+static_assert(std::is_trivially_copyable_v<const_nv_frozen>);
+
+/*
+ * Key hashing and comparison.  If the source nvlist was created with
+ * NV_FLAG_IGNORE_CASE, keys are compared case-insensitively, as libnv does.
+ */
+
+unsigned char
+fold(char c, bool ignore_case)
+{
+	auto u = static_cast<unsigned char>(c);
+	if (ignore_case && u >= 'A' && u <= 'Z')
+		u += 'a' - 'A';
+	return (u);
+}
+
+std::uint64_t
+key_hash(std::string_view key, bool ignore_case)
+{
+	// FNV-1a; keys are short, so this is cheaper than anything fancier.
+	auto h = std::uint64_t{0xcbf29ce484222325};
+	for (auto c : key) {
+		h ^= fold(c, ignore_case);
+		h *= 0x100000001b3;
+	}
+	return (h);
+}
+
+int
+key_compare(std::string_view a, std::string_view b, bool ignore_case)
+{
+	if (!ignore_case)
+		return (a.compare(b));
+
+	auto n = std::min(a.size(), b.size());
+	for (auto i = std::size_t{0}; i < n; ++i) {
+		auto ca = fold(a[i], true), cb = fold(b[i], true);
+		if (ca != cb)
+			return (ca < cb ? -1 : 1);
+	}
+
+	if (a.size() == b.size())
+		return (0);
+	return (a.size() < b.size() ? -1 : 1);
+}
+
+std::string_view
+entry_key(__frozen_entry const &entry)
+{
+	return {entry.__key, entry.__keylen};
+}
+
+/*
+ * Build a frozen list.  This runs twice: once with a null base to measure
+ * the size of the block, and again to fill it in.  While measuring, every
+ * allocation returns nullptr and nothing is written.
+ */
+struct freezer {
+	std::byte *base = nullptr;
+	std::size_t offset = 0;
+	std::vector<int> *fds = nullptr;
+	std::size_t nfds = 0;
+
+	bool measuring() const {
+		return (base == nullptr);
+	}
+
+	template<typename T>
+	T *alloc(std::size_t n, std::size_t align = alignof(T)) {
+		offset = (offset + align - 1) & ~(align - 1);
+		auto *ptr = measuring() ? nullptr
+			: reinterpret_cast<T *>(base + offset);
+		offset += n * sizeof(T);
+		return (ptr);
+	}
+
+	template<typename T>
+	T const *copy_array(T const *data, std::size_t n) {
+		auto *ptr = alloc<T>(n);
+		if (ptr != nullptr)
+			std::uninitialized_copy_n(data, n, ptr);
+		return (ptr);
+	}
+
+	char const *copy_string(char const *str, std::size_t len) {
+		auto *ptr = alloc<char>(len + 1);
+		if (ptr != nullptr)
+			std::memcpy(ptr, str, len + 1);
+		return (ptr);
+	}
+
+	/*
+	 * The measuring pass counts the descriptors, so that fds can be
+	 * reserved once beforehand and push_back() cannot throw and leak the
+	 * new descriptor.
+	 */
+	int dup_fd(int fd) {
+		if (measuring()) {
+			++nfds;
+			return (-1);
+		}
+
+		assert(fds->size() < fds->capacity());
+		auto newfd = ::fcntl(fd, F_DUPFD_CLOEXEC, 0);
+		if (newfd == -1)
+			throw std::system_error(
+				std::error_code(errno, std::system_category()));
+		fds->push_back(newfd);
+		return (newfd);
+	}
+
+	__frozen_list const *freeze(::nvlist_t const *);
+	void freeze_value(__frozen_entry &, int, void *);
+};
+
+__frozen_list const *
+freezer::freeze(::nvlist_t const *nvl)
+{
+	auto type = int{};
+	auto *cookie = static_cast<void *>(nullptr);
+
+	auto n = std::size_t{};
+	while (::nvlist_next(nvl, &type, &cookie) != nullptr)
+		++n;
+
+	// keep the hash table at most half full
+	auto slots = std::bit_ceil(std::max(n * 2, std::size_t{1}));
+
+	auto *list = alloc<__frozen_list>(1, cache_line);
+	auto *entries = alloc<__frozen_entry>(n);
+	auto *table = alloc<std::uint32_t>(slots);
+
+	cookie = nullptr;
+	for (auto i = std::size_t{}; i < n; ++i) {
+		auto const *name = ::nvlist_next(nvl, &type, &cookie);
+		auto entry = __frozen_entry{};
+
+		entry.__keylen = static_cast<std::uint32_t>(std::strlen(name));
+		entry.__key = copy_string(name, entry.__keylen);
+		entry.__type = static_cast<std::uint32_t>(type);
+		freeze_value(entry, type, cookie);
+
+		if (entries != nullptr)
+			std::construct_at(&entries[i], entry);
+	}
+
+	if (measuring())
+		return (nullptr);
+
+	auto flags = ::nvlist_flags(nvl);
+	auto ignore_case = (flags & NV_FLAG_IGNORE_CASE) != 0;
+
+	// stable, so that duplicate keys keep their original order.
+	std::stable_sort(entries, entries + n,
+		[=] (auto const &a, auto const &b) {
+			return (key_compare(entry_key(a), entry_key(b),
+					    ignore_case) < 0);
+		});
+
+	// only the first of a run of duplicate keys goes in the table.
+	std::uninitialized_fill_n(table, slots, 0);
+	for (auto i = std::size_t{}; i < n; ++i) {
+		if (i > 0 && key_compare(entry_key(entries[i - 1]),
+					 entry_key(entries[i]),
+					 ignore_case) == 0)
+			continue;
+
+		auto slot = key_hash(entry_key(entries[i]), ignore_case);
+		for (;; ++slot)
+			if (table[slot & (slots - 1)] == 0)
+				break;
+		table[slot & (slots - 1)] = static_cast<std::uint32_t>(i + 1);
+	}
+
+	std::construct_at(list, __frozen_list{
+		static_cast<std::uint32_t>(n),
+		static_cast<std::uint32_t>(slots - 1),
+		flags,
+		::nvlist_in_array(nvl),
+		entries,
+		table,
+	});
+
+	return (list);
+}
+
+void
+freezer::freeze_value(__frozen_entry &entry, int type, void *cookie)
+{
+	auto nitems = std::size_t{};
+
+	switch (type) {
+	case NV_TYPE_NULL:
+		break;
+
+	case NV_TYPE_BOOL:
+		entry.__number = ::cnvlist_get_bool(cookie);
+		break;
+
+	case NV_TYPE_NUMBER:
+		entry.__number = ::cnvlist_get_number(cookie);
+		break;
+
+	case NV_TYPE_STRING: {
+		auto const *str = ::cnvlist_get_string(cookie);
+		entry.__count = std::strlen(str);
+		entry.__ptr = copy_string(str, entry.__count);
+		break;
+	}
+
+	case NV_TYPE_NVLIST:
+		entry.__ptr = freeze(::cnvlist_get_nvlist(cookie));
+		break;
+
+	case NV_TYPE_DESCRIPTOR:
+		entry.__number = static_cast<std::uint64_t>(
+				dup_fd(::cnvlist_get_descriptor(cookie)));
+		break;
+
+	case NV_TYPE_BINARY: {
+		auto const *data = static_cast<std::byte const *>(
+				::cnvlist_get_binary(cookie, &nitems));
+		entry.__ptr = copy_array(data, nitems);
+		entry.__count = nitems;
+		break;
+	}
+
+	case NV_TYPE_BOOL_ARRAY: {
+		auto const *data = ::cnvlist_get_bool_array(cookie, &nitems);
+		entry.__ptr = copy_array(data, nitems);
+		entry.__count = nitems;
+		break;
+	}
+
+	case NV_TYPE_NUMBER_ARRAY: {
+		auto const *data = ::cnvlist_get_number_array(cookie, &nitems);
+		entry.__ptr = copy_array(data, nitems);
+		entry.__count = nitems;
+		break;
+	}
+
+	case NV_TYPE_STRING_ARRAY: {
+		auto const *data = ::cnvlist_get_string_array(cookie, &nitems);
+		auto *views = alloc<std::string_view>(nitems);
+
+		for (auto i = std::size_t{}; i < nitems; ++i) {
+			auto len = std::strlen(data[i]);
+			auto const *str = copy_string(data[i], len);
+			if (views != nullptr)
+				std::construct_at(&views[i], str, len);
+		}
+
+		entry.__ptr = views;
+		entry.__count = nitems;
+		break;
+	}
+
+	case NV_TYPE_NVLIST_ARRAY: {
+		auto const *data = ::cnvlist_get_nvlist_array(cookie, &nitems);
+		auto *lists = alloc<const_nv_frozen>(nitems);
+
+		for (auto i = std::size_t{}; i < nitems; ++i) {
+			auto const *list = freeze(data[i]);
+			if (lists != nullptr)
+				std::construct_at(&lists[i], list);
+		}
+
+		entry.__ptr = lists;
+		entry.__count = nitems;
+		break;
+	}
+
+	case NV_TYPE_DESCRIPTOR_ARRAY: {
+		auto const *data = ::cnvlist_get_descriptor_array(cookie,
+								  &nitems);
+		auto *fds_ = alloc<int>(nitems);
+
+		for (auto i = std::size_t{}; i < nitems; ++i) {
+			auto fd = dup_fd(data[i]);
+			if (fds_ != nullptr)
+				fds_[i] = fd;
+		}
+
+		entry.__ptr = fds_;
+		entry.__count = nitems;
+		break;
+	}
+
+	default:
+		std::abort();
+	}
+}
+
+} // anonymous namespace
+
+/*
+ * const_nv_frozen
+ */
+
+const_nv_frozen::const_nv_frozen(__detail::__frozen_list const *list) noexcept
+	: __m_list(list)
+{
+}
+
+void
+const_nv_frozen::__throw_if_null() const
+{
+	if (__m_list == nullptr)
+		throw std::logic_error("attempt to access a null nv_frozen");
+}
+
+/*
+ * Return the first entry with the given key and type, or nullptr.  A type of
+ * NV_TYPE_NONE matches any type.
+ */
+__detail::__frozen_entry const *
+const_nv_frozen::__find(std::string_view key, int type) const
+{
+	__throw_if_null();
+
+	auto ignore_case = (__m_list->__flags & NV_FLAG_IGNORE_CASE) != 0;
+	auto mask = __m_list->__mask;
+	auto const *entries = __m_list->__entries;
+
+	for (auto slot = key_hash(key, ignore_case);; ++slot) {
+		auto idx = __m_list->__table[slot & mask];
+		if (idx == 0)
+			return (nullptr);
+
+		auto const *entry = &entries[idx - 1];
+		if (entry->__keylen != key.size()
+		    || key_compare(entry_key(*entry), key, ignore_case) != 0)
+			continue;
+
+		// duplicate keys are adjacent; find one of the right type.
+		auto const *end = entries + __m_list->__count;
+		for (; entry != end; ++entry) {
+			if (key_compare(entry_key(*entry), key,
+					ignore_case) != 0)
+				return (nullptr);
+			if (type == NV_TYPE_NONE
+			    || entry->__type == static_cast<unsigned>(type))
+				return (entry);
+		}
+
+		return (nullptr);
+	}
+}
+
+__detail::__frozen_entry const &
+const_nv_frozen::__get(std::string_view key, int type) const
+{
+	if (auto const *entry = __find(key, type); entry != nullptr)
+		return (*entry);
+
+	throw nv_key_not_found(std::string(key));
+}
+
+std::size_t
+const_nv_frozen::size() const
+{
+	__throw_if_null();
+	return (__m_list->__count);
+}
+
+bool
+const_nv_frozen::empty() const
+{
+	return (size() == 0);
+}
+
+int
+const_nv_frozen::flags() const
+{
+	__throw_if_null();
+	return (__m_list->__flags);
+}
+
+bool
+const_nv_frozen::in_array() const
+{
+	__throw_if_null();
+	return (__m_list->__in_array);
+}
+
+/*
+ * Add the contents of a frozen list to an nvlist.  Errors are left in the
+ * nvlist's error state for the caller to check.
+ */
+void
+const_nv_frozen::__thaw_into(::nvlist_t *nvl,
+			     __detail::__frozen_list const *list)
+{
+	for (auto const &entry : std::span(list->__entries, list->__count)) {
+		auto const *key = entry.__key;
+		auto n = entry.__count;
+
+		switch (entry.__type) {
+		case NV_TYPE_NULL:
+			::nvlist_add_null(nvl, key);
+			break;
+
+		case NV_TYPE_BOOL:
+			::nvlist_add_bool(nvl, key, entry.__number != 0);
+			break;
+
+		case NV_TYPE_NUMBER:
+			::nvlist_add_number(nvl, key, entry.__number);
+			break;
+
+		case NV_TYPE_STRING:
+			::nvlist_add_string(nvl, key,
+				static_cast<char const *>(entry.__ptr));
+			break;
+
+		case NV_TYPE_NVLIST: {
+			auto const *child =
+				static_cast<__detail::__frozen_list const *>(
+					entry.__ptr);
+			auto *cnvl = ::nvlist_create(child->__flags);
+			if (cnvl != nullptr)
+				__thaw_into(cnvl, child);
+			::nvlist_move_nvlist(nvl, key, cnvl);
+			break;
+		}
+
+		case NV_TYPE_DESCRIPTOR:
+			::nvlist_add_descriptor(nvl, key,
+				static_cast<int>(entry.__number));
+			break;
+
+		case NV_TYPE_BINARY:
+			::nvlist_add_binary(nvl, key, entry.__ptr, n);
+			break;
+
+		case NV_TYPE_BOOL_ARRAY:
+			::nvlist_add_bool_array(nvl, key,
+				static_cast<bool const *>(entry.__ptr), n);
+			break;
+
+		case NV_TYPE_NUMBER_ARRAY:
+			::nvlist_add_number_array(nvl, key,
+				static_cast<std::uint64_t const *>(entry.__ptr),
+				n);
+			break;
+
+		case NV_TYPE_STRING_ARRAY: {
+			auto const *views =
+				static_cast<std::string_view const *>(
+					entry.__ptr);
+			// the frozen strings are always NUL-terminated
+			auto ptrs = std::span(views, n)
+				| std::views::transform(&std::string_view::data)
+				| std::ranges::to<std::vector>();
+			::nvlist_add_string_array(nvl, key, ptrs.data(), n);
+			break;
+		}
+
+		case NV_TYPE_NVLIST_ARRAY: {
+			auto const *lists =
+				static_cast<const_nv_frozen const *>(
+					entry.__ptr);
+			auto *arr = static_cast<::nvlist_t **>(
+					std::calloc(n, sizeof(::nvlist_t *)));
+
+			for (auto i = std::size_t{}; arr && i < n; ++i) {
+				auto const *child = lists[i].__m_list;
+				arr[i] = ::nvlist_create(child->__flags);
+				if (arr[i] != nullptr)
+					__thaw_into(arr[i], child);
+			}
+
+			// nvlist_move_nvlist_array frees arr on failure
+			::nvlist_move_nvlist_array(nvl, key, arr, n);
+			break;
+		}
+
+		case NV_TYPE_DESCRIPTOR_ARRAY:
+			::nvlist_add_descriptor_array(nvl, key,
+				static_cast<int const *>(entry.__ptr), n);
+			break;
+
+		default:
+			std::abort();
+		}
+	}
+}
+
+nv_list
+const_nv_frozen::thaw() const
+{
+	__throw_if_null();
+
+	auto nvl = nv_list(__m_list->__flags);
+	__thaw_into(nvl.ptr(), __m_list);
+
+	if (auto err = ::nvlist_error(nvl.ptr()); err != 0)
+		throw std::system_error(
+			std::error_code(err, std::generic_category()));
+
+	return (nvl);
+}
+
+std::vector<std::byte>
+const_nv_frozen::pack() const
+{
+	return (thaw().pack());
+}
+
+void
+const_nv_frozen::send(int fd) const
+{
+	thaw().send(fd);
+}
+
+bool
+const_nv_frozen::exists(std::string_view key) const
+{
+	return (exists_type(key, NV_TYPE_NONE));
+}
+
+bool
+const_nv_frozen::exists_type(std::string_view key, int type) const
+{
+	return (__find(key, type) != nullptr);
+}
+
+bool
+const_nv_frozen::exists_null(std::string_view key) const
+{
+	return (exists_type(key, NV_TYPE_NULL));
+}
+
+bool
+const_nv_frozen::exists_bool(std::string_view key) const
+{
+	return (exists_type(key, NV_TYPE_BOOL));
+}
+
+bool
+const_nv_frozen::exists_number(std::string_view key) const
+{
+	return (exists_type(key, NV_TYPE_NUMBER));
+}
+
+bool
+const_nv_frozen::exists_string(std::string_view key) const
+{
+	return (exists_type(key, NV_TYPE_STRING));
+}
+
+bool
+const_nv_frozen::exists_nvlist(std::string_view key) const
+{
+	return (exists_type(key, NV_TYPE_NVLIST));
+}
+
+bool
+const_nv_frozen::exists_descriptor(std::string_view key) const
+{
+	return (exists_type(key, NV_TYPE_DESCRIPTOR));
+}
+
+bool
+const_nv_frozen::exists_binary(std::string_view key) const
+{
+	return (exists_type(key, NV_TYPE_BINARY));
+}
+
+bool
+const_nv_frozen::exists_bool_array(std::string_view key) const
+{
+	return (exists_type(key, NV_TYPE_BOOL_ARRAY));
+}
+
+bool
+const_nv_frozen::exists_number_array(std::string_view key) const
+{
+	return (exists_type(key, NV_TYPE_NUMBER_ARRAY));
+}
+
+bool
+const_nv_frozen::exists_string_array(std::string_view key) const
+{
+	return (exists_type(key, NV_TYPE_STRING_ARRAY));
+}
+
+bool
+const_nv_frozen::exists_nvlist_array(std::string_view key) const
+{
+	return (exists_type(key, NV_TYPE_NVLIST_ARRAY));
+}
+
+bool
+const_nv_frozen::exists_descriptor_array(std::string_view key) const
+{
+	return (exists_type(key, NV_TYPE_DESCRIPTOR_ARRAY));
+}
+
+bool
+const_nv_frozen::get_bool(std::string_view key) const
+{
+	return (__get(key, NV_TYPE_BOOL).__number != 0);
+}
+
+std::uint64_t
+const_nv_frozen::get_number(std::string_view key) const
+{
+	return (__get(key, NV_TYPE_NUMBER).__number);
+}
+
+std::string_view
+const_nv_frozen::get_string(std::string_view key) const
+{
+	auto const &entry = __get(key, NV_TYPE_STRING);
+	return {static_cast<char const *>(entry.__ptr), entry.__count};
+}
+
+const_nv_frozen
+const_nv_frozen::get_nvlist(std::string_view key) const
+{
+	auto const &entry = __get(key, NV_TYPE_NVLIST);
+	return (const_nv_frozen(
+		static_cast<__detail::__frozen_list const *>(entry.__ptr)));
+}
+
+int
+const_nv_frozen::get_descriptor(std::string_view key) const
+{
+	return (static_cast<int>(__get(key, NV_TYPE_DESCRIPTOR).__number));
+}
+
+std::span<std::byte const>
+const_nv_frozen::get_binary(std::string_view key) const
+{
+	auto const &entry = __get(key, NV_TYPE_BINARY);
+	return {static_cast<std::byte const *>(entry.__ptr), entry.__count};
+}
+
+std::span<bool const>
+const_nv_frozen::get_bool_array(std::string_view key) const
+{
+	auto const &entry = __get(key, NV_TYPE_BOOL_ARRAY);
+	return {static_cast<bool const *>(entry.__ptr), entry.__count};
+}
+
+std::span<std::uint64_t const>
+const_nv_frozen::get_number_array(std::string_view key) const
+{
+	auto const &entry = __get(key, NV_TYPE_NUMBER_ARRAY);
+	return {static_cast<std::uint64_t const *>(entry.__ptr),
+		entry.__count};
+}
+
+std::span<std::string_view const>
+const_nv_frozen::get_string_array(std::string_view key) const
+{
+	auto const &entry = __get(key, NV_TYPE_STRING_ARRAY);
+	return {static_cast<std::string_view const *>(entry.__ptr),
+		entry.__count};
+}
+
+std::span<const_nv_frozen const>
+const_nv_frozen::get_nvlist_array(std::string_view key) const
+{
+	auto const &entry = __get(key, NV_TYPE_NVLIST_ARRAY);
+	return {static_cast<const_nv_frozen const *>(entry.__ptr),
+		entry.__count};
+}
+
+std::span<int const>
+const_nv_frozen::get_descriptor_array(std::string_view key) const
+{
+	auto const &entry = __get(key, NV_TYPE_DESCRIPTOR_ARRAY);
+	return {static_cast<int const *>(entry.__ptr), entry.__count};
+}
+
+/*
+ * nv_frozen
+ */
+
+nv_frozen::nv_frozen(const_nv_list const &nvl)
+{
+	if (auto err = nvl.error(); err)
+		throw nv_error_state(err);
+
+	auto measure = freezer{};
+	(void)measure.freeze(nvl.ptr());
+
+	auto size = measure.offset;
+	__m_block = static_cast<std::byte *>(
+		::operator new(size, std::align_val_t(cache_line)));
+
+	try {
+		__m_fds.reserve(measure.nfds);
+		auto build = freezer{__m_block, 0, &__m_fds};
+		__m_list = build.freeze(nvl.ptr());
+		assert(build.offset == size);
+	} catch (...) {
+		__free();
+		throw;
+	}
+}
+
+nv_frozen::nv_frozen(nv_frozen &&other) noexcept
+	: const_nv_frozen(std::exchange(other.__m_list, nullptr))
+	, __m_block(std::exchange(other.__m_block, nullptr))
+	, __m_fds(std::move(other.__m_fds))
+{
+}
+
+nv_frozen &
+nv_frozen::operator=(nv_frozen &&other) noexcept
+{
+	if (this != &other) {
+		__free();
+		__m_list = std::exchange(other.__m_list, nullptr);
+		__m_block = std::exchange(other.__m_block, nullptr);
+		__m_fds = std::move(other.__m_fds);
+	}
+
+	return (*this);
+}
+
+nv_frozen::~nv_frozen()
+{
+	__free();
+}
+
+void
+nv_frozen::__free() noexcept
+{
+	for (auto fd : __m_fds)
+		(void)::close(fd);
+	__m_fds.clear();
+
+	if (__m_block != nullptr)
+		::operator delete(__m_block, std::align_val_t(cache_line));
+
+	__m_block = nullptr;
+	__m_list = nullptr;
+}
+
+/*
+ * nv_frozen_iterator
+ */
+
+nv_frozen_iterator
+begin(const_nv_frozen const &nvf)
+{
+	return (nv_frozen_iterator(nvf));
+}
+
+std::default_sentinel_t
+end(const_nv_frozen const &)
+{
+	return {};
+}
+
+nv_frozen_iterator::nv_frozen_iterator()
+{
+}
+
+nv_frozen_iterator::nv_frozen_iterator(const_nv_frozen const &nvf)
+{
+	nvf.__throw_if_null();
+	__entry = nvf.__m_list->__entries;
+	__end = __entry + nvf.__m_list->__count;
+	__load();
+}
+
+nv_frozen_iterator &
+nv_frozen_iterator::operator++()
+{
+	++__entry;
+	__load();
+	return (*this);
+}
+
+nv_frozen_iterator
+nv_frozen_iterator::operator++(int)
+{
+	nv_frozen_iterator tmp = *this;
+	++(*this);
+	return (tmp);
+}
+
+bool
+nv_frozen_iterator::operator==(nv_frozen_iterator const &other) const
+{
+	return (__entry == other.__entry);
+}
+
+bool
+nv_frozen_iterator::operator==(std::default_sentinel_t) const
+{
+	return (__entry == __end);
+}
+
+nv_frozen_iterator::const_reference
+nv_frozen_iterator::operator*() const
+{
+	return (__current);
+}
+
+nv_frozen_iterator::const_pointer
+nv_frozen_iterator::operator->() const
+{
+	return (&__current);
+}
+
+void
+nv_frozen_iterator::__load()
+{
+	if (__entry == __end)
+		return;
+
+	auto const &e = *__entry;
+	auto key = entry_key(e);
+
+	switch (e.__type) {
+	case NV_TYPE_NULL:
+		__current = {key, nullptr};
+		break;
+
+	case NV_TYPE_BOOL:
+		__current = {key, e.__number != 0};
+		break;
+
+	case NV_TYPE_NUMBER:
+		__current = {key, e.__number};
+		break;
+
+	case NV_TYPE_STRING:
+		__current = {key, std::string_view(
+			static_cast<char const *>(e.__ptr), e.__count)};
+		break;
+
+	case NV_TYPE_NVLIST:
+		__current = {key, const_nv_frozen(
+			static_cast<__frozen_list const *>(e.__ptr))};
+		break;
+
+	case NV_TYPE_DESCRIPTOR:
+		__current = {key, static_cast<int>(e.__number)};
+		break;
+
+	case NV_TYPE_BINARY:
+		__current = {key, std::span(
+			static_cast<std::byte const *>(e.__ptr), e.__count)};
+		break;
+
+	case NV_TYPE_BOOL_ARRAY:
+		__current = {key, std::span(
+			static_cast<bool const *>(e.__ptr), e.__count)};
+		break;
+
+	case NV_TYPE_NUMBER_ARRAY:
+		__current = {key, std::span(
+			static_cast<std::uint64_t const *>(e.__ptr),
+			e.__count)};
+		break;
+
+	case NV_TYPE_STRING_ARRAY:
+		__current = {key, std::span(
+			static_cast<std::string_view const *>(e.__ptr),
+			e.__count)};
+		break;
+
+	case NV_TYPE_NVLIST_ARRAY:
+		__current = {key, std::span(
+			static_cast<const_nv_frozen const *>(e.__ptr),
+			e.__count)};
+		break;
+
+	case NV_TYPE_DESCRIPTOR_ARRAY:
+		__current = {key, std::span(
+			static_cast<int const *>(e.__ptr), e.__count)};
+		break;
+
+	default:
+		std::abort();
+	}
+}
+
+namespace __detail {
+
+nv_frozen
+__const_nv_list::freeze() const
+{
+	return (nv_frozen(const_nv_list(__m_nv)));
+}
+
+} // namespace bsd::__detail
+
+} // namespace bsd
@@ -0,0 +1,247 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR MIT
+ * Refer to the file 'LICENSE' in the nvxx distribution for license terms.
+ */
+
+#ifndef	_NVXX_FROZEN_H_INCLUDED
+#define _NVXX_FROZEN_H_INCLUDED
+
+#ifndef _NVXX_H_INCLUDED
+# error include <nvxx.h> instead of including this header directly
+#endif
+
+#include <cstdint>
+#include <iterator>
+#include <variant>
+
+/*
+ * nv_frozen: an immutable copy of an nvlist stored in a single contiguous
+ * block of memory.  The pairs in each (sub-)list are sorted by key and
+ * indexed by an open-addressed hash table stored in the same block, and all
+ * values are stored inline in the block, so a lookup touches a small,
+ * predictable number of cache lines.
+ */
+
+namespace bsd {
+
+struct const_nv_frozen;
+struct nv_frozen;
+
+namespace __detail {
+
+/*
+ * A single pair in a frozen nvlist.  Scalar values are stored in __number;
+ * all other values are stored elsewhere in the block and referenced by
+ * __ptr, with __count holding the string length or number of array items.
+ */
+struct __frozen_entry {
+	char const	*__key;
+	std::uint32_t	 __keylen;
+	std::uint32_t	 __type;
+	union {
+		std::uint64_t	 __number;
+		void const	*__ptr;
+	};
+	std::size_t	 __count;
+};
+
+struct __frozen_list {
+	std::uint32_t		 __count;	/* number of entries */
+	std::uint32_t		 __mask;	/* hash table size - 1 */
+	int			 __flags;	/* nvlist_flags() of the source */
+	bool			 __in_array;
+	__frozen_entry const	*__entries;	/* sorted by key */
+	std::uint32_t const	*__table;	/* entry index + 1, or 0 */
+};
+
+} // namespace bsd::__detail
+
+/*
+ * A const_nv_frozen is a non-owning reference to a frozen nvlist, or to an
+ * nvlist nested inside one.  Its lifetime ends when the nv_frozen which owns
+ * the block is destroyed.  const_nv_frozen supports the same read-only
+ * operations as const_nv_list, except that the array accessors return spans
+ * into the frozen block rather than vectors.
+ */
+struct const_nv_frozen {
+	/*
+	 * Default constructing a const_nv_frozen leaves it in the empty
+	 * state; it can be assigned to or destructed but no other operations
+	 * are valid.
+	 */
+	const_nv_frozen() noexcept = default;
+
+	explicit const_nv_frozen(__detail::__frozen_list const *) noexcept;
+
+	/*
+	 * Return the number of pairs in this list.
+	 */
+	[[nodiscard]] std::size_t size() const;
+
+	/*
+	 * Returns true if this list contains no pairs.
+	 */
+	[[nodiscard]] bool empty() const;
+
+	/*
+	 * Return the flags of the nvlist which this list was frozen from.
+	 */
+	[[nodiscard]] int flags() const;
+
+	/*
+	 * Returns true if the nvlist which this list was frozen from was part
+	 * of an nvlist array.
+	 */
+	[[nodiscard]] bool in_array() const;
+
+	/*
+	 * Return a new nv_list with the same contents as this list.  The
+	 * pairs in the new list are in key order.
+	 */
+	[[nodiscard]] nv_list thaw() const;
+
+	/*
+	 * Equivalent to thaw().pack() and thaw().send().
+	 */
+	[[nodiscard]] std::vector<std::byte> pack() const;
+	void send(int) const;
+
+	/* exists */
+
+	[[nodiscard]] bool exists(std::string_view) const;
+	[[nodiscard]] bool exists_type(std::string_view, int) const;
+
+	[[nodiscard]] bool exists_null(std::string_view) const;
+	[[nodiscard]] bool exists_bool(std::string_view) const;
+	[[nodiscard]] bool exists_number(std::string_view) const;
+	[[nodiscard]] bool exists_string(std::string_view) const;
+	[[nodiscard]] bool exists_nvlist(std::string_view) const;
+	[[nodiscard]] bool exists_descriptor(std::string_view) const;
+	[[nodiscard]] bool exists_binary(std::string_view) const;
+
+	[[nodiscard]] bool exists_bool_array(std::string_view) const;
+	[[nodiscard]] bool exists_number_array(std::string_view) const;
+	[[nodiscard]] bool exists_string_array(std::string_view) const;
+	[[nodiscard]] bool exists_nvlist_array(std::string_view) const;
+	[[nodiscard]] bool exists_descriptor_array(std::string_view) const;
+
+	/* get */
+
+	[[nodiscard]] auto get_bool(std::string_view) const -> bool;
+	[[nodiscard]] auto get_number(std::string_view) const -> std::uint64_t;
+	[[nodiscard]] auto get_string(std::string_view) const -> std::string_view;
+	[[nodiscard]] auto get_nvlist(std::string_view) const -> const_nv_frozen;
+	[[nodiscard]] auto get_descriptor(std::string_view) const -> int;
+	[[nodiscard]] auto get_binary(std::string_view) const -> std::span<std::byte const>;
+
+	[[nodiscard]] auto get_bool_array(std::string_view) const -> std::span<bool const>;
+	[[nodiscard]] auto get_number_array(std::string_view) const -> std::span<std::uint64_t const>;
+	[[nodiscard]] auto get_string_array(std::string_view) const -> std::span<std::string_view const>;
+	[[nodiscard]] auto get_nvlist_array(std::string_view) const -> std::span<const_nv_frozen const>;
+	[[nodiscard]] auto get_descriptor_array(std::string_view) const -> std::span<int const>;
+
+protected:
+	friend struct nv_frozen_iterator;
+
+	__detail::__frozen_list const *__m_list = nullptr;
+
+	void __throw_if_null() const;
+	__detail::__frozen_entry const *__find(std::string_view, int) const;
+	__detail::__frozen_entry const &__get(std::string_view, int) const;
+
+	static void __thaw_into(::nvlist_t *, __detail::__frozen_list const *);
+};
+
+/*
+ * nv_frozen owns a frozen nvlist.  It may be moved but not copied.
+ */
+struct nv_frozen final : const_nv_frozen {
+	/*
+	 * Create an empty nv_frozen which does not own a list.
+	 */
+	nv_frozen() noexcept = default;
+
+	/*
+	 * Freeze the given nvlist.  Descriptors in the nvlist are duplicated
+	 * and are closed when the nv_frozen is destroyed.  If the nvlist is in
+	 * the error state, throws nv_error_state; on any other failure, throws
+	 * std::system_error.
+	 */
+	explicit nv_frozen(const_nv_list const &);
+
+	nv_frozen(nv_frozen const &) = delete;
+	nv_frozen &operator=(nv_frozen const &) = delete;
+
+	nv_frozen(nv_frozen &&) noexcept;
+	nv_frozen &operator=(nv_frozen &&) noexcept;
+
+	~nv_frozen();
+
+private:
+	std::byte *__m_block = nullptr;
+	std::vector<int> __m_fds;
+
+	void __free() noexcept;
+};
+
+// the value type of a frozen nvlist value
+using nv_frozen_value_t = std::variant<
+	nullptr_t,				/* null */
+	bool,					/* bool */
+	std::uint64_t,				/* number */
+	std::string_view,			/* string */
+	const_nv_frozen,			/* nvlist */
+	int,					/* descriptor */
+	std::span<std::byte const>,		/* binary */
+	std::span<bool const>,			/* bool array */
+	std::span<std::uint64_t const>,		/* number array */
+	std::span<std::string_view const>,	/* string array */
+	std::span<int const>,			/* descriptor array */
+	std::span<const_nv_frozen const>	/* nvlist array */
+>;
+
+using nv_frozen_pair_t = std::pair<nv_list_key_t, nv_frozen_value_t>;
+
+/*
+ * Iterate the pairs of a frozen list in key order.  Unlike nv_list_iterator,
+ * dereferencing this iterator never allocates.
+ */
+struct nv_frozen_iterator {
+	using iterator_category = std::forward_iterator_tag;
+	using difference_type = std::ptrdiff_t;
+	using value_type = nv_frozen_pair_t;
+	using pointer = value_type *;
+	using const_pointer = value_type const *;
+	using reference = value_type &;
+	using const_reference = value_type const &;
+	using sentinel = std::default_sentinel_t;
+
+	nv_frozen_iterator();
+	explicit nv_frozen_iterator(const_nv_frozen const &);
+
+	nv_frozen_iterator &operator++();
+	nv_frozen_iterator operator++(int);
+
+	bool operator==(nv_frozen_iterator const &) const;
+	bool operator==(std::default_sentinel_t) const;
+
+	const_reference operator*() const;
+	const_pointer operator->() const;
+
+private:
+	__detail::__frozen_entry const *__entry = nullptr;
+	__detail::__frozen_entry const *__end = nullptr;
+	nv_frozen_pair_t __current;
+
+	void __load();
+};
+
+static_assert(std::forward_iterator<nv_frozen_iterator>);
+static_assert(std::sentinel_for<std::default_sentinel_t, nv_frozen_iterator>);
+
+nv_frozen_iterator begin(const_nv_frozen const &);
+std::default_sentinel_t end(const_nv_frozen const &);
+
+} // namespace bsd
+
+#endif	/* !_NVXX_FROZEN_H_INCLUDED */
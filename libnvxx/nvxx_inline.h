@@ -0,0 +1,348 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR MIT
+ * Refer to the file 'LICENSE' in the nvxx distribution for license terms.
+ */
+
+#ifndef	_NVXX_INLINE_H_INCLUDED
+#define _NVXX_INLINE_H_INCLUDED
+
+#ifndef _NVXX_H_INCLUDED
+# error include <nvxx.h> instead of including this header directly
+#endif
+
+/*
+ * Inline definitions of the accessors which are called most often: ptr(),
+ * error(), the exists_*() functions and the get_*() functions which do not
+ * allocate.  Defining these in the header lets the compiler inline them into
+ * the caller and fold away the key checks for a constant key, instead of
+ * making a call into the library for every lookup.  Anything which can throw
+ * does so through one of the cold helpers declared in nvxx_base.h, so the
+ * inlined code is only the fast path.
+ */
+
+namespace bsd {
+
+namespace __detail {
+
+/*
+ * __nv_list_base
+ */
+
+inline void
+__nv_list_base::__throw_if_null() const
+{
+	if (__m_nv == nullptr) [[unlikely]]
+		__throw_null_nv_list();
+}
+
+inline void
+__nv_list_base::__throw_if_error() const
+{
+	__throw_if_null();
+
+	if (auto __err = ::nvlist_error(__m_nv); __err != 0) [[unlikely]]
+		__throw_error_state(__err);
+}
+
+inline void
+__nv_list_base::__check_string_null(std::string_view __str,
+				    std::string_view __error) const
+{
+	if (__str.find('\0') != __str.npos) [[unlikely]]
+		__throw_runtime_error(__error);
+}
+
+/*
+ * __const_nv_list
+ */
+
+inline std::error_code
+__const_nv_list::error() const
+{
+	__throw_if_null();
+
+	if (auto const __err = ::nvlist_error(__m_nv); __err != 0)
+		return (std::make_error_code(std::errc(__err)));
+	return {};
+}
+
+inline
+__const_nv_list::operator bool() const noexcept
+{
+	return ((__m_nv != nullptr) && (::nvlist_error(__m_nv) == 0));
+}
+
+inline bool
+__const_nv_list::empty() const
+{
+	__throw_if_error();
+	return (::nvlist_empty(__m_nv));
+}
+
+inline int
+__const_nv_list::flags() const
+{
+	__throw_if_error();
+	return (::nvlist_flags(__m_nv));
+}
+
+inline bool
+__const_nv_list::in_array() const noexcept
+{
+	return (::nvlist_in_array(__m_nv));
+}
+
+inline bool
+__const_nv_list::exists_type(std::string_view __key, int __type) const
+{
+	__throw_if_error();
+	__check_string_null(__key, "nv_list keys may not contain NUL");
+
+	return (::nvlist_exists_type(__m_nv, __nv_key(__key).c_str(), __type));
+}
+
+inline bool
+__const_nv_list::exists(std::string_view __key) const
+{
+	return (exists_type(__key, NV_TYPE_NONE));
+}
+
+inline bool
+__const_nv_list::exists_null(std::string_view __key) const
+{
+	return (exists_type(__key, NV_TYPE_NULL));
+}
+
+inline bool
+__const_nv_list::exists_bool(std::string_view __key) const
+{
+	return (exists_type(__key, NV_TYPE_BOOL));
+}
+
+inline bool
+__const_nv_list::exists_number(std::string_view __key) const
+{
+	return (exists_type(__key, NV_TYPE_NUMBER));
+}
+
+inline bool
+__const_nv_list::exists_string(std::string_view __key) const
+{
+	return (exists_type(__key, NV_TYPE_STRING));
+}
+
+inline bool
+__const_nv_list::exists_nvlist(std::string_view __key) const
+{
+	return (exists_type(__key, NV_TYPE_NVLIST));
+}
+
+inline bool
+__const_nv_list::exists_descriptor(std::string_view __key) const
+{
+	return (exists_type(__key, NV_TYPE_DESCRIPTOR));
+}
+
+inline bool
+__const_nv_list::exists_binary(std::string_view __key) const
+{
+	return (exists_type(__key, NV_TYPE_BINARY));
+}
+
+inline bool
+__const_nv_list::exists_bool_array(std::string_view __key) const
+{
+	return (exists_type(__key, NV_TYPE_BOOL_ARRAY));
+}
+
+inline bool
+__const_nv_list::exists_number_array(std::string_view __key) const
+{
+	return (exists_type(__key, NV_TYPE_NUMBER_ARRAY));
+}
+
+inline bool
+__const_nv_list::exists_string_array(std::string_view __key) const
+{
+	return (exists_type(__key, NV_TYPE_STRING_ARRAY));
+}
+
+inline bool
+__const_nv_list::exists_nvlist_array(std::string_view __key) const
+{
+	return (exists_type(__key, NV_TYPE_NVLIST_ARRAY));
+}
+
+inline bool
+__const_nv_list::exists_descriptor_array(std::string_view __key) const
+{
+	return (exists_type(__key, NV_TYPE_DESCRIPTOR_ARRAY));
+}
+
+inline bool
+__const_nv_list::get_bool(std::string_view __key) const
+{
+	__NVXX_STATS_CALL(get);
+	__throw_if_error();
+	__check_string_null(__key, "nv_list keys may not contain NUL");
+
+	auto const __k = __nv_key(__key);
+	if (!::nvlist_exists_bool(__m_nv, __k.c_str())) [[unlikely]]
+		__throw_key_not_found(__key);
+
+	return (::nvlist_get_bool(__m_nv, __k.c_str()));
+}
+
+inline std::uint64_t
+__const_nv_list::get_number(std::string_view __key) const
+{
+	__NVXX_STATS_CALL(get);
+	__throw_if_error();
+	__check_string_null(__key, "nv_list keys may not contain NUL");
+
+	auto const __k = __nv_key(__key);
+	if (!::nvlist_exists_number(__m_nv, __k.c_str())) [[unlikely]]
+		__throw_key_not_found(__key);
+
+	return (::nvlist_get_number(__m_nv, __k.c_str()));
+}
+
+inline std::string_view
+__const_nv_list::get_string(std::string_view __key) const
+{
+	__NVXX_STATS_CALL(get);
+	__throw_if_error();
+	__check_string_null(__key, "nv_list keys may not contain NUL");
+
+	auto const __k = __nv_key(__key);
+	if (!::nvlist_exists_string(__m_nv, __k.c_str())) [[unlikely]]
+		__throw_key_not_found(__key);
+
+	return (::nvlist_get_string(__m_nv, __k.c_str()));
+}
+
+inline int
+__const_nv_list::get_descriptor(std::string_view __key) const
+{
+	__NVXX_STATS_CALL(get);
+	__throw_if_error();
+	__check_string_null(__key, "nv_list keys may not contain NUL");
+
+	auto const __k = __nv_key(__key);
+	if (!::nvlist_exists_descriptor(__m_nv, __k.c_str())) [[unlikely]]
+		__throw_key_not_found(__key);
+
+	return (::nvlist_get_descriptor(__m_nv, __k.c_str()));
+}
+
+inline const_nv_list
+__const_nv_list::get_nvlist(std::string_view __key) const
+{
+	__NVXX_STATS_CALL(get);
+	__throw_if_error();
+	__check_string_null(__key, "nv_list keys may not contain NUL");
+
+	auto const __k = __nv_key(__key);
+	if (!::nvlist_exists_nvlist(__m_nv, __k.c_str())) [[unlikely]]
+		__throw_key_not_found(__key);
+
+	return (const_nv_list(::nvlist_get_nvlist(__m_nv, __k.c_str())));
+}
+
+inline std::span<std::byte const>
+__const_nv_list::get_binary(std::string_view __key) const
+{
+	__NVXX_STATS_CALL(get);
+	__throw_if_error();
+	__check_string_null(__key, "nv_list keys may not contain NUL");
+
+	auto const __k = __nv_key(__key);
+	if (!::nvlist_exists_binary(__m_nv, __k.c_str())) [[unlikely]]
+		__throw_key_not_found(__key);
+
+	auto __size = std::size_t{};
+	auto const *__data = ::nvlist_get_binary(__m_nv, __k.c_str(), &__size);
+	return {static_cast<std::byte const *>(__data), __size};
+}
+
+inline std::span<bool const>
+__const_nv_list::get_bool_array(std::string_view __key) const
+{
+	__NVXX_STATS_CALL(get);
+	__throw_if_error();
+	__check_string_null(__key, "nv_list keys may not contain NUL");
+
+	auto const __k = __nv_key(__key);
+	if (!::nvlist_exists_bool_array(__m_nv, __k.c_str())) [[unlikely]]
+		__throw_key_not_found(__key);
+
+	auto __nitems = std::size_t{};
+	auto const *__data = ::nvlist_get_bool_array(
+		__m_nv, __k.c_str(), &__nitems);
+	return {__data, __nitems};
+}
+
+inline std::span<std::uint64_t const>
+__const_nv_list::get_number_array(std::string_view __key) const
+{
+	__NVXX_STATS_CALL(get);
+	__throw_if_error();
+	__check_string_null(__key, "nv_list keys may not contain NUL");
+
+	auto const __k = __nv_key(__key);
+	if (!::nvlist_exists_number_array(__m_nv, __k.c_str())) [[unlikely]]
+		__throw_key_not_found(__key);
+
+	auto __nitems = std::size_t{};
+	auto const *__data = ::nvlist_get_number_array(
+		__m_nv, __k.c_str(), &__nitems);
+	return {__data, __nitems};
+}
+
+inline std::span<int const>
+__const_nv_list::get_descriptor_array(std::string_view __key) const
+{
+	__NVXX_STATS_CALL(get);
+	__throw_if_error();
+	__check_string_null(__key, "nv_list keys may not contain NUL");
+
+	auto const __k = __nv_key(__key);
+	if (!::nvlist_exists_descriptor_array(__m_nv, __k.c_str())) [[unlikely]]
+		__throw_key_not_found(__key);
+
+	auto __nitems = std::size_t{};
+	auto const *__data = ::nvlist_get_descriptor_array(
+		__m_nv, __k.c_str(), &__nitems);
+	return {__data, __nitems};
+}
+
+} // namespace bsd::__detail
+
+/*
+ * const_nv_list, nv_list
+ */
+
+inline ::nvlist_t const *
+const_nv_list::ptr() const
+{
+	__throw_if_null();
+	return (__m_nv);
+}
+
+inline ::nvlist_t *
+nv_list::ptr()
+{
+	__throw_if_null();
+	return (__m_nv);
+}
+
+inline ::nvlist_t const *
+nv_list::ptr() const
+{
+	__throw_if_null();
+	return (__m_nv);
+}
+
+} // namespace bsd
+
+#endif	/* !_NVXX_INLINE_H_INCLUDED */
@@ -98,95 +98,78 @@ nv_list_iterator::__advance()
 		return;
 	}
 
-	auto name = std::string_view(namep);
+	__current = std::make_pair(std::string_view(namep),
+				   __detail::__make_value(type, __cookie));
+}
+
+namespace __detail {
 
+nv_list_value_t
+__make_value(int type, void const *cookie)
+{
 	switch (type) {
 	case NV_TYPE_NULL:
-		__current = std::make_pair(name, nullptr);
-		break;
+		return (nullptr);
 
 	case NV_TYPE_BOOL:
-		__current = std::make_pair(name, cnvlist_get_bool(__cookie));
-		break;
+		return (cnvlist_get_bool(cookie));
 
 	case NV_TYPE_NUMBER:
-		__current = std::make_pair(name, cnvlist_get_number(__cookie));
-		break;
+		return (cnvlist_get_number(cookie));
 
 	case NV_TYPE_STRING:
-		__current = std::make_pair(name,
-				std::string_view(
-					cnvlist_get_string(__cookie)));
-		break;
+		return (std::string_view(cnvlist_get_string(cookie)));
 
 	case NV_TYPE_NVLIST:
-		__current = std::make_pair(name,
-				const_nv_list(cnvlist_get_nvlist(__cookie)));
-		break;
+		return (const_nv_list(cnvlist_get_nvlist(cookie)));
 
 	case NV_TYPE_DESCRIPTOR:
-		__current = std::make_pair(name,
-					   cnvlist_get_descriptor(__cookie));
-		break;
+		return (cnvlist_get_descriptor(cookie));
 
 	case NV_TYPE_BINARY: {
 		auto nitems = std::size_t{};
-		auto ptr = cnvlist_get_binary(__cookie, &nitems);
-		auto span = std::span{static_cast<std::byte const *>(ptr), nitems};
-		__current = std::make_pair(name, span);
-		break;
+		auto ptr = cnvlist_get_binary(cookie, &nitems);
+		return (std::span{static_cast<std::byte const *>(ptr), nitems});
 	}
 
 	case NV_TYPE_BOOL_ARRAY: {
 		auto nitems = std::size_t{};
-		auto ptr = cnvlist_get_bool_array(__cookie, &nitems);
-		auto span = std::span{ptr, nitems};
-		__current = std::make_pair(name, span);
-		break;
+		auto ptr = cnvlist_get_bool_array(cookie, &nitems);
+		return (std::span{ptr, nitems});
 	}
 
 	case NV_TYPE_NUMBER_ARRAY: {
 		auto nitems = std::size_t{};
-		auto ptr = cnvlist_get_number_array(__cookie, &nitems);
-		auto span = std::span{ptr, nitems};
-		__current = std::make_pair(name, span);
-		break;
+		auto ptr = cnvlist_get_number_array(cookie, &nitems);
+		return (std::span{ptr, nitems});
 	}
 
 	case NV_TYPE_STRING_ARRAY: {
 		auto nitems = std::size_t{};
-		auto ptr = cnvlist_get_string_array(__cookie, &nitems);
+		auto ptr = cnvlist_get_string_array(cookie, &nitems);
 		auto span = std::span{ptr, nitems};
-		auto vector =
-			span
+		return (span
 			| std::views::transform([] (char const *ptr) {
 				return (std::string_view(ptr));
 			})
-			| std::ranges::to<std::vector>();
-		__current = std::make_pair(name, vector);
-		break;
+			| std::ranges::to<std::vector>());
 	}
 
 	case NV_TYPE_DESCRIPTOR_ARRAY: {
 		auto nitems = std::size_t{};
-		auto ptr = cnvlist_get_descriptor_array(__cookie, &nitems);
-		auto span = std::span{ptr, nitems};
-		__current = std::make_pair(name, span);
-		break;
+		auto ptr = cnvlist_get_descriptor_array(cookie, &nitems);
+		return (std::span{ptr, nitems});
 	}
 
 	case NV_TYPE_NVLIST_ARRAY: {
 		auto nitems = std::size_t{};
-		auto ptr = cnvlist_get_nvlist_array(__cookie, &nitems);
+		auto ptr = cnvlist_get_nvlist_array(cookie, &nitems);
 		auto span = std::span{ptr, nitems};
-		auto vector =
-			span
+		return (span
 			| std::views::transform([] (::nvlist_t const *ptr) {
 				return (const_nv_list(ptr));
 			})
-			| std::ranges::to<std::vector>();
-		__current = std::make_pair(name, vector);
-		break;
+			| std::ranges::to<std::vector>());
 	}
 
 	default:
@@ -194,4 +177,6 @@ nv_list_iterator::__advance()
 	}
 }
 
+} // namespace bsd::__detail
+
 }
@@ -40,6 +40,16 @@ using nv_list_value_t = std::variant<
 	std::vector<const_nv_list>	/* nvlist array */
 >;
 
+namespace __detail {
+
+/*
+ * Return the value of the pair referred to by the given cookie, as returned by
+ * nvlist_next().
+ */
+nv_list_value_t __make_value(int __type, void const *__cookie);
+
+} // namespace bsd::__detail
+
 // the iterator value type
 using nv_list_pair_t = std::pair<nv_list_key_t, nv_list_value_t>;
 
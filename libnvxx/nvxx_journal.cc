@@ -0,0 +1,623 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR MIT
+ * Refer to the file 'LICENSE' in the nvxx distribution for license terms.
+ */
+
+#include <sys/types.h>
+#include <sys/endian.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+
+#if defined(__SSE4_2__)
+# include <nmmintrin.h>
+#endif
+
+#include "nvxx.h"
+
+/*
+ * The on-disk format of the journal is a 16-byte file header followed by
+ * zero or more records.  Each record consists of a 16-byte frame header
+ * followed by the packed nvlist.  All integers are little-endian.
+ *
+ *	file header:	char magic[8]; u32 version; u32 reserved;
+ *	frame header:	u32 length; u32 crc; u64 seqno;
+ *
+ * The CRC32C covers the packed nvlist followed by the encoded seqno, so the
+ * checksum of the payload can be calculated before the record is assigned a
+ * sequence number.
+ */
+
+namespace bsd {
+
+namespace {
+
+constexpr auto journal_magic = std::array<char, 8>{
+	'N', 'V', 'X', 'X', 'J', 'R', 'N', 'L'
+};
+constexpr std::uint32_t journal_version = 1;
+
+constexpr std::size_t file_header_size = 16;
+constexpr std::size_t frame_header_size = 16;
+
+struct frame_header {
+	std::uint32_t length;
+	std::uint32_t crc;
+	std::uint64_t seqno;
+};
+
+/*
+ * CRC32C (Castagnoli), using the SSE4.2 instruction if the compiler is
+ * allowed to use it, otherwise a slice-by-8 table.
+ */
+
+constexpr std::uint32_t crc32c_poly = 0x82f63b78;
+
+constexpr auto crc32c_tables = [] {
+	auto t = std::array<std::array<std::uint32_t, 256>, 8>{};
+
+	for (auto i = 0u; i < 256; ++i) {
+		auto c = std::uint32_t{i};
+		for (auto k = 0; k < 8; ++k)
+			c = (c & 1) ? ((c >> 1) ^ crc32c_poly) : (c >> 1);
+		t[0][i] = c;
+	}
+
+	for (auto i = 0u; i < 256; ++i)
+		for (auto k = 1u; k < 8; ++k)
+			t[k][i] = (t[k - 1][i] >> 8)
+				^ t[0][t[k - 1][i] & 0xff];
+
+	return (t);
+}();
+
+std::uint32_t
+crc32c(std::uint32_t crc, std::byte const *p, std::size_t n)
+{
+	crc = ~crc;
+
+#if defined(__SSE4_2__)
+	auto crc64 = std::uint64_t{crc};
+	for (; n >= 8; p += 8, n -= 8)
+		crc64 = _mm_crc32_u64(crc64, le64dec(p));
+	crc = static_cast<std::uint32_t>(crc64);
+	for (; n > 0; ++p, --n)
+		crc = _mm_crc32_u8(crc, std::to_integer<std::uint8_t>(*p));
+#else
+	auto const &t = crc32c_tables;
+
+	for (; n >= 8; p += 8, n -= 8) {
+		auto lo = crc ^ le32dec(p);
+		auto hi = le32dec(p + 4);
+		crc = t[7][lo & 0xff] ^ t[6][(lo >> 8) & 0xff]
+		    ^ t[5][(lo >> 16) & 0xff] ^ t[4][lo >> 24]
+		    ^ t[3][hi & 0xff] ^ t[2][(hi >> 8) & 0xff]
+		    ^ t[1][(hi >> 16) & 0xff] ^ t[0][hi >> 24];
+	}
+
+	for (; n > 0; ++p, --n)
+		crc = t[0][(crc ^ std::to_integer<std::uint32_t>(*p)) & 0xff]
+		    ^ (crc >> 8);
+#endif
+
+	return (~crc);
+}
+
+std::uint32_t
+record_crc(std::uint32_t payload_crc, std::uint64_t seqno)
+{
+	auto buf = std::array<std::byte, 8>{};
+	le64enc(buf.data(), seqno);
+	return (crc32c(payload_crc, buf.data(), buf.size()));
+}
+
+frame_header
+decode_frame(std::byte const *p)
+{
+	return {le32dec(p), le32dec(p + 4), le64dec(p + 8)};
+}
+
+void
+encode_frame(std::byte *p, frame_header const &frame)
+{
+	le32enc(p, frame.length);
+	le32enc(p + 4, frame.crc);
+	le64enc(p + 8, frame.seqno);
+}
+
+void
+check_file_header(std::byte const *p)
+{
+	if (std::memcmp(p, journal_magic.data(), journal_magic.size()) != 0)
+		throw nv_journal_corrupt(0, "bad journal magic");
+
+	if (le32dec(p + 8) != journal_version)
+		throw nv_journal_corrupt(0, "unsupported journal version");
+}
+
+[[noreturn]] void
+throw_errno(int err)
+{
+	throw std::system_error(std::error_code(err, std::system_category()));
+}
+
+/*
+ * Write the entire iovec to the given offset, retrying on short writes.
+ */
+void
+pwritev_all(int fd, std::span<::iovec> iov, off_t offset)
+{
+	while (!iov.empty()) {
+		auto ret = ::pwritev(fd, iov.data(),
+				     static_cast<int>(iov.size()), offset);
+		if (ret == -1) {
+			if (errno == EINTR)
+				continue;
+			throw_errno(errno);
+		}
+
+		offset += ret;
+
+		auto done = static_cast<std::size_t>(ret);
+		while (!iov.empty() && done >= iov.front().iov_len) {
+			done -= iov.front().iov_len;
+			iov = iov.subspan(1);
+		}
+
+		if (!iov.empty()) {
+			iov.front().iov_base =
+				static_cast<char *>(iov.front().iov_base) + done;
+			iov.front().iov_len -= done;
+		}
+	}
+}
+
+} // anonymous namespace
+
+/*
+ * nv_journal_record
+ */
+
+nv_list
+nv_journal_record::unpack(int flags) const
+{
+	return (nv_list::unpack(data, flags));
+}
+
+/*
+ * nv_journal_writer
+ */
+
+nv_journal_writer::nv_journal_writer(std::string const &path,
+				     nv_journal_options const &opts)
+	: __m_opts(opts)
+{
+	__m_fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	if (__m_fd == -1)
+		throw_errno(errno);
+
+	try {
+		__recover();
+	} catch (...) {
+		(void)::close(__m_fd);
+		throw;
+	}
+}
+
+/*
+ * Find the end of the journal and the next sequence number.  A trailing
+ * record which is incomplete or fails its checksum is assumed to be the
+ * result of an interrupted write and is discarded.
+ */
+void
+nv_journal_writer::__recover()
+{
+	struct ::stat sb{};
+	if (::fstat(__m_fd, &sb) == -1)
+		throw_errno(errno);
+
+	if (sb.st_size == 0) {
+		auto hdr = std::array<std::byte, file_header_size>{};
+		std::memcpy(hdr.data(), journal_magic.data(),
+			    journal_magic.size());
+		le32enc(hdr.data() + 8, journal_version);
+
+		auto iov = std::array<::iovec, 1>{{
+			{hdr.data(), hdr.size()}
+		}};
+		pwritev_all(__m_fd, iov, 0);
+
+		if (::fsync(__m_fd) == -1)
+			throw_errno(errno);
+
+		__m_size = file_header_size;
+		return;
+	}
+
+	auto size = static_cast<std::size_t>(sb.st_size);
+	if (size < file_header_size)
+		throw nv_journal_corrupt(0, "truncated journal header");
+
+	auto *map = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, __m_fd, 0);
+	if (map == MAP_FAILED)
+		throw_errno(errno);
+
+	auto *base = static_cast<std::byte const *>(map);
+	auto offset = std::uint64_t{file_header_size};
+	auto last = std::optional<std::uint64_t>();
+
+	try {
+		check_file_header(base);
+
+		while (offset + frame_header_size <= size) {
+			auto frame = decode_frame(base + offset);
+			auto end = offset + frame_header_size + frame.length;
+			if (end > size)
+				break;
+
+			if (last && frame.seqno != __m_next)
+				throw nv_journal_corrupt(offset,
+						"sequence number out of order");
+
+			last = offset;
+			__m_next = frame.seqno + 1;
+			offset = end;
+		}
+
+		if (last) {
+			auto frame = decode_frame(base + *last);
+			auto *data = base + *last + frame_header_size;
+			auto crc = record_crc(crc32c(0, data, frame.length),
+					      frame.seqno);
+			if (crc != frame.crc) {
+				offset = *last;
+				__m_next = frame.seqno;
+			}
+		}
+	} catch (...) {
+		(void)::munmap(map, size);
+		throw;
+	}
+
+	(void)::munmap(map, size);
+
+	if (offset != size && ::ftruncate(__m_fd, offset) == -1)
+		throw_errno(errno);
+
+	__m_size = offset;
+	__m_durable = __m_next;
+}
+
+nv_journal_writer::~nv_journal_writer()
+{
+	try {
+		commit();
+	} catch (...) {
+		/* nothing we can do here */
+	}
+
+	(void)::close(__m_fd);
+}
+
+std::uint64_t
+nv_journal_writer::append(const_nv_list const &nvl)
+{
+	if (auto err = nvl.error(); err)
+		throw nv_error_state(err);
+
+	auto size = std::size_t{};
+	auto *packed = ::nvlist_pack(nvl.ptr(), &size);
+	if (packed == nullptr)
+		throw_errno(errno);
+
+	auto data = __detail::__ptr_guard(static_cast<std::byte *>(packed));
+
+	if (size > UINT32_MAX)
+		throw std::system_error(
+			std::make_error_code(std::errc::file_too_large));
+
+	// checksum the payload before taking the lock
+	auto payload_crc = crc32c(0, data.__ptr, size);
+
+	auto lock = std::unique_lock(__m_mtx);
+	auto seqno = __m_next;
+
+	auto hdr = std::array<std::byte, frame_header_size>{};
+	encode_frame(hdr.data(), {
+		static_cast<std::uint32_t>(size),
+		record_crc(payload_crc, seqno),
+		seqno
+	});
+
+	auto iov = std::array<::iovec, 2>{{
+		{hdr.data(), hdr.size()},
+		{data.__ptr, size},
+	}};
+
+	try {
+		pwritev_all(__m_fd, iov, static_cast<off_t>(__m_size));
+	} catch (...) {
+		// don't leave a partial record in the journal
+		(void)::ftruncate(__m_fd, static_cast<off_t>(__m_size));
+		throw;
+	}
+
+	__m_size += hdr.size() + size;
+	++__m_next;
+
+	auto pending = __m_next - __m_durable;
+	lock.unlock();
+
+	if (__m_opts.group_size != 0 && pending >= __m_opts.group_size)
+		commit(seqno);
+
+	return (seqno);
+}
+
+void
+nv_journal_writer::commit(std::uint64_t seqno)
+{
+	auto lock = std::unique_lock(__m_mtx);
+
+	if (seqno >= __m_next)
+		throw std::out_of_range("journal record has not been written");
+
+	while (__m_durable <= seqno) {
+		if (__m_syncing) {
+			__m_cv.wait(lock);
+			continue;
+		}
+
+		/*
+		 * become the leader for this group; everything appended so
+		 * far will be covered by our fsync.
+		 */
+		__m_syncing = true;
+		auto target = __m_next;
+
+		lock.unlock();
+		auto ret = ::fdatasync(__m_fd);
+		auto err = errno;
+		lock.lock();
+
+		__m_syncing = false;
+		__m_cv.notify_all();
+
+		if (ret == -1)
+			throw_errno(err);
+
+		__m_durable = std::max(__m_durable, target);
+	}
+}
+
+void
+nv_journal_writer::commit()
+{
+	auto lock = std::unique_lock(__m_mtx);
+	if (__m_next == __m_durable)
+		return;
+
+	auto last = __m_next - 1;
+	lock.unlock();
+	commit(last);
+}
+
+std::uint64_t
+nv_journal_writer::next_seqno() const
+{
+	auto lock = std::unique_lock(__m_mtx);
+	return (__m_next);
+}
+
+/*
+ * nv_journal_reader
+ */
+
+nv_journal_reader::nv_journal_reader(std::string const &path,
+				     nv_journal_options const &opts)
+	: __m_opts(opts)
+{
+	if (__m_opts.index_interval == 0)
+		__m_opts.index_interval = 1;
+
+	__m_fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (__m_fd == -1)
+		throw_errno(errno);
+
+	try {
+		__map();
+		__scan();
+	} catch (...) {
+		__unmap();
+		(void)::close(__m_fd);
+		throw;
+	}
+}
+
+nv_journal_reader::~nv_journal_reader()
+{
+	__unmap();
+	(void)::close(__m_fd);
+}
+
+void
+nv_journal_reader::__map()
+{
+	struct ::stat sb{};
+	if (::fstat(__m_fd, &sb) == -1)
+		throw_errno(errno);
+
+	auto size = static_cast<std::size_t>(sb.st_size);
+	if (size == 0)
+		return;
+
+	auto *map = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, __m_fd, 0);
+	if (map == MAP_FAILED)
+		throw_errno(errno);
+
+	(void)::posix_madvise(map, size, POSIX_MADV_SEQUENTIAL);
+
+	__m_base = static_cast<std::byte const *>(map);
+	__m_mapsize = size;
+}
+
+void
+nv_journal_reader::__unmap() noexcept
+{
+	if (__m_base != nullptr)
+		(void)::munmap(const_cast<std::byte *>(__m_base), __m_mapsize);
+
+	__m_base = nullptr;
+	__m_mapsize = 0;
+}
+
+/*
+ * Index any complete records after the current end of the journal.  Only the
+ * frame headers are examined here; checksums are verified by next().
+ */
+void
+nv_journal_reader::__scan()
+{
+	if (__m_end == 0) {
+		// the writer may not have written the header yet
+		if (__m_mapsize < file_header_size)
+			return;
+
+		check_file_header(__m_base);
+		__m_end = __m_pos = file_header_size;
+	}
+
+	while (__m_end + frame_header_size <= __m_mapsize) {
+		auto frame = decode_frame(__m_base + __m_end);
+		auto end = __m_end + frame_header_size + frame.length;
+		if (end > __m_mapsize)
+			break;
+
+		if (__m_nrecords == 0)
+			__m_first = frame.seqno;
+		else if (frame.seqno != __m_first + __m_nrecords)
+			throw nv_journal_corrupt(__m_end,
+					"sequence number out of order");
+
+		if (__m_nrecords % __m_opts.index_interval == 0)
+			__m_index.emplace_back(frame.seqno, __m_end);
+
+		++__m_nrecords;
+		__m_end = end;
+	}
+}
+
+std::optional<nv_journal_record>
+nv_journal_reader::next()
+{
+	if (__m_pos >= __m_end)
+		return {};
+
+	auto frame = decode_frame(__m_base + __m_pos);
+	auto *data = __m_base + __m_pos + frame_header_size;
+
+	auto crc = record_crc(crc32c(0, data, frame.length), frame.seqno);
+	if (crc != frame.crc)
+		throw nv_journal_corrupt(__m_pos, "checksum mismatch");
+
+	__m_pos += frame_header_size + frame.length;
+	return (nv_journal_record{frame.seqno, {data, frame.length}});
+}
+
+void
+nv_journal_reader::seek(std::uint64_t seqno)
+{
+	if (seqno < __m_first || seqno - __m_first >= __m_nrecords)
+		throw std::out_of_range("journal sequence number out of range");
+
+	// find the last indexed record at or before seqno...
+	auto it = std::ranges::upper_bound(__m_index, seqno, {},
+			&std::pair<std::uint64_t, std::uint64_t>::first);
+	auto offset = std::prev(it)->second;
+
+	// ... then walk forward to the record itself.
+	for (;;) {
+		auto frame = decode_frame(__m_base + offset);
+		if (frame.seqno == seqno)
+			break;
+		offset += frame_header_size + frame.length;
+	}
+
+	__m_pos = offset;
+}
+
+void
+nv_journal_reader::rewind() noexcept
+{
+	__m_pos = __m_index.empty() ? __m_end : __m_index.front().second;
+}
+
+/*
+ * Forget every record, so that the next __scan() indexes the journal from the
+ * start.
+ */
+void
+nv_journal_reader::__reset() noexcept
+{
+	__m_end = __m_pos = 0;
+	__m_nrecords = 0;
+	__m_first = 0;
+	__m_index.clear();
+}
+
+bool
+nv_journal_reader::refresh()
+{
+	struct ::stat sb{};
+	if (::fstat(__m_fd, &sb) == -1)
+		throw_errno(errno);
+
+	auto const size = static_cast<std::uint64_t>(sb.st_size);
+	if (size == __m_mapsize)
+		return (false);
+
+	auto const old_end = __m_end;
+	auto const old_pos = __m_pos;
+
+	/*
+	 * If the journal has been truncated, for example by a writer removing
+	 * a torn record, records we have indexed may be gone: index it again
+	 * from the start, and keep the current position if it is still inside
+	 * the journal.
+	 */
+	auto const truncated = (size < __m_end);
+
+	__unmap();
+
+	try {
+		if (truncated)
+			__reset();
+
+		__map();
+		__scan();
+	} catch (...) {
+		__unmap();
+		__reset();
+		throw;
+	}
+
+	if (truncated && old_pos <= __m_end)
+		__m_pos = old_pos;
+
+	return (__m_end != old_end);
+}
+
+std::uint64_t
+nv_journal_reader::size() const noexcept
+{
+	return (__m_nrecords);
+}
+
+} // namespace bsd
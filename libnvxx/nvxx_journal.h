@@ -0,0 +1,219 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR MIT
+ * Refer to the file 'LICENSE' in the nvxx distribution for license terms.
+ */
+
+#ifndef	_NVXX_JOURNAL_H_INCLUDED
+#define _NVXX_JOURNAL_H_INCLUDED
+
+#ifndef _NVXX_H_INCLUDED
+# error include <nvxx.h> instead of including this header directly
+#endif
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+
+/*
+ * nv_journal: an append-only log of packed nvlists.
+ *
+ * Each record in the journal is framed with its length, its sequence number
+ * and a CRC32C checksum.  Records are appended by nv_journal_writer and read
+ * back by nv_journal_reader, which maps the file into memory and keeps a
+ * sparse index of record offsets to allow seeking by sequence number.
+ */
+
+namespace bsd {
+
+/*
+ * The journal file contains a record which is damaged or is not a valid
+ * journal record.
+ */
+struct nv_journal_corrupt : nv_error {
+	std::uint64_t offset;
+
+	nv_journal_corrupt(std::uint64_t __offset, std::string_view __what)
+		: nv_error("corrupt journal record at offset {0}: {1}",
+			   __offset, __what)
+		, offset(__offset)
+	{
+	}
+};
+
+struct nv_journal_options {
+	/*
+	 * If non-zero, the writer will automatically commit the journal
+	 * after this many records have been appended without an intervening
+	 * commit.  If zero, records are only made durable by an explicit call
+	 * to commit().
+	 */
+	std::size_t group_size = 0;
+
+	/*
+	 * The reader stores the offset of every index_interval'th record in
+	 * its index.  Smaller values make seek() faster at the cost of memory.
+	 */
+	std::size_t index_interval = 64;
+};
+
+/*
+ * A single record read from the journal.  The data span refers to the mapped
+ * journal file and remains valid until the reader is destroyed or refresh()
+ * is called.
+ */
+struct nv_journal_record {
+	std::uint64_t seqno{};
+	std::span<std::byte const> data;
+
+	/*
+	 * Unpack the record into a new nv_list, as if by nv_list::unpack().
+	 */
+	[[nodiscard]] nv_list unpack(int __flags = 0) const;
+};
+
+/*
+ * Append records to a journal file.  The writer may be used concurrently from
+ * multiple threads; callers which commit concurrently share a single fsync()
+ * (group commit).
+ */
+struct nv_journal_writer {
+	/*
+	 * Open the journal at the given path for writing, creating it if it
+	 * does not exist.  If the file ends with a partially written record,
+	 * the partial record is discarded.  On failure, throws
+	 * std::system_error, or nv_journal_corrupt if the file is not a valid
+	 * journal.
+	 */
+	explicit nv_journal_writer(std::string const &__path,
+				   nv_journal_options const &__opts = {});
+
+	nv_journal_writer(nv_journal_writer const &) = delete;
+	nv_journal_writer &operator=(nv_journal_writer const &) = delete;
+
+	/*
+	 * Commit any outstanding records and close the journal.  Errors
+	 * during the final commit are ignored.
+	 */
+	~nv_journal_writer();
+
+	/*
+	 * Pack the given nvlist and append it to the journal, returning its
+	 * sequence number.  The record is not durable until it has been
+	 * committed.  On failure, throws std::system_error.
+	 */
+	std::uint64_t append(const_nv_list const &);
+
+	/*
+	 * Wait until every record up to and including the given sequence
+	 * number is durable.  If another thread is already committing, the
+	 * caller waits for that commit instead of issuing its own.  On
+	 * failure, throws std::system_error.
+	 */
+	void commit(std::uint64_t __seqno);
+
+	/*
+	 * Commit every record appended so far.
+	 */
+	void commit();
+
+	/*
+	 * Return the sequence number which will be assigned to the next
+	 * record.
+	 */
+	[[nodiscard]] std::uint64_t next_seqno() const;
+
+private:
+	int __m_fd = -1;
+	nv_journal_options __m_opts;
+
+	mutable std::mutex __m_mtx;
+	std::condition_variable __m_cv;
+
+	std::uint64_t __m_size = 0;	/* end of the last record */
+	std::uint64_t __m_next = 0;	/* next sequence number */
+	std::uint64_t __m_durable = 0;	/* records below this are durable */
+	bool __m_syncing = false;	/* a commit is in progress */
+
+	void __recover();
+};
+
+/*
+ * Read records from a journal file.  The file is mapped into memory, so
+ * records can be replayed without copying them.
+ */
+struct nv_journal_reader {
+	/*
+	 * Open and map the journal at the given path.  On failure, throws
+	 * std::system_error, or nv_journal_corrupt if the file is not a valid
+	 * journal.
+	 */
+	explicit nv_journal_reader(std::string const &__path,
+				   nv_journal_options const &__opts = {});
+
+	nv_journal_reader(nv_journal_reader const &) = delete;
+	nv_journal_reader &operator=(nv_journal_reader const &) = delete;
+
+	~nv_journal_reader();
+
+	/*
+	 * Return the next record in the journal and advance past it, or an
+	 * empty optional if the end of the journal has been reached.  If the
+	 * record's checksum does not match, throws nv_journal_corrupt.
+	 */
+	[[nodiscard]] std::optional<nv_journal_record> next();
+
+	/*
+	 * Position the reader so that the next call to next() returns the
+	 * record with the given sequence number.  If no such record exists,
+	 * throws std::out_of_range.
+	 */
+	void seek(std::uint64_t __seqno);
+
+	/*
+	 * Position the reader at the start of the journal.
+	 */
+	void rewind() noexcept;
+
+	/*
+	 * Re-examine the journal file for records which were appended since
+	 * it was opened or last refreshed, and return true if any were found.
+	 * This can be used to follow a journal which is being written to.
+	 * Refreshing invalidates any records previously returned by next().
+	 *
+	 * If the journal has been truncated, records past its new end are
+	 * forgotten, and if the current position was past the end, the reader
+	 * is positioned at the start of the journal.
+	 */
+	bool refresh();
+
+	/*
+	 * Return the number of complete records in the journal.
+	 */
+	[[nodiscard]] std::uint64_t size() const noexcept;
+
+private:
+	int __m_fd = -1;
+	nv_journal_options __m_opts;
+
+	std::byte const *__m_base = nullptr;
+	std::size_t __m_mapsize = 0;
+
+	std::uint64_t __m_end = 0;	/* end of the last complete record */
+	std::uint64_t __m_nrecords = 0;
+	std::uint64_t __m_first = 0;	/* seqno of the first record */
+	std::uint64_t __m_pos = 0;	/* offset of the next record */
+
+	/* (seqno, offset) of every index_interval'th record */
+	std::vector<std::pair<std::uint64_t, std::uint64_t>> __m_index;
+
+	void __map();
+	void __unmap() noexcept;
+	void __scan();
+	void __reset() noexcept;
+};
+
+} // namespace bsd
+
+#endif	/* !_NVXX_JOURNAL_H_INCLUDED */
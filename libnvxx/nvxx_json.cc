@@ -0,0 +1,472 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR MIT
+ * Refer to the file 'LICENSE' in the nvxx distribution for license terms.
+ */
+
+#include <bit>
+#include <charconv>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if defined(__SSE2__)
+# include <emmintrin.h>
+#endif
+
+#include "nvxx.h"
+
+namespace bsd {
+
+namespace {
+
+// Objects nested more deeply than this are rejected.
+constexpr unsigned max_depth = 512;
+
+/*
+ * Return the offset of the first character in [p, end) which ends a run of
+ * plain string characters: a quote, a backslash or a control character.
+ * This is where the parser spends most of its time on typical input, so
+ * it examines 16 bytes at a time with SSE2 where that is available, and 8
+ * bytes at a time in a 64-bit word otherwise.
+ */
+std::size_t
+scan_string(char const *p, char const *end) noexcept
+{
+	auto const *const start = p;
+
+#if defined(__SSE2__)
+	auto const quote = _mm_set1_epi8('"');
+	auto const backslash = _mm_set1_epi8('\\');
+	auto const control = _mm_set1_epi8(0x1f);
+
+	while (end - p >= 16) {
+		auto const v = _mm_loadu_si128(
+			reinterpret_cast<__m128i const *>(p));
+		// v <= 0x1f (unsigned) iff max(v, 0x1f) == 0x1f
+		auto const special = _mm_or_si128(
+			_mm_or_si128(_mm_cmpeq_epi8(v, quote),
+				     _mm_cmpeq_epi8(v, backslash)),
+			_mm_cmpeq_epi8(_mm_max_epu8(v, control), control));
+
+		if (auto const mask = static_cast<unsigned>(
+			    _mm_movemask_epi8(special)); mask != 0)
+			return (static_cast<std::size_t>(p - start)
+				+ static_cast<std::size_t>(
+					std::countr_zero(mask)));
+		p += 16;
+	}
+#else
+	constexpr auto ones = ~std::uint64_t{0} / 255;
+	constexpr auto highs = ones * 0x80;
+
+	auto has_zero = [] (std::uint64_t x) {
+		return (((x - ones) & ~x & highs) != 0);
+	};
+
+	while (end - p >= 8) {
+		std::uint64_t w;
+		std::memcpy(&w, p, sizeof(w));
+
+		auto const special = has_zero(w ^ (ones * '"'))
+			|| has_zero(w ^ (ones * '\\'))
+			|| ((w - ones * 0x20) & ~w & highs) != 0;
+		if (special)
+			break;
+		p += 8;
+	}
+#endif
+
+	while (p < end) {
+		auto const c = static_cast<unsigned char>(*p);
+		if (c == '"' || c == '\\' || c < 0x20)
+			break;
+		++p;
+	}
+
+	return (static_cast<std::size_t>(p - start));
+}
+
+void
+append_utf8(std::string &out, std::uint32_t cp)
+{
+	if (cp < 0x80) {
+		out += static_cast<char>(cp);
+	} else if (cp < 0x800) {
+		out += static_cast<char>(0xc0 | (cp >> 6));
+		out += static_cast<char>(0x80 | (cp & 0x3f));
+	} else if (cp < 0x10000) {
+		out += static_cast<char>(0xe0 | (cp >> 12));
+		out += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+		out += static_cast<char>(0x80 | (cp & 0x3f));
+	} else {
+		out += static_cast<char>(0xf0 | (cp >> 18));
+		out += static_cast<char>(0x80 | ((cp >> 12) & 0x3f));
+		out += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+		out += static_cast<char>(0x80 | (cp & 0x3f));
+	}
+}
+
+/*
+ * A recursive-descent parser which adds values to the nv_list as they are
+ * parsed.
+ */
+struct parser {
+	std::string_view text;
+	int flags;
+	std::size_t pos = 0;
+	unsigned depth = 0;
+
+	[[noreturn]] void fail(std::string_view what) const {
+		throw nv_json_error(pos, what);
+	}
+
+	[[noreturn]] void fail_at(std::size_t at, std::string_view what) const {
+		throw nv_json_error(at, what);
+	}
+
+	bool at_end() const noexcept {
+		return (pos >= text.size());
+	}
+
+	char peek() const noexcept {
+		return (at_end() ? '\0' : text[pos]);
+	}
+
+	void skip_ws() noexcept {
+		while (!at_end()) {
+			switch (text[pos]) {
+			case ' ': case '\t': case '\n': case '\r':
+				++pos;
+				continue;
+			}
+			break;
+		}
+	}
+
+	void expect(char c) {
+		if (peek() != c)
+			fail(std::format("expected '{}'", c));
+		++pos;
+	}
+
+	bool literal(std::string_view word) noexcept {
+		if (text.substr(pos, word.size()) != word)
+			return (false);
+		pos += word.size();
+		return (true);
+	}
+
+	nv_list parse_document();
+	nv_list parse_object();
+	void parse_member(nv_list &, std::string const &key, std::size_t at);
+	void parse_array(nv_list &, std::string const &key);
+	std::string parse_string();
+	std::uint64_t parse_number();
+	std::uint32_t parse_hex4();
+};
+
+nv_list
+parser::parse_document()
+{
+	skip_ws();
+	if (peek() != '{')
+		fail("expected an object");
+
+	auto nvl = parse_object();
+
+	skip_ws();
+	if (!at_end())
+		fail("unexpected data after the object");
+
+	return (nvl);
+}
+
+nv_list
+parser::parse_object()
+{
+	if (++depth > max_depth)
+		fail("objects nested too deeply");
+
+	expect('{');
+	auto nvl = nv_list(flags);
+
+	skip_ws();
+	if (peek() == '}') {
+		++pos;
+		--depth;
+		return (nvl);
+	}
+
+	for (;;) {
+		skip_ws();
+		if (peek() != '"')
+			fail("expected a key");
+
+		auto const at = pos;
+		auto const key = parse_string();
+
+		skip_ws();
+		expect(':');
+		skip_ws();
+		parse_member(nvl, key, at);
+
+		skip_ws();
+		if (peek() == ',') {
+			++pos;
+			continue;
+		}
+
+		expect('}');
+		break;
+	}
+
+	--depth;
+	return (nvl);
+}
+
+void
+parser::parse_member(nv_list &nvl, std::string const &key, std::size_t at)
+{
+	try {
+		switch (peek()) {
+		case '{':
+			nvl.move_nvlist(key, parse_object());
+			return;
+
+		case '[':
+			parse_array(nvl, key);
+			return;
+
+		case '"':
+			nvl.add_string(key, parse_string());
+			return;
+
+		case 't':
+		case 'f':
+		case 'n':
+			if (literal("true"))
+				nvl.add_bool(key, true);
+			else if (literal("false"))
+				nvl.add_bool(key, false);
+			else if (literal("null"))
+				nvl.add_null(key);
+			else
+				fail("invalid literal");
+			return;
+
+		default:
+			nvl.add_number(key, parse_number());
+			return;
+		}
+	} catch (nv_key_exists const &) {
+		fail_at(at, "duplicate key");
+	}
+}
+
+void
+parser::parse_array(nv_list &nvl, std::string const &key)
+{
+	expect('[');
+	skip_ws();
+
+	if (peek() == ']') {
+		++pos;
+		nvl.add_number_array(key, {});
+		return;
+	}
+
+	/*
+	 * The type of the array is the type of its first element, and every
+	 * other element must have the same type.
+	 */
+	auto const type = peek();
+	auto numbers = std::vector<std::uint64_t>();
+	auto bools = std::vector<bool>();
+	auto strings = std::vector<std::string>();
+	auto lists = std::vector<nv_list>();
+
+	for (;;) {
+		skip_ws();
+
+		auto const c = peek();
+		auto const is_bool = c == 't' || c == 'f';
+		auto const same = c == type
+			|| (is_bool && (type == 't' || type == 'f'))
+			|| ((c == '-' || (c >= '0' && c <= '9'))
+			    && (type == '-' || (type >= '0' && type <= '9')));
+
+		if (c == ']' || c == ',' || c == '\0')
+			fail("expected a value");
+		if (c == '[')
+			fail("nested arrays cannot be stored in an nvlist");
+		if (c == 'n')
+			fail("arrays containing null cannot be stored "
+			     "in an nvlist");
+		if (!same)
+			fail("arrays of mixed types cannot be stored "
+			     "in an nvlist");
+
+		if (c == '{') {
+			lists.push_back(parse_object());
+		} else if (c == '"') {
+			strings.push_back(parse_string());
+		} else if (is_bool) {
+			if (literal("true"))
+				bools.push_back(true);
+			else if (literal("false"))
+				bools.push_back(false);
+			else
+				fail("invalid literal");
+		} else {
+			numbers.push_back(parse_number());
+		}
+
+		skip_ws();
+		if (peek() == ',') {
+			++pos;
+			continue;
+		}
+
+		expect(']');
+		break;
+	}
+
+	if (type == '{') {
+		// move the lists into the nvlist rather than copying them.
+		auto ptrs = __detail::__malloc_copy<::nvlist_t *>(
+			lists | std::views::transform([] (nv_list &l) {
+				return (std::move(l).release());
+			}));
+		nvl.move_nvlist_array(key, ptrs);
+	} else if (type == '"') {
+		nvl.add_string_range(key, strings);
+	} else if (type == 't' || type == 'f') {
+		nvl.add_bool_range(key, bools);
+	} else {
+		nvl.add_number_array(key, numbers);
+	}
+}
+
+std::uint32_t
+parser::parse_hex4()
+{
+	auto value = std::uint32_t{};
+	auto const *first = text.data() + pos;
+	auto const *last = first + std::min<std::size_t>(4, text.size() - pos);
+
+	auto const res = std::from_chars(first, last, value, 16);
+	if (res.ec != std::errc() || res.ptr != first + 4)
+		fail("invalid \\u escape");
+
+	pos += 4;
+	return (value);
+}
+
+std::string
+parser::parse_string()
+{
+	expect('"');
+
+	auto out = std::string();
+
+	for (;;) {
+		auto const *p = text.data() + pos;
+		auto const run = scan_string(p, text.data() + text.size());
+		out.append(p, run);
+		pos += run;
+
+		if (at_end())
+			fail("unterminated string");
+
+		auto const c = text[pos];
+		if (c == '"') {
+			++pos;
+			return (out);
+		}
+
+		if (c != '\\')
+			fail("control character in string");
+
+		auto const esc = pos++;
+		switch (peek()) {
+		case '"':	out += '"'; break;
+		case '\\':	out += '\\'; break;
+		case '/':	out += '/'; break;
+		case 'b':	out += '\b'; break;
+		case 'f':	out += '\f'; break;
+		case 'n':	out += '\n'; break;
+		case 'r':	out += '\r'; break;
+		case 't':	out += '\t'; break;
+
+		case 'u': {
+			++pos;
+			auto cp = parse_hex4();
+
+			if (cp >= 0xd800 && cp <= 0xdbff) {
+				if (!literal("\\u"))
+					fail_at(esc, "unpaired surrogate");
+				auto const low = parse_hex4();
+				if (low < 0xdc00 || low > 0xdfff)
+					fail_at(esc, "unpaired surrogate");
+				cp = 0x10000 + ((cp - 0xd800) << 10)
+					+ (low - 0xdc00);
+			} else if (cp >= 0xdc00 && cp <= 0xdfff) {
+				fail_at(esc, "unpaired surrogate");
+			}
+
+			if (cp == 0)
+				fail_at(esc, "nvlist strings may not "
+				        "contain NUL");
+
+			append_utf8(out, cp);
+			continue;
+		}
+
+		default:
+			fail_at(esc, "invalid escape sequence");
+		}
+
+		++pos;
+	}
+}
+
+std::uint64_t
+parser::parse_number()
+{
+	auto const start = pos;
+
+	if (peek() == '-')
+		fail("negative numbers cannot be stored in an nvlist");
+
+	if (peek() < '0' || peek() > '9')
+		fail("expected a value");
+
+	if (peek() == '0' && pos + 1 < text.size()
+	    && text[pos + 1] >= '0' && text[pos + 1] <= '9')
+		fail("numbers may not have leading zeroes");
+
+	auto value = std::uint64_t{};
+	auto const res = std::from_chars(text.data() + pos,
+					 text.data() + text.size(), value);
+	if (res.ec == std::errc::result_out_of_range)
+		fail_at(start, "number too large to be stored in an nvlist");
+
+	pos = static_cast<std::size_t>(res.ptr - text.data());
+
+	if (auto const c = peek(); c == '.' || c == 'e' || c == 'E')
+		fail_at(start, "non-integer numbers cannot be stored "
+			"in an nvlist");
+
+	return (value);
+}
+
+} // anonymous namespace
+
+nv_list
+nv_from_json(std::string_view text, int flags)
+{
+	auto p = parser{.text = text, .flags = flags};
+	return (p.parse_document());
+}
+
+} // namespace bsd
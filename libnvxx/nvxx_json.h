@@ -0,0 +1,361 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR MIT
+ * Refer to the file 'LICENSE' in the nvxx distribution for license terms.
+ */
+
+#ifndef	_NVXX_JSON_H_INCLUDED
+#define _NVXX_JSON_H_INCLUDED
+
+#ifndef _NVXX_H_INCLUDED
+# error include <nvxx.h> instead of including this header directly
+#endif
+
+#include <charconv>
+#include <cstdint>
+#include <iterator>
+
+/*
+ * JSON import and export of nvlists.
+ *
+ * An nvlist is written as a JSON object, with its pairs in the order returned
+ * by nvlist_next().  Values are mapped as follows:
+ *
+ *	null			null
+ *	bool			true or false
+ *	number			an integer
+ *	string			a string
+ *	nvlist			an object
+ *	descriptor		the descriptor number
+ *	binary			a string containing the base64-encoded data
+ *	arrays			an array of the above
+ *
+ * Keys and strings are written as UTF-8 with only the characters which JSON
+ * requires to be escaped escaped; they are not otherwise checked.
+ *
+ * nv_from_json() performs the reverse mapping, except that binary values and
+ * descriptors cannot be distinguished from strings and numbers.  Since an
+ * nvlist cannot store them, negative and non-integer numbers, arrays of mixed
+ * types, arrays containing null or other arrays, and strings containing NUL
+ * are rejected.  An empty array is stored as an empty number array.
+ */
+
+namespace bsd {
+
+/*
+ * nv_from_json() was given invalid JSON, or JSON which cannot be represented
+ * as an nvlist.  offset is the offset in the input of the error.
+ */
+struct nv_json_error : nv_error {
+	std::size_t offset;
+
+	nv_json_error(std::size_t __offset, std::string_view __what)
+		: nv_error("invalid JSON at offset {0}: {1}", __offset, __what)
+		, offset(__offset)
+	{
+	}
+};
+
+namespace __detail {
+
+template<std::output_iterator<char> _O>
+_O
+__json_number(std::uint64_t __value, _O __out)
+{
+	char __buf[20];
+	auto const __res = std::to_chars(__buf, __buf + sizeof(__buf), __value);
+	return (std::ranges::copy(__buf, __res.ptr, std::move(__out)).out);
+}
+
+inline constexpr bool
+__json_needs_escape(char __c) noexcept
+{
+	auto const __u = static_cast<unsigned char>(__c);
+	return (__u < 0x20 || __c == '"' || __c == '\\');
+}
+
+/*
+ * Write a quoted string.  Runs of characters which do not need escaping are
+ * copied in one go.
+ */
+template<std::output_iterator<char> _O>
+_O
+__json_string(std::string_view __str, _O __out)
+{
+	static constexpr char __hex[] = "0123456789abcdef";
+
+	*__out++ = '"';
+
+	auto __it = __str.begin();
+	while (__it != __str.end()) {
+		auto const __run = std::ranges::find_if(__it, __str.end(),
+							__json_needs_escape);
+		__out = std::ranges::copy(__it, __run, std::move(__out)).out;
+		if (__run == __str.end())
+			break;
+
+		*__out++ = '\\';
+		switch (*__run) {
+		case '"':	*__out++ = '"'; break;
+		case '\\':	*__out++ = '\\'; break;
+		case '\b':	*__out++ = 'b'; break;
+		case '\f':	*__out++ = 'f'; break;
+		case '\n':	*__out++ = 'n'; break;
+		case '\r':	*__out++ = 'r'; break;
+		case '\t':	*__out++ = 't'; break;
+		default: {
+			auto const __u = static_cast<unsigned char>(*__run);
+			*__out++ = 'u';
+			*__out++ = '0';
+			*__out++ = '0';
+			*__out++ = __hex[__u >> 4];
+			*__out++ = __hex[__u & 0xf];
+			break;
+		}
+		}
+
+		__it = __run + 1;
+	}
+
+	*__out++ = '"';
+	return (__out);
+}
+
+/*
+ * Write binary data as a quoted base64 string, as described in RFC 4648.
+ */
+template<std::output_iterator<char> _O>
+_O
+__json_base64(std::span<std::byte const> __data, _O __out)
+{
+	static constexpr char __alphabet[] =
+		"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz"
+		"0123456789+/";
+
+	auto __byte = [&] (std::size_t __i) -> unsigned {
+		return (std::to_integer<unsigned>(__data[__i]));
+	};
+
+	*__out++ = '"';
+
+	auto __i = std::size_t{0};
+	for (; __i + 3 <= __data.size(); __i += 3) {
+		auto const __v = (__byte(__i) << 16)
+			| (__byte(__i + 1) << 8)
+			| __byte(__i + 2);
+		*__out++ = __alphabet[(__v >> 18) & 0x3f];
+		*__out++ = __alphabet[(__v >> 12) & 0x3f];
+		*__out++ = __alphabet[(__v >> 6) & 0x3f];
+		*__out++ = __alphabet[__v & 0x3f];
+	}
+
+	if (auto const __left = __data.size() - __i; __left > 0) {
+		auto __v = __byte(__i) << 16;
+		if (__left == 2)
+			__v |= __byte(__i + 1) << 8;
+
+		*__out++ = __alphabet[(__v >> 18) & 0x3f];
+		*__out++ = __alphabet[(__v >> 12) & 0x3f];
+		*__out++ = __left == 2 ? __alphabet[(__v >> 6) & 0x3f] : '=';
+		*__out++ = '=';
+	}
+
+	*__out++ = '"';
+	return (__out);
+}
+
+/*
+ * Write a JSON array by calling __fn(element, out) for each element.
+ */
+template<typename _T, std::output_iterator<char> _O, typename _F>
+_O
+__json_array(std::span<_T const> __items, _O __out, _F &&__fn)
+{
+	*__out++ = '[';
+	for (auto __i = std::size_t{0}; __i < __items.size(); ++__i) {
+		if (__i > 0)
+			*__out++ = ',';
+		__out = __fn(__items[__i], std::move(__out));
+	}
+	*__out++ = ']';
+	return (__out);
+}
+
+template<std::output_iterator<char> _O>
+_O __json_object(::nvlist_t const *, _O);
+
+template<std::output_iterator<char> _O>
+_O
+__json_value(int __type, void const *__cookie, _O __out)
+{
+	using namespace std::literals;
+
+	auto __nitems = std::size_t{};
+
+	switch (__type) {
+	case NV_TYPE_NULL:
+		return (std::ranges::copy("null"sv, std::move(__out)).out);
+
+	case NV_TYPE_BOOL:
+		return (std::ranges::copy(::cnvlist_get_bool(__cookie)
+					  ? "true"sv : "false"sv,
+					  std::move(__out)).out);
+
+	case NV_TYPE_NUMBER:
+		return (__json_number(::cnvlist_get_number(__cookie),
+				      std::move(__out)));
+
+	case NV_TYPE_STRING:
+		return (__json_string(::cnvlist_get_string(__cookie),
+				      std::move(__out)));
+
+	case NV_TYPE_NVLIST:
+		return (__json_object(::cnvlist_get_nvlist(__cookie),
+				      std::move(__out)));
+
+	case NV_TYPE_DESCRIPTOR:
+		return (__json_number(static_cast<std::uint64_t>(
+			::cnvlist_get_descriptor(__cookie)), std::move(__out)));
+
+	case NV_TYPE_BINARY: {
+		auto const *__data = ::cnvlist_get_binary(__cookie, &__nitems);
+		return (__json_base64(std::span(
+			static_cast<std::byte const *>(__data), __nitems),
+			std::move(__out)));
+	}
+
+	case NV_TYPE_BOOL_ARRAY: {
+		auto const *__data = ::cnvlist_get_bool_array(__cookie,
+							      &__nitems);
+		return (__json_array(std::span(__data, __nitems),
+				     std::move(__out),
+			[] (bool __b, _O __o) {
+				return (std::ranges::copy(__b ? "true"sv
+							  : "false"sv,
+							  std::move(__o)).out);
+			}));
+	}
+
+	case NV_TYPE_NUMBER_ARRAY: {
+		auto const *__data = ::cnvlist_get_number_array(__cookie,
+								&__nitems);
+		return (__json_array(std::span(__data, __nitems),
+				     std::move(__out),
+			[] (std::uint64_t __n, _O __o) {
+				return (__json_number(__n, std::move(__o)));
+			}));
+	}
+
+	case NV_TYPE_STRING_ARRAY: {
+		auto const *__data = ::cnvlist_get_string_array(__cookie,
+								&__nitems);
+		return (__json_array(std::span(__data, __nitems),
+				     std::move(__out),
+			[] (char const *__s, _O __o) {
+				return (__json_string(__s, std::move(__o)));
+			}));
+	}
+
+	case NV_TYPE_NVLIST_ARRAY: {
+		auto const *__data = ::cnvlist_get_nvlist_array(__cookie,
+								&__nitems);
+		return (__json_array(std::span(__data, __nitems),
+				     std::move(__out),
+			[] (::nvlist_t const *__nvl, _O __o) {
+				return (__json_object(__nvl, std::move(__o)));
+			}));
+	}
+
+	case NV_TYPE_DESCRIPTOR_ARRAY: {
+		auto const *__data = ::cnvlist_get_descriptor_array(__cookie,
+								    &__nitems);
+		return (__json_array(std::span(__data, __nitems),
+				     std::move(__out),
+			[] (int __fd, _O __o) {
+				return (__json_number(
+					static_cast<std::uint64_t>(__fd),
+					std::move(__o)));
+			}));
+	}
+
+	default:
+		std::abort();
+	}
+}
+
+template<std::output_iterator<char> _O>
+_O
+__json_object(::nvlist_t const *__nvl, _O __out)
+{
+	*__out++ = '{';
+
+	void *__cookie = nullptr;
+	auto __first = true;
+	int __type;
+
+	while (auto const *__key = ::nvlist_next(__nvl, &__type, &__cookie)) {
+		if (!__first)
+			*__out++ = ',';
+		__first = false;
+
+		__out = __json_string(__key, std::move(__out));
+		*__out++ = ':';
+		__out = __json_value(__type, __cookie, std::move(__out));
+	}
+
+	*__out++ = '}';
+	return (__out);
+}
+
+} // namespace bsd::__detail
+
+/*
+ * Write the nvlist to the output iterator as a JSON object, and return the
+ * iterator.  If the nvlist is in the error state, throws nv_error_state.
+ */
+template<std::output_iterator<char> _O>
+_O
+nv_to_json(const_nv_list const &__nvl, _O __out)
+{
+	if (auto const __err = __nvl.error(); __err)
+		throw nv_error_state(__err);
+
+	return (__detail::__json_object(__nvl.ptr(), std::move(__out)));
+}
+
+/*
+ * Parse a JSON object and return it as an nv_list created with the given
+ * flags.  If the input is not valid JSON, or cannot be represented as an
+ * nvlist, throws nv_json_error.  If the nvlist was not created with
+ * NV_FLAG_NO_UNIQUE, duplicate keys are an error.
+ */
+[[nodiscard]] nv_list nv_from_json(std::string_view, int __flags = 0);
+
+} // namespace bsd
+
+/*
+ * Format an nvlist as JSON, as if by nv_to_json().  No format specification
+ * is accepted.
+ */
+
+template<>
+struct std::formatter<bsd::const_nv_list, char> {
+	constexpr auto parse(std::format_parse_context &__ctx) {
+		auto __it = __ctx.begin();
+		if (__it != __ctx.end() && *__it != '}')
+			throw std::format_error("invalid format specification "
+						"for an nvlist");
+		return (__it);
+	}
+
+	template<typename _Ctx>
+	auto format(bsd::const_nv_list const &__nvl, _Ctx &__ctx) const {
+		return (bsd::nv_to_json(__nvl, __ctx.out()));
+	}
+};
+
+template<>
+struct std::formatter<bsd::nv_list, char>
+	: std::formatter<bsd::const_nv_list, char> {
+};
+
+#endif	/* !_NVXX_JSON_H_INCLUDED */
@@ -0,0 +1,190 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR MIT
+ * Refer to the file 'LICENSE' in the nvxx distribution for license terms.
+ */
+
+#include <bit>
+#include <cstdlib>
+#include <cstring>
+
+#include "nvxx.h"
+
+namespace bsd {
+
+namespace {
+
+/*
+ * The layout of struct nvlist and struct nvpair in libnv, which are private,
+ * used only for their size.  Each nvpair is allocated together with its key.
+ */
+struct model_nvlist {
+	int		 magic;
+	int		 error;
+	int		 flags;
+	std::size_t	 datasize;
+	void		*parent;
+	void		*array_next;
+	void		*head[2];
+};
+
+struct model_nvpair {
+	int		 magic;
+	char		*name;
+	int		 type;
+	std::uint64_t	 data;
+	std::size_t	 datasize;
+	std::size_t	 nitems;
+	void		*list;
+	void		*next[2];
+};
+
+/*
+ * Return the size malloc() actually allocates for a request of n bytes,
+ * using the jemalloc small size classes: multiples of 16 up to 128, then
+ * four classes for each power of two.
+ */
+std::size_t
+malloc_size(std::size_t n) noexcept
+{
+	if (n <= 8)
+		return (8);
+	if (n <= 128)
+		return ((n + 15) & ~std::size_t{15});
+
+	auto const lg = static_cast<unsigned>(std::bit_width(n - 1)) - 1;
+	auto const step = std::size_t{1} << (lg - 2);
+	return ((n + step - 1) & ~(step - 1));
+}
+
+/*
+ * Account for one allocation of n bytes in the given field.
+ */
+void
+allocate(nv_memory_usage &usage, std::size_t nv_memory_usage::*field,
+	 std::size_t n) noexcept
+{
+	usage.*field += n;
+	usage.overhead += malloc_size(n) - n;
+	++usage.allocations;
+}
+
+nv_memory_usage measure(::nvlist_t const *);
+
+void
+measure_pair(nv_memory_usage &usage, char const *key, int type, void *cookie)
+{
+	auto const keylen = std::strlen(key) + 1;
+
+	// the pair and its key are a single allocation.
+	usage.nodes += sizeof(model_nvpair);
+	usage.keys += keylen;
+	usage.overhead += malloc_size(sizeof(model_nvpair) + keylen)
+		- (sizeof(model_nvpair) + keylen);
+	++usage.allocations;
+
+	auto nitems = std::size_t{};
+
+	switch (type) {
+	case NV_TYPE_NULL:
+	case NV_TYPE_BOOL:
+	case NV_TYPE_NUMBER:
+	case NV_TYPE_DESCRIPTOR:
+		break;
+
+	case NV_TYPE_STRING:
+		allocate(usage, &nv_memory_usage::values,
+			 std::strlen(::cnvlist_get_string(cookie)) + 1);
+		break;
+
+	case NV_TYPE_BINARY:
+		(void)::cnvlist_get_binary(cookie, &nitems);
+		allocate(usage, &nv_memory_usage::values, nitems);
+		break;
+
+	case NV_TYPE_NVLIST: {
+		auto child = measure(::cnvlist_get_nvlist(cookie));
+		usage += child;
+		usage.children.emplace_back(key, std::move(child));
+		break;
+	}
+
+	case NV_TYPE_BOOL_ARRAY:
+		(void)::cnvlist_get_bool_array(cookie, &nitems);
+		allocate(usage, &nv_memory_usage::arrays,
+			 nitems * sizeof(bool));
+		break;
+
+	case NV_TYPE_NUMBER_ARRAY:
+		(void)::cnvlist_get_number_array(cookie, &nitems);
+		allocate(usage, &nv_memory_usage::arrays,
+			 nitems * sizeof(std::uint64_t));
+		break;
+
+	case NV_TYPE_DESCRIPTOR_ARRAY:
+		(void)::cnvlist_get_descriptor_array(cookie, &nitems);
+		allocate(usage, &nv_memory_usage::arrays,
+			 nitems * sizeof(int));
+		break;
+
+	case NV_TYPE_STRING_ARRAY: {
+		auto const *data = ::cnvlist_get_string_array(cookie, &nitems);
+		allocate(usage, &nv_memory_usage::arrays,
+			 nitems * sizeof(char *));
+		for (auto const *str : std::span(data, nitems))
+			allocate(usage, &nv_memory_usage::values,
+				 std::strlen(str) + 1);
+		break;
+	}
+
+	case NV_TYPE_NVLIST_ARRAY: {
+		auto const *data = ::cnvlist_get_nvlist_array(cookie, &nitems);
+
+		auto array = nv_memory_usage{};
+		allocate(array, &nv_memory_usage::arrays,
+			 nitems * sizeof(::nvlist_t *));
+
+		for (auto i = std::size_t{0}; i < nitems; ++i) {
+			auto child = measure(data[i]);
+			array += child;
+			array.children.emplace_back(std::to_string(i),
+						    std::move(child));
+		}
+
+		usage += array;
+		usage.children.emplace_back(key, std::move(array));
+		break;
+	}
+
+	default:
+		std::abort();
+	}
+}
+
+nv_memory_usage
+measure(::nvlist_t const *nvl)
+{
+	auto usage = nv_memory_usage{};
+	allocate(usage, &nv_memory_usage::nodes, sizeof(model_nvlist));
+
+	void *cookie = nullptr;
+	int type;
+	while (auto const *key = ::nvlist_next(nvl, &type, &cookie))
+		measure_pair(usage, key, type, cookie);
+
+	return (usage);
+}
+
+} // anonymous namespace
+
+namespace __detail {
+
+nv_memory_usage
+__const_nv_list::memory_usage() const
+{
+	__throw_if_error();
+	return (measure(__m_nv));
+}
+
+} // namespace bsd::__detail
+
+} // namespace bsd
@@ -0,0 +1,69 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR MIT
+ * Refer to the file 'LICENSE' in the nvxx distribution for license terms.
+ */
+
+#ifndef	_NVXX_MEMORY_H_INCLUDED
+#define _NVXX_MEMORY_H_INCLUDED
+
+#ifndef _NVXX_H_INCLUDED
+# error include <nvxx.h> instead of including this header directly
+#endif
+
+/*
+ * nv_memory_usage: an estimate of the heap memory used by an nvlist, returned
+ * by memory_usage().
+ *
+ * libnv does not expose its allocations, so this is computed from the layout
+ * of its internal structures and the size classes used by jemalloc, the
+ * FreeBSD malloc.  It should be close for small and medium allocations, but
+ * is only an estimate.  Memory held by descriptors is not included.
+ */
+
+namespace bsd {
+
+struct nv_memory_usage {
+	// The nvlist and nvpair structures.
+	std::size_t nodes = 0;
+	// The keys, which are stored with their nvpair.
+	std::size_t keys = 0;
+	// String and binary values.
+	std::size_t values = 0;
+	// The storage of array values, including the arrays of pointers
+	// used by string and nvlist arrays.
+	std::size_t arrays = 0;
+	// The difference between the requested sizes and the size classes
+	// malloc rounds them up to.
+	std::size_t overhead = 0;
+	// The number of allocations.
+	std::size_t allocations = 0;
+
+	/*
+	 * The usage of each nvlist or nvlist array value in this nvlist,
+	 * which is also included in the totals above.  For an nvlist array,
+	 * the children of the entry are the elements of the array, named by
+	 * their index.
+	 */
+	std::vector<std::pair<std::string, nv_memory_usage>> children;
+
+	/*
+	 * The total estimated heap usage in bytes.
+	 */
+	[[nodiscard]] std::size_t total() const noexcept {
+		return (nodes + keys + values + arrays + overhead);
+	}
+
+	nv_memory_usage &operator+=(nv_memory_usage const &__other) noexcept {
+		nodes += __other.nodes;
+		keys += __other.keys;
+		values += __other.values;
+		arrays += __other.arrays;
+		overhead += __other.overhead;
+		allocations += __other.allocations;
+		return (*this);
+	}
+};
+
+} // namespace bsd
+
+#endif	/* !_NVXX_MEMORY_H_INCLUDED */
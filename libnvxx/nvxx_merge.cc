@@ -0,0 +1,223 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR MIT
+ * Refer to the file 'LICENSE' in the nvxx distribution for license terms.
+ */
+
+#include <unordered_map>
+
+#include "nvxx.h"
+
+namespace bsd {
+
+namespace {
+
+/*
+ * Resolve a conflict between the destination pair (dtype, dcookie) and the
+ * source pair (stype, scookie) with the given key.
+ */
+using resolver = std::function<nv_merge_policy (char const *,
+						int, void const *,
+						int, void const *)>;
+
+void
+throw_if_error(::nvlist_t const *nvl)
+{
+	if (auto err = ::nvlist_error(nvl); err != 0)
+		throw std::system_error(
+			std::error_code(err, std::generic_category()));
+}
+
+template<bool __move>
+void
+merge(::nvlist_t *dst, ::nvlist_t *src, resolver const &resolve)
+{
+	struct dst_pair {
+		int type;
+		void *cookie;
+	};
+
+	/*
+	 * Index the destination by key, so that each source key is found in
+	 * constant time.  An entry is removed from the index before the pair
+	 * it refers to is freed, since the key belongs to the pair.
+	 */
+	auto index = std::unordered_map<std::string_view, dst_pair>();
+
+	auto type = int{};
+	auto *cookie = static_cast<void *>(nullptr);
+
+	while (auto const *name = ::nvlist_next(dst, &type, &cookie))
+		index.emplace(name, dst_pair{type, cookie});
+
+	auto transfer = [&] (char const *name, int stype, void *scookie) {
+		if constexpr (__move)
+			__detail::__move_pair(dst, name, stype, scookie);
+		else
+			__detail::__copy_pair(dst, name, stype, scookie);
+	};
+
+	cookie = nullptr;
+	auto const *name = ::nvlist_next(src, &type, &cookie);
+
+	while (name != nullptr) {
+		// find the next pair before this one is moved out of src
+		auto next_type = int{};
+		auto *next_cookie = cookie;
+		auto const *next_name = ::nvlist_next(src, &next_type,
+						      &next_cookie);
+
+		auto it = index.find(name);
+
+		if (it == index.end()) {
+			transfer(name, type, cookie);
+		} else if (it->second.type == NV_TYPE_NVLIST
+			   && type == NV_TYPE_NVLIST) {
+			/*
+			 * Merge the nested nvlists in place, so that the
+			 * destination keeps its child if the merge throws.
+			 */
+			auto *dchild = const_cast<::nvlist_t *>(
+				::cnvlist_get_nvlist(it->second.cookie));
+			auto *schild = const_cast<::nvlist_t *>(
+				::cnvlist_get_nvlist(cookie));
+			merge<__move>(dchild, schild, resolve);
+		} else {
+			auto [dtype, dcookie] = it->second;
+
+			switch (resolve(name, dtype, dcookie, type, cookie)) {
+			case nv_merge_policy::overwrite:
+				index.erase(it);
+				__detail::__free_pair(dtype, dcookie);
+				transfer(name, type, cookie);
+				break;
+
+			case nv_merge_policy::keep:
+				break;
+
+			case nv_merge_policy::error:
+				throw nv_key_exists(std::string(name));
+			}
+		}
+
+		name = next_name;
+		type = next_type;
+		cookie = next_cookie;
+	}
+
+	throw_if_error(dst);
+}
+
+resolver
+fixed(nv_merge_policy policy)
+{
+	return [=] (char const *, int, void const *, int, void const *) {
+		return (policy);
+	};
+}
+
+resolver
+callback(nv_merge_callback const &cb)
+{
+	return [&] (char const *key,
+		    int dtype, void const *dcookie,
+		    int stype, void const *scookie) {
+		return (cb(key,
+			   __detail::__make_value(dtype, dcookie),
+			   __detail::__make_value(stype, scookie)));
+	};
+}
+
+/*
+ * Return true if src is an nvlist nested inside dst, at any depth.
+ */
+bool
+nested_in(::nvlist_t const *src, ::nvlist_t const *dst)
+{
+	for (auto const *nvl = ::nvlist_get_parent(src, nullptr);
+	     nvl != nullptr; nvl = ::nvlist_get_parent(nvl, nullptr))
+		if (nvl == dst)
+			return (true);
+	return (false);
+}
+
+/*
+ * Merge src into dst without modifying src.  Merging a list into itself
+ * changes nothing.  Merging may free pairs of dst, so if src is nested inside
+ * dst, merge from a copy of it instead.
+ */
+void
+merge_copy(::nvlist_t *dst, ::nvlist_t *src, resolver const &resolve)
+{
+	if (src == dst)
+		return;
+
+	if (nested_in(src, dst)) {
+		auto copy = nv_list(const_nv_list(src));
+		merge<true>(dst, copy.ptr(), resolve);
+		return;
+	}
+
+	merge<false>(dst, src, resolve);
+}
+
+/*
+ * Merge src into dst, moving pairs out of src.  src cannot be moved from if
+ * it belongs to dst, so that throws std::system_error with EINVAL.
+ */
+void
+merge_move(::nvlist_t *dst, ::nvlist_t *src, resolver const &resolve)
+{
+	if (src == dst)
+		return;
+
+	if (nested_in(src, dst))
+		throw std::system_error(
+			std::make_error_code(std::errc::invalid_argument));
+
+	merge<true>(dst, src, resolve);
+}
+
+::nvlist_t *
+checked_ptr(nv_list &nvl)
+{
+	if (auto err = nvl.error(); err)
+		throw nv_error_state(err);
+	return (nvl.ptr());
+}
+
+::nvlist_t *
+checked_ptr(const_nv_list const &nvl)
+{
+	if (auto err = nvl.error(); err)
+		throw nv_error_state(err);
+	// merge_copy() never modifies src
+	return (const_cast<::nvlist_t *>(nvl.ptr()));
+}
+
+} // anonymous namespace
+
+void
+nv_merge(nv_list &dst, const_nv_list const &src, nv_merge_policy policy)
+{
+	merge_copy(checked_ptr(dst), checked_ptr(src), fixed(policy));
+}
+
+void
+nv_merge(nv_list &dst, nv_list &&src, nv_merge_policy policy)
+{
+	merge_move(checked_ptr(dst), checked_ptr(src), fixed(policy));
+}
+
+void
+nv_merge(nv_list &dst, const_nv_list const &src, nv_merge_callback const &cb)
+{
+	merge_copy(checked_ptr(dst), checked_ptr(src), callback(cb));
+}
+
+void
+nv_merge(nv_list &dst, nv_list &&src, nv_merge_callback const &cb)
+{
+	merge_move(checked_ptr(dst), checked_ptr(src), callback(cb));
+}
+
+} // namespace bsd
@@ -0,0 +1,70 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR MIT
+ * Refer to the file 'LICENSE' in the nvxx distribution for license terms.
+ */
+
+#ifndef	_NVXX_MERGE_H_INCLUDED
+#define _NVXX_MERGE_H_INCLUDED
+
+#ifndef _NVXX_H_INCLUDED
+# error include <nvxx.h> instead of including this header directly
+#endif
+
+#include <functional>
+
+/*
+ * nv_merge: deep merge of one nvlist into another.
+ */
+
+namespace bsd {
+
+/*
+ * What to do when a key exists in both the source and destination nvlists,
+ * and the values are not both nvlists.
+ */
+enum struct nv_merge_policy {
+	overwrite,	/* replace the destination value with the source */
+	keep,		/* keep the destination value */
+	error,		/* throw nv_key_exists */
+};
+
+/*
+ * A callback which decides how to resolve a conflict.  It is called with the
+ * key, the destination value and the source value, and returns the policy to
+ * apply to that key.
+ */
+using nv_merge_callback = std::function<
+	nv_merge_policy (std::string_view __key,
+			 nv_list_value_t const &__dst,
+			 nv_list_value_t const &__src)>;
+
+/*
+ * Merge the pairs of src into dst.  Keys which exist only in src are added to
+ * dst.  If a key exists in both and both values are nvlists, they are merged
+ * recursively; otherwise the conflict is resolved by the given policy or
+ * callback.  Each nvlist is visited once.
+ *
+ * If src is an rvalue nv_list, values are moved from src rather than copied;
+ * afterwards src contains only the pairs which were not merged.
+ *
+ * Merging an nvlist into itself does nothing.  src may be nested inside dst,
+ * in which case it is copied before merging, except that an rvalue src
+ * nested inside dst throws std::system_error with EINVAL.
+ *
+ * If either nvlist is in the error state, throws nv_error_state.  If the
+ * policy is nv_merge_policy::error and a conflict is found, throws
+ * nv_key_exists; on any other failure, throws std::system_error.  If an
+ * exception is thrown, dst may have been partially merged.
+ */
+void nv_merge(nv_list &__dst, const_nv_list const &__src,
+	      nv_merge_policy = nv_merge_policy::overwrite);
+void nv_merge(nv_list &__dst, nv_list &&__src,
+	      nv_merge_policy = nv_merge_policy::overwrite);
+void nv_merge(nv_list &__dst, const_nv_list const &__src,
+	      nv_merge_callback const &);
+void nv_merge(nv_list &__dst, nv_list &&__src,
+	      nv_merge_callback const &);
+
+} // namespace bsd
+
+#endif	/* !_NVXX_MERGE_H_INCLUDED */
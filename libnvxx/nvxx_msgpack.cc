@@ -0,0 +1,384 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR MIT
+ * Refer to the file 'LICENSE' in the nvxx distribution for license terms.
+ */
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "nvxx.h"
+
+namespace bsd {
+
+namespace {
+
+// Maps nested more deeply than this are rejected.
+constexpr unsigned max_depth = 512;
+
+/*
+ * The kinds of MessagePack value, as determined by the type byte.
+ */
+enum struct kind {
+	nil, boolean, integer, str, bin, array, map, unsupported,
+};
+
+kind
+classify(std::uint8_t type) noexcept
+{
+	if (type <= 0x7f || type >= 0xe0)
+		return (kind::integer);
+	if (type <= 0x8f)
+		return (kind::map);
+	if (type <= 0x9f)
+		return (kind::array);
+	if (type <= 0xbf)
+		return (kind::str);
+
+	switch (type) {
+	case 0xc0:
+		return (kind::nil);
+	case 0xc2: case 0xc3:
+		return (kind::boolean);
+	case 0xc4: case 0xc5: case 0xc6:
+		return (kind::bin);
+	case 0xcc: case 0xcd: case 0xce: case 0xcf:
+	case 0xd0: case 0xd1: case 0xd2: case 0xd3:
+		return (kind::integer);
+	case 0xd9: case 0xda: case 0xdb:
+		return (kind::str);
+	case 0xdc: case 0xdd:
+		return (kind::array);
+	case 0xde: case 0xdf:
+		return (kind::map);
+	default:
+		return (kind::unsupported);
+	}
+}
+
+/*
+ * A recursive-descent parser which adds values to the nv_list as they are
+ * parsed.  Strings are passed to the nv_list directly from the input.
+ */
+struct parser {
+	std::span<std::byte const> data;
+	int flags;
+	std::size_t pos = 0;
+	unsigned depth = 0;
+
+	[[noreturn]] void fail(std::string_view what) const {
+		throw nv_msgpack_error(pos, what);
+	}
+
+	[[noreturn]] void fail_at(std::size_t at, std::string_view what) const {
+		throw nv_msgpack_error(at, what);
+	}
+
+	std::size_t remaining() const noexcept {
+		return (data.size() - pos);
+	}
+
+	std::uint8_t peek() const {
+		if (remaining() == 0)
+			fail("unexpected end of input");
+		return (std::to_integer<std::uint8_t>(data[pos]));
+	}
+
+	std::uint8_t next() {
+		auto const c = peek();
+		++pos;
+		return (c);
+	}
+
+	std::uint64_t be(unsigned size) {
+		if (remaining() < size)
+			fail("unexpected end of input");
+
+		auto value = std::uint64_t{0};
+		while (size-- > 0)
+			value = (value << 8)
+				| std::to_integer<std::uint64_t>(data[pos++]);
+		return (value);
+	}
+
+	std::span<std::byte const> bytes(std::uint64_t size) {
+		if (remaining() < size)
+			fail("unexpected end of input");
+
+		auto const ret = data.subspan(pos, size);
+		pos += size;
+		return (ret);
+	}
+
+	nv_list parse_document();
+	nv_list parse_map();
+	void parse_member(nv_list &, std::string_view key, std::size_t at);
+	void parse_array(nv_list &, std::string_view key);
+	std::string_view parse_str();
+	std::span<std::byte const> parse_bin();
+	std::uint64_t parse_integer();
+	std::size_t parse_length(std::uint8_t, std::uint8_t fixmask,
+				 std::uint8_t b8, std::uint8_t b16);
+};
+
+nv_list
+parser::parse_document()
+{
+	if (remaining() == 0 || classify(peek()) != kind::map)
+		fail("expected a map");
+
+	auto nvl = parse_map();
+
+	if (remaining() != 0)
+		fail("unexpected data after the map");
+
+	return (nvl);
+}
+
+/*
+ * Return the length of a str, bin, array or map from its header, whose type
+ * byte has already been read.  Types below b8 are the fixed-size form with
+ * the length in the bits given by fixmask; b8 and b16 are the type bytes of
+ * the 8- and 16-bit forms, and the 32-bit form follows b16.  A b8 of 0 means
+ * there is no 8-bit form.
+ */
+std::size_t
+parser::parse_length(std::uint8_t type, std::uint8_t fixmask,
+		     std::uint8_t b8, std::uint8_t b16)
+{
+	if (b8 != 0 && type == b8)
+		return (be(1));
+	if (type == b16)
+		return (be(2));
+	if (type == b16 + 1)
+		return (be(4));
+	return (type & fixmask);
+}
+
+nv_list
+parser::parse_map()
+{
+	if (++depth > max_depth)
+		fail("maps nested too deeply");
+
+	auto const size = parse_length(next(), 0x0f, 0, 0xde);
+	auto nvl = nv_list(flags);
+
+	for (auto i = std::size_t{0}; i < size; ++i) {
+		auto const at = pos;
+		if (classify(peek()) != kind::str)
+			fail("map keys must be strings");
+
+		auto const key = parse_str();
+		if (key.find('\0') != key.npos)
+			fail_at(at, "nvlist keys may not contain NUL");
+
+		parse_member(nvl, key, at);
+	}
+
+	--depth;
+	return (nvl);
+}
+
+void
+parser::parse_member(nv_list &nvl, std::string_view key, std::size_t at)
+{
+	try {
+		switch (classify(peek())) {
+		case kind::nil:
+			++pos;
+			nvl.add_null(key);
+			return;
+
+		case kind::boolean:
+			nvl.add_bool(key, next() == 0xc3);
+			return;
+
+		case kind::integer:
+			nvl.add_number(key, parse_integer());
+			return;
+
+		case kind::str: {
+			auto const start = pos;
+			auto const str = parse_str();
+			if (str.find('\0') != str.npos)
+				fail_at(start, "nvlist strings may not "
+					"contain NUL");
+			nvl.add_string(key, str);
+			return;
+		}
+
+		case kind::bin:
+			nvl.add_binary(key, parse_bin());
+			return;
+
+		case kind::map:
+			nvl.move_nvlist(key, parse_map());
+			return;
+
+		case kind::array:
+			parse_array(nvl, key);
+			return;
+
+		case kind::unsupported:
+			fail("floats and extension types cannot be stored "
+			     "in an nvlist");
+		}
+	} catch (nv_key_exists const &) {
+		fail_at(at, "duplicate key");
+	}
+}
+
+void
+parser::parse_array(nv_list &nvl, std::string_view key)
+{
+	auto const size = parse_length(next(), 0x0f, 0, 0xdc);
+
+	if (size == 0) {
+		nvl.add_number_array(key, {});
+		return;
+	}
+
+	/*
+	 * The type of the array is the type of its first element, and every
+	 * other element must have the same type.  Each element is at least
+	 * one byte, which bounds the size of the vectors for a malicious
+	 * count.
+	 */
+	if (size > remaining())
+		fail("unexpected end of input");
+
+	auto const type = classify(peek());
+	auto numbers = std::vector<std::uint64_t>();
+	auto bools = std::vector<bool>();
+	auto strings = std::vector<std::string_view>();
+	auto lists = std::vector<nv_list>();
+
+	switch (type) {
+	case kind::integer:	numbers.reserve(size); break;
+	case kind::boolean:	bools.reserve(size); break;
+	case kind::str:		strings.reserve(size); break;
+	case kind::map:		lists.reserve(size); break;
+	default:		break;
+	}
+
+	for (auto i = std::size_t{0}; i < size; ++i) {
+		auto const k = classify(peek());
+
+		if (k == kind::array)
+			fail("nested arrays cannot be stored in an nvlist");
+		if (k == kind::nil)
+			fail("arrays containing nil cannot be stored "
+			     "in an nvlist");
+		if (k == kind::bin)
+			fail("arrays of bin cannot be stored in an nvlist");
+		if (k == kind::unsupported)
+			fail("floats and extension types cannot be stored "
+			     "in an nvlist");
+		if (k != type)
+			fail("arrays of mixed types cannot be stored "
+			     "in an nvlist");
+
+		switch (k) {
+		case kind::integer:
+			numbers.push_back(parse_integer());
+			break;
+
+		case kind::boolean:
+			bools.push_back(next() == 0xc3);
+			break;
+
+		case kind::str: {
+			auto const start = pos;
+			auto const str = parse_str();
+			if (str.find('\0') != str.npos)
+				fail_at(start, "nvlist strings may not "
+					"contain NUL");
+			strings.push_back(str);
+			break;
+		}
+
+		case kind::map:
+			lists.push_back(parse_map());
+			break;
+
+		default:
+			std::abort();
+		}
+	}
+
+	switch (type) {
+	case kind::map: {
+		// move the lists into the nvlist rather than copying them.
+		auto ptrs = __detail::__malloc_copy<::nvlist_t *>(
+			lists | std::views::transform([] (nv_list &l) {
+				return (std::move(l).release());
+			}));
+		nvl.move_nvlist_array(key, ptrs);
+		break;
+	}
+
+	case kind::str:
+		nvl.add_string_range(key, strings);
+		break;
+
+	case kind::boolean:
+		nvl.add_bool_range(key, bools);
+		break;
+
+	default:
+		nvl.add_number_array(key, numbers);
+		break;
+	}
+}
+
+std::string_view
+parser::parse_str()
+{
+	auto const size = parse_length(next(), 0x1f, 0xd9, 0xda);
+	auto const str = bytes(size);
+	return {reinterpret_cast<char const *>(str.data()), str.size()};
+}
+
+std::span<std::byte const>
+parser::parse_bin()
+{
+	auto const type = next();
+	return (bytes(be(1u << (type - 0xc4))));
+}
+
+std::uint64_t
+parser::parse_integer()
+{
+	auto const start = pos;
+	auto const type = next();
+
+	if (type <= 0x7f)
+		return (type);
+
+	if (type >= 0xe0)
+		fail_at(start, "negative integers cannot be stored "
+			"in an nvlist");
+
+	if (type >= 0xcc && type <= 0xcf)
+		return (be(1u << (type - 0xcc)));
+
+	// a signed integer, which is negative if its top bit is set.
+	auto const size = 1u << (type - 0xd0);
+	auto const value = be(size);
+	if ((value >> (size * 8 - 1)) != 0)
+		fail_at(start, "negative integers cannot be stored "
+			"in an nvlist");
+	return (value);
+}
+
+} // anonymous namespace
+
+nv_list
+nv_from_msgpack(std::span<std::byte const> data, int flags)
+{
+	auto p = parser{.data = data, .flags = flags};
+	return (p.parse_document());
+}
+
+} // namespace bsd
@@ -0,0 +1,299 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR MIT
+ * Refer to the file 'LICENSE' in the nvxx distribution for license terms.
+ */
+
+#ifndef	_NVXX_MSGPACK_H_INCLUDED
+#define _NVXX_MSGPACK_H_INCLUDED
+
+#ifndef _NVXX_H_INCLUDED
+# error include <nvxx.h> instead of including this header directly
+#endif
+
+#include <cstdint>
+#include <iterator>
+
+/*
+ * MessagePack import and export of nvlists.
+ *
+ * An nvlist is written as a MessagePack map with string keys, with its pairs
+ * in the order returned by nvlist_next().  Values are mapped as follows:
+ *
+ *	null			nil
+ *	bool			true or false
+ *	number			an unsigned integer
+ *	string			a str
+ *	nvlist			a map
+ *	descriptor		the descriptor number
+ *	binary			a bin
+ *	arrays			an array of the above
+ *
+ * Integers and lengths are written in the shortest form which holds them.
+ *
+ * nv_from_msgpack() performs the reverse mapping, except that descriptors
+ * cannot be distinguished from numbers.  Signed integers are accepted if they
+ * are not negative.  Since an nvlist cannot store them, negative integers,
+ * floats, extension types, maps with non-string keys, arrays of mixed types,
+ * arrays containing nil, bin or other arrays, and strings containing NUL are
+ * rejected.  An empty array is stored as an empty number array.
+ */
+
+namespace bsd {
+
+/*
+ * nv_from_msgpack() was given invalid MessagePack, or MessagePack which cannot
+ * be represented as an nvlist.  offset is the offset in the input of the
+ * error.
+ */
+struct nv_msgpack_error : nv_error {
+	std::size_t offset;
+
+	nv_msgpack_error(std::size_t __offset, std::string_view __what)
+		: nv_error("invalid MessagePack at offset {0}: {1}",
+			   __offset, __what)
+		, offset(__offset)
+	{
+	}
+};
+
+namespace __detail {
+
+/*
+ * Write the low __size bytes of __value in big-endian order.
+ */
+template<std::output_iterator<std::byte> _O>
+_O
+__msgpack_be(std::uint64_t __value, unsigned __size, _O __out)
+{
+	while (__size-- > 0)
+		*__out++ = static_cast<std::byte>(__value >> (__size * 8));
+	return (__out);
+}
+
+template<std::output_iterator<std::byte> _O>
+_O
+__msgpack_uint(std::uint64_t __value, _O __out)
+{
+	if (__value < 0x80) {
+		*__out++ = static_cast<std::byte>(__value);
+		return (__out);
+	}
+
+	if (__value <= 0xff) {
+		*__out++ = std::byte{0xcc};
+		return (__msgpack_be(__value, 1, std::move(__out)));
+	}
+
+	if (__value <= 0xffff) {
+		*__out++ = std::byte{0xcd};
+		return (__msgpack_be(__value, 2, std::move(__out)));
+	}
+
+	if (__value <= 0xffffffff) {
+		*__out++ = std::byte{0xce};
+		return (__msgpack_be(__value, 4, std::move(__out)));
+	}
+
+	*__out++ = std::byte{0xcf};
+	return (__msgpack_be(__value, 8, std::move(__out)));
+}
+
+/*
+ * Write the header of a str, bin, array or map of __size elements.  __fix is
+ * the type byte of the fixed-size form and __fixmax the largest size it can
+ * hold, or 0 if there is none; __b8, __b16 and __b32 are the type bytes of
+ * the 8-, 16- and 32-bit forms, or 0 if there is none.
+ */
+template<std::output_iterator<std::byte> _O>
+_O
+__msgpack_header(std::size_t __size, unsigned __fix, std::size_t __fixmax,
+		 unsigned __b8, unsigned __b16, unsigned __b32, _O __out)
+{
+	if (__fix != 0 && __size <= __fixmax) {
+		*__out++ = static_cast<std::byte>(__fix | __size);
+		return (__out);
+	}
+
+	if (__b8 != 0 && __size <= 0xff) {
+		*__out++ = static_cast<std::byte>(__b8);
+		return (__msgpack_be(__size, 1, std::move(__out)));
+	}
+
+	if (__size <= 0xffff) {
+		*__out++ = static_cast<std::byte>(__b16);
+		return (__msgpack_be(__size, 2, std::move(__out)));
+	}
+
+	if (__size <= 0xffffffff) {
+		*__out++ = static_cast<std::byte>(__b32);
+		return (__msgpack_be(__size, 4, std::move(__out)));
+	}
+
+	throw std::length_error("value too large to be written as MessagePack");
+}
+
+template<std::output_iterator<std::byte> _O>
+_O
+__msgpack_string(std::string_view __str, _O __out)
+{
+	__out = __msgpack_header(__str.size(), 0xa0, 31, 0xd9, 0xda, 0xdb,
+				 std::move(__out));
+	return (std::ranges::copy(std::as_bytes(std::span(__str)),
+				  std::move(__out)).out);
+}
+
+template<std::output_iterator<std::byte> _O>
+_O
+__msgpack_array(std::size_t __size, _O __out)
+{
+	return (__msgpack_header(__size, 0x90, 15, 0, 0xdc, 0xdd,
+				 std::move(__out)));
+}
+
+template<std::output_iterator<std::byte> _O>
+_O __msgpack_map(::nvlist_t const *, _O);
+
+template<std::output_iterator<std::byte> _O>
+_O
+__msgpack_value(int __type, void const *__cookie, _O __out)
+{
+	auto __nitems = std::size_t{};
+
+	switch (__type) {
+	case NV_TYPE_NULL:
+		*__out++ = std::byte{0xc0};
+		return (__out);
+
+	case NV_TYPE_BOOL:
+		*__out++ = ::cnvlist_get_bool(__cookie)
+			? std::byte{0xc3} : std::byte{0xc2};
+		return (__out);
+
+	case NV_TYPE_NUMBER:
+		return (__msgpack_uint(::cnvlist_get_number(__cookie),
+				       std::move(__out)));
+
+	case NV_TYPE_STRING:
+		return (__msgpack_string(::cnvlist_get_string(__cookie),
+					 std::move(__out)));
+
+	case NV_TYPE_NVLIST:
+		return (__msgpack_map(::cnvlist_get_nvlist(__cookie),
+				      std::move(__out)));
+
+	case NV_TYPE_DESCRIPTOR:
+		return (__msgpack_uint(static_cast<std::uint64_t>(
+			::cnvlist_get_descriptor(__cookie)), std::move(__out)));
+
+	case NV_TYPE_BINARY: {
+		auto const *__data = static_cast<std::byte const *>(
+			::cnvlist_get_binary(__cookie, &__nitems));
+		__out = __msgpack_header(__nitems, 0, 0, 0xc4, 0xc5, 0xc6,
+					 std::move(__out));
+		return (std::ranges::copy(__data, __data + __nitems,
+					  std::move(__out)).out);
+	}
+
+	case NV_TYPE_BOOL_ARRAY: {
+		auto const *__data = ::cnvlist_get_bool_array(__cookie,
+							      &__nitems);
+		__out = __msgpack_array(__nitems, std::move(__out));
+		for (auto __b : std::span(__data, __nitems))
+			*__out++ = __b ? std::byte{0xc3} : std::byte{0xc2};
+		return (__out);
+	}
+
+	case NV_TYPE_NUMBER_ARRAY: {
+		auto const *__data = ::cnvlist_get_number_array(__cookie,
+								&__nitems);
+		__out = __msgpack_array(__nitems, std::move(__out));
+		for (auto __n : std::span(__data, __nitems))
+			__out = __msgpack_uint(__n, std::move(__out));
+		return (__out);
+	}
+
+	case NV_TYPE_STRING_ARRAY: {
+		auto const *__data = ::cnvlist_get_string_array(__cookie,
+								&__nitems);
+		__out = __msgpack_array(__nitems, std::move(__out));
+		for (auto const *__s : std::span(__data, __nitems))
+			__out = __msgpack_string(__s, std::move(__out));
+		return (__out);
+	}
+
+	case NV_TYPE_NVLIST_ARRAY: {
+		auto const *__data = ::cnvlist_get_nvlist_array(__cookie,
+								&__nitems);
+		__out = __msgpack_array(__nitems, std::move(__out));
+		for (auto const *__nvl : std::span(__data, __nitems))
+			__out = __msgpack_map(__nvl, std::move(__out));
+		return (__out);
+	}
+
+	case NV_TYPE_DESCRIPTOR_ARRAY: {
+		auto const *__data = ::cnvlist_get_descriptor_array(__cookie,
+								    &__nitems);
+		__out = __msgpack_array(__nitems, std::move(__out));
+		for (auto __fd : std::span(__data, __nitems))
+			__out = __msgpack_uint(static_cast<std::uint64_t>(__fd),
+					       std::move(__out));
+		return (__out);
+	}
+
+	default:
+		std::abort();
+	}
+}
+
+template<std::output_iterator<std::byte> _O>
+_O
+__msgpack_map(::nvlist_t const *__nvl, _O __out)
+{
+	void *__cookie = nullptr;
+	int __type;
+
+	// a map is prefixed with its size, so count the pairs first.
+	auto __size = std::size_t{0};
+	while (::nvlist_next(__nvl, &__type, &__cookie) != nullptr)
+		++__size;
+
+	__out = __msgpack_header(__size, 0x80, 15, 0, 0xde, 0xdf,
+				 std::move(__out));
+
+	__cookie = nullptr;
+	while (auto const *__key = ::nvlist_next(__nvl, &__type, &__cookie)) {
+		__out = __msgpack_string(__key, std::move(__out));
+		__out = __msgpack_value(__type, __cookie, std::move(__out));
+	}
+
+	return (__out);
+}
+
+} // namespace bsd::__detail
+
+/*
+ * Write the nvlist to the output iterator as a MessagePack map, and return
+ * the iterator.  If the nvlist is in the error state, throws nv_error_state.
+ */
+template<std::output_iterator<std::byte> _O>
+_O
+nv_to_msgpack(const_nv_list const &__nvl, _O __out)
+{
+	if (auto const __err = __nvl.error(); __err)
+		throw nv_error_state(__err);
+
+	return (__detail::__msgpack_map(__nvl.ptr(), std::move(__out)));
+}
+
+/*
+ * Parse a MessagePack map and return it as an nv_list created with the given
+ * flags.  If the input is not valid MessagePack, or cannot be represented as
+ * an nvlist, throws nv_msgpack_error.  If the nvlist was not created with
+ * NV_FLAG_NO_UNIQUE, duplicate keys are an error.
+ */
+[[nodiscard]] nv_list nv_from_msgpack(std::span<std::byte const>,
+				      int __flags = 0);
+
+} // namespace bsd
+
+#endif	/* !_NVXX_MSGPACK_H_INCLUDED */
@@ -0,0 +1,492 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR MIT
+ * Refer to the file 'LICENSE' in the nvxx distribution for license terms.
+ */
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+#include "nvxx.h"
+
+namespace bsd::__detail {
+
+namespace {
+
+// nvlists nested more deeply than this are rejected.
+constexpr unsigned max_depth = 512;
+
+// NV_FLAG_PUBLIC_MASK, plus the byte order flag.
+constexpr std::uint8_t flag_public_mask = NV_FLAG_IGNORE_CASE
+					| NV_FLAG_NO_UNIQUE;
+constexpr std::uint8_t flag_mask = flag_public_mask
+				 | __nv_packer::__flag_big_endian;
+
+// NVLIST_ARRAY_NEXT, which separates the elements of an nvlist array.
+constexpr std::uint8_t type_nvlist_array_next = 254;
+
+constexpr bool host_big_endian = (std::endian::native == std::endian::big);
+
+template<typename T>
+T
+load(std::byte const *ptr, bool swap) noexcept
+{
+	T value;
+	std::memcpy(&value, ptr, sizeof(value));
+	return (swap ? std::byteswap(value) : value);
+}
+
+} // anonymous namespace
+
+/*
+ * The nvlist fields of an object are packed by walking the nvlist, in the
+ * same order and with the same sizes as nvlist_size() and nvlist_pack().
+ */
+
+std::size_t
+__nv_packer::__nvlist_size(::nvlist_t const *nvl)
+{
+	auto size = __list_header_size;
+	void *cookie = nullptr;
+	int type;
+
+	while (auto const *key = ::nvlist_next(nvl, &type, &cookie)) {
+		auto nitems = std::size_t{};
+
+		switch (type) {
+		case NV_TYPE_NULL:
+			size += __pair_size(key, 0);
+			break;
+
+		case NV_TYPE_BOOL:
+			size += __pair_size(key, sizeof(std::uint8_t));
+			break;
+
+		case NV_TYPE_NUMBER:
+			size += __pair_size(key, sizeof(std::uint64_t));
+			break;
+
+		case NV_TYPE_STRING:
+			size += __pair_size(key, std::strlen(
+				::cnvlist_get_string(cookie)) + 1);
+			break;
+
+		case NV_TYPE_BINARY:
+			(void)::cnvlist_get_binary(cookie, &nitems);
+			size += __pair_size(key, nitems);
+			break;
+
+		case NV_TYPE_NVLIST:
+			size += __nvlist_pair_size(key,
+					::cnvlist_get_nvlist(cookie));
+			break;
+
+		case NV_TYPE_BOOL_ARRAY:
+			(void)::cnvlist_get_bool_array(cookie, &nitems);
+			size += __pair_size(key, sizeof(bool) * nitems);
+			break;
+
+		case NV_TYPE_NUMBER_ARRAY:
+			(void)::cnvlist_get_number_array(cookie, &nitems);
+			size += __pair_size(key, sizeof(std::uint64_t) * nitems);
+			break;
+
+		case NV_TYPE_STRING_ARRAY: {
+			auto const *data = ::cnvlist_get_string_array(cookie,
+								      &nitems);
+			auto datasize = std::size_t{0};
+			for (auto const *str : std::span(data, nitems))
+				datasize += std::strlen(str) + 1;
+			size += __pair_size(key, datasize);
+			break;
+		}
+
+		default:
+			// descriptors and nvlist arrays.
+			throw std::system_error(std::make_error_code(
+				std::errc::operation_not_supported));
+		}
+	}
+
+	return (size);
+}
+
+void
+__nv_packer::__nvlist(std::string_view name, ::nvlist_t const *nvl) noexcept
+{
+	/*
+	 * The data size of an nvlist pair is the size of the nvlist, which is
+	 * filled in once the nvlist has been written.
+	 */
+	auto *const header = __m_ptr;
+	__pair_header(NV_TYPE_NVLIST, name, 0, 0);
+	auto *const start = __m_ptr;
+
+	__list_header(::nvlist_flags(nvl));
+
+	void *cookie = nullptr;
+	int type;
+
+	while (auto const *key = ::nvlist_next(nvl, &type, &cookie)) {
+		auto nitems = std::size_t{};
+
+		switch (type) {
+		case NV_TYPE_NULL:
+			__pair_header(NV_TYPE_NULL, key, 0, 0);
+			break;
+
+		case NV_TYPE_BOOL:
+			__pair_header(NV_TYPE_BOOL, key, sizeof(std::uint8_t), 0);
+			__write(static_cast<std::uint8_t>(
+				::cnvlist_get_bool(cookie)));
+			break;
+
+		case NV_TYPE_NUMBER:
+			__pair_header(NV_TYPE_NUMBER, key,
+				      sizeof(std::uint64_t), 0);
+			__write(::cnvlist_get_number(cookie));
+			break;
+
+		case NV_TYPE_STRING:
+			__string(key, ::cnvlist_get_string(cookie));
+			break;
+
+		case NV_TYPE_BINARY: {
+			auto const *data = ::cnvlist_get_binary(cookie, &nitems);
+			__pair_header(NV_TYPE_BINARY, key, nitems, 0);
+			__write_bytes(data, nitems);
+			break;
+		}
+
+		case NV_TYPE_NVLIST:
+			__nvlist(key, ::cnvlist_get_nvlist(cookie));
+			break;
+
+		case NV_TYPE_BOOL_ARRAY: {
+			auto const *data = ::cnvlist_get_bool_array(cookie,
+								    &nitems);
+			__pair_header(NV_TYPE_BOOL_ARRAY, key,
+				      sizeof(bool) * nitems, nitems);
+			__write_bytes(data, sizeof(bool) * nitems);
+			break;
+		}
+
+		case NV_TYPE_NUMBER_ARRAY: {
+			auto const *data = ::cnvlist_get_number_array(cookie,
+								      &nitems);
+			__pair_header(NV_TYPE_NUMBER_ARRAY, key,
+				      sizeof(std::uint64_t) * nitems, nitems);
+			__write_bytes(data, sizeof(std::uint64_t) * nitems);
+			break;
+		}
+
+		case NV_TYPE_STRING_ARRAY: {
+			auto const *data = ::cnvlist_get_string_array(cookie,
+								      &nitems);
+			__string_array(key, std::span(data, nitems));
+			break;
+		}
+
+		default:
+			// rejected by __nvlist_size().
+			std::abort();
+		}
+	}
+
+	auto const datasize = static_cast<std::uint64_t>(__m_ptr - start);
+	std::memcpy(header + sizeof(std::uint8_t) + sizeof(std::uint16_t),
+		    &datasize, sizeof(datasize));
+
+	// NVLIST_UP, which has an empty name.
+	__pair_header(__type_nvlist_up, "", 0, 0);
+}
+
+void
+__throw_unpack_error(std::errc err)
+{
+	throw std::system_error(std::make_error_code(err));
+}
+
+/*
+ * The checks made here follow nvlist_xunpack() and nvpair_unpack_*(), so that
+ * any input which nvlist_unpack() rejects is also rejected here.
+ */
+
+__nv_unpacker::__nv_unpacker(std::span<std::byte const> data)
+	: __m_ptr(data.data())
+	, __m_end(data.data() + data.size())
+{
+	auto const flags = __header();
+
+	// nvlist_unpack() with a flags argument of 0.
+	if ((flags & flag_public_mask) != 0)
+		__throw_unpack_error(std::errc::illegal_byte_sequence);
+
+	__m_swap = ((flags & __nv_packer::__flag_big_endian) != 0)
+		!= host_big_endian;
+}
+
+/*
+ * Read and check an nvlist header, which must be followed by exactly the
+ * number of bytes it records, and return its flags.
+ */
+std::uint8_t
+__nv_unpacker::__header()
+{
+	auto const left = static_cast<std::size_t>(__m_end - __m_ptr);
+	if (left < __nv_packer::__list_header_size)
+		__throw_unpack_error(std::errc::invalid_argument);
+
+	auto const magic = std::to_integer<std::uint8_t>(__m_ptr[0]);
+	auto const version = std::to_integer<std::uint8_t>(__m_ptr[1]);
+	auto const flags = std::to_integer<std::uint8_t>(__m_ptr[2]);
+
+	if (magic != __nv_packer::__magic
+	    || version != __nv_packer::__version
+	    || (flags & ~flag_mask) != 0)
+		__throw_unpack_error(std::errc::invalid_argument);
+
+	// The header is in its own byte order.
+	auto const swap = ((flags & __nv_packer::__flag_big_endian) != 0)
+		!= host_big_endian;
+	auto const descriptors = load<std::uint64_t>(__m_ptr + 3, swap);
+	auto const size = load<std::uint64_t>(__m_ptr + 11, swap);
+
+	__m_ptr += __nv_packer::__list_header_size;
+
+	if (descriptors != 0
+	    || size != left - __nv_packer::__list_header_size)
+		__throw_unpack_error(std::errc::invalid_argument);
+
+	return (flags);
+}
+
+/*
+ * Read and check a pair.  The data of an nvlist pair is not consumed, since
+ * it is the nested nvlist which follows.
+ */
+void
+__nv_unpacker::__pair(__nv_packed_pair &pair)
+{
+	if (static_cast<std::size_t>(__m_end - __m_ptr)
+	    < __nv_packer::__pair_header_size)
+		__throw_unpack_error(std::errc::invalid_argument);
+
+	auto const type = std::to_integer<std::uint8_t>(__m_ptr[0]);
+	auto const namesize = load<std::uint16_t>(__m_ptr + 1, __m_swap);
+	auto const datasize = load<std::uint64_t>(__m_ptr + 3, __m_swap);
+	auto const nitems = load<std::uint64_t>(__m_ptr + 11, __m_swap);
+	__m_ptr += __nv_packer::__pair_header_size;
+
+	auto left = static_cast<std::size_t>(__m_end - __m_ptr);
+	if (namesize == 0 || namesize > NV_NAME_MAX || namesize > left)
+		__throw_unpack_error(std::errc::invalid_argument);
+
+	auto const *name = reinterpret_cast<char const *>(__m_ptr);
+	if (::strnlen(name, namesize) != namesize - 1u)
+		__throw_unpack_error(std::errc::invalid_argument);
+
+	__m_ptr += namesize;
+	left -= namesize;
+
+	if (datasize > left)
+		__throw_unpack_error(std::errc::invalid_argument);
+
+	auto const data = std::span(__m_ptr, static_cast<std::size_t>(datasize));
+	auto const nuls = [&] {
+		return (static_cast<std::size_t>(
+			std::ranges::count(data, std::byte{0})));
+	};
+	auto const bools = [&] {
+		return (std::ranges::all_of(data, [] (std::byte b) {
+			return (std::to_integer<unsigned>(b) <= 1);
+		}));
+	};
+
+	auto valid = false;
+
+	switch (type) {
+	case __nv_packer::__type_nvlist_up:
+	case NV_TYPE_NVLIST:
+		pair = {type, {name, namesize - 1u}, {},
+			static_cast<std::size_t>(nitems), __m_swap};
+		if (type == NV_TYPE_NVLIST ? datasize == 0 : datasize != 0)
+			__throw_unpack_error(std::errc::invalid_argument);
+		return;
+
+	case NV_TYPE_NULL:
+		valid = (datasize == 0);
+		break;
+
+	case NV_TYPE_BOOL:
+		valid = (datasize == 1 && bools());
+		break;
+
+	case NV_TYPE_NUMBER:
+		valid = (datasize == sizeof(std::uint64_t));
+		break;
+
+	case NV_TYPE_STRING:
+		valid = (datasize > 0 && nuls() == 1
+			 && data.back() == std::byte{0});
+		break;
+
+	case NV_TYPE_BINARY:
+		valid = (datasize > 0);
+		break;
+
+	case NV_TYPE_BOOL_ARRAY:
+		static_assert(sizeof(bool) == 1);
+		valid = (datasize == nitems && bools());
+		break;
+
+	case NV_TYPE_NUMBER_ARRAY:
+		valid = (nitems <= datasize / sizeof(std::uint64_t)
+			 && datasize == nitems * sizeof(std::uint64_t));
+		break;
+
+	case NV_TYPE_STRING_ARRAY:
+		valid = (datasize == 0
+			 ? nitems == 0
+			 : (nuls() == nitems && data.back() == std::byte{0}));
+		break;
+
+	case NV_TYPE_NVLIST_ARRAY:
+	case type_nvlist_array_next:
+		__throw_unpack_error(std::errc::operation_not_supported);
+
+	default:
+		// including descriptors, since the header has none.
+		break;
+	}
+
+	if (!valid)
+		__throw_unpack_error(std::errc::invalid_argument);
+
+	pair = {type, {name, namesize - 1u}, data,
+		static_cast<std::size_t>(nitems), __m_swap};
+	__m_ptr += datasize;
+}
+
+bool
+__nv_unpacker::__next(__nv_packed_pair &pair)
+{
+	if (__m_ptr == __m_end)
+		return (false);
+
+	__pair(pair);
+
+	// NVLIST_UP without a parent.
+	if (pair.__type == __nv_packer::__type_nvlist_up)
+		__throw_unpack_error(std::errc::invalid_argument);
+
+	return (true);
+}
+
+nv_list
+__nv_unpacker::__nvlist(__nv_packed_pair const &pair)
+{
+	pair.__expect(NV_TYPE_NVLIST);
+
+	auto nvl = nv_list(__header() & flag_public_mask);
+	__pairs(&nvl, 1);
+	return (nvl);
+}
+
+void
+__nv_unpacker::__skip_nvlist()
+{
+	(void)__header();
+	__pairs(nullptr, 1);
+}
+
+/*
+ * Read the pairs of a nested nvlist up to its NVLIST_UP pair, adding them to
+ * nvl if it is not null.
+ */
+void
+__nv_unpacker::__pairs(nv_list *nvl, unsigned depth)
+{
+	if (depth > max_depth)
+		__throw_unpack_error(std::errc::invalid_argument);
+
+	auto pair = __nv_packed_pair{};
+
+	for (;;) {
+		// The nvlist must be ended by NVLIST_UP.
+		if (__m_ptr == __m_end)
+			__throw_unpack_error(std::errc::invalid_argument);
+
+		__pair(pair);
+
+		if (pair.__type == __nv_packer::__type_nvlist_up)
+			return;
+
+		if (pair.__type == NV_TYPE_NVLIST) {
+			auto const flags = __header() & flag_public_mask;
+			if (nvl == nullptr) {
+				__pairs(nullptr, depth + 1);
+				continue;
+			}
+
+			auto child = nv_list(flags);
+			__pairs(&child, depth + 1);
+			try {
+				nvl->move_nvlist(pair.__name, std::move(child));
+			} catch (nv_key_exists const &) {
+				__throw_unpack_error(std::errc::file_exists);
+			}
+			continue;
+		}
+
+		if (nvl == nullptr)
+			continue;
+
+		try {
+			switch (pair.__type) {
+			case NV_TYPE_NULL:
+				nvl->add_null(pair.__name);
+				break;
+
+			case NV_TYPE_BOOL:
+				nvl->add_bool(pair.__name, pair.__bool());
+				break;
+
+			case NV_TYPE_NUMBER:
+				nvl->add_number(pair.__name, pair.__number());
+				break;
+
+			case NV_TYPE_STRING:
+				nvl->add_string(pair.__name, pair.__string());
+				break;
+
+			case NV_TYPE_BINARY:
+				nvl->add_binary(pair.__name, pair.__data);
+				break;
+
+			case NV_TYPE_BOOL_ARRAY:
+				nvl->add_bool_range(pair.__name,
+						    pair.__bool_array());
+				break;
+
+			case NV_TYPE_NUMBER_ARRAY:
+				nvl->add_number_range(pair.__name,
+						      pair.__number_array());
+				break;
+
+			case NV_TYPE_STRING_ARRAY:
+				nvl->add_string_range(pair.__name,
+						      pair.__string_array());
+				break;
+
+			default:
+				// rejected by __pair().
+				std::abort();
+			}
+		} catch (nv_key_exists const &) {
+			__throw_unpack_error(std::errc::file_exists);
+		}
+	}
+}
+
+} // namespace bsd::__detail
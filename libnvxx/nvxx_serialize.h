@@ -10,6 +10,9 @@
 # error include <nvxx.h> instead of including this header directly
 #endif
 
+#include <bit>
+#include <cstring>
+
 namespace bsd {
 
 namespace __detail {
@@ -48,6 +51,273 @@ concept __serializer =
 		typename _T::__serializer_tag_t;
 	};
 
+/*
+ * __nv_packer writes libnv's packed format directly for nv_pack(), and must
+ * produce exactly what nvlist_pack() would for the equivalent nvlist.  The
+ * layout follows subr_nvlist.c and subr_nvpair.c: an nvlist is a header
+ * followed by its pairs, a pair is a header followed by its NUL-terminated
+ * name and its data, and the pairs of a nested nvlist are followed by an
+ * NVLIST_UP pair.  Integers are written in host byte order, and the header
+ * records which that is.
+ *
+ * The buffer must be exactly the size of the packed nvlist, because each
+ * nvlist header records the number of bytes which follow it.
+ */
+struct __nv_packer {
+	// sizeof(struct nvlist_header) and sizeof(struct nvpair_header)
+	static constexpr std::size_t __list_header_size = 19;
+	static constexpr std::size_t __pair_header_size = 19;
+
+	// Private to libnv.
+	static constexpr std::uint8_t __magic = 0x6c;
+	static constexpr std::uint8_t __version = 0;
+	static constexpr std::uint8_t __flag_big_endian = 0x80;
+	static constexpr std::uint8_t __type_nvlist_up = 255;
+
+	explicit __nv_packer(std::span<std::byte> __buf) noexcept
+		: __m_ptr(__buf.data())
+		, __m_end(__buf.data() + __buf.size())
+	{
+	}
+
+	/*
+	 * Check that __name is a valid key, as nvlist_add_*() would, and
+	 * return the packed size of a pair with __datasize bytes of data.
+	 */
+	static std::size_t __pair_size(std::string_view __name,
+				       std::size_t __datasize)
+	{
+		if (__name.find('\0') != __name.npos) [[unlikely]]
+			__throw_runtime_error(
+				"nv_list keys may not contain NUL");
+		if (__name.size() >= NV_NAME_MAX) [[unlikely]]
+			throw std::system_error(std::make_error_code(
+				std::errc::filename_too_long));
+
+		return (__pair_header_size + __name.size() + 1 + __datasize);
+	}
+
+	/*
+	 * Return the packed size of an nvlist pair holding __nvl, which
+	 * includes the nvlist and the NVLIST_UP pair after it.  If the nvlist
+	 * holds descriptors or nvlist arrays, which nv_pack() does not
+	 * support, throws std::system_error.
+	 */
+	static std::size_t __nvlist_pair_size(std::string_view __name,
+					      ::nvlist_t const *__nvl)
+	{
+		return (__pair_size(__name, 0) + __nvlist_size(__nvl)
+			+ __pair_header_size + 1);
+	}
+
+	static std::size_t __nvlist_size(::nvlist_t const *);
+
+	void __list_header(int __flags) noexcept {
+		auto __hflags = static_cast<std::uint8_t>(__flags);
+		if constexpr (std::endian::native == std::endian::big)
+			__hflags |= __flag_big_endian;
+
+		__write(__magic);
+		__write(__version);
+		__write(__hflags);
+		__write(std::uint64_t{0});	// descriptors
+		__write(static_cast<std::uint64_t>(
+			__m_end - __m_ptr - sizeof(std::uint64_t)));
+	}
+
+	void __pair_header(std::uint8_t __type, std::string_view __name,
+			   std::uint64_t __datasize,
+			   std::uint64_t __nitems) noexcept {
+		__write(__type);
+		__write(static_cast<std::uint16_t>(__name.size() + 1));
+		__write(__datasize);
+		__write(__nitems);
+		__write_string(__name);
+	}
+
+	template<typename _T>
+	void __write(_T __value) noexcept {
+		std::memcpy(__m_ptr, &__value, sizeof(__value));
+		__m_ptr += sizeof(__value);
+	}
+
+	void __write_bytes(void const *__data, std::size_t __size) noexcept {
+		std::memcpy(__m_ptr, __data, __size);
+		__m_ptr += __size;
+	}
+
+	void __write_string(std::string_view __str) noexcept {
+		__write_bytes(__str.data(), __str.size());
+		*__m_ptr++ = std::byte{0};
+	}
+
+	static std::size_t __string_size(std::string_view __name,
+					 std::string_view __value)
+	{
+		if (__value.find('\0') != __value.npos) [[unlikely]]
+			__throw_runtime_error(
+				"nv_list string values may not contain NUL");
+
+		return (__pair_size(__name, __value.size() + 1));
+	}
+
+	void __string(std::string_view __name,
+		      std::string_view __value) noexcept {
+		__pair_header(NV_TYPE_STRING, __name, __value.size() + 1, 0);
+		__write_string(__value);
+	}
+
+	static std::size_t __string_array_size(std::string_view __name,
+					       auto const &__range)
+	{
+		auto __datasize = std::size_t{0};
+		for (std::string_view __value : __range) {
+			if (__value.find('\0') != __value.npos) [[unlikely]]
+				__throw_runtime_error("nv_list string values "
+						      "may not contain NUL");
+			__datasize += __value.size() + 1;
+		}
+
+		return (__pair_size(__name, __datasize));
+	}
+
+	void __string_array(std::string_view __name,
+			    auto const &__range) noexcept {
+		auto __datasize = std::size_t{0};
+		auto __nitems = std::size_t{0};
+		for (std::string_view __value : __range) {
+			__datasize += __value.size() + 1;
+			++__nitems;
+		}
+
+		__pair_header(NV_TYPE_STRING_ARRAY, __name,
+			      __datasize, __nitems);
+		for (std::string_view __value : __range)
+			__write_string(__value);
+	}
+
+	// Write an nvlist pair holding __nvl, as sized by __nvlist_pair_size().
+	void __nvlist(std::string_view __name, ::nvlist_t const *__nvl) noexcept;
+
+private:
+	std::byte *__m_ptr;
+	std::byte *__m_end;
+};
+
+[[noreturn, gnu::cold]] void __throw_unpack_error(std::errc);
+
+// Record that a field was unpacked; a field may only appear once.
+inline void
+__unpack_seen(bool &__seen)
+{
+	if (__seen) [[unlikely]]
+		__throw_unpack_error(std::errc::file_exists);
+	__seen = true;
+}
+
+/*
+ * A pair read by __nv_unpacker.  The name and the data refer to the packed
+ * buffer, and have already been checked.  The accessors throw
+ * nv_key_not_found if the pair is not of the expected type, as the nv_list
+ * accessors would.
+ */
+struct __nv_packed_pair {
+	std::uint8_t __type = 0;
+	std::string_view __name;
+	std::span<std::byte const> __data;
+	std::size_t __nitems = 0;
+	bool __swap = false;
+
+	void __expect(int __want) const {
+		if (__type != __want) [[unlikely]]
+			__throw_key_not_found(__name);
+	}
+
+	std::uint64_t __load(std::size_t __i) const noexcept {
+		std::uint64_t __value;
+		std::memcpy(&__value, __data.data() + __i * sizeof(__value),
+			    sizeof(__value));
+		return (__swap ? std::byteswap(__value) : __value);
+	}
+
+	bool __bool() const {
+		__expect(NV_TYPE_BOOL);
+		return (__data[0] != std::byte{0});
+	}
+
+	std::uint64_t __number() const {
+		__expect(NV_TYPE_NUMBER);
+		return (__load(0));
+	}
+
+	std::string_view __string() const {
+		__expect(NV_TYPE_STRING);
+		return {reinterpret_cast<char const *>(__data.data()),
+			__data.size() - 1};
+	}
+
+	auto __bool_array() const {
+		__expect(NV_TYPE_BOOL_ARRAY);
+		return (__data | std::views::transform([] (std::byte __b) {
+			return (__b != std::byte{0});
+		}));
+	}
+
+	auto __number_array() const {
+		__expect(NV_TYPE_NUMBER_ARRAY);
+		return (std::views::iota(std::size_t{0}, __nitems)
+			| std::views::transform([this] (std::size_t __i) {
+				return (__load(__i));
+			}));
+	}
+
+	// The strings are stored one after another, each with its NUL.
+	auto __string_array() const {
+		__expect(NV_TYPE_STRING_ARRAY);
+		auto const __chars = std::string_view(
+			reinterpret_cast<char const *>(__data.data()),
+			__data.size());
+		return (__chars
+			| std::views::split('\0')
+			| std::views::take(__nitems)
+			| std::views::transform([] (auto &&__s) {
+				return (std::string_view(__s.begin(),
+							 __s.end()));
+			}));
+	}
+};
+
+/*
+ * __nv_unpacker reads libnv's packed format for nv_unpack_into(), checking
+ * the input as nvlist_unpack() would.  If the input is invalid, throws
+ * std::system_error with EINVAL.  Input which is valid but which contains
+ * descriptors or nvlist arrays is rejected with EOPNOTSUPP.
+ */
+struct __nv_unpacker {
+	// Check the nvlist header.
+	explicit __nv_unpacker(std::span<std::byte const>);
+
+	/*
+	 * Read the next pair of the top-level nvlist, or return false at the
+	 * end of the input.  If the pair is an nvlist, its contents follow,
+	 * and the caller must consume them with __nvlist() or
+	 * __skip_nvlist().
+	 */
+	bool __next(__nv_packed_pair &);
+
+	nv_list __nvlist(__nv_packed_pair const &);
+	void __skip_nvlist();
+
+private:
+	std::byte const *__m_ptr;
+	std::byte const *__m_end;
+	bool __m_swap = false;
+
+	std::uint8_t __header();
+	void __pair(__nv_packed_pair &);
+	void __pairs(nv_list *, unsigned __depth);
+};
+
 } // namespace __detail
 
 /*
@@ -68,6 +338,22 @@ struct nv_encoder<bool> {
 	auto decode(const_nv_list const &__nvl, std::string_view __key) -> bool {
 		return (__nvl.get_bool(__key));
 	}
+
+	std::size_t packed_size(std::string_view __key, bool) {
+		return (__detail::__nv_packer::__pair_size(
+				__key, sizeof(std::uint8_t)));
+	}
+
+	void pack(__detail::__nv_packer &__p, std::string_view __key,
+		  bool __value) {
+		__p.__pair_header(NV_TYPE_BOOL, __key, sizeof(std::uint8_t), 0);
+		__p.__write(static_cast<std::uint8_t>(__value));
+	}
+
+	bool unpack(__detail::__nv_unpacker &,
+		    __detail::__nv_packed_pair const &__p) {
+		return (__p.__bool());
+	}
 };
 
 template<__detail::__from_range_container_of<bool> _C>
@@ -80,6 +366,26 @@ struct nv_encoder<_C> {
 	auto decode(const_nv_list const &__nvl, std::string_view __key) -> _C {
 		return (_C(std::from_range, __nvl.get_bool_array(__key)));
 	}
+
+	std::size_t packed_size(std::string_view __key, _C const &__range) {
+		return (__detail::__nv_packer::__pair_size(__key,
+			sizeof(bool) * std::ranges::distance(__range)));
+	}
+
+	void pack(__detail::__nv_packer &__p, std::string_view __key,
+		  _C const &__range) {
+		auto const __n = static_cast<std::size_t>(
+					std::ranges::distance(__range));
+		__p.__pair_header(NV_TYPE_BOOL_ARRAY, __key,
+				  sizeof(bool) * __n, __n);
+		for (bool __b : __range)
+			__p.__write(__b);
+	}
+
+	_C unpack(__detail::__nv_unpacker &,
+		  __detail::__nv_packed_pair const &__p) {
+		return (_C(std::from_range, __p.__bool_array()));
+	}
 };
 
 /* uint64_t */
@@ -96,6 +402,23 @@ struct nv_encoder<std::uint64_t> {
 			     std::string_view __key) {
 		return __nvl.get_number(__key);
 	}
+
+	std::size_t packed_size(std::string_view __key, std::uint64_t) {
+		return (__detail::__nv_packer::__pair_size(
+				__key, sizeof(std::uint64_t)));
+	}
+
+	void pack(__detail::__nv_packer &__p, std::string_view __key,
+		  std::uint64_t __value) {
+		__p.__pair_header(NV_TYPE_NUMBER, __key,
+				  sizeof(std::uint64_t), 0);
+		__p.__write(__value);
+	}
+
+	std::uint64_t unpack(__detail::__nv_unpacker &,
+			     __detail::__nv_packed_pair const &__p) {
+		return (__p.__number());
+	}
 };
 
 template<__detail::__from_range_container_of<std::uint64_t> _C>
@@ -108,6 +431,26 @@ struct nv_encoder<_C> {
 	auto decode(const_nv_list const &__nvl, std::string_view __key) -> _C {
 		return (_C(std::from_range, __nvl.get_number_array(__key)));
 	}
+
+	std::size_t packed_size(std::string_view __key, _C const &__range) {
+		return (__detail::__nv_packer::__pair_size(__key,
+			sizeof(std::uint64_t) * std::ranges::distance(__range)));
+	}
+
+	void pack(__detail::__nv_packer &__p, std::string_view __key,
+		  _C const &__range) {
+		auto const __n = static_cast<std::size_t>(
+					std::ranges::distance(__range));
+		__p.__pair_header(NV_TYPE_NUMBER_ARRAY, __key,
+				  sizeof(std::uint64_t) * __n, __n);
+		for (std::uint64_t __v : __range)
+			__p.__write(__v);
+	}
+
+	_C unpack(__detail::__nv_unpacker &,
+		  __detail::__nv_packed_pair const &__p) {
+		return (_C(std::from_range, __p.__number_array()));
+	}
 };
 
 /* string */
@@ -124,6 +467,21 @@ struct nv_encoder<std::string> {
 			   std::string_view __key) {
 		return std::string(__nvl.get_string(__key));
 	}
+
+	std::size_t packed_size(std::string_view __key,
+				std::string const &__value) {
+		return (__detail::__nv_packer::__string_size(__key, __value));
+	}
+
+	void pack(__detail::__nv_packer &__p, std::string_view __key,
+		  std::string const &__value) {
+		__p.__string(__key, __value);
+	}
+
+	std::string unpack(__detail::__nv_unpacker &,
+			   __detail::__nv_packed_pair const &__p) {
+		return (std::string(__p.__string()));
+	}
 };
 
 template<__detail::__from_range_container_of<std::string> _C>
@@ -143,6 +501,26 @@ struct nv_encoder<_C> {
 			  });
 		return {std::from_range, __strings};
 	}
+
+	std::size_t packed_size(std::string_view __key, _C const &__range) {
+		return (__detail::__nv_packer::__string_array_size(__key,
+								   __range));
+	}
+
+	void pack(__detail::__nv_packer &__p, std::string_view __key,
+		  _C const &__range) {
+		__p.__string_array(__key, __range);
+	}
+
+	_C unpack(__detail::__nv_unpacker &,
+		  __detail::__nv_packed_pair const &__p) {
+		auto __strings =
+			__p.__string_array()
+			| std::views::transform([] (std::string_view __s) {
+				return std::string(__s);
+			});
+		return {std::from_range, __strings};
+	}
 };
 
 /* string_view */
@@ -159,6 +537,22 @@ struct nv_encoder<std::string_view> {
 				std::string_view __key) {
 		return __nvl.get_string(__key);
 	}
+
+	std::size_t packed_size(std::string_view __key,
+				std::string_view __value) {
+		return (__detail::__nv_packer::__string_size(__key, __value));
+	}
+
+	void pack(__detail::__nv_packer &__p, std::string_view __key,
+		  std::string_view __value) {
+		__p.__string(__key, __value);
+	}
+
+	// The string refers to the packed buffer.
+	std::string_view unpack(__detail::__nv_unpacker &,
+				__detail::__nv_packed_pair const &__p) {
+		return (__p.__string());
+	}
 };
 
 template<__detail::__from_range_container_of<std::string_view> _C>
@@ -171,6 +565,21 @@ struct nv_encoder<_C> {
 	_C decode(const_nv_list const &__nvl, std::string_view __key) {
 		return {std::from_range, __nvl.get_string_array(__key)};
 	}
+
+	std::size_t packed_size(std::string_view __key, _C const &__range) {
+		return (__detail::__nv_packer::__string_array_size(__key,
+								   __range));
+	}
+
+	void pack(__detail::__nv_packer &__p, std::string_view __key,
+		  _C const &__range) {
+		__p.__string_array(__key, __range);
+	}
+
+	_C unpack(__detail::__nv_unpacker &,
+		  __detail::__nv_packed_pair const &__p) {
+		return {std::from_range, __p.__string_array()};
+	}
 };
 
 /* nv_list */
@@ -186,6 +595,25 @@ struct nv_encoder<nv_list> {
 	nv_list decode(const_nv_list const &__nvl, std::string_view __key) {
 		return (nv_list(__nvl.get_nvlist(__key)));
 	}
+
+	std::size_t packed_size(std::string_view __key,
+				nv_list const &__value) {
+		if (auto const __err = __value.error(); __err)
+			throw nv_error_state(__err);
+
+		return (__detail::__nv_packer::__nvlist_pair_size(
+				__key, __value.ptr()));
+	}
+
+	void pack(__detail::__nv_packer &__p, std::string_view __key,
+		  nv_list const &__value) {
+		__p.__nvlist(__key, __value.ptr());
+	}
+
+	nv_list unpack(__detail::__nv_unpacker &__u,
+		       __detail::__nv_packed_pair const &__p) {
+		return (__u.__nvlist(__p));
+	}
 };
 
 template<__detail::__from_range_container_of<nv_list> _C>
@@ -221,6 +649,20 @@ struct nv_encoder<const_nv_list> {
 			     std::string_view __key) {
 		return __nvl.get_nvlist(__key);
 	}
+
+	std::size_t packed_size(std::string_view __key,
+				const_nv_list const &__value) {
+		if (auto const __err = __value.error(); __err)
+			throw nv_error_state(__err);
+
+		return (__detail::__nv_packer::__nvlist_pair_size(
+				__key, __value.ptr()));
+	}
+
+	void pack(__detail::__nv_packer &__p, std::string_view __key,
+		  const_nv_list const &__value) {
+		__p.__nvlist(__key, __value.ptr());
+	}
 };
 
 template<__detail::__from_range_container_of<const_nv_list> _C>
@@ -255,6 +697,29 @@ struct nv_encoder<std::optional<_T>> {
 		else
 			return {};
 	}
+
+	std::size_t packed_size(std::string_view __key,
+				std::optional<_T> const &__value) {
+		if (__value)
+			return (nv_encoder<_T>{}.packed_size(__key, *__value));
+		return (0);
+	}
+
+	void pack(__detail::__nv_packer &__p, std::string_view __key,
+		  std::optional<_T> const &__value) {
+		if (__value)
+			nv_encoder<_T>{}.pack(__p, __key, *__value);
+	}
+
+	std::optional<_T> unpack(__detail::__nv_unpacker &__u,
+				 __detail::__nv_packed_pair const &__p) {
+		return {nv_encoder<_T>{}.unpack(__u, __p)};
+	}
+
+	// The value to use if the pair is not present.
+	std::optional<_T> unpack_missing() {
+		return {};
+	}
 };
 
 /*
@@ -283,6 +748,43 @@ struct nv_field : __detail::__serializer_tag {
 						.decode(__nvl, __field_name);
 	}
 
+	std::size_t packed_size(_Object const &__object) const {
+		return (nv_encoder<_Member>{}.packed_size(
+				__field_name, __object.*__field_ptr));
+	}
+
+	void pack(__detail::__nv_packer &__p, _Object const &__object) const {
+		nv_encoder<_Member>{}.pack(__p, __field_name,
+					   __object.*__field_ptr);
+	}
+
+	static consteval std::size_t unpack_fields() {
+		return (1);
+	}
+
+	bool unpack(__detail::__nv_unpacker &__u,
+		    __detail::__nv_packed_pair const &__p,
+		    _Object &__object, std::span<bool> __seen) const {
+		if (__p.__name != __field_name)
+			return (false);
+
+		__detail::__unpack_seen(__seen[0]);
+		__object.*__field_ptr = nv_encoder<_Member>{}.unpack(__u, __p);
+		return (true);
+	}
+
+	void unpack_missing(_Object &__object,
+			    std::span<bool const> __seen) const {
+		if (__seen[0])
+			return;
+
+		using __encoder = nv_encoder<_Member>;
+		if constexpr (requires { __encoder{}.unpack_missing(); })
+			__object.*__field_ptr = __encoder{}.unpack_missing();
+		else
+			throw nv_key_not_found(__field_name);
+	}
+
 private:
 	std::string __field_name;
 	_Member _Object::* __field_ptr;
@@ -312,6 +814,43 @@ struct nv_object : __detail::__serializer_tag {
 		__schema.deserialize(__nvl, __object.*__field_ptr);
 	}
 
+	std::size_t packed_size(_Object const &__object) const {
+		using __schema_type = nv_schema<_Member>;
+		auto __schema = __schema_type{}.get();
+		return (__schema.packed_size(__object.*__field_ptr));
+	}
+
+	void pack(__detail::__nv_packer &__p, _Object const &__object) const {
+		using __schema_type = nv_schema<_Member>;
+		auto __schema = __schema_type{}.get();
+		__schema.pack(__p, __object.*__field_ptr);
+	}
+
+	static consteval std::size_t unpack_fields() {
+		using __schema_type = nv_schema<_Member>;
+		return (decltype(__schema_type{}.get())::unpack_fields());
+	}
+
+	/*
+	 * This is called for every pair, so the schema is only created once
+	 * rather than on each call.
+	 */
+	bool unpack(__detail::__nv_unpacker &__u,
+		    __detail::__nv_packed_pair const &__p,
+		    _Object &__object, std::span<bool> __seen) const {
+		using __schema_type = nv_schema<_Member>;
+		static auto const __schema = __schema_type{}.get();
+		return (__schema.unpack(__u, __p, __object.*__field_ptr,
+					__seen));
+	}
+
+	void unpack_missing(_Object &__object,
+			    std::span<bool const> __seen) const {
+		using __schema_type = nv_schema<_Member>;
+		auto __schema = __schema_type{}.get();
+		__schema.unpack_missing(__object.*__field_ptr, __seen);
+	}
+
 private:
 	std::string __field_name;
 	_Member _Object::* __field_ptr;
@@ -339,6 +878,36 @@ struct nv_literal<std::string_view> : __detail::__serializer_tag {
 			throw nv_key_not_found(__field_name);
 	}
 
+	std::size_t packed_size(auto const &) const {
+		return (__detail::__nv_packer::__string_size(__field_name,
+							     __field_value));
+	}
+
+	void pack(__detail::__nv_packer &__p, auto const &) const {
+		__p.__string(__field_name, __field_value);
+	}
+
+	static consteval std::size_t unpack_fields() {
+		return (1);
+	}
+
+	bool unpack(__detail::__nv_unpacker &,
+		    __detail::__nv_packed_pair const &__p,
+		    auto &, std::span<bool> __seen) const {
+		if (__p.__name != __field_name)
+			return (false);
+
+		__detail::__unpack_seen(__seen[0]);
+		if (__p.__string() != __field_value)
+			throw nv_key_not_found(__field_name);
+		return (true);
+	}
+
+	void unpack_missing(auto &, std::span<bool const> __seen) const {
+		if (!__seen[0])
+			throw nv_key_not_found(__field_name);
+	}
+
 private:
 	std::string __field_name;
 	std::string __field_value;
@@ -368,6 +937,35 @@ struct __field_sequence : __detail::__serializer_tag {
 		__second.deserialize(__nvl, __object);
 	}
 
+	std::size_t packed_size(auto const &__object) const {
+		return (__first.packed_size(__object)
+			+ __second.packed_size(__object));
+	}
+
+	void pack(__nv_packer &__p, auto const &__object) const {
+		__first.pack(__p, __object);
+		__second.pack(__p, __object);
+	}
+
+	static consteval std::size_t unpack_fields() {
+		return (_First::unpack_fields() + _Second::unpack_fields());
+	}
+
+	bool unpack(__nv_unpacker &__u, __nv_packed_pair const &__p,
+		    auto &__object, std::span<bool> __seen) const {
+		constexpr auto __n = _First::unpack_fields();
+		return (__first.unpack(__u, __p, __object, __seen.first(__n))
+			|| __second.unpack(__u, __p, __object,
+					   __seen.subspan(__n)));
+	}
+
+	void unpack_missing(auto &__object,
+			    std::span<bool const> __seen) const {
+		constexpr auto __n = _First::unpack_fields();
+		__first.unpack_missing(__object, __seen.first(__n));
+		__second.unpack_missing(__object, __seen.subspan(__n));
+	}
+
 private:
 	_First __first;
 	_Second __second;
@@ -384,6 +982,7 @@ auto operator>> (__detail::__serializer auto const &__f1,
 nv_list
 nv_serialize(auto &&__o, __detail::__serializer auto const &__schema)
 {
+	__NVXX_STATS_CALL(serialize);
 	auto __nvl = nv_list();
 	__schema.serialize(__nvl, __o);
 	return (__nvl);
@@ -402,6 +1001,7 @@ nv_deserialize(const_nv_list const &__nvl,
 	       auto &__obj,
 	       __detail::__serializer auto const &__schema)
 {
+	__NVXX_STATS_CALL(serialize);
 	__schema.deserialize(__nvl, __obj);
 }
 
@@ -412,6 +1012,124 @@ void nv_deserialize(const_nv_list const &__nvl, auto &__obj)
 	nv_deserialize(__nvl, __obj, __schema);
 }
 
+/*
+ * Direct packing: write the object in the format produced by nvlist_pack(),
+ * without creating an nvlist first.  The result is identical to calling
+ * pack() on the result of nv_serialize(), and can be passed to
+ * nv_list::unpack().  Fields holding descriptors or nvlist arrays are not
+ * supported, and the schema must not contain duplicate names.
+ */
+
+std::size_t
+nv_packed_size(auto const &__o, __detail::__serializer auto const &__schema)
+{
+	return (__detail::__nv_packer::__list_header_size
+		+ __schema.packed_size(__o));
+}
+
+std::size_t
+nv_packed_size(auto const &__o)
+{
+	using __schema_type = nv_schema<std::remove_cvref_t<decltype(__o)>>;
+	auto __schema = __schema_type{}.get();
+	return (nv_packed_size(__o, __schema));
+}
+
+/*
+ * Pack the object into the start of the buffer and return the part of the
+ * buffer which was used.  If the buffer is too small, throws std::system_error
+ * with std::errc::no_buffer_space and leaves the buffer unchanged.
+ */
+std::span<std::byte>
+nv_pack(auto const &__o, std::span<std::byte> __buffer,
+	__detail::__serializer auto const &__schema)
+{
+	__NVXX_STATS_CALL(serialize);
+
+	auto const __size = nv_packed_size(__o, __schema);
+	if (__size > __buffer.size())
+		throw std::system_error(std::make_error_code(
+			std::errc::no_buffer_space));
+
+	auto __used = __buffer.first(__size);
+	auto __p = __detail::__nv_packer(__used);
+	__p.__list_header(0);
+	__schema.pack(__p, __o);
+	return (__used);
+}
+
+std::span<std::byte>
+nv_pack(auto const &__o, std::span<std::byte> __buffer)
+{
+	using __schema_type = nv_schema<std::remove_cvref_t<decltype(__o)>>;
+	auto __schema = __schema_type{}.get();
+	return (nv_pack(__o, __buffer, __schema));
+}
+
+/*
+ * As above, but pack the object into a new vector.
+ */
+std::vector<std::byte>
+nv_pack(auto const &__o, __detail::__serializer auto const &__schema)
+{
+	__NVXX_STATS_CALL(serialize);
+
+	auto __buffer = std::vector<std::byte>(nv_packed_size(__o, __schema));
+	auto __p = __detail::__nv_packer(__buffer);
+	__p.__list_header(0);
+	__schema.pack(__p, __o);
+	return (__buffer);
+}
+
+std::vector<std::byte>
+nv_pack(auto const &__o)
+{
+	using __schema_type = nv_schema<std::remove_cvref_t<decltype(__o)>>;
+	auto __schema = __schema_type{}.get();
+	return (nv_pack(__o, __schema));
+}
+
+/*
+ * Direct unpacking: read data in the format produced by nvlist_pack() into
+ * the object, without creating an nvlist first.  Each pair is assigned to the
+ * field of the same name, and pairs which do not match a field are checked
+ * and ignored.  As with nv_deserialize(), throws nv_key_not_found if a
+ * required field is missing or has the wrong type.  If the data is not valid,
+ * throws std::system_error with std::errc::invalid_argument, or with
+ * std::errc::file_exists if a field appears more than once.
+ *
+ * Fields of type std::string_view refer to the data, which must outlive
+ * them.  Fields of type const_nv_list cannot be unpacked.
+ */
+
+void
+nv_unpack_into(auto &__obj, std::span<std::byte const> __data,
+	       __detail::__serializer auto const &__schema)
+{
+	__NVXX_STATS_CALL(serialize);
+
+	using __schema_type = std::remove_cvref_t<decltype(__schema)>;
+	auto __seen = std::array<bool, __schema_type::unpack_fields()>{};
+	auto __u = __detail::__nv_unpacker(__data);
+	auto __p = __detail::__nv_packed_pair{};
+
+	while (__u.__next(__p)) {
+		if (!__schema.unpack(__u, __p, __obj, __seen)
+		    && __p.__type == NV_TYPE_NVLIST)
+			__u.__skip_nvlist();
+	}
+
+	__schema.unpack_missing(__obj, __seen);
+}
+
+void
+nv_unpack_into(auto &__obj, std::span<std::byte const> __data)
+{
+	using __schema_type = nv_schema<std::remove_cvref_t<decltype(__obj)>>;
+	auto __schema = __schema_type{}.get();
+	nv_unpack_into(__obj, __data, __schema);
+}
+
 } // namespace bsd
 
 #endif	/* !_NVXX_SERIALIZE_H */
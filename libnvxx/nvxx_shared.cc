@@ -0,0 +1,168 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR MIT
+ * Refer to the file 'LICENSE' in the nvxx distribution for license terms.
+ */
+
+#include <atomic>
+#include <utility>
+
+#include "nvxx.h"
+
+namespace bsd {
+
+namespace __detail {
+
+/*
+ * The control block for an nv_shared_list, holding the reference count and
+ * the nvlist itself in a single allocation.
+ */
+struct __shared_block {
+	explicit __shared_block(nv_list &&__list)
+		: __m_list(std::move(__list))
+	{
+	}
+
+	std::atomic<std::size_t> __m_refs{1};
+	nv_list __m_list;
+};
+
+} // namespace bsd::__detail
+
+nv_shared_list::nv_shared_list(int flags)
+	: __m_block(new __detail::__shared_block(nv_list(flags)))
+{
+}
+
+nv_shared_list::nv_shared_list(nv_list &&nvl)
+	: __m_block(new __detail::__shared_block(std::move(nvl)))
+{
+}
+
+nv_shared_list::nv_shared_list(const_nv_list const &nvl)
+	: __m_block(new __detail::__shared_block(nv_list(nvl)))
+{
+}
+
+nv_shared_list::nv_shared_list(nv_shared_list const &other) noexcept
+	: __m_block(other.__m_block)
+{
+	/*
+	 * A new reference can only be created from an existing one, so there
+	 * is nothing to synchronise with here.
+	 */
+	if (__m_block != nullptr)
+		__m_block->__m_refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+nv_shared_list &
+nv_shared_list::operator=(nv_shared_list const &other) noexcept
+{
+	if (__m_block != other.__m_block) {
+		if (other.__m_block != nullptr)
+			other.__m_block->__m_refs.fetch_add(1,
+					std::memory_order_relaxed);
+		__release(std::exchange(__m_block, other.__m_block));
+	}
+
+	return (*this);
+}
+
+nv_shared_list::nv_shared_list(nv_shared_list &&other) noexcept
+	: __m_block(std::exchange(other.__m_block, nullptr))
+{
+}
+
+nv_shared_list &
+nv_shared_list::operator=(nv_shared_list &&other) noexcept
+{
+	if (this != &other)
+		__release(std::exchange(__m_block,
+					std::exchange(other.__m_block, nullptr)));
+
+	return (*this);
+}
+
+nv_shared_list::~nv_shared_list()
+{
+	__release(__m_block);
+}
+
+void
+nv_shared_list::__release(__detail::__shared_block *block) noexcept
+{
+	if (block == nullptr)
+		return;
+
+	/*
+	 * The release decrement orders this thread's accesses to the nvlist
+	 * before the decrement, and the acquire fence orders the deletion
+	 * after every other thread's decrement.
+	 */
+	if (block->__m_refs.fetch_sub(1, std::memory_order_release) == 1) {
+		std::atomic_thread_fence(std::memory_order_acquire);
+		delete block;
+	}
+}
+
+void
+nv_shared_list::__throw_if_null() const
+{
+	if (__m_block == nullptr)
+		throw std::logic_error("attempt to access a moved-from "
+				       "nv_shared_list");
+}
+
+const_nv_list
+nv_shared_list::get() const
+{
+	__throw_if_null();
+	return (__m_block->__m_list);
+}
+
+nv_shared_list::operator const_nv_list() const
+{
+	return (get());
+}
+
+::nvlist_t const *
+nv_shared_list::ptr() const
+{
+	__throw_if_null();
+	return (__m_block->__m_list.ptr());
+}
+
+nv_list &
+nv_shared_list::edit()
+{
+	__throw_if_null();
+
+	if (!unique()) {
+		auto *block = new __detail::__shared_block(
+					nv_list(__m_block->__m_list));
+		__release(std::exchange(__m_block, block));
+	}
+
+	return (__m_block->__m_list);
+}
+
+std::size_t
+nv_shared_list::use_count() const noexcept
+{
+	if (__m_block == nullptr)
+		return (0);
+	return (__m_block->__m_refs.load(std::memory_order_relaxed));
+}
+
+bool
+nv_shared_list::unique() const noexcept
+{
+	/*
+	 * Acquire here so that, if we are about to modify the nvlist, every
+	 * read by a thread which has since dropped its reference happens
+	 * before our writes.
+	 */
+	return (__m_block != nullptr
+		&& __m_block->__m_refs.load(std::memory_order_acquire) == 1);
+}
+
+} // namespace bsd
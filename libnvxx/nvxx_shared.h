@@ -0,0 +1,122 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR MIT
+ * Refer to the file 'LICENSE' in the nvxx distribution for license terms.
+ */
+
+#ifndef	_NVXX_SHARED_H_INCLUDED
+#define _NVXX_SHARED_H_INCLUDED
+
+#ifndef _NVXX_H_INCLUDED
+# error include <nvxx.h> instead of including this header directly
+#endif
+
+#include <cstddef>
+
+/*
+ * nv_shared_list: a reference-counted, copy-on-write handle to an nvlist.
+ *
+ * Copying an nv_shared_list only increments a reference count; the nvlist
+ * itself is cloned the first time a shared copy is modified through edit().
+ * The reference count is atomic, so copies of the same nv_shared_list may be
+ * used and destroyed in different threads.  As with std::shared_ptr, a single
+ * nv_shared_list object must not be accessed concurrently from multiple
+ * threads if any of them modifies it.
+ */
+
+namespace bsd {
+
+namespace __detail {
+
+struct __shared_block;
+
+} // namespace bsd::__detail
+
+struct nv_shared_list {
+	/*
+	 * Create a new, empty nvlist.  The flags argument is passed to
+	 * nvlist_create().  On failure, throws std::system_error.
+	 */
+	explicit nv_shared_list(int __flags = 0);
+
+	/*
+	 * Take ownership of an existing nv_list.  The nvlist is not copied.
+	 */
+	explicit nv_shared_list(nv_list &&);
+
+	/*
+	 * Create an nv_shared_list from a copy of the given const_nv_list made
+	 * with nvlist_clone().  On failure, throws std::system_error.
+	 */
+	explicit nv_shared_list(const_nv_list const &);
+
+	/*
+	 * Copying an nv_shared_list shares the nvlist with the original;
+	 * neither operation can fail.
+	 */
+	nv_shared_list(nv_shared_list const &) noexcept;
+	nv_shared_list &operator=(nv_shared_list const &) noexcept;
+
+	/*
+	 * Moving from an nv_shared_list leaves it in the empty state; it can
+	 * be assigned to or destructed but no other operations are valid.
+	 */
+	nv_shared_list(nv_shared_list &&) noexcept;
+	nv_shared_list &operator=(nv_shared_list &&) noexcept;
+
+	/*
+	 * Release this reference to the nvlist, and destroy the nvlist if
+	 * this was the last reference.
+	 */
+	~nv_shared_list();
+
+	/*
+	 * Return a const_nv_list referring to the shared nvlist.  The
+	 * const_nv_list remains valid as long as this nv_shared_list refers to
+	 * the same nvlist, i.e. until it is destroyed, assigned to, or edit()
+	 * is called on it.
+	 */
+	[[nodiscard]] const_nv_list get() const;
+	operator const_nv_list() const;
+
+	/*
+	 * Return the nvlist pointer held by this nv_shared_list.  The pointer
+	 * must not be used to modify the nvlist.
+	 */
+	[[nodiscard]] ::nvlist_t const *ptr() const;
+
+	/*
+	 * Return a reference to an nv_list which may be modified.  If the
+	 * nvlist is shared with any other nv_shared_list, it is first cloned
+	 * with nvlist_clone() so that the modification is not visible through
+	 * the other copies; on failure, throws std::system_error and this
+	 * nv_shared_list is unchanged.
+	 *
+	 * The returned reference is valid until this nv_shared_list is
+	 * destroyed or assigned to.  It must not be used after this
+	 * nv_shared_list has been copied, since the nvlist would then be shared
+	 * again; call edit() again instead.
+	 */
+	[[nodiscard]] nv_list &edit();
+
+	/*
+	 * Return the number of nv_shared_list objects which refer to this
+	 * nvlist.  If other threads hold copies, the result is approximate.
+	 */
+	[[nodiscard]] std::size_t use_count() const noexcept;
+
+	/*
+	 * Returns true if no other nv_shared_list refers to this nvlist, i.e.
+	 * if edit() will not clone the nvlist.
+	 */
+	[[nodiscard]] bool unique() const noexcept;
+
+private:
+	__detail::__shared_block *__m_block = nullptr;
+
+	void __throw_if_null() const;
+	static void __release(__detail::__shared_block *) noexcept;
+};
+
+} // namespace bsd
+
+#endif	/* !_NVXX_SHARED_H_INCLUDED */
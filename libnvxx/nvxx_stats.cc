@@ -0,0 +1,158 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR MIT
+ * Refer to the file 'LICENSE' in the nvxx distribution for license terms.
+ */
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#include "nvxx.h"
+
+namespace bsd {
+
+namespace {
+
+/*
+ * The counters for one thread.  Only the owning thread writes to them, so an
+ * increment is a relaxed load and store rather than an atomic add; other
+ * threads only read them, or reset them in nv_stats_reset().
+ */
+struct thread_counters {
+	thread_counters();
+	~thread_counters();
+
+	void add(nv_stats_op op, std::size_t field, std::uint64_t n) noexcept {
+		auto &c = counters[static_cast<std::size_t>(op)][field];
+		c.store(c.load(std::memory_order_relaxed) + n,
+			std::memory_order_relaxed);
+	}
+
+	std::atomic<std::uint64_t> counters[__nv_stats_nops][3]{};
+};
+
+/*
+ * All live threads' counters, and the sum of the counters of threads which
+ * have exited.
+ */
+struct registry {
+	std::mutex mutex;
+	std::vector<thread_counters *> threads;
+	nv_stats_snapshot retired;
+};
+
+registry &
+get_registry()
+{
+	// never destroyed, since threads may exit after static destruction.
+	static auto *reg = new registry;
+	return (*reg);
+}
+
+void
+add_to(nv_stats_snapshot &snap, thread_counters const &tc)
+{
+	for (auto i = std::size_t{0}; i < __nv_stats_nops; ++i) {
+		auto &c = snap.counters[i];
+		c.calls += tc.counters[i][0].load(std::memory_order_relaxed);
+		c.allocs += tc.counters[i][1].load(std::memory_order_relaxed);
+		c.bytes += tc.counters[i][2].load(std::memory_order_relaxed);
+	}
+}
+
+thread_counters::thread_counters()
+{
+	auto &reg = get_registry();
+	auto lock = std::lock_guard(reg.mutex);
+	reg.threads.push_back(this);
+}
+
+thread_counters::~thread_counters()
+{
+	auto &reg = get_registry();
+	auto lock = std::lock_guard(reg.mutex);
+	add_to(reg.retired, *this);
+	std::erase(reg.threads, this);
+}
+
+thread_counters &
+this_thread()
+{
+	thread_local auto counters = thread_counters();
+	return (counters);
+}
+
+} // anonymous namespace
+
+nv_stats_snapshot
+nv_stats_get()
+{
+	auto &reg = get_registry();
+	auto lock = std::lock_guard(reg.mutex);
+
+	auto snap = reg.retired;
+	for (auto const *tc : reg.threads)
+		add_to(snap, *tc);
+	return (snap);
+}
+
+void
+nv_stats_reset()
+{
+	auto &reg = get_registry();
+	auto lock = std::lock_guard(reg.mutex);
+
+	reg.retired = {};
+	for (auto *tc : reg.threads)
+		for (auto &op : tc->counters)
+			for (auto &c : op)
+				c.store(0, std::memory_order_relaxed);
+}
+
+bool
+nv_stats_enabled() noexcept
+{
+#ifdef NVXX_STATS
+	return (true);
+#else
+	return (false);
+#endif
+}
+
+std::string_view
+nv_stats_op_name(nv_stats_op op) noexcept
+{
+	switch (op) {
+	case nv_stats_op::get:		return ("get");
+	case nv_stats_op::add:		return ("add");
+	case nv_stats_op::take:		return ("take");
+	case nv_stats_op::pack:		return ("pack");
+	case nv_stats_op::unpack:	return ("unpack");
+	case nv_stats_op::clone:	return ("clone");
+	case nv_stats_op::send:		return ("send");
+	case nv_stats_op::recv:		return ("recv");
+	case nv_stats_op::serialize:	return ("serialize");
+	}
+
+	return ("unknown");
+}
+
+namespace __detail {
+
+void
+__stats_call(nv_stats_op op) noexcept
+{
+	this_thread().add(op, 0, 1);
+}
+
+void
+__stats_alloc(nv_stats_op op, std::size_t bytes) noexcept
+{
+	auto &tc = this_thread();
+	tc.add(op, 1, 1);
+	tc.add(op, 2, bytes);
+}
+
+} // namespace bsd::__detail
+
+} // namespace bsd
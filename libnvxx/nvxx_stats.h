@@ -0,0 +1,105 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR MIT
+ * Refer to the file 'LICENSE' in the nvxx distribution for license terms.
+ */
+
+#ifndef	_NVXX_STATS_H_INCLUDED
+#define _NVXX_STATS_H_INCLUDED
+
+#ifndef _NVXX_H_INCLUDED
+# error include <nvxx.h> instead of including this header directly
+#endif
+
+/*
+ * nv_stats: optional per-operation statistics.
+ *
+ * If NVXX_STATS is defined, each operation in one of the families below
+ * increments a thread-local call counter, and operations which allocate
+ * memory on behalf of the caller (vector and string returns, the copy made by
+ * pack(), and so on) also count the allocation and its size.  Allocations
+ * made inside libnv itself are not counted; comparing these figures with the
+ * total from a malloc wrapper shows how much of the allocation comes from
+ * each.
+ *
+ * nv_stats_get() adds up the counters of every thread, including threads
+ * which have exited.
+ *
+ * NVXX_STATS is defined by nvxx_config.h, which is generated when the library
+ * is built (make WITH_NVXX_STATS=yes) and installed with it, so every
+ * translation unit sees the same inline code.  If it is not defined, the
+ * counting code is not compiled at all and nv_stats_get() returns zeros.
+ */
+
+namespace bsd {
+
+enum struct nv_stats_op {
+	get,
+	add,
+	take,
+	pack,
+	unpack,
+	clone,
+	send,
+	recv,
+	serialize,
+};
+
+inline constexpr std::size_t __nv_stats_nops =
+	static_cast<std::size_t>(nv_stats_op::serialize) + 1;
+
+struct nv_stats_counters {
+	std::uint64_t calls = 0;
+	std::uint64_t allocs = 0;
+	std::uint64_t bytes = 0;
+};
+
+struct nv_stats_snapshot {
+	[[nodiscard]] nv_stats_counters const &
+	operator[](nv_stats_op __op) const noexcept {
+		return (counters[static_cast<std::size_t>(__op)]);
+	}
+
+	std::array<nv_stats_counters, __nv_stats_nops> counters{};
+};
+
+/*
+ * Return the sum of the counters of all threads.
+ */
+[[nodiscard]] nv_stats_snapshot nv_stats_get();
+
+/*
+ * Reset the counters of all threads to zero.  Counts recorded by other
+ * threads while this is running may be lost.
+ */
+void nv_stats_reset();
+
+/*
+ * Return true if the library was built with NVXX_STATS.
+ */
+[[nodiscard]] bool nv_stats_enabled() noexcept;
+
+/*
+ * Return the name of an operation family, e.g. "get".
+ */
+[[nodiscard]] std::string_view nv_stats_op_name(nv_stats_op) noexcept;
+
+namespace __detail {
+
+void __stats_call(nv_stats_op) noexcept;
+void __stats_alloc(nv_stats_op, std::size_t __bytes) noexcept;
+
+} // namespace bsd::__detail
+
+} // namespace bsd
+
+#ifdef NVXX_STATS
+# define __NVXX_STATS_CALL(__op) \
+	::bsd::__detail::__stats_call(::bsd::nv_stats_op::__op)
+# define __NVXX_STATS_ALLOC(__op, __bytes) \
+	::bsd::__detail::__stats_alloc(::bsd::nv_stats_op::__op, (__bytes))
+#else
+# define __NVXX_STATS_CALL(__op) ((void)0)
+# define __NVXX_STATS_ALLOC(__op, __bytes) ((void)0)
+#endif
+
+#endif	/* !_NVXX_STATS_H_INCLUDED */
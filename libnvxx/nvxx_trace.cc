@@ -0,0 +1,253 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR MIT
+ * Refer to the file 'LICENSE' in the nvxx distribution for license terms.
+ */
+
+#include <bit>
+#include <cmath>
+
+#include "nvxx.h"
+
+namespace bsd {
+
+namespace __detail {
+
+std::atomic<unsigned> __trace_flags{0};
+
+} // namespace bsd::__detail
+
+namespace {
+
+constexpr unsigned flag_histogram = 0x1;
+constexpr unsigned flag_hooks = 0x2;
+
+std::atomic<nv_trace_hooks const *> trace_hooks{nullptr};
+
+/*
+ * A log-linear histogram of latencies in nanoseconds, in the style of
+ * HdrHistogram.  Each power of two is split into 2^sub_bits buckets of equal
+ * width, so a recorded value is known to within 1/2^sub_bits of its size.
+ * All updates are relaxed atomic operations, so recording never blocks;
+ * a summary taken while values are being recorded may not include all of
+ * them.
+ */
+struct histogram {
+	static constexpr unsigned sub_bits = 4;
+	static constexpr unsigned sub_count = 1u << sub_bits;
+	static constexpr std::size_t nbuckets = (64 - sub_bits + 1) * sub_count;
+
+	static std::size_t
+	bucket_for(std::uint64_t value) noexcept {
+		if (value < sub_count)
+			return (value);
+
+		auto const exp = static_cast<unsigned>(std::bit_width(value)) - 1;
+		auto const sub = (value >> (exp - sub_bits)) & (sub_count - 1);
+		return ((exp - sub_bits + 1) * sub_count + sub);
+	}
+
+	// The largest value which falls into the bucket.
+	static std::uint64_t
+	bucket_value(std::size_t bucket) noexcept {
+		if (bucket < sub_count)
+			return (bucket);
+
+		auto const exp = bucket / sub_count + sub_bits - 1;
+		auto const sub = bucket % sub_count;
+		auto const width = std::uint64_t{1} << (exp - sub_bits);
+		return (((sub_count + sub) << (exp - sub_bits)) + (width - 1));
+	}
+
+	void
+	record(std::uint64_t value) noexcept {
+		buckets[bucket_for(value)].fetch_add(1,
+						     std::memory_order_relaxed);
+		count.fetch_add(1, std::memory_order_relaxed);
+		sum.fetch_add(value, std::memory_order_relaxed);
+
+		auto cur = min.load(std::memory_order_relaxed);
+		while (value < cur && !min.compare_exchange_weak(
+			       cur, value, std::memory_order_relaxed))
+			;
+
+		cur = max.load(std::memory_order_relaxed);
+		while (value > cur && !max.compare_exchange_weak(
+			       cur, value, std::memory_order_relaxed))
+			;
+	}
+
+	std::uint64_t
+	percentile(double fraction) const noexcept {
+		auto total = std::uint64_t{0};
+		for (auto const &b : buckets)
+			total += b.load(std::memory_order_relaxed);
+		if (total == 0)
+			return (0);
+
+		fraction = std::clamp(fraction, 0.0, 1.0);
+		auto const target = std::max(std::uint64_t{1},
+			static_cast<std::uint64_t>(std::ceil(fraction * total)));
+
+		auto seen = std::uint64_t{0};
+		for (auto i = std::size_t{0}; i < nbuckets; ++i) {
+			seen += buckets[i].load(std::memory_order_relaxed);
+			if (seen >= target)
+				return (std::min(bucket_value(i),
+					max.load(std::memory_order_relaxed)));
+		}
+
+		return (max.load(std::memory_order_relaxed));
+	}
+
+	void
+	reset() noexcept {
+		for (auto &b : buckets)
+			b.store(0, std::memory_order_relaxed);
+		count.store(0, std::memory_order_relaxed);
+		sum.store(0, std::memory_order_relaxed);
+		min.store(UINT64_MAX, std::memory_order_relaxed);
+		max.store(0, std::memory_order_relaxed);
+	}
+
+	std::atomic<std::uint64_t> buckets[nbuckets]{};
+	std::atomic<std::uint64_t> count{0};
+	std::atomic<std::uint64_t> sum{0};
+	std::atomic<std::uint64_t> min{UINT64_MAX};
+	std::atomic<std::uint64_t> max{0};
+};
+
+histogram histograms[__nv_trace_nops];
+
+histogram &
+histogram_for(nv_trace_op op) noexcept
+{
+	return (histograms[static_cast<std::size_t>(op)]);
+}
+
+void
+set_flag(unsigned flag, bool on) noexcept
+{
+	if (on)
+		__detail::__trace_flags.fetch_or(flag, std::memory_order_relaxed);
+	else
+		__detail::__trace_flags.fetch_and(~flag,
+						  std::memory_order_relaxed);
+}
+
+} // anonymous namespace
+
+void
+nv_trace_set_hooks(nv_trace_hooks const *hooks) noexcept
+{
+	trace_hooks.store(hooks, std::memory_order_release);
+	set_flag(flag_hooks, hooks != nullptr);
+}
+
+void
+nv_trace_enable(bool on) noexcept
+{
+	set_flag(flag_histogram, on);
+}
+
+bool
+nv_trace_enabled() noexcept
+{
+	return ((__detail::__trace_flags.load(std::memory_order_relaxed)
+		 & flag_histogram) != 0);
+}
+
+void
+nv_trace_reset() noexcept
+{
+	for (auto &h : histograms)
+		h.reset();
+}
+
+nv_trace_latency
+nv_trace_get(nv_trace_op op) noexcept
+{
+	using std::chrono::nanoseconds;
+
+	auto const &h = histogram_for(op);
+	auto ret = nv_trace_latency{};
+
+	ret.count = h.count.load(std::memory_order_relaxed);
+	if (ret.count == 0)
+		return (ret);
+
+	ret.min = nanoseconds(h.min.load(std::memory_order_relaxed));
+	ret.max = nanoseconds(h.max.load(std::memory_order_relaxed));
+	ret.mean = nanoseconds(h.sum.load(std::memory_order_relaxed)
+			       / ret.count);
+	ret.p50 = nanoseconds(h.percentile(0.5));
+	ret.p99 = nanoseconds(h.percentile(0.99));
+	ret.p999 = nanoseconds(h.percentile(0.999));
+	return (ret);
+}
+
+std::chrono::nanoseconds
+nv_trace_percentile(nv_trace_op op, double fraction) noexcept
+{
+	return (std::chrono::nanoseconds(
+		histogram_for(op).percentile(fraction)));
+}
+
+std::string_view
+nv_trace_op_name(nv_trace_op op) noexcept
+{
+	switch (op) {
+	case nv_trace_op::send:		return ("send");
+	case nv_trace_op::recv:		return ("recv");
+	case nv_trace_op::xfer:		return ("xfer");
+	case nv_trace_op::pack:		return ("pack");
+	case nv_trace_op::unpack:	return ("unpack");
+	}
+
+	return ("unknown");
+}
+
+namespace __detail {
+
+void
+__trace_scope::__begin(std::size_t size) noexcept
+{
+	__m_active = true;
+	__m_size = size;
+
+	if (auto const *hooks = trace_hooks.load(std::memory_order_acquire);
+	    hooks != nullptr && hooks->begin)
+		hooks->begin(nv_trace_event{
+			.op = __m_op,
+			.fd = __m_fd,
+			.size = __m_size,
+		});
+
+	// start the clock after the hook so its cost is not included.
+	__m_start = std::chrono::steady_clock::now();
+}
+
+void
+__trace_scope::__end(int error, ::nvlist_t const *nvl) noexcept
+{
+	auto const elapsed = std::chrono::duration_cast<
+		std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now() - __m_start);
+
+	if (__trace_flags.load(std::memory_order_relaxed) & flag_histogram)
+		histogram_for(__m_op).record(
+			static_cast<std::uint64_t>(elapsed.count()));
+
+	if (auto const *hooks = trace_hooks.load(std::memory_order_acquire);
+	    hooks != nullptr && hooks->end)
+		hooks->end(nv_trace_event{
+			.op = __m_op,
+			.fd = __m_fd,
+			.size = nvl ? ::nvlist_size(nvl) : __m_size,
+			.elapsed = elapsed,
+			.error = error,
+		});
+}
+
+} // namespace bsd::__detail
+
+} // namespace bsd
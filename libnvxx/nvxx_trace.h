@@ -0,0 +1,164 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR MIT
+ * Refer to the file 'LICENSE' in the nvxx distribution for license terms.
+ */
+
+#ifndef	_NVXX_TRACE_H_INCLUDED
+#define _NVXX_TRACE_H_INCLUDED
+
+#ifndef _NVXX_H_INCLUDED
+# error include <nvxx.h> instead of including this header directly
+#endif
+
+/*
+ * nv_trace: latency histograms and tracing hooks for the operations which
+ * move an nvlist in or out of the process: send(), recv(), xfer(), pack() and
+ * unpack().
+ *
+ * Both are off by default and are enabled at runtime.  While neither is
+ * enabled, the cost to each operation is one relaxed atomic load.
+ */
+
+namespace bsd {
+
+enum struct nv_trace_op {
+	send,
+	recv,
+	xfer,
+	pack,
+	unpack,
+};
+
+inline constexpr std::size_t __nv_trace_nops =
+	static_cast<std::size_t>(nv_trace_op::unpack) + 1;
+
+/*
+ * Passed to the tracing hooks.  fd is -1 for pack() and unpack().  size is
+ * the packed size of the nvlist which is being sent or unpacked; for recv()
+ * it is zero until the nvlist has been received, and for xfer() it is the
+ * size of the request in the begin event and of the response in the end
+ * event.  elapsed and error are only set in the end event; error is the errno
+ * value the operation failed with, or zero.
+ */
+struct nv_trace_event {
+	nv_trace_op op;
+	int fd = -1;
+	std::size_t size = 0;
+	std::chrono::nanoseconds elapsed{};
+	int error = 0;
+};
+
+/*
+ * Hooks called before and after each traced operation.  Either may be empty.
+ * The hooks are called in the thread performing the operation and must not
+ * throw.
+ */
+struct nv_trace_hooks {
+	std::function<void (nv_trace_event const &)> begin;
+	std::function<void (nv_trace_event const &)> end;
+};
+
+/*
+ * A summary of the latency histogram for one operation.  The percentiles are
+ * accurate to within about 6%.
+ */
+struct nv_trace_latency {
+	std::uint64_t count = 0;
+	std::chrono::nanoseconds min{};
+	std::chrono::nanoseconds max{};
+	std::chrono::nanoseconds mean{};
+	std::chrono::nanoseconds p50{};
+	std::chrono::nanoseconds p99{};
+	std::chrono::nanoseconds p999{};
+};
+
+/*
+ * Install the tracing hooks, or remove them if the argument is null.  The
+ * hooks are not copied; the caller must keep them alive until they have been
+ * replaced and any operations which were running at the time have finished.
+ */
+void nv_trace_set_hooks(nv_trace_hooks const *) noexcept;
+
+/*
+ * Start or stop recording latency histograms.  Stopping does not discard the
+ * histograms recorded so far.
+ */
+void nv_trace_enable(bool = true) noexcept;
+[[nodiscard]] bool nv_trace_enabled() noexcept;
+
+/*
+ * Discard the latency histograms.
+ */
+void nv_trace_reset() noexcept;
+
+/*
+ * Return a summary of the latency histogram for an operation.
+ */
+[[nodiscard]] nv_trace_latency nv_trace_get(nv_trace_op) noexcept;
+
+/*
+ * Return the latency below which the given fraction of operations completed,
+ * e.g. 0.99 for the 99th percentile.
+ */
+[[nodiscard]] std::chrono::nanoseconds
+nv_trace_percentile(nv_trace_op, double) noexcept;
+
+/*
+ * Return the name of an operation, e.g. "send".
+ */
+[[nodiscard]] std::string_view nv_trace_op_name(nv_trace_op) noexcept;
+
+namespace __detail {
+
+// Non-zero if histograms are enabled or hooks are installed.
+extern std::atomic<unsigned> __trace_flags;
+
+/*
+ * Times a single traced operation.  If tracing is disabled, this only loads
+ * __trace_flags.
+ */
+struct __trace_scope {
+	__trace_scope(nv_trace_op __op, int __fd,
+		      ::nvlist_t const *__nvl) noexcept
+		: __m_op(__op)
+		, __m_fd(__fd)
+	{
+		if (__trace_flags.load(std::memory_order_relaxed) != 0)
+			[[unlikely]] __begin(__nvl ? ::nvlist_size(__nvl) : 0);
+	}
+
+	__trace_scope(nv_trace_op __op, std::size_t __size) noexcept
+		: __m_op(__op)
+	{
+		if (__trace_flags.load(std::memory_order_relaxed) != 0)
+			[[unlikely]] __begin(__size);
+	}
+
+	__trace_scope(__trace_scope const &) = delete;
+	__trace_scope &operator=(__trace_scope const &) = delete;
+
+	/*
+	 * Finish the operation.  nvl is the nvlist which was received, or null
+	 * to report the size given to the constructor.
+	 */
+	void end(int __error, ::nvlist_t const *__nvl = nullptr) noexcept {
+		if (__m_active) [[unlikely]]
+			__end(__error, __nvl);
+	}
+
+private:
+	void __begin(std::size_t) noexcept;
+	void __end(int, ::nvlist_t const *) noexcept;
+
+	nv_trace_op __m_op;
+	int __m_fd = -1;
+	bool __m_active = false;
+	std::size_t __m_size = 0;
+	std::chrono::steady_clock::time_point __m_start;
+};
+
+} // namespace bsd::__detail
+
+} // namespace bsd
+
+#endif	/* !_NVXX_TRACE_H_INCLUDED */
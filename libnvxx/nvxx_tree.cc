@@ -0,0 +1,596 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR MIT
+ * Refer to the file 'LICENSE' in the nvxx distribution for license terms.
+ */
+
+#include <cerrno>
+#include <cstdlib>
+#include <strings.h>
+
+#include "nvxx.h"
+
+namespace bsd {
+
+namespace __detail {
+
+/*
+ * A single pair in a tree node.  Null, bool and number values are stored
+ * inline.  Nested nvlists are stored as nodes and nvlist arrays as vectors of
+ * trees, so that they can be shared with other trees.  All other values are
+ * stored as an nvlist which contains only that pair (a "leaf"); this lets the
+ * leaf be shared between trees, and lets the accessors return exactly what
+ * the corresponding const_nv_list accessor would.
+ */
+struct __tree_entry {
+	std::string __key;
+	int __type;
+	std::variant<std::monostate,
+		     bool,
+		     std::uint64_t,
+		     std::shared_ptr<nv_list const>,
+		     std::shared_ptr<__tree_node const>,
+		     std::shared_ptr<std::vector<nv_tree> const>> __value;
+};
+
+struct __tree_node {
+	__tree_node(int __flags, std::vector<__tree_entry> __entries)
+		: __m_flags(__flags)
+		, __m_entries(std::move(__entries))
+	{
+	}
+
+	__tree_node(__tree_node const &) = delete;
+	__tree_node &operator=(__tree_node const &) = delete;
+
+	int __m_flags;
+	std::vector<__tree_entry> __m_entries;
+
+	std::ptrdiff_t __index(std::string_view, int) const;
+	void __materialize(::nvlist_t *) const;
+
+	static auto __import(::nvlist_t const *)
+		-> std::shared_ptr<__tree_node const>;
+	static auto __update(__tree_node const &,
+			     std::span<std::string_view const>,
+			     __tree_entry *)
+		-> std::shared_ptr<__tree_node const>;
+};
+
+} // namespace bsd::__detail
+
+namespace {
+
+using __detail::__tree_entry;
+using __detail::__tree_node;
+
+using leaf_ptr = std::shared_ptr<nv_list const>;
+using node_ptr = std::shared_ptr<__tree_node const>;
+using array_ptr = std::shared_ptr<std::vector<nv_tree> const>;
+
+bool
+key_equal(std::string_view a, std::string_view b, int flags)
+{
+	if (a.size() != b.size())
+		return (false);
+
+	if (flags & NV_FLAG_IGNORE_CASE)
+		return (::strncasecmp(a.data(), b.data(), a.size()) == 0);
+
+	return (a == b);
+}
+
+void
+throw_if_error(::nvlist_t const *nvl)
+{
+	if (auto err = ::nvlist_error(nvl); err != 0)
+		throw std::system_error(
+			std::error_code(err, std::generic_category()));
+}
+
+/*
+ * Create a leaf entry by calling fn to add the value to an empty nv_list.
+ */
+template<typename _Fn>
+__tree_entry
+make_leaf(nv_tree_path const &path, int type, _Fn &&fn)
+{
+	if (path.keys().empty())
+		throw std::invalid_argument("empty nv_tree path");
+
+	auto key = path.keys().back();
+	auto leaf = nv_list();
+	std::forward<_Fn>(fn)(leaf, key);
+
+	return {std::string(key), type,
+		std::make_shared<nv_list const>(std::move(leaf))};
+}
+
+__tree_entry
+make_entry(nv_tree_path const &path, int type, auto &&value)
+{
+	if (path.keys().empty())
+		throw std::invalid_argument("empty nv_tree path");
+
+	return {std::string(path.keys().back()), type,
+		std::forward<decltype(value)>(value)};
+}
+
+const_nv_list
+leaf_of(__tree_entry const &entry)
+{
+	return (*std::get<leaf_ptr>(entry.__value));
+}
+
+} // anonymous namespace
+
+namespace __detail {
+
+/*
+ * Return the index of the first entry with the given key and type, or -1.  A
+ * type of NV_TYPE_NONE matches any type.
+ */
+std::ptrdiff_t
+__tree_node::__index(std::string_view key, int type) const
+{
+	for (auto i = std::size_t{}; i < __m_entries.size(); ++i) {
+		auto const &entry = __m_entries[i];
+
+		if (type != NV_TYPE_NONE && entry.__type != type)
+			continue;
+
+		if (key_equal(entry.__key, key, __m_flags))
+			return (static_cast<std::ptrdiff_t>(i));
+	}
+
+	return (-1);
+}
+
+auto
+__tree_node::__import(::nvlist_t const *nvl)
+	-> std::shared_ptr<__tree_node const>
+{
+	auto entries = std::vector<__tree_entry>();
+	auto type = int{};
+	auto *cookie = static_cast<void *>(nullptr);
+
+	while (auto const *name = ::nvlist_next(nvl, &type, &cookie)) {
+		auto &entry = entries.emplace_back(std::string(name), type);
+
+		switch (type) {
+		case NV_TYPE_NULL:
+			break;
+
+		case NV_TYPE_BOOL:
+			entry.__value = ::cnvlist_get_bool(cookie);
+			break;
+
+		case NV_TYPE_NUMBER:
+			entry.__value = ::cnvlist_get_number(cookie);
+			break;
+
+		case NV_TYPE_NVLIST:
+			entry.__value = __import(::cnvlist_get_nvlist(cookie));
+			break;
+
+		case NV_TYPE_NVLIST_ARRAY: {
+			auto nitems = std::size_t{};
+			auto const *data =
+				::cnvlist_get_nvlist_array(cookie, &nitems);
+
+			auto array = std::vector<nv_tree>();
+			array.reserve(nitems);
+			for (auto const *elm : std::span(data, nitems))
+				array.push_back(nv_tree(__import(elm)));
+
+			entry.__value = std::make_shared<
+				std::vector<nv_tree> const>(std::move(array));
+			break;
+		}
+
+		default: {
+			auto leaf = nv_list();
+			__copy_pair(leaf.ptr(), name, type, cookie);
+			throw_if_error(leaf.ptr());
+			entry.__value = std::make_shared<nv_list const>(
+						std::move(leaf));
+			break;
+		}
+		}
+	}
+
+	return (std::make_shared<__tree_node const>(::nvlist_flags(nvl),
+						    std::move(entries)));
+}
+
+/*
+ * Add the contents of this node to the given nvlist.  Errors are left in the
+ * nvlist's error state.
+ */
+void
+__tree_node::__materialize(::nvlist_t *nvl) const
+{
+	auto child = [] (node_ptr const &node) -> ::nvlist_t * {
+		auto *cnvl = ::nvlist_create(node->__m_flags);
+		if (cnvl != nullptr)
+			node->__materialize(cnvl);
+		return (cnvl);
+	};
+
+	for (auto const &entry : __m_entries) {
+		auto const *key = entry.__key.c_str();
+
+		switch (entry.__type) {
+		case NV_TYPE_NULL:
+			::nvlist_add_null(nvl, key);
+			break;
+
+		case NV_TYPE_BOOL:
+			::nvlist_add_bool(nvl, key, std::get<bool>(entry.__value));
+			break;
+
+		case NV_TYPE_NUMBER:
+			::nvlist_add_number(nvl, key,
+				std::get<std::uint64_t>(entry.__value));
+			break;
+
+		case NV_TYPE_NVLIST: {
+			auto *cnvl = child(std::get<node_ptr>(entry.__value));
+			if (cnvl == nullptr) {
+				::nvlist_set_error(nvl, ENOMEM);
+				return;
+			}
+			::nvlist_move_nvlist(nvl, key, cnvl);
+			break;
+		}
+
+		case NV_TYPE_NVLIST_ARRAY: {
+			auto const &array = *std::get<array_ptr>(entry.__value);
+			auto *arr = static_cast<::nvlist_t **>(
+				std::calloc(array.size(), sizeof(::nvlist_t *)));
+			if (arr == nullptr) {
+				::nvlist_set_error(nvl, ENOMEM);
+				return;
+			}
+
+			for (auto i = std::size_t{}; i < array.size(); ++i)
+				arr[i] = child(array[i].__m_root);
+
+			// nvlist_move_nvlist_array frees arr on failure
+			::nvlist_move_nvlist_array(nvl, key, arr, array.size());
+			break;
+		}
+
+		default: {
+			auto const &leaf = *std::get<leaf_ptr>(entry.__value);
+			auto type = int{};
+			auto *cookie = static_cast<void *>(nullptr);
+			(void)::nvlist_next(leaf.ptr(), &type, &cookie);
+			__copy_pair(nvl, key, type, cookie);
+			break;
+		}
+		}
+	}
+}
+
+/*
+ * Return a copy of node in which the entry at path has been replaced with
+ * *entry, or removed if entry is null.  Only the nodes along the path are
+ * copied.
+ */
+auto
+__tree_node::__update(__tree_node const &node,
+		      std::span<std::string_view const> path,
+		      __tree_entry *entry)
+	-> std::shared_ptr<__tree_node const>
+{
+	if (path.empty())
+		throw std::invalid_argument("empty nv_tree path");
+
+	auto key = path.front();
+	auto last = (path.size() == 1);
+	auto idx = node.__index(key, last ? NV_TYPE_NONE : NV_TYPE_NVLIST);
+	auto entries = node.__m_entries;
+
+	if (!last) {
+		if (idx < 0)
+			throw nv_key_not_found(std::string(key));
+
+		auto &value = entries[idx].__value;
+		value = __update(*std::get<node_ptr>(value),
+				 path.subspan(1), entry);
+	} else if (entry == nullptr) {
+		if (idx < 0)
+			throw nv_key_not_found(std::string(key));
+
+		entries.erase(entries.begin() + idx);
+	} else if (idx < 0) {
+		entries.push_back(std::move(*entry));
+	} else {
+		entries[idx] = std::move(*entry);
+	}
+
+	return (std::make_shared<__tree_node const>(node.__m_flags,
+						    std::move(entries)));
+}
+
+} // namespace bsd::__detail
+
+/*
+ * nv_tree
+ */
+
+nv_tree::nv_tree(int flags)
+	: __m_root(std::make_shared<__tree_node const>(
+			flags, std::vector<__tree_entry>()))
+{
+}
+
+nv_tree::nv_tree(const_nv_list const &nvl)
+{
+	if (auto err = nvl.error(); err)
+		throw nv_error_state(err);
+
+	__m_root = __tree_node::__import(nvl.ptr());
+}
+
+nv_tree::nv_tree(std::shared_ptr<__detail::__tree_node const> root) noexcept
+	: __m_root(std::move(root))
+{
+}
+
+std::size_t
+nv_tree::size() const noexcept
+{
+	return (__m_root->__m_entries.size());
+}
+
+bool
+nv_tree::empty() const noexcept
+{
+	return (size() == 0);
+}
+
+int
+nv_tree::flags() const noexcept
+{
+	return (__m_root->__m_flags);
+}
+
+bool
+nv_tree::same(nv_tree const &other) const noexcept
+{
+	return (__m_root == other.__m_root);
+}
+
+nv_list
+nv_tree::materialize() const
+{
+	auto nvl = nv_list(__m_root->__m_flags);
+	__m_root->__materialize(nvl.ptr());
+	throw_if_error(nvl.ptr());
+	return (nvl);
+}
+
+std::vector<std::byte>
+nv_tree::pack() const
+{
+	return (materialize().pack());
+}
+
+__detail::__tree_entry const &
+nv_tree::__get(std::string_view key, int type) const
+{
+	auto idx = __m_root->__index(key, type);
+	if (idx < 0)
+		throw nv_key_not_found(std::string(key));
+
+	return (__m_root->__m_entries[idx]);
+}
+
+nv_tree
+nv_tree::__set(nv_tree_path const &path, __detail::__tree_entry &&entry) const
+{
+	return (nv_tree(__tree_node::__update(*__m_root, path.keys(), &entry)));
+}
+
+nv_tree
+nv_tree::erase(nv_tree_path const &path) const
+{
+	return (nv_tree(__tree_node::__update(*__m_root, path.keys(), nullptr)));
+}
+
+/* exists */
+
+bool
+nv_tree::exists(std::string_view key) const
+{
+	return (exists_type(key, NV_TYPE_NONE));
+}
+
+bool
+nv_tree::exists_type(std::string_view key, int type) const
+{
+	return (__m_root->__index(key, type) >= 0);
+}
+
+/* get */
+
+bool
+nv_tree::get_bool(std::string_view key) const
+{
+	return (std::get<bool>(__get(key, NV_TYPE_BOOL).__value));
+}
+
+std::uint64_t
+nv_tree::get_number(std::string_view key) const
+{
+	return (std::get<std::uint64_t>(__get(key, NV_TYPE_NUMBER).__value));
+}
+
+std::string_view
+nv_tree::get_string(std::string_view key) const
+{
+	auto const &entry = __get(key, NV_TYPE_STRING);
+	return (leaf_of(entry).get_string(entry.__key));
+}
+
+nv_tree
+nv_tree::get_nvlist(std::string_view key) const
+{
+	return (nv_tree(std::get<node_ptr>(__get(key, NV_TYPE_NVLIST).__value)));
+}
+
+int
+nv_tree::get_descriptor(std::string_view key) const
+{
+	auto const &entry = __get(key, NV_TYPE_DESCRIPTOR);
+	return (leaf_of(entry).get_descriptor(entry.__key));
+}
+
+std::span<std::byte const>
+nv_tree::get_binary(std::string_view key) const
+{
+	auto const &entry = __get(key, NV_TYPE_BINARY);
+	return (leaf_of(entry).get_binary(entry.__key));
+}
+
+std::span<bool const>
+nv_tree::get_bool_array(std::string_view key) const
+{
+	auto const &entry = __get(key, NV_TYPE_BOOL_ARRAY);
+	return (leaf_of(entry).get_bool_array(entry.__key));
+}
+
+std::span<std::uint64_t const>
+nv_tree::get_number_array(std::string_view key) const
+{
+	auto const &entry = __get(key, NV_TYPE_NUMBER_ARRAY);
+	return (leaf_of(entry).get_number_array(entry.__key));
+}
+
+std::vector<std::string_view>
+nv_tree::get_string_array(std::string_view key) const
+{
+	auto const &entry = __get(key, NV_TYPE_STRING_ARRAY);
+	return (leaf_of(entry).get_string_array(entry.__key));
+}
+
+std::span<nv_tree const>
+nv_tree::get_nvlist_array(std::string_view key) const
+{
+	auto const &entry = __get(key, NV_TYPE_NVLIST_ARRAY);
+	return (*std::get<array_ptr>(entry.__value));
+}
+
+std::span<int const>
+nv_tree::get_descriptor_array(std::string_view key) const
+{
+	auto const &entry = __get(key, NV_TYPE_DESCRIPTOR_ARRAY);
+	return (leaf_of(entry).get_descriptor_array(entry.__key));
+}
+
+/* set */
+
+nv_tree
+nv_tree::set_null(nv_tree_path const &path) const
+{
+	return (__set(path, make_entry(path, NV_TYPE_NULL, std::monostate{})));
+}
+
+nv_tree
+nv_tree::set_bool(nv_tree_path const &path, bool value) const
+{
+	return (__set(path, make_entry(path, NV_TYPE_BOOL, value)));
+}
+
+nv_tree
+nv_tree::set_number(nv_tree_path const &path, std::uint64_t value) const
+{
+	return (__set(path, make_entry(path, NV_TYPE_NUMBER, value)));
+}
+
+nv_tree
+nv_tree::set_string(nv_tree_path const &path, std::string_view value) const
+{
+	return (__set(path, make_leaf(path, NV_TYPE_STRING,
+		[&] (nv_list &leaf, std::string_view key) {
+			leaf.add_string(key, value);
+		})));
+}
+
+nv_tree
+nv_tree::set_nvlist(nv_tree_path const &path, nv_tree const &value) const
+{
+	return (__set(path, make_entry(path, NV_TYPE_NVLIST, value.__m_root)));
+}
+
+nv_tree
+nv_tree::set_descriptor(nv_tree_path const &path, int value) const
+{
+	return (__set(path, make_leaf(path, NV_TYPE_DESCRIPTOR,
+		[&] (nv_list &leaf, std::string_view key) {
+			leaf.add_descriptor(key, value);
+		})));
+}
+
+nv_tree
+nv_tree::set_binary(nv_tree_path const &path,
+		    std::span<std::byte const> value) const
+{
+	return (__set(path, make_leaf(path, NV_TYPE_BINARY,
+		[&] (nv_list &leaf, std::string_view key) {
+			leaf.add_binary(key, value);
+		})));
+}
+
+nv_tree
+nv_tree::set_bool_array(nv_tree_path const &path,
+			std::span<bool const> value) const
+{
+	return (__set(path, make_leaf(path, NV_TYPE_BOOL_ARRAY,
+		[&] (nv_list &leaf, std::string_view key) {
+			leaf.add_bool_array(key, value);
+		})));
+}
+
+nv_tree
+nv_tree::set_number_array(nv_tree_path const &path,
+			  std::span<std::uint64_t const> value) const
+{
+	return (__set(path, make_leaf(path, NV_TYPE_NUMBER_ARRAY,
+		[&] (nv_list &leaf, std::string_view key) {
+			leaf.add_number_array(key, value);
+		})));
+}
+
+nv_tree
+nv_tree::set_string_array(nv_tree_path const &path,
+			  std::span<std::string_view const> value) const
+{
+	return (__set(path, make_leaf(path, NV_TYPE_STRING_ARRAY,
+		[&] (nv_list &leaf, std::string_view key) {
+			leaf.add_string_array(key, value);
+		})));
+}
+
+nv_tree
+nv_tree::set_nvlist_array(nv_tree_path const &path,
+			  std::span<nv_tree const> value) const
+{
+	auto array = std::make_shared<std::vector<nv_tree> const>(
+				std::from_range, value);
+	return (__set(path, make_entry(path, NV_TYPE_NVLIST_ARRAY,
+				       std::move(array))));
+}
+
+nv_tree
+nv_tree::set_descriptor_array(nv_tree_path const &path,
+			      std::span<int const> value) const
+{
+	return (__set(path, make_leaf(path, NV_TYPE_DESCRIPTOR_ARRAY,
+		[&] (nv_list &leaf, std::string_view key) {
+			leaf.add_descriptor_array(key, value);
+		})));
+}
+
+} // namespace bsd
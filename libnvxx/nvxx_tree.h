@@ -0,0 +1,197 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR MIT
+ * Refer to the file 'LICENSE' in the nvxx distribution for license terms.
+ */
+
+#ifndef	_NVXX_TREE_H_INCLUDED
+#define _NVXX_TREE_H_INCLUDED
+
+#ifndef _NVXX_H_INCLUDED
+# error include <nvxx.h> instead of including this header directly
+#endif
+
+#include <initializer_list>
+#include <memory>
+#include <string>
+
+/*
+ * nv_tree: a persistent (immutable) nvlist.
+ *
+ * An nv_tree is never modified in place; instead, the set_*() and erase()
+ * functions return a new nv_tree which differs from the original at the given
+ * path.  Only the nested nvlists along that path are copied.  All other
+ * nested nvlists, and all strings, binaries and arrays, are shared between
+ * the old and new trees by reference count, so changing a single value deep
+ * inside a large tree is cheap.
+ */
+
+namespace bsd {
+
+namespace __detail {
+
+struct __tree_node;
+struct __tree_entry;
+
+} // namespace bsd::__detail
+
+/*
+ * The path to a value inside an nv_tree, as a sequence of keys.  Every key
+ * except the last must name a nested nvlist.  A path with a single key
+ * refers to a value in the top-level nvlist.
+ *
+ * nv_tree_path does not copy the keys, and is intended only to be used as a
+ * function argument.
+ */
+struct nv_tree_path {
+	nv_tree_path(char const *__key) noexcept
+		: __m_key(__key)
+		, __m_keys(&__m_key, 1)
+	{
+	}
+
+	nv_tree_path(std::string_view __key) noexcept
+		: __m_key(__key)
+		, __m_keys(&__m_key, 1)
+	{
+	}
+
+	nv_tree_path(std::string const &__key) noexcept
+		: __m_key(__key)
+		, __m_keys(&__m_key, 1)
+	{
+	}
+
+	nv_tree_path(std::initializer_list<std::string_view> __keys) noexcept
+		: __m_keys(__keys.begin(), __keys.size())
+	{
+	}
+
+	nv_tree_path(std::span<std::string_view const> __keys) noexcept
+		: __m_keys(__keys)
+	{
+	}
+
+	nv_tree_path(nv_tree_path const &) = delete;
+	nv_tree_path &operator=(nv_tree_path const &) = delete;
+
+	[[nodiscard]] std::span<std::string_view const> keys() const noexcept {
+		return (__m_keys);
+	}
+
+private:
+	std::string_view __m_key;
+	std::span<std::string_view const> __m_keys;
+};
+
+struct nv_tree {
+	/*
+	 * Create a new, empty tree.  The flags have the same meaning as for
+	 * nvlist_create().
+	 */
+	explicit nv_tree(int __flags = 0);
+
+	/*
+	 * Create a tree containing a copy of the given nvlist.  This copies
+	 * the entire nvlist once; subsequent changes to the tree do not.  If
+	 * the nvlist is in the error state, throws nv_error_state.
+	 */
+	explicit nv_tree(const_nv_list const &);
+
+	/*
+	 * Copying an nv_tree only copies a reference to the root; both trees
+	 * share all of their contents.  There is no separate move, so a tree
+	 * which is moved from is copied and still refers to its root.
+	 */
+	nv_tree(nv_tree const &) noexcept = default;
+	nv_tree &operator=(nv_tree const &) noexcept = default;
+
+	[[nodiscard]] std::size_t size() const noexcept;
+	[[nodiscard]] bool empty() const noexcept;
+	[[nodiscard]] int flags() const noexcept;
+
+	/*
+	 * Returns true if the two trees share the same root, i.e. if one was
+	 * copied from the other and neither has been replaced since.
+	 */
+	[[nodiscard]] bool same(nv_tree const &) const noexcept;
+
+	/*
+	 * Return a new nv_list with the same contents as this tree.  This
+	 * copies the whole tree, since an nvlist cannot share nested nvlists
+	 * with another; to read the tree, use the accessors below instead.
+	 */
+	[[nodiscard]] nv_list materialize() const;
+
+	/*
+	 * Equivalent to materialize().pack().  The copy is freed before this
+	 * returns.
+	 */
+	[[nodiscard]] std::vector<std::byte> pack() const;
+
+	/* exists */
+
+	[[nodiscard]] bool exists(std::string_view) const;
+	[[nodiscard]] bool exists_type(std::string_view, int) const;
+
+	/*
+	 * get: these behave exactly as the const_nv_list functions of the same
+	 * name, except that nested nvlists are returned as nv_trees.  Spans
+	 * returned by these functions remain valid as long as any nv_tree
+	 * which contains the value exists.
+	 */
+
+	[[nodiscard]] auto get_bool(std::string_view) const -> bool;
+	[[nodiscard]] auto get_number(std::string_view) const -> std::uint64_t;
+	[[nodiscard]] auto get_string(std::string_view) const -> std::string_view;
+	[[nodiscard]] auto get_nvlist(std::string_view) const -> nv_tree;
+	[[nodiscard]] auto get_descriptor(std::string_view) const -> int;
+	[[nodiscard]] auto get_binary(std::string_view) const -> std::span<std::byte const>;
+
+	[[nodiscard]] auto get_bool_array(std::string_view) const -> std::span<bool const>;
+	[[nodiscard]] auto get_number_array(std::string_view) const -> std::span<std::uint64_t const>;
+	[[nodiscard]] auto get_string_array(std::string_view) const -> std::vector<std::string_view>;
+	[[nodiscard]] auto get_nvlist_array(std::string_view) const -> std::span<nv_tree const>;
+	[[nodiscard]] auto get_descriptor_array(std::string_view) const -> std::span<int const>;
+
+	/*
+	 * set: return a new tree in which the value at the given path has
+	 * been replaced with the given value, or added if it did not exist.
+	 * If an intermediate key in the path does not exist or is not an
+	 * nvlist, throws nv_key_not_found.  Descriptors are duplicated, as
+	 * with nv_list::add_descriptor().
+	 */
+
+	[[nodiscard]] nv_tree set_null(nv_tree_path const &) const;
+	[[nodiscard]] nv_tree set_bool(nv_tree_path const &, bool) const;
+	[[nodiscard]] nv_tree set_number(nv_tree_path const &, std::uint64_t) const;
+	[[nodiscard]] nv_tree set_string(nv_tree_path const &, std::string_view) const;
+	[[nodiscard]] nv_tree set_nvlist(nv_tree_path const &, nv_tree const &) const;
+	[[nodiscard]] nv_tree set_descriptor(nv_tree_path const &, int) const;
+	[[nodiscard]] nv_tree set_binary(nv_tree_path const &, std::span<std::byte const>) const;
+
+	[[nodiscard]] nv_tree set_bool_array(nv_tree_path const &, std::span<bool const>) const;
+	[[nodiscard]] nv_tree set_number_array(nv_tree_path const &, std::span<std::uint64_t const>) const;
+	[[nodiscard]] nv_tree set_string_array(nv_tree_path const &, std::span<std::string_view const>) const;
+	[[nodiscard]] nv_tree set_nvlist_array(nv_tree_path const &, std::span<nv_tree const>) const;
+	[[nodiscard]] nv_tree set_descriptor_array(nv_tree_path const &, std::span<int const>) const;
+
+	/*
+	 * Return a new tree with the value at the given path removed.  If the
+	 * path does not exist, throws nv_key_not_found.
+	 */
+	[[nodiscard]] nv_tree erase(nv_tree_path const &) const;
+
+private:
+	friend struct __detail::__tree_node;
+
+	explicit nv_tree(std::shared_ptr<__detail::__tree_node const>) noexcept;
+
+	std::shared_ptr<__detail::__tree_node const> __m_root;
+
+	__detail::__tree_entry const &__get(std::string_view, int) const;
+	nv_tree __set(nv_tree_path const &, __detail::__tree_entry &&) const;
+};
+
+} // namespace bsd
+
+#endif	/* !_NVXX_TREE_H_INCLUDED */
@@ -80,6 +80,125 @@ struct __ptr_guard {
 	_T *__ptr;
 };
 
+/*
+ * A NUL-terminated copy of an nvlist key, for passing to the C API.  Keys
+ * shorter than the inline buffer, which is nearly all of them, are copied
+ * without allocating.
+ */
+struct __nv_key {
+	explicit __nv_key(std::string_view __key) {
+		if (__key.size() < sizeof(__m_buf)) {
+			std::ranges::copy(__key, __m_buf);
+			__m_buf[__key.size()] = '\0';
+			__m_str = __m_buf;
+		} else {
+			__m_long.assign(__key);
+			__m_str = __m_long.c_str();
+		}
+	}
+
+	__nv_key(__nv_key const &) = delete;
+	__nv_key &operator=(__nv_key const &) = delete;
+
+	char const *c_str() const noexcept {
+		return (__m_str);
+	}
+
+private:
+	char __m_buf[128];
+	std::string __m_long;
+	char const *__m_str;
+};
+
+/*
+ * Add a string which need not be NUL-terminated to an nvlist, copying it only
+ * once where possible.  As with the nvlist_add_*() functions, errors are
+ * recorded in the nvlist's error state.
+ */
+void __nvlist_add_string(::nvlist_t *, char const *__key,
+			 std::string_view __value) noexcept;
+
+/*
+ * A contiguous range whose elements are exactly _T, which can be passed to
+ * the C API without copying.
+ */
+template<typename _R, typename _T>
+concept __contiguous_range_of =
+	std::ranges::contiguous_range<_R>
+	&& std::ranges::sized_range<_R>
+	&& std::same_as<std::remove_cv_t<std::ranges::range_value_t<_R>>, _T>;
+
+/*
+ * Copy a sized range into a new array allocated with malloc(), suitable for
+ * passing to an nvlist_move_*() function.  The range must not be empty.  On
+ * failure, throws std::system_error.
+ */
+template<typename _T>
+std::span<_T>
+__malloc_copy(std::ranges::sized_range auto &&__range)
+{
+	auto const __n = static_cast<std::size_t>(std::ranges::size(__range));
+
+	if (__n > SIZE_MAX / sizeof(_T))
+		throw std::system_error(
+			std::make_error_code(std::errc::not_enough_memory));
+
+	auto *__p = static_cast<_T *>(std::malloc(__n * sizeof(_T)));
+	if (__p == nullptr)
+		throw std::system_error(
+			std::make_error_code(std::errc::not_enough_memory));
+
+	try {
+		std::ranges::copy(__range, __p);
+	} catch (...) {
+		std::free(__p);
+		throw;
+	}
+
+	return (std::span<_T>(__p, __n));
+}
+
+/*
+ * As __malloc_copy(), but for a range which is not sized: the array grows
+ * geometrically as the range is read.  If the range is empty, nothing is
+ * allocated and an empty span is returned.
+ */
+template<typename _T>
+std::span<_T>
+__malloc_collect(std::ranges::input_range auto &&__range)
+{
+	auto *__p = static_cast<_T *>(nullptr);
+	auto __n = std::size_t{0};
+	auto __cap = std::size_t{0};
+
+	try {
+		for (auto &&__value : __range) {
+			if (__n == __cap) {
+				__cap = (__cap == 0) ? 16 : __cap * 2;
+				if (__cap > SIZE_MAX / sizeof(_T))
+					throw std::system_error(
+						std::make_error_code(
+						std::errc::not_enough_memory));
+
+				auto *__np = std::realloc(__p,
+							  __cap * sizeof(_T));
+				if (__np == nullptr)
+					throw std::system_error(
+						std::make_error_code(
+						std::errc::not_enough_memory));
+				__p = static_cast<_T *>(__np);
+			}
+
+			__p[__n++] = std::forward<decltype(__value)>(__value);
+		}
+	} catch (...) {
+		std::free(__p);
+		throw;
+	}
+
+	return (std::span<_T>(__p, __n));
+}
+
 template<typename T>
 auto construct = std::views::transform([] (auto &&value) {
 	return (T(std::forward<decltype(value)>(value)));
@@ -0,0 +1,170 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR MIT
+ * Refer to the file 'LICENSE' in the nvxx distribution for license terms.
+ */
+
+#include <atf-c++.hpp>
+
+#include "nvxx.h"
+
+#define TEST_CASE(name)				\
+	ATF_TEST_CASE_WITHOUT_HEAD(name)	\
+	ATF_TEST_CASE_BODY(name)
+
+using namespace std::literals;
+using namespace bsd::nv_literals;
+
+namespace {
+
+/*
+ * { a: { b: { c: [ {}, {}, {}, { d: 42 } ], s: [ "x", "y" ] } } }
+ */
+bsd::nv_list
+make_nested()
+{
+	auto leaf = bsd::nv_list();
+	leaf.add_number("d", 42);
+
+	auto elems = std::vector<bsd::nv_list>(3);
+	elems.push_back(leaf);
+
+	auto b = bsd::nv_list();
+	b.add_nvlist_array("c", elems);
+	b.add_string_array("s", std::vector{"x"sv, "y"sv});
+
+	auto a = bsd::nv_list();
+	a.add_nvlist("b", b);
+
+	auto nvl = bsd::nv_list();
+	nvl.add_nvlist("a", a);
+	return (nvl);
+}
+
+} // anonymous namespace
+
+TEST_CASE(nv_path_fixed)
+{
+	auto nvl = make_nested();
+
+	auto d = nvl.at<std::uint64_t>("a.b.c[3].d"_nvpath);
+	ATF_REQUIRE_EQ(true, d.has_value());
+	ATF_REQUIRE_EQ(42, *d);
+
+	auto s = nvl.at<std::string_view>("a.b.s[1]"_nvpath);
+	ATF_REQUIRE_EQ(true, s.has_value());
+	ATF_REQUIRE_EQ("y"sv, *s);
+
+	auto b = nvl.at<bsd::const_nv_list>(bsd::nv_fixed_path("a.b"));
+	ATF_REQUIRE_EQ(true, b.has_value());
+	ATF_REQUIRE_EQ(true, b->exists_nvlist_array("c"));
+}
+
+TEST_CASE(nv_path_runtime)
+{
+	auto nvl = make_nested();
+	auto path = bsd::nv_path("a.b.c[3].d"sv);
+	ATF_REQUIRE_EQ(4, path.size());
+
+	auto d = nvl.at<std::uint64_t>(path);
+	ATF_REQUIRE_EQ(42, d.value());
+
+	// a path may be evaluated any number of times
+	auto other = make_nested();
+	ATF_REQUIRE_EQ(42, other.at<std::uint64_t>(path).value());
+}
+
+TEST_CASE(nv_path_any)
+{
+	auto nvl = make_nested();
+
+	auto d = nvl.at<bsd::nv_list_value_t>("a.b.c[3].d"_nvpath);
+	ATF_REQUIRE_EQ(42, std::get<std::uint64_t>(d.value()));
+
+	auto s = nvl.at<bsd::nv_list_value_t>("a.b.s"_nvpath);
+	auto strings = std::get<std::vector<std::string_view>>(s.value());
+	ATF_REQUIRE_EQ(2, strings.size());
+}
+
+TEST_CASE(nv_path_errors)
+{
+	auto nvl = make_nested();
+
+	ATF_REQUIRE(nvl.at<std::uint64_t>("a.x.c"_nvpath).error()
+		    == (bsd::nv_path_error{bsd::nv_path_errc::not_found, 1}));
+
+	// "b" is an nvlist, not an nvlist array
+	ATF_REQUIRE(nvl.at<std::uint64_t>("a.b[0].c"_nvpath).error()
+		    == (bsd::nv_path_error{bsd::nv_path_errc::type_mismatch, 1}));
+
+	// "d" is a number, not a string
+	ATF_REQUIRE(nvl.at<std::string_view>("a.b.c[3].d"_nvpath).error()
+		    == (bsd::nv_path_error{bsd::nv_path_errc::type_mismatch, 3}));
+
+	ATF_REQUIRE(nvl.at<std::uint64_t>("a.b.c[4].d"_nvpath).error()
+		    == (bsd::nv_path_error{bsd::nv_path_errc::out_of_range, 2}));
+
+	ATF_REQUIRE(nvl.at<std::string_view>("a.b.s[2]"_nvpath).error()
+		    == (bsd::nv_path_error{bsd::nv_path_errc::out_of_range, 2}));
+}
+
+TEST_CASE(nv_path_invalid)
+{
+	ATF_REQUIRE_THROW(bsd::nv_path_invalid, (void)bsd::nv_path(""sv));
+	ATF_REQUIRE_THROW(bsd::nv_path_invalid, (void)bsd::nv_path("a..b"sv));
+	ATF_REQUIRE_THROW(bsd::nv_path_invalid, (void)bsd::nv_path("a[]"sv));
+	ATF_REQUIRE_THROW(bsd::nv_path_invalid, (void)bsd::nv_path("a[1"sv));
+	ATF_REQUIRE_THROW(bsd::nv_path_invalid, (void)bsd::nv_path("a[1]b"sv));
+	ATF_REQUIRE_THROW(bsd::nv_path_invalid, (void)bsd::nv_path("a[x]"sv));
+}
+
+TEST_CASE(nv_path_error_state)
+{
+	auto nvl = make_nested();
+	nvl.set_error(std::errc::invalid_argument);
+
+	ATF_REQUIRE_THROW(bsd::nv_error_state,
+			  (void)nvl.at<std::uint64_t>("a"_nvpath));
+}
+
+TEST_CASE(nv_get_many)
+{
+	auto nvl = bsd::nv_list();
+	nvl.add_string("host", "alpha");
+	nvl.add_number("port", 80);
+	nvl.add_bool("debug", true);
+	nvl.add_string("unused", "value");
+
+	auto [host, port, debug, missing, wrong] = nvl.get_many(
+		bsd::nv_key<std::string_view>("host"),
+		bsd::nv_key<std::uint64_t>("port"),
+		bsd::nv_key<bsd::nv_list_value_t>("debug"),
+		bsd::nv_key<std::uint64_t>("missing"),
+		bsd::nv_key<std::uint64_t>("host"));
+
+	ATF_REQUIRE_EQ("alpha"sv, host.value());
+	ATF_REQUIRE_EQ(80, port.value());
+	ATF_REQUIRE_EQ(true, std::get<bool>(debug.value()));
+	ATF_REQUIRE_EQ(false, missing.has_value());
+	ATF_REQUIRE_EQ(false, wrong.has_value());
+}
+
+TEST_CASE(nv_get_many_error_state)
+{
+	auto nvl = bsd::nv_list();
+	nvl.set_error(std::errc::invalid_argument);
+
+	ATF_REQUIRE_THROW(bsd::nv_error_state,
+			  (void)nvl.get_many(bsd::nv_key<bool>("x")));
+}
+
+ATF_INIT_TEST_CASES(tcs)
+{
+	ATF_ADD_TEST_CASE(tcs, nv_path_fixed);
+	ATF_ADD_TEST_CASE(tcs, nv_path_runtime);
+	ATF_ADD_TEST_CASE(tcs, nv_path_any);
+	ATF_ADD_TEST_CASE(tcs, nv_path_errors);
+	ATF_ADD_TEST_CASE(tcs, nv_path_invalid);
+	ATF_ADD_TEST_CASE(tcs, nv_path_error_state);
+	ATF_ADD_TEST_CASE(tcs, nv_get_many);
+	ATF_ADD_TEST_CASE(tcs, nv_get_many_error_state);
+}
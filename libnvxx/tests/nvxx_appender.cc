@@ -0,0 +1,119 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR MIT
+ * Refer to the file 'LICENSE' in the nvxx distribution for license terms.
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <atf-c++.hpp>
+
+#include "nvxx.h"
+
+#define TEST_CASE(name)				\
+	ATF_TEST_CASE_WITHOUT_HEAD(name)	\
+	ATF_TEST_CASE_BODY(name)
+
+using namespace std::literals;
+
+TEST_CASE(nv_appender_number)
+{
+	auto nvl = bsd::nv_list();
+
+	{
+		auto numbers = bsd::nv_array_appender<std::uint64_t>(nvl, "n");
+		for (auto i = 0u; i < 1000; ++i)
+			numbers.push_back(i);
+		ATF_REQUIRE_EQ(1000, numbers.size());
+
+		// nothing is added until the appender is flushed
+		ATF_REQUIRE_EQ(false, nvl.exists("n"));
+	}
+
+	auto numbers = nvl.get_number_array("n");
+	ATF_REQUIRE_EQ(1000, numbers.size());
+	ATF_REQUIRE_EQ(0, numbers[0]);
+	ATF_REQUIRE_EQ(999, numbers[999]);
+}
+
+TEST_CASE(nv_appender_existing)
+{
+	auto nvl = bsd::nv_list();
+	nvl.add_string_array("s", std::vector{"a"sv, "b"sv});
+
+	auto strings = bsd::nv_array_appender<std::string>(nvl, "s");
+	strings.push_back("c");
+	strings.push_back("d");
+	strings.flush();
+	ATF_REQUIRE_EQ(0, strings.size());
+
+	auto result = nvl.get_string_array("s");
+	ATF_REQUIRE_EQ(4, result.size());
+	ATF_REQUIRE_EQ("a"sv, result[0]);
+	ATF_REQUIRE_EQ("d"sv, result[3]);
+}
+
+TEST_CASE(nv_appender_nvlist)
+{
+	auto nvl = bsd::nv_list();
+	auto elem = bsd::nv_list();
+	elem.add_number("x", 1);
+
+	auto lists = bsd::nv_array_appender<bsd::nv_list>(nvl, "l");
+	lists.push_back(elem);
+	lists.push_back(std::move(elem));
+	lists.flush();
+
+	auto result = nvl.get_nvlist_array("l");
+	ATF_REQUIRE_EQ(2, result.size());
+	ATF_REQUIRE_EQ(1, result[1].get_number("x"));
+
+	// a second flush appends to the array
+	lists.push_back(bsd::nv_list());
+	lists.flush();
+	ATF_REQUIRE_EQ(3, nvl.get_nvlist_array("l").size());
+}
+
+TEST_CASE(nv_appender_type_mismatch)
+{
+	auto nvl = bsd::nv_list();
+	nvl.add_number("key", 1);
+
+	auto bools = bsd::nv_array_appender<bool>(nvl, "key");
+	bools.push_back(true);
+	ATF_REQUIRE_THROW(bsd::nv_key_exists, bools.flush());
+	ATF_REQUIRE_EQ(0, bools.size());
+}
+
+TEST_CASE(nv_appender_moved_from)
+{
+	auto fd = ::open("/dev/null", O_RDONLY);
+	ATF_REQUIRE(fd != -1);
+
+	auto nvl = bsd::nv_list();
+
+	{
+		auto fds = bsd::nv_array_appender<bsd::nv_fd>(nvl, "fd");
+		fds.push_back(bsd::nv_fd(fd));
+		auto other = std::move(nvl);
+	}
+
+	// destroying the appender closed the buffered descriptor.
+	ATF_REQUIRE_EQ(-1, ::fcntl(fd, F_GETFD));
+
+	nvl = bsd::nv_list();
+	auto strings = bsd::nv_array_appender<std::string>(nvl, "s");
+	strings.push_back("a");
+	auto other = std::move(nvl);
+	ATF_REQUIRE_THROW(std::logic_error, strings.flush());
+	ATF_REQUIRE_EQ(0, strings.size());
+}
+
+ATF_INIT_TEST_CASES(tcs)
+{
+	ATF_ADD_TEST_CASE(tcs, nv_appender_number);
+	ATF_ADD_TEST_CASE(tcs, nv_appender_existing);
+	ATF_ADD_TEST_CASE(tcs, nv_appender_nvlist);
+	ATF_ADD_TEST_CASE(tcs, nv_appender_type_mismatch);
+	ATF_ADD_TEST_CASE(tcs, nv_appender_moved_from);
+}
@@ -4,6 +4,8 @@
  */
 
 #include <algorithm>
+#include <cstdlib>
+#include <cstring>
 #include <ranges>
 #include <list>
 #include <vector>
@@ -11,9 +13,11 @@
 #include <string>
 #include <string_view>
 #include <thread>
+#include <type_traits>
 
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <fcntl.h>
 #include <atf-c++.hpp>
 
 #include "nvxx.h"
@@ -96,6 +100,19 @@ TEST_CASE(nvxx_const_nv_list_ctor_default)
 	ATF_REQUIRE_THROW(std::logic_error, nvl.ptr());
 }
 
+TEST_CASE(nvxx_const_nv_list_layout)
+{
+	ATF_REQUIRE_EQ(true, std::is_trivially_copyable_v<bsd::const_nv_list>);
+	ATF_REQUIRE_EQ(sizeof(::nvlist_t *), sizeof(bsd::const_nv_list));
+	ATF_REQUIRE_EQ(sizeof(::nvlist_t *), sizeof(bsd::nv_list));
+
+	auto nvl = bsd::nv_list();
+	auto cnv = bsd::const_nv_list(nvl);
+	auto copy = bsd::const_nv_list();
+	std::memcpy(&copy, &cnv, sizeof(copy));
+	ATF_REQUIRE_EQ(nvl.ptr(), copy.ptr());
+}
+
 TEST_CASE(nvxx_const_nv_list_ctor_nv_list)
 {
 	using namespace std::literals;
@@ -1154,6 +1171,25 @@ TEST_CASE(nvxx_add_bool_range)
 	ATF_REQUIRE_EQ(false, data2[1]);
 }
 
+TEST_CASE(nvxx_add_bool_unsized_range)
+{
+	using namespace std::literals;
+	auto constexpr key = "test_bool"sv;
+
+	// more elements than the first allocation holds
+	auto data = std::views::iota(0u, 100u)
+		| std::views::filter([] (auto i) { return (i % 3 != 0); })
+		| std::views::transform([] (auto i) { return (i % 2 == 0); });
+	static_assert(!std::ranges::sized_range<decltype(data)>);
+
+	auto nvl = bsd::nv_list();
+	nvl.add_bool_range(key, data);
+
+	auto data2 = nvl.get_bool_array(key);
+	ATF_REQUIRE_EQ(66, data2.size());
+	ATF_REQUIRE_EQ(true, std::ranges::equal(data, data2));
+}
+
 TEST_CASE(nvxx_add_bool_contig_range)
 {
 	using namespace std::literals;
@@ -1398,6 +1434,28 @@ TEST_CASE(nvxx_add_duplicate_number_array)
 			     nvl.add_number_range(key, value));
 }
 
+TEST_CASE(nvxx_move_duplicate_number_array)
+{
+	using namespace std::literals;
+	auto constexpr key = "test_number"sv;
+	auto value = std::vector{42_u64, 1024_u64};
+
+	auto nvl = bsd::nv_list();
+	nvl.add_number_range(key, value);
+
+	// the array is freed by libnv when the move fails
+	auto *array = static_cast<std::uint64_t *>(
+		std::malloc(2 * sizeof(std::uint64_t)));
+	ATF_REQUIRE_EQ(true, array != nullptr);
+	array[0] = 42;
+	array[1] = 1024;
+
+	ATF_REQUIRE_THROW_RE(bsd::nv_key_exists,
+			     "key \"test_number\" already exists",
+			     nvl.move_number_array(key, {array, 2}));
+	ATF_REQUIRE_EQ(true, (nvl.error() == std::errc::file_exists));
+}
+
 TEST_CASE(nvxx_free_number_array)
 {
 	using namespace std::literals;
@@ -1485,6 +1543,19 @@ TEST_CASE(nvxx_add_string)
 	ATF_REQUIRE_EQ(value, nvl.get_string(key));
 }
 
+TEST_CASE(nvxx_add_string_substring)
+{
+	using namespace std::literals;
+	auto constexpr key = "test_string"sv;
+	auto constexpr value = "100% %s value"sv;
+
+	// the value is not NUL-terminated and must not be used as a format
+	auto nvl = bsd::nv_list();
+	nvl.add_string(key, value.substr(0, 7));
+
+	ATF_REQUIRE_EQ("100% %s"sv, nvl.get_string(key));
+}
+
 TEST_CASE(nvxx_add_string_nul_key)
 {
 	using namespace std::literals;
@@ -2103,6 +2174,36 @@ TEST_CASE(nvxx_free_descriptor_array_nonexistent)
 	ATF_REQUIRE_THROW(bsd::nv_key_not_found, nvl.free_descriptor_array(key));
 }
 
+TEST_CASE(nvxx_move_descriptor_array)
+{
+	using namespace std::literals;
+	auto constexpr key = "test_descriptor"sv;
+
+	auto fds = std::array<int, 2>{};
+	auto ret = ::pipe(&fds[0]);
+	ATF_REQUIRE_EQ(0, ret);
+
+	auto *array = static_cast<int *>(std::malloc(2 * sizeof(int)));
+	ATF_REQUIRE_EQ(true, array != nullptr);
+	array[0] = fds[0];
+	array[1] = fds[1];
+
+	{
+		auto nvl = bsd::nv_list();
+		nvl.move_descriptor_array(key, {array, 2});
+
+		// the descriptors are not duplicated
+		auto value = nvl.get_descriptor_array(key);
+		ATF_REQUIRE_EQ(2, value.size());
+		ATF_REQUIRE_EQ(fds[0], value[0]);
+		ATF_REQUIRE_EQ(fds[1], value[1]);
+	}
+
+	// and destroying the list closed them
+	ATF_REQUIRE_EQ(-1, ::fcntl(fds[0], F_GETFD));
+	ATF_REQUIRE_EQ(-1, ::fcntl(fds[1], F_GETFD));
+}
+
 /*
  * binary
  */
@@ -2246,6 +2347,51 @@ TEST_CASE(nvxx_add_binary_range)
 	ATF_REQUIRE_EQ(true, std::ranges::equal(data, data2));
 }
 
+TEST_CASE(nvxx_add_sized_range)
+{
+	using namespace std::literals;
+
+	auto nvl = bsd::nv_list();
+
+	// sized but not contiguous, so these are copied once and moved
+	nvl.add_number_range("numbers", std::views::iota(0_u64, 16_u64));
+	nvl.add_bool_range("bools", std::vector<bool>{true, false, true});
+	nvl.add_binary_range("binary", std::views::iota(0u, 8u)
+			     | std::views::transform([] (auto i) {
+				     return (static_cast<std::byte>(i));
+			     }));
+
+	ATF_REQUIRE_EQ(true, std::ranges::equal(
+			std::views::iota(0_u64, 16_u64),
+			nvl.get_number_array("numbers")));
+
+	auto bools = nvl.get_bool_array("bools");
+	ATF_REQUIRE_EQ(3, bools.size());
+	ATF_REQUIRE_EQ(false, bools[1]);
+
+	auto binary = nvl.get_binary("binary");
+	ATF_REQUIRE_EQ(8, binary.size());
+	ATF_REQUIRE_EQ(std::byte{7}, binary[7]);
+}
+
+TEST_CASE(nvxx_add_sized_range_error)
+{
+	using namespace std::literals;
+
+	auto nvl = bsd::nv_list();
+	nvl.add_number("numbers", 1);
+
+	ATF_REQUIRE_THROW_RE(bsd::nv_key_exists,
+			     "key \"numbers\" already exists",
+			     nvl.add_number_range("numbers",
+				     std::views::iota(0_u64, 16_u64)));
+
+	auto nvl2 = bsd::nv_list();
+	ATF_REQUIRE_THROW(std::runtime_error,
+			  nvl2.add_number_range("num\0bers"sv,
+				  std::views::iota(0_u64, 16_u64)));
+}
+
 ATF_INIT_TEST_CASES(tcs)
 {
 	ATF_ADD_TEST_CASE(tcs, nvxx_nv_list_ctor_default);
@@ -2256,6 +2402,7 @@ ATF_INIT_TEST_CASES(tcs)
 
 	ATF_ADD_TEST_CASE(tcs, nvxx_const_nv_list_ctor_default);
 	ATF_ADD_TEST_CASE(tcs, nvxx_const_nv_list_ctor_copy);
+	ATF_ADD_TEST_CASE(tcs, nvxx_const_nv_list_layout);
 	ATF_ADD_TEST_CASE(tcs, nvxx_const_nv_list_ctor_nv_list);
 	ATF_ADD_TEST_CASE(tcs, nvxx_const_nv_list_ctor_nvlist_t);
 
@@ -2357,6 +2504,7 @@ ATF_INIT_TEST_CASES(tcs)
 	ATF_ADD_TEST_CASE(tcs, nvxx_add_duplicate_bool_array);
 	ATF_ADD_TEST_CASE(tcs, nvxx_get_nonexistent_bool_array);
 	ATF_ADD_TEST_CASE(tcs, nvxx_add_bool_range);
+	ATF_ADD_TEST_CASE(tcs, nvxx_add_bool_unsized_range);
 	ATF_ADD_TEST_CASE(tcs, nvxx_add_bool_contig_range);
 	ATF_ADD_TEST_CASE(tcs, nvxx_free_bool_array);
 	ATF_ADD_TEST_CASE(tcs, nvxx_free_bool_array_nul_key);
@@ -2377,6 +2525,7 @@ ATF_INIT_TEST_CASES(tcs)
 	ATF_ADD_TEST_CASE(tcs, nvxx_add_number_array_nul_key);
 	ATF_ADD_TEST_CASE(tcs, nvxx_add_number_array_error);
 	ATF_ADD_TEST_CASE(tcs, nvxx_add_duplicate_number_array);
+	ATF_ADD_TEST_CASE(tcs, nvxx_move_duplicate_number_array);
 	ATF_ADD_TEST_CASE(tcs, nvxx_get_nonexistent_number_array);
 	ATF_ADD_TEST_CASE(tcs, nvxx_add_number_range);
 	ATF_ADD_TEST_CASE(tcs, nvxx_add_number_contig_range);
@@ -2385,6 +2534,7 @@ ATF_INIT_TEST_CASES(tcs)
 	ATF_ADD_TEST_CASE(tcs, nvxx_free_number_array_nonexistent);
 
 	ATF_ADD_TEST_CASE(tcs, nvxx_add_string);
+	ATF_ADD_TEST_CASE(tcs, nvxx_add_string_substring);
 	ATF_ADD_TEST_CASE(tcs, nvxx_add_string_nul_key);
 	ATF_ADD_TEST_CASE(tcs, nvxx_add_string_nul_value);
 	ATF_ADD_TEST_CASE(tcs, nvxx_add_string_error);
@@ -2437,6 +2587,7 @@ ATF_INIT_TEST_CASES(tcs)
 	ATF_ADD_TEST_CASE(tcs, nvxx_free_descriptor_array);
 	ATF_ADD_TEST_CASE(tcs, nvxx_free_descriptor_array_nul_key);
 	ATF_ADD_TEST_CASE(tcs, nvxx_free_descriptor_array_nonexistent);
+	ATF_ADD_TEST_CASE(tcs, nvxx_move_descriptor_array);
 
 	ATF_ADD_TEST_CASE(tcs, nvxx_add_binary);
 	ATF_ADD_TEST_CASE(tcs, nvxx_add_binary_nul_key);
@@ -2450,4 +2601,6 @@ ATF_INIT_TEST_CASES(tcs)
 	ATF_ADD_TEST_CASE(tcs, nvxx_free_binary_nonexistent);
 
 	ATF_ADD_TEST_CASE(tcs, nvxx_add_binary_range);
+	ATF_ADD_TEST_CASE(tcs, nvxx_add_sized_range);
+	ATF_ADD_TEST_CASE(tcs, nvxx_add_sized_range_error);
 }
@@ -0,0 +1,177 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR MIT
+ * Refer to the file 'LICENSE' in the nvxx distribution for license terms.
+ */
+
+#include <map>
+
+#include <atf-c++.hpp>
+
+#include "nvxx.h"
+
+#define TEST_CASE(name)				\
+	ATF_TEST_CASE_WITHOUT_HEAD(name)	\
+	ATF_TEST_CASE_BODY(name)
+
+using namespace std::literals;
+
+TEST_CASE(nv_builder_build)
+{
+	auto numbers = std::vector<std::uint64_t>{1, 2, 3};
+
+	auto builder = bsd::nv_list_builder();
+	builder.add_null("null")
+		.add_bool("bool", true)
+		.add_number("number", 42)
+		.add_string("string", "value")
+		.add_number_array("numbers", numbers);
+
+	auto nvl = std::move(builder).build();
+
+	ATF_REQUIRE_EQ(true, nvl.exists_null("null"));
+	ATF_REQUIRE_EQ(true, nvl.get_bool("bool"));
+	ATF_REQUIRE_EQ(42, nvl.get_number("number"));
+	ATF_REQUIRE_EQ("value"sv, nvl.get_string("string"));
+	ATF_REQUIRE_EQ(3, nvl.get_number_array("numbers").size());
+}
+
+TEST_CASE(nv_builder_entries)
+{
+	auto child = bsd::nv_list();
+	child.add_number("x", 1);
+
+	auto builder = bsd::nv_list_builder();
+	builder.add({ {"host", "alpha"},
+		      {"port", 80},
+		      {"debug", false},
+		      {"child", child} });
+	builder.add(std::tuple(std::pair("tuple", "value"),
+			       std::pair("answer", 42u)));
+	builder.add_range(std::map<std::string, std::uint64_t>{
+		{"a", 1}, {"b", 2}});
+
+	auto nvl = std::move(builder).build();
+	ATF_REQUIRE_EQ("alpha"sv, nvl.get_string("host"));
+	ATF_REQUIRE_EQ(80, nvl.get_number("port"));
+	ATF_REQUIRE_EQ(false, nvl.get_bool("debug"));
+	ATF_REQUIRE_EQ(1, nvl.get_nvlist("child").get_number("x"));
+	ATF_REQUIRE_EQ("value"sv, nvl.get_string("tuple"));
+	ATF_REQUIRE_EQ(42, nvl.get_number("answer"));
+	ATF_REQUIRE_EQ(2, nvl.get_number("b"));
+}
+
+TEST_CASE(nv_builder_deferred_error)
+{
+	auto builder = bsd::nv_list_builder();
+
+	// neither of these throws
+	builder.add_number("key", 1);
+	builder.add_number("key", 2);
+	builder.add_number("other", 3);
+	ATF_REQUIRE_EQ(false, static_cast<bool>(builder));
+
+	// only the first error is kept
+	builder.add_string("nul\0"sv, "value");
+
+	ATF_REQUIRE_THROW(bsd::nv_key_exists, (void)std::move(builder).build());
+}
+
+TEST_CASE(nv_builder_nul)
+{
+	auto builder = bsd::nv_list_builder();
+	builder.add_string("key\0"sv, "value");
+	ATF_REQUIRE_THROW(std::runtime_error, (void)std::move(builder).build());
+
+	auto values = bsd::nv_list_builder();
+	values.add_string("key", "val\0ue"sv);
+	ATF_REQUIRE_THROW(std::runtime_error, (void)std::move(values).build());
+}
+
+TEST_CASE(nv_builder_commit)
+{
+	auto nvl = bsd::nv_list();
+	nvl.add_number("existing", 1);
+
+	auto builder = bsd::nv_list_builder();
+	builder.add_number("new", 2).add_string("string", "value");
+	std::move(builder).commit(nvl);
+
+	ATF_REQUIRE_EQ(1, nvl.get_number("existing"));
+	ATF_REQUIRE_EQ(2, nvl.get_number("new"));
+	ATF_REQUIRE_EQ("value"sv, nvl.get_string("string"));
+}
+
+TEST_CASE(nv_builder_commit_rollback)
+{
+	auto nvl = bsd::nv_list();
+	nvl.add_number("existing", 1);
+	auto before = bsd::nv_list(nvl);
+
+	// a key which already exists in the destination
+	auto builder = bsd::nv_list_builder();
+	builder.add_number("new", 2);
+	builder.add_number("existing", 3);
+	ATF_REQUIRE_THROW(bsd::nv_key_exists, std::move(builder).commit(nvl));
+	ATF_REQUIRE_EQ(true, nvl == before);
+	ATF_REQUIRE_EQ(false, static_cast<bool>(nvl.error()));
+
+	// a duplicate key within the builder
+	auto dup = bsd::nv_list_builder();
+	dup.add_number("a", 1);
+	dup.add_number("a", 2);
+	ATF_REQUIRE_THROW(bsd::nv_key_exists, std::move(dup).commit(nvl));
+	ATF_REQUIRE_EQ(true, nvl == before);
+}
+
+TEST_CASE(nv_builder_commit_flags)
+{
+	auto nvl = bsd::nv_list();
+	nvl.add_number("existing", 1);
+	auto before = bsd::nv_list(nvl);
+
+	// a duplicate which the builder allows but the destination does not
+	auto dup = bsd::nv_list_builder(NV_FLAG_NO_UNIQUE);
+	dup.add_number("new", 1);
+	dup.add_number("new", 2);
+	ATF_REQUIRE_THROW(bsd::nv_key_exists, std::move(dup).commit(nvl));
+	ATF_REQUIRE_EQ(true, nvl == before);
+	ATF_REQUIRE_EQ(false, static_cast<bool>(nvl.error()));
+
+	// keys which differ only in case, in a destination which ignores case
+	auto icase = bsd::nv_list(NV_FLAG_IGNORE_CASE);
+	icase.add_number("Existing", 1);
+	auto icase_before = bsd::nv_list(icase);
+
+	auto builder = bsd::nv_list_builder();
+	builder.add_number("new", 2);
+	builder.add_number("EXISTING", 3);
+	ATF_REQUIRE_THROW(bsd::nv_key_exists,
+			  std::move(builder).commit(icase));
+	ATF_REQUIRE_EQ(true, icase == icase_before);
+	ATF_REQUIRE_EQ(false, static_cast<bool>(icase.error()));
+
+	auto cased = bsd::nv_list_builder();
+	cased.add_number("key", 1);
+	cased.add_number("KEY", 2);
+	ATF_REQUIRE_THROW(bsd::nv_key_exists, std::move(cased).commit(icase));
+	ATF_REQUIRE_EQ(true, icase == icase_before);
+
+	// but a destination which allows duplicates accepts them
+	auto multi = bsd::nv_list(NV_FLAG_NO_UNIQUE);
+	auto dup2 = bsd::nv_list_builder(NV_FLAG_NO_UNIQUE);
+	dup2.add_number("new", 1);
+	dup2.add_number("new", 2);
+	std::move(dup2).commit(multi);
+	ATF_REQUIRE_EQ(false, multi.empty());
+}
+
+ATF_INIT_TEST_CASES(tcs)
+{
+	ATF_ADD_TEST_CASE(tcs, nv_builder_build);
+	ATF_ADD_TEST_CASE(tcs, nv_builder_entries);
+	ATF_ADD_TEST_CASE(tcs, nv_builder_deferred_error);
+	ATF_ADD_TEST_CASE(tcs, nv_builder_nul);
+	ATF_ADD_TEST_CASE(tcs, nv_builder_commit);
+	ATF_ADD_TEST_CASE(tcs, nv_builder_commit_rollback);
+	ATF_ADD_TEST_CASE(tcs, nv_builder_commit_flags);
+}
@@ -0,0 +1,251 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR MIT
+ * Refer to the file 'LICENSE' in the nvxx distribution for license terms.
+ */
+
+#include <array>
+#include <initializer_list>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <atf-c++.hpp>
+
+#include "nvxx.h"
+
+#define TEST_CASE(name)				\
+	ATF_TEST_CASE_WITHOUT_HEAD(name)	\
+	ATF_TEST_CASE_BODY(name)
+
+using namespace std::literals;
+
+namespace {
+
+std::vector<std::byte>
+bytes(std::initializer_list<unsigned> values)
+{
+	auto ret = std::vector<std::byte>();
+	for (auto v : values)
+		ret.push_back(static_cast<std::byte>(v));
+	return (ret);
+}
+
+std::vector<std::byte>
+to_cbor(bsd::const_nv_list const &nvl)
+{
+	auto ret = std::vector<std::byte>();
+	bsd::nv_to_cbor(nvl, std::back_inserter(ret));
+	return (ret);
+}
+
+} // anonymous namespace
+
+TEST_CASE(nv_to_cbor_empty)
+{
+	auto nvl = bsd::nv_list();
+	ATF_REQUIRE(bytes({0xa0}) == to_cbor(nvl));
+}
+
+TEST_CASE(nv_to_cbor_scalars)
+{
+	auto nvl = bsd::nv_list();
+	nvl.add_null("z");
+	nvl.add_bool("t", true);
+	nvl.add_number("a", 23);
+	nvl.add_number("b", 24);
+	nvl.add_number("c", 4294967296);
+	nvl.add_string("s", "ab");
+	nvl.add_binary("x", std::as_bytes(std::span("\x01\xff"sv)));
+
+	ATF_REQUIRE(bytes({0xa7,
+			   0x61, 'z', 0xf6,
+			   0x61, 't', 0xf5,
+			   0x61, 'a', 0x17,
+			   0x61, 'b', 0x18, 0x18,
+			   0x61, 'c', 0x1b, 0, 0, 0, 1, 0, 0, 0, 0,
+			   0x61, 's', 0x62, 'a', 'b',
+			   0x61, 'x', 0x42, 0x01, 0xff})
+		    == to_cbor(nvl));
+}
+
+TEST_CASE(nv_to_cbor_nested)
+{
+	auto inner = bsd::nv_list();
+	inner.add_number("x", 1);
+
+	auto nvl = bsd::nv_list();
+	nvl.add_nvlist("i", inner);
+	nvl.add_number_array("n", std::vector<std::uint64_t>{1, 300});
+	nvl.add_bool_array("b", std::array{true, false});
+	nvl.add_nvlist_array("l", std::vector{inner});
+
+	ATF_REQUIRE(bytes({0xa4,
+			   0x61, 'i', 0xa1, 0x61, 'x', 0x01,
+			   0x61, 'n', 0x82, 0x01, 0x19, 0x01, 0x2c,
+			   0x61, 'b', 0x82, 0xf5, 0xf4,
+			   0x61, 'l', 0x81, 0xa1, 0x61, 'x', 0x01})
+		    == to_cbor(nvl));
+}
+
+TEST_CASE(nv_to_cbor_error)
+{
+	auto nvl = bsd::nv_list();
+	nvl.set_error(std::errc::invalid_argument);
+
+	auto out = std::vector<std::byte>();
+	ATF_REQUIRE_THROW(bsd::nv_error_state,
+			  bsd::nv_to_cbor(nvl, std::back_inserter(out)));
+}
+
+TEST_CASE(nv_from_cbor_scalars)
+{
+	auto nvl = bsd::nv_from_cbor(bytes({
+		0xa6,
+		0x61, 'z', 0xf6,
+		0x61, 'f', 0xf4,
+		0x61, 'n', 0x1b, 0xff, 0xff, 0xff, 0xff,
+				 0xff, 0xff, 0xff, 0xff,
+		0x61, 'i', 0x19, 0x01, 0x00,
+		0x61, 's', 0x63, 'a', 'b', 'c',
+		0x61, 'x', 0x41, 0x2a}));
+
+	ATF_REQUIRE_EQ(true, nvl.exists_null("z"));
+	ATF_REQUIRE_EQ(false, nvl.get_bool("f"));
+	ATF_REQUIRE_EQ(18446744073709551615u, nvl.get_number("n"));
+	ATF_REQUIRE_EQ(256, nvl.get_number("i"));
+	ATF_REQUIRE_EQ("abc"sv, nvl.get_string("s"));
+
+	auto const bin = nvl.get_binary("x");
+	ATF_REQUIRE_EQ(1, bin.size());
+	ATF_REQUIRE_EQ(0x2a, std::to_integer<int>(bin[0]));
+}
+
+TEST_CASE(nv_from_cbor_nested)
+{
+	auto nvl = bsd::nv_from_cbor(bytes({
+		0xa5,
+		0x61, 'i', 0xa1, 0x61, 'x', 0x01,
+		0x61, 'n', 0x83, 0x01, 0x02, 0x03,
+		0x61, 's', 0x82, 0x61, 'a', 0x61, 'b',
+		0x61, 'l', 0x82, 0xa1, 0x61, 'x', 0x01,
+				 0xa1, 0x61, 'x', 0x02,
+		0x61, 'e', 0x80}));
+
+	ATF_REQUIRE_EQ(1, nvl.get_nvlist("i").get_number("x"));
+
+	auto numbers = nvl.get_number_array("n");
+	ATF_REQUIRE_EQ(3, numbers.size());
+	ATF_REQUIRE_EQ(3, numbers[2]);
+
+	auto strings = nvl.get_string_array("s");
+	ATF_REQUIRE_EQ(2, strings.size());
+	ATF_REQUIRE_EQ("b"sv, strings[1]);
+
+	auto lists = nvl.get_nvlist_array("l");
+	ATF_REQUIRE_EQ(2, lists.size());
+	ATF_REQUIRE_EQ(2, lists[1].get_number("x"));
+
+	ATF_REQUIRE_EQ(0, nvl.get_number_array("e").size());
+}
+
+TEST_CASE(nv_from_cbor_indefinite)
+{
+	// a self-described indefinite-length map, containing an
+	// indefinite-length array and text strings made of several chunks.
+	auto nvl = bsd::nv_from_cbor(bytes({
+		0xd9, 0xd9, 0xf7,
+		0xbf,
+		0x7f, 0x61, 'k', 0x62, 'e', 'y', 0xff,
+		      0x7f, 0x62, 'v', 'a', 0x63, 'l', 'u', 'e', 0xff,
+		0x61, 'a', 0x9f, 0x01, 0x02, 0xff,
+		0x61, 'e', 0x9f, 0xff,
+		0xff}));
+
+	ATF_REQUIRE_EQ("value"sv, nvl.get_string("key"));
+	ATF_REQUIRE_EQ(2, nvl.get_number_array("a").size());
+	ATF_REQUIRE_EQ(0, nvl.get_number_array("e").size());
+}
+
+TEST_CASE(nv_from_cbor_roundtrip)
+{
+	auto inner = bsd::nv_list();
+	inner.add_bool("b", true);
+
+	auto nvl = bsd::nv_list();
+	nvl.add_number("n", 70000);
+	nvl.add_string("s", std::string(300, 'x'));
+	nvl.add_binary("x", std::as_bytes(std::span("binary"sv)));
+	nvl.add_number_array("a", std::vector<std::uint64_t>{1, 1u << 20});
+	nvl.add_string_array("sa", std::vector{"a"sv, "b"sv});
+	nvl.add_nvlist("inner", inner);
+	nvl.add_nvlist_array("la", std::vector{inner, inner});
+
+	ATF_REQUIRE(nvl == bsd::nv_from_cbor(to_cbor(nvl)));
+}
+
+TEST_CASE(nv_from_cbor_duplicate)
+{
+	auto const data = bytes({0xa2, 0x61, 'a', 0x01, 0x61, 'a', 0x02});
+
+	try {
+		(void)bsd::nv_from_cbor(data);
+		ATF_FAIL("nv_cbor_error not thrown");
+	} catch (bsd::nv_cbor_error const &e) {
+		ATF_REQUIRE_EQ(4, e.offset);
+	}
+
+	auto nvl = bsd::nv_from_cbor(data, NV_FLAG_NO_UNIQUE);
+	ATF_REQUIRE_EQ(false, nvl.empty());
+}
+
+TEST_CASE(nv_from_cbor_errors)
+{
+	auto const invalid = {
+		bytes({0x81, 0x01}),			// not a map
+		bytes({0xa0, 0x00}),			// trailing data
+		bytes({0xa1, 0x01, 0x01}),		// non-text key
+		bytes({0xa1, 0x61, 'a'}),		// missing value
+		bytes({0xbf, 0x61, 'a', 0x01}),		// missing break
+		bytes({0xa1, 0x61, 'a', 0x63, 'b'}),	// short string
+		bytes({0xa1, 0x61, 'a', 0x61, 0x00}),	// NUL
+		bytes({0xa1, 0x61, 'a', 0x20}),		// negative
+		bytes({0xa1, 0x61, 'a', 0xf9, 0x3c, 0x00}),	// float
+		bytes({0xa1, 0x61, 'a', 0xf7}),		// undefined
+		bytes({0xa1, 0x61, 'a', 0xc1, 0x01}),	// tag
+		bytes({0xa1, 0x61, 'a', 0x1c}),		// reserved
+		bytes({0xa1, 0x61, 'a', 0xff}),		// unexpected break
+		bytes({0xa1, 0x61, 'a', 0x7f, 0x41, 'b', 0xff}),
+							// bad chunk
+		bytes({0xa1, 0x61, 'a', 0x82, 0x01, 0xf5}),	// mixed array
+		bytes({0xa1, 0x61, 'a', 0x81, 0x80}),	// nested array
+		bytes({0xa1, 0x61, 'a', 0x81, 0xf6}),	// null in array
+		bytes({0xa1, 0x61, 'a', 0x9b, 0xff, 0xff, 0xff, 0xff,
+					   0xff, 0xff, 0xff, 0xff}),
+							// huge array
+	};
+
+	for (auto const &data : invalid)
+		ATF_REQUIRE_THROW(bsd::nv_cbor_error,
+				  (void)bsd::nv_from_cbor(data));
+
+	auto deep = std::vector<std::byte>();
+	for (auto i = 0; i < 600; ++i)
+		deep.insert(deep.end(), {std::byte{0xa1}, std::byte{0x61},
+					 std::byte{'a'}});
+	deep.push_back(std::byte{0x01});
+	ATF_REQUIRE_THROW(bsd::nv_cbor_error, (void)bsd::nv_from_cbor(deep));
+}
+
+ATF_INIT_TEST_CASES(tcs)
+{
+	ATF_ADD_TEST_CASE(tcs, nv_to_cbor_empty);
+	ATF_ADD_TEST_CASE(tcs, nv_to_cbor_scalars);
+	ATF_ADD_TEST_CASE(tcs, nv_to_cbor_nested);
+	ATF_ADD_TEST_CASE(tcs, nv_to_cbor_error);
+	ATF_ADD_TEST_CASE(tcs, nv_from_cbor_scalars);
+	ATF_ADD_TEST_CASE(tcs, nv_from_cbor_nested);
+	ATF_ADD_TEST_CASE(tcs, nv_from_cbor_indefinite);
+	ATF_ADD_TEST_CASE(tcs, nv_from_cbor_roundtrip);
+	ATF_ADD_TEST_CASE(tcs, nv_from_cbor_duplicate);
+	ATF_ADD_TEST_CASE(tcs, nv_from_cbor_errors);
+}
@@ -0,0 +1,186 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR MIT
+ * Refer to the file 'LICENSE' in the nvxx distribution for license terms.
+ */
+
+#include <algorithm>
+#include <functional>
+#include <unordered_set>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <atf-c++.hpp>
+
+#include "nvxx.h"
+
+#define TEST_CASE(name)				\
+	ATF_TEST_CASE_WITHOUT_HEAD(name)	\
+	ATF_TEST_CASE_BODY(name)
+
+using namespace std::literals;
+
+namespace {
+
+bsd::nv_list
+make_list(bool reversed)
+{
+	auto inner = bsd::nv_list();
+	inner.add_number("x", 1);
+	inner.add_string("y", "two");
+
+	auto nvl = bsd::nv_list();
+	auto add = std::vector<std::function<void ()>>{
+		[&] { nvl.add_number("number", 42); },
+		[&] { nvl.add_string("string", "hello"); },
+		[&] { nvl.add_null("null"); },
+		[&] { nvl.add_nvlist("inner", inner); },
+		[&] { nvl.add_number_array("numbers",
+				std::vector<std::uint64_t>{1, 2, 3}); },
+		[&] { nvl.add_string_array("strings",
+				std::vector{"a"sv, "b"sv}); },
+		[&] { nvl.add_binary("binary",
+				std::vector<std::byte>(100, std::byte{7})); },
+	};
+
+	if (reversed)
+		std::ranges::reverse(add);
+
+	for (auto &fn : add)
+		fn();
+
+	return (nvl);
+}
+
+} // anonymous namespace
+
+TEST_CASE(nv_compare_order)
+{
+	auto a = make_list(false);
+	auto b = make_list(true);
+
+	ATF_REQUIRE_EQ(true, a == b);
+	ATF_REQUIRE_EQ(false, a != b);
+	ATF_REQUIRE_EQ(bsd::nv_hash(a), bsd::nv_hash(b));
+}
+
+TEST_CASE(nv_compare_differ)
+{
+	auto a = make_list(false);
+
+	auto b = make_list(false);
+	b.add_bool("extra", true);
+	ATF_REQUIRE_EQ(false, a == b);
+
+	auto c = bsd::nv_list(make_list(false));
+	c.free_number("number");
+	c.add_number("number", 43);
+	ATF_REQUIRE_EQ(false, a == c);
+	ATF_REQUIRE(bsd::nv_hash(a) != bsd::nv_hash(c));
+
+	// same key, different type
+	auto d = bsd::nv_list();
+	d.add_number("key", 1);
+	auto e = bsd::nv_list();
+	e.add_bool("key", true);
+	ATF_REQUIRE_EQ(false, d == e);
+
+	// nested difference
+	auto f = bsd::nv_list();
+	auto inner = bsd::nv_list();
+	inner.add_number("x", 2);
+	f.add_nvlist("inner", inner);
+	auto g = bsd::nv_list();
+	inner.free_number("x");
+	inner.add_number("x", 3);
+	g.add_nvlist("inner", inner);
+	ATF_REQUIRE_EQ(false, f == g);
+	ATF_REQUIRE(bsd::nv_hash(f) != bsd::nv_hash(g));
+}
+
+TEST_CASE(nv_compare_array_order)
+{
+	auto a = bsd::nv_list();
+	a.add_number_array("array", std::vector<std::uint64_t>{1, 2});
+	auto b = bsd::nv_list();
+	b.add_number_array("array", std::vector<std::uint64_t>{2, 1});
+
+	ATF_REQUIRE_EQ(false, a == b);
+	ATF_REQUIRE(bsd::nv_hash(a) != bsd::nv_hash(b));
+}
+
+TEST_CASE(nv_compare_duplicates)
+{
+	auto a = bsd::nv_list(NV_FLAG_NO_UNIQUE);
+	a.add_number("key", 1);
+	a.add_number("key", 2);
+
+	auto b = bsd::nv_list(NV_FLAG_NO_UNIQUE);
+	b.add_number("key", 2);
+	b.add_number("key", 1);
+
+	ATF_REQUIRE_EQ(true, a == b);
+	ATF_REQUIRE_EQ(bsd::nv_hash(a), bsd::nv_hash(b));
+
+	auto c = bsd::nv_list(NV_FLAG_NO_UNIQUE);
+	c.add_number("key", 1);
+	c.add_number("key", 1);
+	ATF_REQUIRE_EQ(false, a == c);
+}
+
+TEST_CASE(nv_compare_descriptor)
+{
+	auto fd = ::open("/dev/null", O_RDONLY);
+	ATF_REQUIRE(fd != -1);
+
+	// add_descriptor() duplicates the descriptor
+	auto a = bsd::nv_list();
+	a.add_descriptor("fd", fd);
+	auto b = bsd::nv_list();
+	b.add_descriptor("fd", fd);
+	(void)::close(fd);
+
+	ATF_REQUIRE(a.get_descriptor("fd") != b.get_descriptor("fd"));
+	ATF_REQUIRE_EQ(true, a == b);
+	ATF_REQUIRE_EQ(bsd::nv_hash(a), bsd::nv_hash(b));
+}
+
+TEST_CASE(nv_compare_seed)
+{
+	auto a = make_list(false);
+	ATF_REQUIRE(bsd::nv_hash(a, 1) != bsd::nv_hash(a, 2));
+	ATF_REQUIRE(bsd::nv_hash(bsd::nv_list()) != bsd::nv_hash(a));
+}
+
+TEST_CASE(nv_compare_unordered_set)
+{
+	auto set = std::unordered_set<bsd::nv_list>();
+	set.insert(make_list(false));
+	set.insert(make_list(true));
+	set.insert(bsd::nv_list());
+
+	ATF_REQUIRE_EQ(2, set.size());
+}
+
+TEST_CASE(nv_compare_error)
+{
+	auto a = bsd::nv_list();
+	auto b = bsd::nv_list();
+	b.set_error(std::errc::invalid_argument);
+
+	ATF_REQUIRE_THROW(bsd::nv_error_state, (void)(a == b));
+	ATF_REQUIRE_THROW(bsd::nv_error_state, (void)bsd::nv_hash(b));
+}
+
+ATF_INIT_TEST_CASES(tcs)
+{
+	ATF_ADD_TEST_CASE(tcs, nv_compare_order);
+	ATF_ADD_TEST_CASE(tcs, nv_compare_differ);
+	ATF_ADD_TEST_CASE(tcs, nv_compare_array_order);
+	ATF_ADD_TEST_CASE(tcs, nv_compare_duplicates);
+	ATF_ADD_TEST_CASE(tcs, nv_compare_descriptor);
+	ATF_ADD_TEST_CASE(tcs, nv_compare_seed);
+	ATF_ADD_TEST_CASE(tcs, nv_compare_unordered_set);
+	ATF_ADD_TEST_CASE(tcs, nv_compare_error);
+}
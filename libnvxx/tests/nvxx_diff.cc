@@ -0,0 +1,185 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR MIT
+ * Refer to the file 'LICENSE' in the nvxx distribution for license terms.
+ */
+
+#include <vector>
+
+#include <atf-c++.hpp>
+
+#include "nvxx.h"
+
+#define TEST_CASE(name)				\
+	ATF_TEST_CASE_WITHOUT_HEAD(name)	\
+	ATF_TEST_CASE_BODY(name)
+
+using namespace std::literals;
+
+namespace {
+
+bsd::nv_list
+make_config()
+{
+	auto net = bsd::nv_list();
+	net.add_string("address", "192.0.2.1");
+	net.add_number("mtu", 1500);
+
+	auto nvl = bsd::nv_list();
+	nvl.add_string("hostname", "alpha");
+	nvl.add_number("port", 80);
+	nvl.add_bool("debug", false);
+	nvl.add_nvlist("net", net);
+	return (nvl);
+}
+
+} // anonymous namespace
+
+TEST_CASE(nv_diff_equal)
+{
+	auto patch = bsd::nv_diff(make_config(), make_config());
+	ATF_REQUIRE_EQ(true, patch.empty());
+}
+
+TEST_CASE(nv_diff_changes)
+{
+	auto oldl = make_config();
+	auto newl = make_config();
+
+	newl.free_number("port");
+	newl.add_number("port", 8080);
+	newl.free_bool("debug");
+	newl.add_string("extra", "value");
+
+	auto patch = bsd::nv_diff(oldl, newl);
+
+	auto set = patch.get_nvlist("set");
+	ATF_REQUIRE_EQ(8080, set.get_number("port"));
+	ATF_REQUIRE_EQ("value"sv, set.get_string("extra"));
+	ATF_REQUIRE_EQ(false, set.exists("hostname"));
+
+	auto removed = patch.get_string_array("remove");
+	ATF_REQUIRE_EQ(1, removed.size());
+	ATF_REQUIRE_EQ("debug"sv, removed[0]);
+
+	ATF_REQUIRE_EQ(false, patch.exists("patch"));
+
+	bsd::nv_apply(oldl, patch);
+	ATF_REQUIRE_EQ(true, oldl == newl);
+}
+
+TEST_CASE(nv_diff_nested)
+{
+	auto oldl = make_config();
+	auto newl = make_config();
+
+	auto net = newl.take_nvlist("net");
+	net.free_number("mtu");
+	net.add_number("mtu", 9000);
+	newl.move_nvlist("net", std::move(net));
+
+	auto patch = bsd::nv_diff(oldl, newl);
+	ATF_REQUIRE_EQ(false, patch.exists("set"));
+	ATF_REQUIRE_EQ(9000, patch.get_nvlist("patch").get_nvlist("net")
+				   .get_nvlist("set").get_number("mtu"));
+
+	bsd::nv_apply(oldl, patch);
+	ATF_REQUIRE_EQ(true, oldl == newl);
+	ATF_REQUIRE_EQ("192.0.2.1"sv,
+		       oldl.get_nvlist("net").get_string("address"));
+}
+
+TEST_CASE(nv_diff_type_change)
+{
+	auto oldl = bsd::nv_list();
+	oldl.add_number("key", 1);
+	auto newl = bsd::nv_list();
+	newl.add_string("key", "one");
+
+	auto patch = bsd::nv_diff(oldl, newl);
+	ATF_REQUIRE_EQ("one"sv, patch.get_nvlist("set").get_string("key"));
+
+	bsd::nv_apply(oldl, patch);
+	ATF_REQUIRE_EQ(true, oldl == newl);
+}
+
+TEST_CASE(nv_diff_pack)
+{
+	auto oldl = make_config();
+	auto newl = make_config();
+	newl.add_number("new", 1);
+
+	// a patch survives being packed and unpacked
+	auto patch = bsd::nv_list::unpack(bsd::nv_diff(oldl, newl).pack());
+	bsd::nv_apply(oldl, patch);
+	ATF_REQUIRE_EQ(true, oldl == newl);
+}
+
+TEST_CASE(nv_apply_invalid)
+{
+	auto nvl = make_config();
+
+	auto bad = bsd::nv_list();
+	bad.add_number("unknown", 1);
+	ATF_REQUIRE_THROW(bsd::nv_patch_invalid, bsd::nv_apply(nvl, bad));
+
+	auto missing = bsd::nv_list();
+	auto patches = bsd::nv_list();
+	patches.add_nvlist("nonexistent", bsd::nv_list());
+	missing.add_nvlist("patch", patches);
+	ATF_REQUIRE_THROW(bsd::nv_key_not_found, bsd::nv_apply(nvl, missing));
+}
+
+TEST_CASE(nv_apply_invalid_unchanged)
+{
+	auto nvl = make_config();
+
+	// change "net", then fail on a missing nvlist nested inside it.
+	auto net_patches = bsd::nv_list();
+	net_patches.add_nvlist("nonexistent", bsd::nv_list());
+
+	auto net_set = bsd::nv_list();
+	net_set.add_number("mtu", 9000);
+
+	auto net_patch = bsd::nv_list();
+	net_patch.add_nvlist("set", net_set);
+	net_patch.add_nvlist("patch", net_patches);
+
+	auto patches = bsd::nv_list();
+	patches.add_nvlist("net", net_patch);
+
+	auto missing = bsd::nv_list();
+	missing.add_string_array("remove", std::vector{"port"sv});
+	missing.add_nvlist("patch", patches);
+	ATF_REQUIRE_THROW(bsd::nv_key_not_found, bsd::nv_apply(nvl, missing));
+	ATF_REQUIRE_EQ(true, nvl == make_config());
+
+	// a patch for a key which is not an nvlist.
+	auto mistyped_patches = bsd::nv_list();
+	mistyped_patches.add_nvlist("net", bsd::nv_list());
+	mistyped_patches.add_nvlist("hostname", bsd::nv_list());
+
+	auto mistyped = bsd::nv_list();
+	mistyped.add_nvlist("patch", mistyped_patches);
+	ATF_REQUIRE_THROW(bsd::nv_key_not_found, bsd::nv_apply(nvl, mistyped));
+	ATF_REQUIRE_EQ(true, nvl == make_config());
+	ATF_REQUIRE_EQ(1500, nvl.get_nvlist("net").get_number("mtu"));
+}
+
+TEST_CASE(nv_diff_no_unique)
+{
+	auto oldl = bsd::nv_list(NV_FLAG_NO_UNIQUE);
+	ATF_REQUIRE_THROW(std::invalid_argument,
+			  (void)bsd::nv_diff(oldl, bsd::nv_list()));
+}
+
+ATF_INIT_TEST_CASES(tcs)
+{
+	ATF_ADD_TEST_CASE(tcs, nv_diff_equal);
+	ATF_ADD_TEST_CASE(tcs, nv_diff_changes);
+	ATF_ADD_TEST_CASE(tcs, nv_diff_nested);
+	ATF_ADD_TEST_CASE(tcs, nv_diff_type_change);
+	ATF_ADD_TEST_CASE(tcs, nv_diff_pack);
+	ATF_ADD_TEST_CASE(tcs, nv_apply_invalid);
+	ATF_ADD_TEST_CASE(tcs, nv_apply_invalid_unchanged);
+	ATF_ADD_TEST_CASE(tcs, nv_diff_no_unique);
+}
@@ -0,0 +1,205 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR MIT
+ * Refer to the file 'LICENSE' in the nvxx distribution for license terms.
+ */
+
+#include <algorithm>
+#include <ranges>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <atf-c++.hpp>
+
+#include "nvxx.h"
+
+#define TEST_CASE(name)				\
+	ATF_TEST_CASE_WITHOUT_HEAD(name)	\
+	ATF_TEST_CASE_BODY(name)
+
+using namespace std::literals;
+
+TEST_CASE(nv_frozen_scalars)
+{
+	auto nvl = bsd::nv_list();
+	nvl.add_null("a null");
+	nvl.add_bool("a bool", true);
+	nvl.add_number("a number", 42);
+	nvl.add_string("a string", "hello");
+
+	auto frozen = nvl.freeze();
+	ATF_REQUIRE_EQ(4, frozen.size());
+
+	ATF_REQUIRE_EQ(true, frozen.exists_null("a null"));
+	ATF_REQUIRE_EQ(true, frozen.get_bool("a bool"));
+	ATF_REQUIRE_EQ(42, frozen.get_number("a number"));
+	ATF_REQUIRE_EQ("hello"sv, frozen.get_string("a string"));
+
+	ATF_REQUIRE_EQ(false, frozen.exists("missing"));
+	ATF_REQUIRE_EQ(false, frozen.exists_string("a number"));
+	ATF_REQUIRE_THROW(bsd::nv_key_not_found,
+			  (void)frozen.get_number("missing"));
+	ATF_REQUIRE_THROW(bsd::nv_key_not_found,
+			  (void)frozen.get_string("a number"));
+}
+
+TEST_CASE(nv_frozen_arrays)
+{
+	auto nvl = bsd::nv_list();
+	auto numbers = std::vector<std::uint64_t>{1, 2, 3};
+	auto strings = std::vector{"one"sv, "two"sv, "three"sv};
+	auto bytes = std::vector<std::byte>{std::byte{1}, std::byte{2}};
+
+	nvl.add_number_array("numbers", numbers);
+	nvl.add_string_array("strings", strings);
+	nvl.add_binary("binary", bytes);
+
+	auto frozen = bsd::nv_frozen(nvl);
+	ATF_REQUIRE_EQ(true, std::ranges::equal(numbers,
+			frozen.get_number_array("numbers")));
+	ATF_REQUIRE_EQ(true, std::ranges::equal(strings,
+			frozen.get_string_array("strings")));
+	ATF_REQUIRE_EQ(true, std::ranges::equal(bytes,
+			frozen.get_binary("binary")));
+}
+
+TEST_CASE(nv_frozen_nested)
+{
+	auto inner = bsd::nv_list();
+	inner.add_number("value", 1);
+
+	auto elems = std::vector<bsd::nv_list>();
+	for (auto i = 0u; i < 3; ++i) {
+		elems.emplace_back();
+		elems.back().add_number("index", i);
+	}
+
+	auto nvl = bsd::nv_list();
+	nvl.add_nvlist("inner", inner);
+	nvl.add_nvlist_array("array", elems);
+
+	auto frozen = nvl.freeze();
+	ATF_REQUIRE_EQ(1, frozen.get_nvlist("inner").get_number("value"));
+
+	auto array = frozen.get_nvlist_array("array");
+	ATF_REQUIRE_EQ(3, array.size());
+	for (auto i = 0u; i < 3; ++i) {
+		ATF_REQUIRE_EQ(true, array[i].in_array());
+		ATF_REQUIRE_EQ(i, array[i].get_number("index"));
+	}
+}
+
+TEST_CASE(nv_frozen_many_keys)
+{
+	auto nvl = bsd::nv_list();
+	for (auto i = 0u; i < 1000; ++i)
+		nvl.add_number(std::format("key{}", i), i);
+
+	auto frozen = nvl.freeze();
+	ATF_REQUIRE_EQ(1000, frozen.size());
+	for (auto i = 0u; i < 1000; ++i)
+		ATF_REQUIRE_EQ(i, frozen.get_number(std::format("key{}", i)));
+	ATF_REQUIRE_EQ(false, frozen.exists("key1000"));
+}
+
+TEST_CASE(nv_frozen_ignore_case)
+{
+	auto nvl = bsd::nv_list(NV_FLAG_IGNORE_CASE);
+	nvl.add_number("Key", 1);
+
+	auto frozen = nvl.freeze();
+	ATF_REQUIRE_EQ(NV_FLAG_IGNORE_CASE, frozen.flags());
+	ATF_REQUIRE_EQ(1, frozen.get_number("KEY"));
+	ATF_REQUIRE_EQ(1, frozen.get_number("key"));
+}
+
+TEST_CASE(nv_frozen_duplicate_keys)
+{
+	auto nvl = bsd::nv_list(NV_FLAG_NO_UNIQUE);
+	nvl.add_number("key", 1);
+	nvl.add_string("key", "one");
+
+	auto frozen = nvl.freeze();
+	ATF_REQUIRE_EQ(2, frozen.size());
+	ATF_REQUIRE_EQ(1, frozen.get_number("key"));
+	ATF_REQUIRE_EQ("one"sv, frozen.get_string("key"));
+}
+
+TEST_CASE(nv_frozen_descriptor)
+{
+	auto fd = ::open("/dev/null", O_RDONLY);
+	ATF_REQUIRE(fd != -1);
+
+	auto nvl = bsd::nv_list();
+	nvl.add_descriptor("fd", fd);
+	(void)::close(fd);
+
+	auto frozen = nvl.freeze();
+	auto dupfd = frozen.get_descriptor("fd");
+	ATF_REQUIRE(dupfd != nvl.get_descriptor("fd"));
+	ATF_REQUIRE(::fcntl(dupfd, F_GETFD) != -1);
+
+	frozen = bsd::nv_frozen();
+	ATF_REQUIRE_EQ(-1, ::fcntl(dupfd, F_GETFD));
+}
+
+TEST_CASE(nv_frozen_thaw)
+{
+	auto nvl = bsd::nv_list();
+	nvl.add_number("b", 2);
+	nvl.add_number("a", 1);
+	nvl.add_string_array("strings", std::vector{"x"sv, "y"sv});
+
+	auto inner = bsd::nv_list();
+	inner.add_bool("flag", true);
+	nvl.add_nvlist("inner", inner);
+
+	auto thawed = nvl.freeze().thaw();
+	ATF_REQUIRE_EQ(1, thawed.get_number("a"));
+	ATF_REQUIRE_EQ(2, thawed.get_number("b"));
+	ATF_REQUIRE_EQ(2, thawed.get_string_array("strings").size());
+	ATF_REQUIRE_EQ(true, thawed.get_nvlist("inner").get_bool("flag"));
+}
+
+TEST_CASE(nv_frozen_iterate)
+{
+	auto nvl = bsd::nv_list();
+	nvl.add_number("c", 3);
+	nvl.add_number("a", 1);
+	nvl.add_number("b", 2);
+
+	auto frozen = nvl.freeze();
+	auto keys = std::vector<std::string_view>();
+	for (auto const &[key, value] : frozen) {
+		keys.push_back(key);
+		ATF_REQUIRE_EQ(true, std::holds_alternative<std::uint64_t>(value));
+	}
+
+	ATF_REQUIRE_EQ(true, (keys == std::vector{"a"sv, "b"sv, "c"sv}));
+}
+
+TEST_CASE(nv_frozen_error)
+{
+	auto nvl = bsd::nv_list();
+	nvl.set_error(std::errc::invalid_argument);
+	ATF_REQUIRE_THROW(bsd::nv_error_state, (void)bsd::nv_frozen(nvl));
+
+	auto empty = bsd::nv_frozen();
+	ATF_REQUIRE_THROW(std::logic_error, (void)empty.size());
+}
+
+ATF_INIT_TEST_CASES(tcs)
+{
+	ATF_ADD_TEST_CASE(tcs, nv_frozen_scalars);
+	ATF_ADD_TEST_CASE(tcs, nv_frozen_arrays);
+	ATF_ADD_TEST_CASE(tcs, nv_frozen_nested);
+	ATF_ADD_TEST_CASE(tcs, nv_frozen_many_keys);
+	ATF_ADD_TEST_CASE(tcs, nv_frozen_ignore_case);
+	ATF_ADD_TEST_CASE(tcs, nv_frozen_duplicate_keys);
+	ATF_ADD_TEST_CASE(tcs, nv_frozen_descriptor);
+	ATF_ADD_TEST_CASE(tcs, nv_frozen_thaw);
+	ATF_ADD_TEST_CASE(tcs, nv_frozen_iterate);
+	ATF_ADD_TEST_CASE(tcs, nv_frozen_error);
+}
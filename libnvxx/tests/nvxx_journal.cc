@@ -0,0 +1,246 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR MIT
+ * Refer to the file 'LICENSE' in the nvxx distribution for license terms.
+ */
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <atf-c++.hpp>
+
+#include "nvxx.h"
+
+#define TEST_CASE(name)				\
+	ATF_TEST_CASE_WITHOUT_HEAD(name)	\
+	ATF_TEST_CASE_BODY(name)
+
+namespace {
+
+auto constexpr journal_path = "test.journal";
+
+bsd::nv_list
+make_record(std::uint64_t i)
+{
+	auto nvl = bsd::nv_list();
+	nvl.add_number("index", i);
+	nvl.add_string("name", "record " + std::to_string(i));
+	return (nvl);
+}
+
+} // anonymous namespace
+
+TEST_CASE(nv_journal_replay)
+{
+	{
+		auto writer = bsd::nv_journal_writer(journal_path);
+		for (auto i = 0u; i < 100; ++i)
+			ATF_REQUIRE_EQ(i, writer.append(make_record(i)));
+		writer.commit();
+		ATF_REQUIRE_EQ(100, writer.next_seqno());
+	}
+
+	auto reader = bsd::nv_journal_reader(journal_path);
+	ATF_REQUIRE_EQ(100, reader.size());
+
+	auto i = 0u;
+	while (auto record = reader.next()) {
+		ATF_REQUIRE_EQ(i, record->seqno);
+		auto nvl = record->unpack();
+		ATF_REQUIRE_EQ(i, nvl.get_number("index"));
+		++i;
+	}
+	ATF_REQUIRE_EQ(100, i);
+}
+
+TEST_CASE(nv_journal_reopen)
+{
+	{
+		auto writer = bsd::nv_journal_writer(journal_path);
+		for (auto i = 0u; i < 10; ++i)
+			(void)writer.append(make_record(i));
+	}
+
+	{
+		auto writer = bsd::nv_journal_writer(journal_path);
+		ATF_REQUIRE_EQ(10, writer.next_seqno());
+		ATF_REQUIRE_EQ(10, writer.append(make_record(10)));
+	}
+
+	auto reader = bsd::nv_journal_reader(journal_path);
+	ATF_REQUIRE_EQ(11, reader.size());
+}
+
+TEST_CASE(nv_journal_seek)
+{
+	{
+		auto writer = bsd::nv_journal_writer(journal_path);
+		for (auto i = 0u; i < 1000; ++i)
+			(void)writer.append(make_record(i));
+	}
+
+	auto reader = bsd::nv_journal_reader(journal_path, {.index_interval = 16});
+
+	for (auto seqno : {0u, 1u, 15u, 16u, 17u, 500u, 999u}) {
+		reader.seek(seqno);
+		auto record = reader.next();
+		ATF_REQUIRE_EQ(true, record.has_value());
+		ATF_REQUIRE_EQ(seqno, record->seqno);
+		ATF_REQUIRE_EQ(seqno, record->unpack().get_number("index"));
+	}
+
+	ATF_REQUIRE_THROW(std::out_of_range, reader.seek(1000));
+
+	reader.rewind();
+	ATF_REQUIRE_EQ(0, reader.next()->seqno);
+}
+
+TEST_CASE(nv_journal_tail)
+{
+	auto writer = bsd::nv_journal_writer(journal_path);
+	(void)writer.append(make_record(0));
+
+	auto reader = bsd::nv_journal_reader(journal_path);
+	ATF_REQUIRE_EQ(0, reader.next()->seqno);
+	ATF_REQUIRE_EQ(false, reader.next().has_value());
+	ATF_REQUIRE_EQ(false, reader.refresh());
+
+	(void)writer.append(make_record(1));
+	ATF_REQUIRE_EQ(true, reader.refresh());
+	ATF_REQUIRE_EQ(1, reader.next()->seqno);
+}
+
+TEST_CASE(nv_journal_tail_truncated)
+{
+	{
+		auto writer = bsd::nv_journal_writer(journal_path);
+		for (auto i = 0u; i < 10; ++i)
+			(void)writer.append(make_record(i));
+	}
+
+	auto reader = bsd::nv_journal_reader(journal_path);
+	ATF_REQUIRE_EQ(10, reader.size());
+	while (reader.next())
+		;
+
+	// the journal loses its later records while it is being read.
+	auto fd = ::open(journal_path, O_RDWR);
+	ATF_REQUIRE(fd != -1);
+	auto size = ::lseek(fd, 0, SEEK_END);
+	ATF_REQUIRE_EQ(0, ::ftruncate(fd, size / 2));
+
+	ATF_REQUIRE_EQ(true, reader.refresh());
+	auto const remaining = reader.size();
+	ATF_REQUIRE(remaining > 0 && remaining < 10);
+	ATF_REQUIRE_THROW(std::out_of_range, reader.seek(9));
+
+	auto i = 0u;
+	while (auto record = reader.next()) {
+		ATF_REQUIRE_EQ(i, record->unpack().get_number("index"));
+		++i;
+	}
+	ATF_REQUIRE_EQ(remaining, i);
+
+	// and then loses all of them.
+	ATF_REQUIRE_EQ(0, ::ftruncate(fd, 0));
+	(void)::close(fd);
+
+	ATF_REQUIRE_EQ(true, reader.refresh());
+	ATF_REQUIRE_EQ(0, reader.size());
+	ATF_REQUIRE_EQ(false, reader.next().has_value());
+	ATF_REQUIRE_THROW(std::out_of_range, reader.seek(0));
+	reader.rewind();
+	ATF_REQUIRE_EQ(false, reader.next().has_value());
+}
+
+TEST_CASE(nv_journal_group_commit)
+{
+	auto writer = bsd::nv_journal_writer(journal_path, {.group_size = 8});
+
+	auto threads = std::vector<std::thread>();
+	for (auto t = 0u; t < 4; ++t) {
+		threads.emplace_back([&, t] {
+			for (auto i = 0u; i < 50; ++i)
+				writer.commit(writer.append(make_record(t)));
+		});
+	}
+
+	for (auto &thread : threads)
+		thread.join();
+
+	auto reader = bsd::nv_journal_reader(journal_path);
+	ATF_REQUIRE_EQ(200, reader.size());
+}
+
+TEST_CASE(nv_journal_torn_write)
+{
+	{
+		auto writer = bsd::nv_journal_writer(journal_path);
+		for (auto i = 0u; i < 3; ++i)
+			(void)writer.append(make_record(i));
+	}
+
+	// simulate a crash in the middle of writing the last record
+	auto fd = ::open(journal_path, O_RDWR);
+	ATF_REQUIRE(fd != -1);
+	auto size = ::lseek(fd, 0, SEEK_END);
+	ATF_REQUIRE_EQ(0, ::ftruncate(fd, size - 5));
+	(void)::close(fd);
+
+	{
+		auto reader = bsd::nv_journal_reader(journal_path);
+		ATF_REQUIRE_EQ(2, reader.size());
+	}
+
+	auto writer = bsd::nv_journal_writer(journal_path);
+	ATF_REQUIRE_EQ(2, writer.next_seqno());
+}
+
+TEST_CASE(nv_journal_corrupt)
+{
+	{
+		auto writer = bsd::nv_journal_writer(journal_path);
+		for (auto i = 0u; i < 3; ++i)
+			(void)writer.append(make_record(i));
+	}
+
+	// damage the payload of the first record
+	auto fd = ::open(journal_path, O_RDWR);
+	ATF_REQUIRE(fd != -1);
+	auto byte = char{0x7f};
+	ATF_REQUIRE_EQ(1, ::pwrite(fd, &byte, 1, 40));
+	(void)::close(fd);
+
+	auto reader = bsd::nv_journal_reader(journal_path);
+	ATF_REQUIRE_THROW(bsd::nv_journal_corrupt, (void)reader.next());
+}
+
+TEST_CASE(nv_journal_bad_magic)
+{
+	auto fd = ::open(journal_path, O_RDWR | O_CREAT, 0644);
+	ATF_REQUIRE(fd != -1);
+	auto junk = std::string(32, 'x');
+	ATF_REQUIRE_EQ(32, ::write(fd, junk.data(), junk.size()));
+	(void)::close(fd);
+
+	ATF_REQUIRE_THROW(bsd::nv_journal_corrupt,
+			  (void)bsd::nv_journal_reader(journal_path));
+	ATF_REQUIRE_THROW(bsd::nv_journal_corrupt,
+			  (void)bsd::nv_journal_writer(journal_path));
+}
+
+ATF_INIT_TEST_CASES(tcs)
+{
+	ATF_ADD_TEST_CASE(tcs, nv_journal_replay);
+	ATF_ADD_TEST_CASE(tcs, nv_journal_reopen);
+	ATF_ADD_TEST_CASE(tcs, nv_journal_seek);
+	ATF_ADD_TEST_CASE(tcs, nv_journal_tail);
+	ATF_ADD_TEST_CASE(tcs, nv_journal_tail_truncated);
+	ATF_ADD_TEST_CASE(tcs, nv_journal_group_commit);
+	ATF_ADD_TEST_CASE(tcs, nv_journal_torn_write);
+	ATF_ADD_TEST_CASE(tcs, nv_journal_corrupt);
+	ATF_ADD_TEST_CASE(tcs, nv_journal_bad_magic);
+}
@@ -0,0 +1,258 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR MIT
+ * Refer to the file 'LICENSE' in the nvxx distribution for license terms.
+ */
+
+#include <array>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <atf-c++.hpp>
+
+#include "nvxx.h"
+
+#define TEST_CASE(name)				\
+	ATF_TEST_CASE_WITHOUT_HEAD(name)	\
+	ATF_TEST_CASE_BODY(name)
+
+using namespace std::literals;
+
+namespace {
+
+std::string
+to_json(bsd::const_nv_list const &nvl)
+{
+	auto ret = std::string();
+	bsd::nv_to_json(nvl, std::back_inserter(ret));
+	return (ret);
+}
+
+} // anonymous namespace
+
+TEST_CASE(nv_to_json_empty)
+{
+	auto nvl = bsd::nv_list();
+	ATF_REQUIRE_EQ("{}"s, to_json(nvl));
+}
+
+TEST_CASE(nv_to_json_scalars)
+{
+	auto nvl = bsd::nv_list();
+	nvl.add_null("null");
+	nvl.add_bool("bool", true);
+	nvl.add_number("number", 18446744073709551615u);
+	nvl.add_string("string", "value");
+
+	ATF_REQUIRE_EQ("{\"null\":null,\"bool\":true,"
+		       "\"number\":18446744073709551615,"
+		       "\"string\":\"value\"}"s,
+		       to_json(nvl));
+}
+
+TEST_CASE(nv_to_json_escape)
+{
+	auto nvl = bsd::nv_list();
+	nvl.add_string("k\"ey", "a\\b\nc\td\x01" "e\xc3\xa9");
+
+	ATF_REQUIRE_EQ("{\"k\\\"ey\":\"a\\\\b\\nc\\td\\u0001e\xc3\xa9\"}"s,
+		       to_json(nvl));
+}
+
+TEST_CASE(nv_to_json_binary)
+{
+	auto nvl = bsd::nv_list();
+	auto const bytes = "foobar"sv;
+	auto data = std::as_bytes(std::span(bytes));
+
+	nvl.add_binary("b0", data.first(0));
+	nvl.add_binary("b1", data.first(1));
+	nvl.add_binary("b2", data.first(2));
+	nvl.add_binary("b6", data);
+
+	ATF_REQUIRE_EQ("{\"b0\":\"\",\"b1\":\"Zg==\",\"b2\":\"Zm8=\","
+		       "\"b6\":\"Zm9vYmFy\"}"s,
+		       to_json(nvl));
+}
+
+TEST_CASE(nv_to_json_nested)
+{
+	auto inner = bsd::nv_list();
+	inner.add_number("x", 1);
+
+	auto nvl = bsd::nv_list();
+	nvl.add_nvlist("inner", inner);
+	nvl.add_number_array("numbers", std::vector<std::uint64_t>{1, 2, 3});
+	nvl.add_string_array("strings", std::vector{"a"sv, "b"sv});
+	nvl.add_bool_array("bools", std::array{true, false});
+	nvl.add_nvlist_array("lists", std::vector{inner, inner});
+
+	ATF_REQUIRE_EQ("{\"inner\":{\"x\":1},\"numbers\":[1,2,3],"
+		       "\"strings\":[\"a\",\"b\"],\"bools\":[true,false],"
+		       "\"lists\":[{\"x\":1},{\"x\":1}]}"s,
+		       to_json(nvl));
+}
+
+TEST_CASE(nv_to_json_buffer)
+{
+	auto nvl = bsd::nv_list();
+	nvl.add_number("n", 42);
+
+	char buf[32] = {};
+	auto *end = bsd::nv_to_json(nvl, buf);
+	ATF_REQUIRE_EQ("{\"n\":42}"sv, std::string_view(buf, end));
+}
+
+TEST_CASE(nv_to_json_format)
+{
+	auto nvl = bsd::nv_list();
+	nvl.add_number("n", 42);
+
+	ATF_REQUIRE_EQ("x={\"n\":42}"s, std::format("x={}", nvl));
+	ATF_REQUIRE_EQ("{\"n\":42}"s,
+		       std::format("{}", bsd::const_nv_list(nvl)));
+}
+
+TEST_CASE(nv_to_json_error)
+{
+	auto nvl = bsd::nv_list();
+	nvl.set_error(std::errc::invalid_argument);
+
+	auto out = std::string();
+	ATF_REQUIRE_THROW(bsd::nv_error_state,
+			  bsd::nv_to_json(nvl, std::back_inserter(out)));
+}
+
+TEST_CASE(nv_from_json_scalars)
+{
+	auto nvl = bsd::nv_from_json(
+		R"( { "n": 18446744073709551615, "s": "value",
+		      "t": true, "f": false, "z": null } )");
+
+	ATF_REQUIRE_EQ(18446744073709551615u, nvl.get_number("n"));
+	ATF_REQUIRE_EQ("value"sv, nvl.get_string("s"));
+	ATF_REQUIRE_EQ(true, nvl.get_bool("t"));
+	ATF_REQUIRE_EQ(false, nvl.get_bool("f"));
+	ATF_REQUIRE_EQ(true, nvl.exists_null("z"));
+}
+
+TEST_CASE(nv_from_json_strings)
+{
+	auto nvl = bsd::nv_from_json(
+		R"({"a\"b": "x\\y\/z\n\u00e9\ud83d\ude00 a long string which )"
+		R"(is scanned several bytes at a time"})");
+
+	ATF_REQUIRE_EQ("x\\y/z\n\xc3\xa9\xf0\x9f\x98\x80 a long string which "
+		       "is scanned several bytes at a time"sv,
+		       nvl.get_string("a\"b"));
+}
+
+TEST_CASE(nv_from_json_nested)
+{
+	auto nvl = bsd::nv_from_json(
+		R"({"inner": {"x": 1, "deeper": {}},
+		    "numbers": [1, 2, 3], "bools": [true, false],
+		    "strings": ["a", "b"], "lists": [{"x": 1}, {"x": 2}],
+		    "empty": []})");
+
+	ATF_REQUIRE_EQ(1, nvl.get_nvlist("inner").get_number("x"));
+	ATF_REQUIRE_EQ(true, nvl.get_nvlist("inner").get_nvlist("deeper").empty());
+
+	auto numbers = nvl.get_number_array("numbers");
+	ATF_REQUIRE_EQ(3, numbers.size());
+	ATF_REQUIRE_EQ(3, numbers[2]);
+
+	auto bools = nvl.get_bool_array("bools");
+	ATF_REQUIRE_EQ(2, bools.size());
+	ATF_REQUIRE_EQ(true, bools[0]);
+
+	auto strings = nvl.get_string_array("strings");
+	ATF_REQUIRE_EQ(2, strings.size());
+	ATF_REQUIRE_EQ("b"sv, strings[1]);
+
+	auto lists = nvl.get_nvlist_array("lists");
+	ATF_REQUIRE_EQ(2, lists.size());
+	ATF_REQUIRE_EQ(2, lists[1].get_number("x"));
+
+	ATF_REQUIRE_EQ(0, nvl.get_number_array("empty").size());
+}
+
+TEST_CASE(nv_from_json_roundtrip)
+{
+	auto nvl = bsd::nv_list();
+	nvl.add_number("n", 42);
+	nvl.add_string("s", "a \"quoted\"\tstring");
+	nvl.add_number_array("a", std::vector<std::uint64_t>{1, 2});
+	auto inner = bsd::nv_list();
+	inner.add_bool("b", true);
+	nvl.add_nvlist("inner", inner);
+
+	ATF_REQUIRE(nvl == bsd::nv_from_json(std::format("{}", nvl)));
+}
+
+TEST_CASE(nv_from_json_duplicate)
+{
+	auto const json = R"({"a": 1, "a": 2})"sv;
+
+	try {
+		(void)bsd::nv_from_json(json);
+		ATF_FAIL("nv_json_error not thrown");
+	} catch (bsd::nv_json_error const &e) {
+		ATF_REQUIRE_EQ(9, e.offset);
+	}
+
+	auto nvl = bsd::nv_from_json(json, NV_FLAG_NO_UNIQUE);
+	ATF_REQUIRE_EQ(false, nvl.empty());
+}
+
+TEST_CASE(nv_from_json_errors)
+{
+	auto const invalid = {
+		R"([1, 2])"sv,			// not an object
+		R"({"a": 1} x)"sv,		// trailing data
+		R"({"a": 1,})"sv,		// trailing comma
+		R"({"a" 1})"sv,			// missing colon
+		R"({"a": "b)"sv,		// unterminated string
+		R"({"a": "\q"})"sv,		// invalid escape
+		R"({"a": "\u0000"})"sv,		// NUL
+		R"({"a": "\ud800"})"sv,		// unpaired surrogate
+		R"({"a": -1})"sv,		// negative
+		R"({"a": 1.5})"sv,		// fraction
+		R"({"a": 1e3})"sv,		// exponent
+		R"({"a": 01})"sv,		// leading zero
+		R"({"a": 18446744073709551616})"sv,	// too large
+		R"({"a": [1, "b"]})"sv,		// mixed array
+		R"({"a": [[1]]})"sv,		// nested array
+		R"({"a": [null]})"sv,		// null in array
+		R"({"a": nul})"sv,		// invalid literal
+		"{\"a\": \"\x01\"}"sv,		// control character
+	};
+
+	for (auto json : invalid)
+		ATF_REQUIRE_THROW(bsd::nv_json_error,
+				  (void)bsd::nv_from_json(json));
+
+	auto deep = std::string();
+	for (auto i = 0; i < 600; ++i)
+		deep += "{\"a\":";
+	deep += "1" + std::string(600, '}');
+	ATF_REQUIRE_THROW(bsd::nv_json_error, (void)bsd::nv_from_json(deep));
+}
+
+ATF_INIT_TEST_CASES(tcs)
+{
+	ATF_ADD_TEST_CASE(tcs, nv_to_json_empty);
+	ATF_ADD_TEST_CASE(tcs, nv_to_json_scalars);
+	ATF_ADD_TEST_CASE(tcs, nv_to_json_escape);
+	ATF_ADD_TEST_CASE(tcs, nv_to_json_binary);
+	ATF_ADD_TEST_CASE(tcs, nv_to_json_nested);
+	ATF_ADD_TEST_CASE(tcs, nv_to_json_buffer);
+	ATF_ADD_TEST_CASE(tcs, nv_to_json_format);
+	ATF_ADD_TEST_CASE(tcs, nv_to_json_error);
+	ATF_ADD_TEST_CASE(tcs, nv_from_json_scalars);
+	ATF_ADD_TEST_CASE(tcs, nv_from_json_strings);
+	ATF_ADD_TEST_CASE(tcs, nv_from_json_nested);
+	ATF_ADD_TEST_CASE(tcs, nv_from_json_roundtrip);
+	ATF_ADD_TEST_CASE(tcs, nv_from_json_duplicate);
+	ATF_ADD_TEST_CASE(tcs, nv_from_json_errors);
+}
@@ -0,0 +1,98 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR MIT
+ * Refer to the file 'LICENSE' in the nvxx distribution for license terms.
+ */
+
+#include <vector>
+
+#include <atf-c++.hpp>
+
+#include "nvxx.h"
+
+#define TEST_CASE(name)				\
+	ATF_TEST_CASE_WITHOUT_HEAD(name)	\
+	ATF_TEST_CASE_BODY(name)
+
+using namespace std::literals;
+
+TEST_CASE(nv_memory_empty)
+{
+	auto nvl = bsd::nv_list();
+	auto usage = nvl.memory_usage();
+
+	ATF_REQUIRE_EQ(1, usage.allocations);
+	ATF_REQUIRE(usage.nodes > 0);
+	ATF_REQUIRE_EQ(0, usage.keys);
+	ATF_REQUIRE_EQ(0, usage.values);
+	ATF_REQUIRE_EQ(0, usage.arrays);
+	ATF_REQUIRE(usage.children.empty());
+	ATF_REQUIRE(usage.total() >= usage.nodes);
+}
+
+TEST_CASE(nv_memory_values)
+{
+	auto nvl = bsd::nv_list();
+	nvl.add_number("num", 42);
+	nvl.add_string("str", "hello");
+	nvl.add_binary("bin", std::vector<std::byte>(1000));
+	nvl.add_number_array("arr", std::vector<std::uint64_t>{1, 2, 3});
+
+	auto usage = nvl.memory_usage();
+
+	// each key is stored with its terminating NUL.
+	ATF_REQUIRE_EQ(16, usage.keys);
+	ATF_REQUIRE_EQ(1006, usage.values);
+	ATF_REQUIRE_EQ(3 * sizeof(std::uint64_t), usage.arrays);
+	// the list, four pairs, the string, the binary and the array.
+	ATF_REQUIRE_EQ(8, usage.allocations);
+	ATF_REQUIRE_EQ(usage.nodes + usage.keys + usage.values
+		       + usage.arrays + usage.overhead, usage.total());
+}
+
+TEST_CASE(nv_memory_string_array)
+{
+	auto nvl = bsd::nv_list();
+	nvl.add_string_array("s", std::vector{"a"sv, "bcd"sv});
+
+	auto usage = nvl.memory_usage();
+	ATF_REQUIRE_EQ(2 * sizeof(char *), usage.arrays);
+	ATF_REQUIRE_EQ(6, usage.values);
+}
+
+TEST_CASE(nv_memory_nested)
+{
+	auto inner = bsd::nv_list();
+	inner.add_binary("data", std::vector<std::byte>(500));
+
+	auto nvl = bsd::nv_list();
+	nvl.add_number("n", 1);
+	nvl.add_nvlist("inner", inner);
+	nvl.add_nvlist_array("list", std::vector{inner, inner});
+
+	auto usage = nvl.memory_usage();
+	ATF_REQUIRE_EQ(2, usage.children.size());
+
+	auto const &[name, child] = usage.children[0];
+	ATF_REQUIRE_EQ("inner"s, name);
+	ATF_REQUIRE_EQ(inner.memory_usage().total(), child.total());
+
+	auto const &[aname, array] = usage.children[1];
+	ATF_REQUIRE_EQ("list"s, aname);
+	ATF_REQUIRE_EQ(2, array.children.size());
+	ATF_REQUIRE_EQ("0"s, array.children[0].first);
+	ATF_REQUIRE_EQ("1"s, array.children[1].first);
+	ATF_REQUIRE_EQ(2 * sizeof(void *), array.arrays);
+	ATF_REQUIRE(array.total() > 2 * child.total());
+
+	// the subtrees are included in the parent.
+	ATF_REQUIRE_EQ(1500, usage.values);
+	ATF_REQUIRE(usage.total() > child.total() + array.total());
+}
+
+ATF_INIT_TEST_CASES(tcs)
+{
+	ATF_ADD_TEST_CASE(tcs, nv_memory_empty);
+	ATF_ADD_TEST_CASE(tcs, nv_memory_values);
+	ATF_ADD_TEST_CASE(tcs, nv_memory_string_array);
+	ATF_ADD_TEST_CASE(tcs, nv_memory_nested);
+}
@@ -0,0 +1,214 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR MIT
+ * Refer to the file 'LICENSE' in the nvxx distribution for license terms.
+ */
+
+#include <atf-c++.hpp>
+
+#include "nvxx.h"
+
+#define TEST_CASE(name)				\
+	ATF_TEST_CASE_WITHOUT_HEAD(name)	\
+	ATF_TEST_CASE_BODY(name)
+
+using namespace std::literals;
+
+namespace {
+
+bsd::nv_list
+make_dst()
+{
+	auto net = bsd::nv_list();
+	net.add_string("address", "192.0.2.1");
+	net.add_number("mtu", 1500);
+
+	auto nvl = bsd::nv_list();
+	nvl.add_string("hostname", "alpha");
+	nvl.add_number("port", 80);
+	nvl.add_nvlist("net", net);
+	return (nvl);
+}
+
+bsd::nv_list
+make_src()
+{
+	auto net = bsd::nv_list();
+	net.add_number("mtu", 9000);
+	net.add_string("gateway", "192.0.2.254");
+
+	auto nvl = bsd::nv_list();
+	nvl.add_number("port", 8080);
+	nvl.add_bool("debug", true);
+	nvl.add_nvlist("net", net);
+	return (nvl);
+}
+
+} // anonymous namespace
+
+TEST_CASE(nv_merge_overwrite)
+{
+	auto dst = make_dst();
+	auto src = make_src();
+
+	bsd::nv_merge(dst, src);
+
+	ATF_REQUIRE_EQ("alpha"sv, dst.get_string("hostname"));
+	ATF_REQUIRE_EQ(8080, dst.get_number("port"));
+	ATF_REQUIRE_EQ(true, dst.get_bool("debug"));
+
+	auto net = dst.get_nvlist("net");
+	ATF_REQUIRE_EQ("192.0.2.1"sv, net.get_string("address"));
+	ATF_REQUIRE_EQ(9000, net.get_number("mtu"));
+	ATF_REQUIRE_EQ("192.0.2.254"sv, net.get_string("gateway"));
+
+	// src was copied from, not modified
+	ATF_REQUIRE_EQ(true, src == make_src());
+}
+
+TEST_CASE(nv_merge_keep)
+{
+	auto dst = make_dst();
+
+	bsd::nv_merge(dst, make_src(), bsd::nv_merge_policy::keep);
+
+	ATF_REQUIRE_EQ(80, dst.get_number("port"));
+	ATF_REQUIRE_EQ(true, dst.get_bool("debug"));
+	ATF_REQUIRE_EQ(1500, dst.get_nvlist("net").get_number("mtu"));
+	ATF_REQUIRE_EQ("192.0.2.254"sv,
+		       dst.get_nvlist("net").get_string("gateway"));
+}
+
+TEST_CASE(nv_merge_error)
+{
+	auto dst = make_dst();
+	ATF_REQUIRE_THROW(bsd::nv_key_exists,
+			  bsd::nv_merge(dst, make_src(),
+					bsd::nv_merge_policy::error));
+
+	// the conflict is inside "net", which must not be lost.
+	ATF_REQUIRE_EQ(true, dst.exists_nvlist("net"));
+	auto net = dst.get_nvlist("net");
+	ATF_REQUIRE_EQ("192.0.2.1"sv, net.get_string("address"));
+	ATF_REQUIRE_EQ(1500, net.get_number("mtu"));
+
+	// no conflicts, so no error
+	auto other = bsd::nv_list();
+	other.add_string("extra", "value");
+	bsd::nv_merge(dst, other, bsd::nv_merge_policy::error);
+	ATF_REQUIRE_EQ("value"sv, dst.get_string("extra"));
+}
+
+TEST_CASE(nv_merge_callback)
+{
+	auto dst = make_dst();
+	auto calls = 0;
+
+	bsd::nv_merge(dst, make_src(),
+		      [&] (std::string_view key,
+			   bsd::nv_list_value_t const &dval,
+			   bsd::nv_list_value_t const &sval) {
+			++calls;
+			// keep the larger of two numbers
+			if (key == "mtu")
+				return (std::get<std::uint64_t>(dval)
+					< std::get<std::uint64_t>(sval)
+					? bsd::nv_merge_policy::overwrite
+					: bsd::nv_merge_policy::keep);
+			return (bsd::nv_merge_policy::keep);
+		      });
+
+	// "port" and "net.mtu" conflict; "net" is merged recursively.
+	ATF_REQUIRE_EQ(2, calls);
+	ATF_REQUIRE_EQ(80, dst.get_number("port"));
+	ATF_REQUIRE_EQ(9000, dst.get_nvlist("net").get_number("mtu"));
+}
+
+TEST_CASE(nv_merge_type_conflict)
+{
+	auto dst = bsd::nv_list();
+	dst.add_number("key", 1);
+	auto src = bsd::nv_list();
+	src.add_nvlist("key", bsd::nv_list());
+
+	// an nvlist only merges with another nvlist
+	bsd::nv_merge(dst, src);
+	ATF_REQUIRE_EQ(true, dst.exists_nvlist("key"));
+	ATF_REQUIRE_EQ(false, dst.exists_number("key"));
+}
+
+TEST_CASE(nv_merge_move)
+{
+	auto dst = make_dst();
+	auto src = make_src();
+
+	bsd::nv_merge(dst, std::move(src), bsd::nv_merge_policy::keep);
+
+	ATF_REQUIRE_EQ(true, dst.get_bool("debug"));
+	ATF_REQUIRE_EQ("192.0.2.254"sv,
+		       dst.get_nvlist("net").get_string("gateway"));
+
+	// values which were kept in dst are left in src
+	ATF_REQUIRE_EQ(8080, src.get_number("port"));
+	ATF_REQUIRE_EQ(false, src.exists("debug"));
+}
+
+TEST_CASE(nv_merge_error_state)
+{
+	auto dst = make_dst();
+	auto src = make_src();
+	src.set_error(std::errc::invalid_argument);
+
+	ATF_REQUIRE_THROW(bsd::nv_error_state, bsd::nv_merge(dst, src));
+}
+
+TEST_CASE(nv_merge_self)
+{
+	auto dst = make_dst();
+
+	bsd::nv_merge(dst, dst);
+	ATF_REQUIRE_EQ(true, dst == make_dst());
+
+	bsd::nv_merge(dst, std::move(dst));
+	ATF_REQUIRE_EQ(true, dst == make_dst());
+}
+
+TEST_CASE(nv_merge_child)
+{
+	/*
+	 * The child has a "child" key which is not an nvlist, so merging it
+	 * into its parent replaces the child itself.
+	 */
+	auto dst = make_dst();
+	auto child = bsd::nv_list();
+	child.add_string("child", "replaced");
+	child.add_number("mtu", 9000);
+	dst.add_nvlist("child", child);
+
+	bsd::nv_merge(dst, dst.get_nvlist("child"));
+
+	ATF_REQUIRE_EQ("replaced"sv, dst.get_string("child"));
+	ATF_REQUIRE_EQ(9000, dst.get_number("mtu"));
+
+	dst.add_nvlist("nested", child);
+
+	// a nested list can't be moved from.
+	auto nested = bsd::nv_list(
+		const_cast<::nvlist_t *>(dst.get_nvlist("nested").ptr()));
+	ATF_REQUIRE_THROW(std::system_error,
+			  bsd::nv_merge(dst, std::move(nested)));
+	std::ignore = std::move(nested).release();
+	ATF_REQUIRE_EQ("replaced"sv, dst.get_string("child"));
+}
+
+ATF_INIT_TEST_CASES(tcs)
+{
+	ATF_ADD_TEST_CASE(tcs, nv_merge_overwrite);
+	ATF_ADD_TEST_CASE(tcs, nv_merge_keep);
+	ATF_ADD_TEST_CASE(tcs, nv_merge_error);
+	ATF_ADD_TEST_CASE(tcs, nv_merge_callback);
+	ATF_ADD_TEST_CASE(tcs, nv_merge_type_conflict);
+	ATF_ADD_TEST_CASE(tcs, nv_merge_move);
+	ATF_ADD_TEST_CASE(tcs, nv_merge_error_state);
+	ATF_ADD_TEST_CASE(tcs, nv_merge_self);
+	ATF_ADD_TEST_CASE(tcs, nv_merge_child);
+}
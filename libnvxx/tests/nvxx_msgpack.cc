@@ -0,0 +1,240 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR MIT
+ * Refer to the file 'LICENSE' in the nvxx distribution for license terms.
+ */
+
+#include <array>
+#include <initializer_list>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <atf-c++.hpp>
+
+#include "nvxx.h"
+
+#define TEST_CASE(name)				\
+	ATF_TEST_CASE_WITHOUT_HEAD(name)	\
+	ATF_TEST_CASE_BODY(name)
+
+using namespace std::literals;
+
+namespace {
+
+std::vector<std::byte>
+bytes(std::initializer_list<unsigned> values)
+{
+	auto ret = std::vector<std::byte>();
+	for (auto v : values)
+		ret.push_back(static_cast<std::byte>(v));
+	return (ret);
+}
+
+std::vector<std::byte>
+to_msgpack(bsd::const_nv_list const &nvl)
+{
+	auto ret = std::vector<std::byte>();
+	bsd::nv_to_msgpack(nvl, std::back_inserter(ret));
+	return (ret);
+}
+
+} // anonymous namespace
+
+TEST_CASE(nv_to_msgpack_empty)
+{
+	auto nvl = bsd::nv_list();
+	ATF_REQUIRE(bytes({0x80}) == to_msgpack(nvl));
+}
+
+TEST_CASE(nv_to_msgpack_scalars)
+{
+	auto nvl = bsd::nv_list();
+	nvl.add_null("z");
+	nvl.add_bool("t", true);
+	nvl.add_number("a", 127);
+	nvl.add_number("b", 256);
+	nvl.add_number("c", 4294967296);
+	nvl.add_string("s", "ab");
+	nvl.add_binary("x", std::as_bytes(std::span("\x01\xff"sv)));
+
+	ATF_REQUIRE(bytes({0x87,
+			   0xa1, 'z', 0xc0,
+			   0xa1, 't', 0xc3,
+			   0xa1, 'a', 0x7f,
+			   0xa1, 'b', 0xcd, 0x01, 0x00,
+			   0xa1, 'c', 0xcf, 0, 0, 0, 1, 0, 0, 0, 0,
+			   0xa1, 's', 0xa2, 'a', 'b',
+			   0xa1, 'x', 0xc4, 0x02, 0x01, 0xff})
+		    == to_msgpack(nvl));
+}
+
+TEST_CASE(nv_to_msgpack_nested)
+{
+	auto inner = bsd::nv_list();
+	inner.add_number("x", 1);
+
+	auto nvl = bsd::nv_list();
+	nvl.add_nvlist("i", inner);
+	nvl.add_number_array("n", std::vector<std::uint64_t>{1, 200});
+	nvl.add_bool_array("b", std::array{true, false});
+	nvl.add_nvlist_array("l", std::vector{inner});
+
+	ATF_REQUIRE(bytes({0x84,
+			   0xa1, 'i', 0x81, 0xa1, 'x', 0x01,
+			   0xa1, 'n', 0x92, 0x01, 0xcc, 0xc8,
+			   0xa1, 'b', 0x92, 0xc3, 0xc2,
+			   0xa1, 'l', 0x91, 0x81, 0xa1, 'x', 0x01})
+		    == to_msgpack(nvl));
+}
+
+TEST_CASE(nv_to_msgpack_long)
+{
+	auto nvl = bsd::nv_list();
+	nvl.add_string("s", std::string(300, 'a'));
+
+	auto const data = to_msgpack(nvl);
+	ATF_REQUIRE_EQ(3 + 3 + 300, data.size());
+	ATF_REQUIRE(bytes({0x81, 0xa1, 's', 0xda, 0x01, 0x2c})
+		    == std::vector(data.begin(), data.begin() + 6));
+}
+
+TEST_CASE(nv_to_msgpack_error)
+{
+	auto nvl = bsd::nv_list();
+	nvl.set_error(std::errc::invalid_argument);
+
+	auto out = std::vector<std::byte>();
+	ATF_REQUIRE_THROW(bsd::nv_error_state,
+			  bsd::nv_to_msgpack(nvl, std::back_inserter(out)));
+}
+
+TEST_CASE(nv_from_msgpack_scalars)
+{
+	auto nvl = bsd::nv_from_msgpack(bytes({
+		0x86,
+		0xa1, 'z', 0xc0,
+		0xa1, 'f', 0xc2,
+		0xa1, 'n', 0xcf, 0xff, 0xff, 0xff, 0xff,
+				 0xff, 0xff, 0xff, 0xff,
+		0xa1, 'i', 0xd1, 0x01, 0x00,
+		0xa1, 's', 0xd9, 0x03, 'a', 'b', 'c',
+		0xa1, 'x', 0xc5, 0x00, 0x01, 0x2a}));
+
+	ATF_REQUIRE_EQ(true, nvl.exists_null("z"));
+	ATF_REQUIRE_EQ(false, nvl.get_bool("f"));
+	ATF_REQUIRE_EQ(18446744073709551615u, nvl.get_number("n"));
+	ATF_REQUIRE_EQ(256, nvl.get_number("i"));
+	ATF_REQUIRE_EQ("abc"sv, nvl.get_string("s"));
+
+	auto const bin = nvl.get_binary("x");
+	ATF_REQUIRE_EQ(1, bin.size());
+	ATF_REQUIRE_EQ(0x2a, std::to_integer<int>(bin[0]));
+}
+
+TEST_CASE(nv_from_msgpack_nested)
+{
+	auto nvl = bsd::nv_from_msgpack(bytes({
+		0x85,
+		0xa1, 'i', 0x81, 0xa1, 'x', 0x01,
+		0xa1, 'n', 0x93, 0x01, 0x02, 0x03,
+		0xa1, 's', 0x92, 0xa1, 'a', 0xa1, 'b',
+		0xa1, 'l', 0x92, 0x81, 0xa1, 'x', 0x01,
+				 0x81, 0xa1, 'x', 0x02,
+		0xa1, 'e', 0x90}));
+
+	ATF_REQUIRE_EQ(1, nvl.get_nvlist("i").get_number("x"));
+
+	auto numbers = nvl.get_number_array("n");
+	ATF_REQUIRE_EQ(3, numbers.size());
+	ATF_REQUIRE_EQ(3, numbers[2]);
+
+	auto strings = nvl.get_string_array("s");
+	ATF_REQUIRE_EQ(2, strings.size());
+	ATF_REQUIRE_EQ("b"sv, strings[1]);
+
+	auto lists = nvl.get_nvlist_array("l");
+	ATF_REQUIRE_EQ(2, lists.size());
+	ATF_REQUIRE_EQ(2, lists[1].get_number("x"));
+
+	ATF_REQUIRE_EQ(0, nvl.get_number_array("e").size());
+}
+
+TEST_CASE(nv_from_msgpack_roundtrip)
+{
+	auto inner = bsd::nv_list();
+	inner.add_bool("b", true);
+
+	auto nvl = bsd::nv_list();
+	nvl.add_number("n", 70000);
+	nvl.add_string("s", std::string(40, 'x'));
+	nvl.add_binary("x", std::as_bytes(std::span("binary"sv)));
+	nvl.add_number_array("a", std::vector<std::uint64_t>{1, 1u << 20});
+	nvl.add_string_array("sa", std::vector{"a"sv, "b"sv});
+	nvl.add_nvlist("inner", inner);
+	nvl.add_nvlist_array("la", std::vector{inner, inner});
+
+	ATF_REQUIRE(nvl == bsd::nv_from_msgpack(to_msgpack(nvl)));
+}
+
+TEST_CASE(nv_from_msgpack_duplicate)
+{
+	auto const data = bytes({0x82, 0xa1, 'a', 0x01, 0xa1, 'a', 0x02});
+
+	try {
+		(void)bsd::nv_from_msgpack(data);
+		ATF_FAIL("nv_msgpack_error not thrown");
+	} catch (bsd::nv_msgpack_error const &e) {
+		ATF_REQUIRE_EQ(4, e.offset);
+	}
+
+	auto nvl = bsd::nv_from_msgpack(data, NV_FLAG_NO_UNIQUE);
+	ATF_REQUIRE_EQ(false, nvl.empty());
+}
+
+TEST_CASE(nv_from_msgpack_errors)
+{
+	auto const invalid = {
+		bytes({0x91, 0x01}),			// not a map
+		bytes({0x80, 0x00}),			// trailing data
+		bytes({0x81, 0x01, 0x01}),		// non-string key
+		bytes({0x81, 0xa1, 'a'}),		// missing value
+		bytes({0x81, 0xa1, 'a', 0xa3, 'b'}),	// short string
+		bytes({0x81, 0xa1, 'a', 0xa1, 0x00}),	// NUL
+		bytes({0x81, 0xa1, 'a', 0xff}),		// negative fixint
+		bytes({0x81, 0xa1, 'a', 0xd0, 0x80}),	// negative int 8
+		bytes({0x81, 0xa1, 'a', 0xca, 0, 0, 0, 0}),	// float
+		bytes({0x81, 0xa1, 'a', 0xd4, 0x01, 0x00}),	// fixext
+		bytes({0x81, 0xa1, 'a', 0xc1}),		// never used
+		bytes({0x81, 0xa1, 'a', 0x92, 0x01, 0xc3}),	// mixed array
+		bytes({0x81, 0xa1, 'a', 0x91, 0x90}),	// nested array
+		bytes({0x81, 0xa1, 'a', 0x91, 0xc0}),	// nil in array
+		bytes({0x81, 0xa1, 'a', 0xdd, 0xff, 0xff, 0xff, 0xff}),
+							// huge array
+	};
+
+	for (auto const &data : invalid)
+		ATF_REQUIRE_THROW(bsd::nv_msgpack_error,
+				  (void)bsd::nv_from_msgpack(data));
+
+	auto deep = std::vector<std::byte>();
+	for (auto i = 0; i < 600; ++i)
+		deep.insert(deep.end(), {std::byte{0x81}, std::byte{0xa1},
+					 std::byte{'a'}});
+	deep.push_back(std::byte{0x01});
+	ATF_REQUIRE_THROW(bsd::nv_msgpack_error,
+			  (void)bsd::nv_from_msgpack(deep));
+}
+
+ATF_INIT_TEST_CASES(tcs)
+{
+	ATF_ADD_TEST_CASE(tcs, nv_to_msgpack_empty);
+	ATF_ADD_TEST_CASE(tcs, nv_to_msgpack_scalars);
+	ATF_ADD_TEST_CASE(tcs, nv_to_msgpack_nested);
+	ATF_ADD_TEST_CASE(tcs, nv_to_msgpack_long);
+	ATF_ADD_TEST_CASE(tcs, nv_to_msgpack_error);
+	ATF_ADD_TEST_CASE(tcs, nv_from_msgpack_scalars);
+	ATF_ADD_TEST_CASE(tcs, nv_from_msgpack_nested);
+	ATF_ADD_TEST_CASE(tcs, nv_from_msgpack_roundtrip);
+	ATF_ADD_TEST_CASE(tcs, nv_from_msgpack_duplicate);
+	ATF_ADD_TEST_CASE(tcs, nv_from_msgpack_errors);
+}
@@ -268,6 +268,266 @@ TEST_CASE(nv_nested_serialize)
 	ATF_REQUIRE_EQ(obj.obj.value, obj2.obj.value);
 }
 
+/*
+ * nv_pack()
+ */
+
+struct object3 {
+	bool bool_value{};
+	std::vector<bool> bool_array;
+	std::string string_value;
+	std::vector<std::string> string_array;
+	std::optional<std::uint64_t> present;
+	std::optional<std::uint64_t> absent;
+	nv_list list = nv_list();
+	object1 obj;
+};
+
+template<>
+struct bsd::nv_schema<object3> {
+	auto get() {
+		return bsd::nv_literal("object type", "object3")
+			>> bsd::nv_field("bool", &object3::bool_value)
+			>> bsd::nv_field("bool array", &object3::bool_array)
+			>> bsd::nv_field("string", &object3::string_value)
+			>> bsd::nv_field("string array", &object3::string_array)
+			>> bsd::nv_field("present", &object3::present)
+			>> bsd::nv_field("absent", &object3::absent)
+			>> bsd::nv_field("list", &object3::list)
+			>> bsd::nv_object("obj", &object3::obj);
+	}
+};
+
+namespace {
+
+object3
+make_object3()
+{
+	auto inner = nv_list();
+	inner.add_number("number", 1);
+	inner.add_string_array("strings",
+			       std::vector<std::string_view>{"x", "yz"});
+
+	auto list = nv_list();
+	list.add_null("null");
+	list.add_binary("binary", std::as_bytes(std::span("data", 4)));
+	list.add_nvlist("inner", inner);
+	list.add_nvlist("empty", nv_list());
+
+	return (object3{
+		.bool_value = true,
+		.bool_array = {true, false, true},
+		.string_value = "a string",
+		.string_array = {"a", "", "bc"},
+		.present = 42,
+		.absent = {},
+		.list = std::move(list),
+		.obj = {666},
+	});
+}
+
+} // anonymous namespace
+
+TEST_CASE(nv_pack)
+{
+	auto obj = object{42, "quux", {42, 666, 1024}};
+
+	auto data = bsd::nv_pack(obj);
+	ATF_REQUIRE_EQ(bsd::nv_packed_size(obj), data.size());
+	ATF_REQUIRE(bsd::nv_serialize(obj).pack() == data);
+}
+
+TEST_CASE(nv_pack_types)
+{
+	auto obj = make_object3();
+
+	auto data = bsd::nv_pack(obj);
+	ATF_REQUIRE_EQ(bsd::nv_packed_size(obj), data.size());
+	ATF_REQUIRE(bsd::nv_serialize(obj).pack() == data);
+
+	auto obj2 = object3{};
+	bsd::nv_deserialize(nv_list::unpack(data), obj2);
+	ATF_REQUIRE_EQ(true, std::ranges::equal(obj.bool_array,
+						obj2.bool_array));
+	ATF_REQUIRE_EQ(obj.string_value, obj2.string_value);
+	ATF_REQUIRE_EQ(true, std::ranges::equal(obj.string_array,
+						obj2.string_array));
+	ATF_REQUIRE_EQ(42, *obj2.present);
+	ATF_REQUIRE_EQ(false, obj2.absent.has_value());
+	ATF_REQUIRE(obj.list == obj2.list);
+	ATF_REQUIRE_EQ(666, obj2.obj.value);
+}
+
+TEST_CASE(nv_pack_schema)
+{
+	auto test_schema =
+		bsd::nv_literal("object type", "test object")
+		>> bsd::nv_field("value", &::object::int_value);
+	auto obj = object{42, "quux", {}};
+
+	ATF_REQUIRE(bsd::nv_serialize(obj, test_schema).pack()
+		    == bsd::nv_pack(obj, test_schema));
+}
+
+TEST_CASE(nv_pack_buffer)
+{
+	auto obj = object{42, "quux", {42, 666, 1024}};
+	auto const size = bsd::nv_packed_size(obj);
+
+	auto buf = std::vector<std::byte>(size + 16);
+	auto used = bsd::nv_pack(obj, buf);
+	ATF_REQUIRE_EQ(buf.data(), used.data());
+	ATF_REQUIRE_EQ(size, used.size());
+	ATF_REQUIRE(std::ranges::equal(bsd::nv_pack(obj), used));
+
+	auto small = std::vector<std::byte>(size - 1);
+	ATF_REQUIRE_THROW(std::system_error, (void)bsd::nv_pack(obj, small));
+}
+
+TEST_CASE(nv_pack_unsupported)
+{
+	auto obj = make_object3();
+	obj.list.add_descriptor("fd", 0);
+	ATF_REQUIRE_THROW(std::system_error, (void)bsd::nv_pack(obj));
+
+	obj = make_object3();
+	obj.string_value = std::string("a\0b", 3);
+	ATF_REQUIRE_THROW(std::runtime_error, (void)bsd::nv_pack(obj));
+}
+
+/*
+ * nv_unpack_into()
+ */
+
+TEST_CASE(nv_unpack_into)
+{
+	auto obj = object{42, "quux", {42, 666, 1024}};
+
+	auto obj2 = object{};
+	bsd::nv_unpack_into(obj2, bsd::nv_pack(obj));
+	ATF_REQUIRE_EQ(42, obj2.int_value);
+	ATF_REQUIRE_EQ("quux", obj2.string_value);
+	ATF_REQUIRE_EQ(true, std::ranges::equal(obj2.array_value,
+						obj.array_value));
+
+	auto obj3 = object{};
+	bsd::nv_unpack_into(obj3, bsd::nv_serialize(obj).pack());
+	ATF_REQUIRE_EQ(42, obj3.int_value);
+	ATF_REQUIRE_EQ("quux", obj3.string_value);
+	ATF_REQUIRE_EQ(true, std::ranges::equal(obj3.array_value,
+						obj.array_value));
+}
+
+TEST_CASE(nv_unpack_into_types)
+{
+	auto obj = make_object3();
+
+	auto obj2 = object3{};
+	obj2.absent = 1;
+	bsd::nv_unpack_into(obj2, bsd::nv_pack(obj));
+	ATF_REQUIRE_EQ(true, obj2.bool_value);
+	ATF_REQUIRE_EQ(true, std::ranges::equal(obj.bool_array,
+						obj2.bool_array));
+	ATF_REQUIRE_EQ(obj.string_value, obj2.string_value);
+	ATF_REQUIRE_EQ(true, std::ranges::equal(obj.string_array,
+						obj2.string_array));
+	ATF_REQUIRE_EQ(42, *obj2.present);
+	ATF_REQUIRE_EQ(false, obj2.absent.has_value());
+	ATF_REQUIRE(obj.list == obj2.list);
+	ATF_REQUIRE_EQ(666, obj2.obj.value);
+}
+
+TEST_CASE(nv_unpack_into_unknown)
+{
+	auto inner = nv_list();
+	inner.add_string("string", "inner");
+
+	auto nvl = nv_list();
+	nvl.add_bool("before", true);
+	nvl.add_nvlist("list", inner);
+	nvl.add_number("value", 42);
+	nvl.add_string_array("after", std::vector<std::string_view>{"a"});
+
+	auto obj = object1{};
+	bsd::nv_unpack_into(obj, nvl.pack());
+	ATF_REQUIRE_EQ(42, obj.value);
+}
+
+TEST_CASE(nv_unpack_into_missing)
+{
+	auto test_schema =
+		bsd::nv_literal("object type", "test object")
+		>> bsd::nv_field("value", &::object::int_value);
+	auto obj = object{};
+
+	auto nvl = bsd::nv_list();
+	nvl.add_number("value", 42u);
+	ATF_REQUIRE_THROW(bsd::nv_key_not_found,
+			  bsd::nv_unpack_into(obj, nvl.pack(), test_schema));
+
+	nvl.add_string("object type", "another object");
+	ATF_REQUIRE_THROW(bsd::nv_key_not_found,
+			  bsd::nv_unpack_into(obj, nvl.pack(), test_schema));
+
+	auto nvl2 = bsd::nv_list();
+	nvl2.add_string("object type", "test object");
+	nvl2.add_string("value", "42");
+	ATF_REQUIRE_THROW(bsd::nv_key_not_found,
+			  bsd::nv_unpack_into(obj, nvl2.pack(), test_schema));
+}
+
+TEST_CASE(nv_unpack_into_invalid)
+{
+	auto nvl = nv_list();
+	nvl.add_number("value", 42);
+	nvl.add_bool("b", true);
+
+	/*
+	 * The header is at 0, the "value" pair header at 19, its name at 38,
+	 * its data at 44, and the "b" pair header at 52, its name at 71 and
+	 * its data at 73.
+	 */
+	auto const data = nvl.pack();
+	ATF_REQUIRE_EQ(74, data.size());
+
+	auto invalid = std::vector<std::vector<std::byte>>();
+	auto change = [&] (auto &&fn) {
+		auto copy = data;
+		fn(copy);
+		invalid.push_back(std::move(copy));
+	};
+
+	change([] (auto &d) { d.clear(); });
+	change([] (auto &d) { d.pop_back(); });
+	change([] (auto &d) { d.push_back(std::byte{0}); });
+	change([] (auto &d) { d[0] = std::byte{0}; });	// magic
+	change([] (auto &d) { d[19] = std::byte{99}; });	// type
+	change([] (auto &d) { d[43] = std::byte{'x'}; });	// name NUL
+	change([] (auto &d) { d[73] = std::byte{2}; });	// bool value
+	change([] (auto &d) {					// data size
+		std::ranges::fill(std::span(d).subspan(22, 8),
+				  std::byte{0xff});
+	});
+
+	for (auto const &bad : invalid) {
+		auto obj = object1{};
+		ATF_REQUIRE_THROW(std::system_error,
+				  bsd::nv_unpack_into(obj, bad));
+	}
+
+	// a field which appears twice.
+	auto dup = nv_list(NV_FLAG_NO_UNIQUE);
+	dup.add_number("value", 1);
+	dup.add_number("value", 2);
+
+	auto dupdata = dup.pack();
+	dupdata[2] &= ~std::byte{NV_FLAG_NO_UNIQUE};
+
+	auto obj = object1{};
+	ATF_REQUIRE_THROW(std::system_error,
+			  bsd::nv_unpack_into(obj, dupdata));
+}
+
 ATF_INIT_TEST_CASES(tcs)
 {
 	ATF_ADD_TEST_CASE(tcs, nv_encoder_bool);
@@ -288,4 +548,16 @@ ATF_INIT_TEST_CASES(tcs)
 	ATF_ADD_TEST_CASE(tcs, nv_serialize_literal);
 	ATF_ADD_TEST_CASE(tcs, nv_deserialize_bad_literal);
 	ATF_ADD_TEST_CASE(tcs, nv_nested_serialize);
+
+	ATF_ADD_TEST_CASE(tcs, nv_pack);
+	ATF_ADD_TEST_CASE(tcs, nv_pack_types);
+	ATF_ADD_TEST_CASE(tcs, nv_pack_schema);
+	ATF_ADD_TEST_CASE(tcs, nv_pack_buffer);
+	ATF_ADD_TEST_CASE(tcs, nv_pack_unsupported);
+
+	ATF_ADD_TEST_CASE(tcs, nv_unpack_into);
+	ATF_ADD_TEST_CASE(tcs, nv_unpack_into_types);
+	ATF_ADD_TEST_CASE(tcs, nv_unpack_into_unknown);
+	ATF_ADD_TEST_CASE(tcs, nv_unpack_into_missing);
+	ATF_ADD_TEST_CASE(tcs, nv_unpack_into_invalid);
 }
@@ -0,0 +1,113 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR MIT
+ * Refer to the file 'LICENSE' in the nvxx distribution for license terms.
+ */
+
+#include <thread>
+#include <vector>
+
+#include <atf-c++.hpp>
+
+#include "nvxx.h"
+
+#define TEST_CASE(name)				\
+	ATF_TEST_CASE_WITHOUT_HEAD(name)	\
+	ATF_TEST_CASE_BODY(name)
+
+TEST_CASE(nv_shared_list_copy)
+{
+	auto nvl = bsd::nv_list();
+	nvl.add_number("value", 42);
+
+	auto shared = bsd::nv_shared_list(std::move(nvl));
+	ATF_REQUIRE_EQ(1, shared.use_count());
+	ATF_REQUIRE_EQ(true, shared.unique());
+
+	auto copy = shared;
+	ATF_REQUIRE_EQ(2, shared.use_count());
+	ATF_REQUIRE_EQ(false, copy.unique());
+	ATF_REQUIRE_EQ(shared.ptr(), copy.ptr());
+	ATF_REQUIRE_EQ(42, copy.get().get_number("value"));
+}
+
+TEST_CASE(nv_shared_list_edit_shared)
+{
+	auto shared = bsd::nv_shared_list();
+	shared.edit().add_number("value", 1);
+
+	auto copy = shared;
+	auto const *old = shared.ptr();
+
+	copy.edit().add_number("other", 2);
+	ATF_REQUIRE(copy.ptr() != old);
+	ATF_REQUIRE_EQ(old, shared.ptr());
+
+	ATF_REQUIRE_EQ(true, shared.unique());
+	ATF_REQUIRE_EQ(true, copy.unique());
+	ATF_REQUIRE_EQ(false, shared.get().exists("other"));
+	ATF_REQUIRE_EQ(1, copy.get().get_number("value"));
+	ATF_REQUIRE_EQ(2, copy.get().get_number("other"));
+}
+
+TEST_CASE(nv_shared_list_edit_unique)
+{
+	auto shared = bsd::nv_shared_list();
+	auto const *old = shared.ptr();
+
+	shared.edit().add_number("value", 1);
+	ATF_REQUIRE_EQ(old, shared.ptr());
+
+	{
+		auto copy = shared;
+	}
+
+	shared.edit().add_number("other", 2);
+	ATF_REQUIRE_EQ(old, shared.ptr());
+}
+
+TEST_CASE(nv_shared_list_move)
+{
+	auto shared = bsd::nv_shared_list();
+	auto moved = std::move(shared);
+
+	ATF_REQUIRE_EQ(0, shared.use_count());
+	ATF_REQUIRE_EQ(1, moved.use_count());
+	ATF_REQUIRE_THROW(std::logic_error, (void)shared.get());
+
+	shared = moved;
+	ATF_REQUIRE_EQ(2, moved.use_count());
+}
+
+TEST_CASE(nv_shared_list_threads)
+{
+	auto nvl = bsd::nv_list();
+	nvl.add_number("value", 42);
+	auto shared = bsd::nv_shared_list(std::move(nvl));
+
+	auto threads = std::vector<std::thread>();
+	for (auto t = 0u; t < 4; ++t) {
+		threads.emplace_back([copy = shared] () mutable {
+			for (auto i = 0u; i < 1000; ++i) {
+				auto local = copy;
+				ATF_REQUIRE_EQ(42,
+					local.get().get_number("value"));
+			}
+			copy.edit().add_number("thread", 1);
+		});
+	}
+
+	for (auto &thread : threads)
+		thread.join();
+
+	ATF_REQUIRE_EQ(1, shared.use_count());
+	ATF_REQUIRE_EQ(false, shared.get().exists("thread"));
+}
+
+ATF_INIT_TEST_CASES(tcs)
+{
+	ATF_ADD_TEST_CASE(tcs, nv_shared_list_copy);
+	ATF_ADD_TEST_CASE(tcs, nv_shared_list_edit_shared);
+	ATF_ADD_TEST_CASE(tcs, nv_shared_list_edit_unique);
+	ATF_ADD_TEST_CASE(tcs, nv_shared_list_move);
+	ATF_ADD_TEST_CASE(tcs, nv_shared_list_threads);
+}
@@ -0,0 +1,89 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR MIT
+ * Refer to the file 'LICENSE' in the nvxx distribution for license terms.
+ */
+
+#include <thread>
+
+#include <atf-c++.hpp>
+
+#include "nvxx.h"
+
+#define TEST_CASE(name)				\
+	ATF_TEST_CASE_WITHOUT_HEAD(name)	\
+	ATF_TEST_CASE_BODY(name)
+
+using namespace std::literals;
+
+TEST_CASE(nv_stats_op_name)
+{
+	ATF_REQUIRE_EQ("get"sv, bsd::nv_stats_op_name(bsd::nv_stats_op::get));
+	ATF_REQUIRE_EQ("serialize"sv,
+		       bsd::nv_stats_op_name(bsd::nv_stats_op::serialize));
+}
+
+TEST_CASE(nv_stats_reset)
+{
+	auto nvl = bsd::nv_list();
+	nvl.add_number("n", 42);
+	(void)nvl.pack();
+
+	bsd::nv_stats_reset();
+
+	auto stats = bsd::nv_stats_get();
+	for (auto const &c : stats.counters) {
+		ATF_REQUIRE_EQ(0, c.calls);
+		ATF_REQUIRE_EQ(0, c.allocs);
+		ATF_REQUIRE_EQ(0, c.bytes);
+	}
+}
+
+TEST_CASE(nv_stats_pack)
+{
+	auto nvl = bsd::nv_list();
+	nvl.add_number("n", 42);
+
+	bsd::nv_stats_reset();
+	auto bytes = nvl.pack();
+	auto stats = bsd::nv_stats_get()[bsd::nv_stats_op::pack];
+
+	if (bsd::nv_stats_enabled()) {
+		ATF_REQUIRE_EQ(1, stats.calls);
+		ATF_REQUIRE_EQ(1, stats.allocs);
+		ATF_REQUIRE_EQ(bytes.size(), stats.bytes);
+	} else {
+		// with statistics disabled, nothing is ever counted.
+		ATF_REQUIRE_EQ(0, stats.calls);
+		ATF_REQUIRE_EQ(0, stats.allocs);
+		ATF_REQUIRE_EQ(0, stats.bytes);
+	}
+}
+
+TEST_CASE(nv_stats_thread)
+{
+	if (!bsd::nv_stats_enabled())
+		ATF_SKIP("library built without NVXX_STATS");
+
+	bsd::nv_stats_reset();
+
+	// counts from a thread which has exited are kept.
+	auto thr = std::thread([] {
+		auto nvl = bsd::nv_list();
+		for (auto i = 0u; i < 5; ++i)
+			nvl.add_number(std::format("n{}", i), i);
+	});
+	thr.join();
+
+	auto nvl = bsd::nv_list();
+	nvl.add_bool("b", true);
+
+	ATF_REQUIRE_EQ(6, bsd::nv_stats_get()[bsd::nv_stats_op::add].calls);
+}
+
+ATF_INIT_TEST_CASES(tcs)
+{
+	ATF_ADD_TEST_CASE(tcs, nv_stats_op_name);
+	ATF_ADD_TEST_CASE(tcs, nv_stats_reset);
+	ATF_ADD_TEST_CASE(tcs, nv_stats_pack);
+	ATF_ADD_TEST_CASE(tcs, nv_stats_thread);
+}
@@ -0,0 +1,121 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR MIT
+ * Refer to the file 'LICENSE' in the nvxx distribution for license terms.
+ */
+
+#include <vector>
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <atf-c++.hpp>
+
+#include "nvxx.h"
+
+#define TEST_CASE(name)				\
+	ATF_TEST_CASE_WITHOUT_HEAD(name)	\
+	ATF_TEST_CASE_BODY(name)
+
+using namespace std::literals;
+
+TEST_CASE(nv_trace_histogram)
+{
+	auto nvl = bsd::nv_list();
+	nvl.add_string("key", "value");
+
+	bsd::nv_trace_reset();
+	bsd::nv_trace_enable();
+	for (auto i = 0; i < 100; ++i)
+		(void)nvl.pack();
+	bsd::nv_trace_enable(false);
+
+	auto lat = bsd::nv_trace_get(bsd::nv_trace_op::pack);
+	ATF_REQUIRE_EQ(100, lat.count);
+	ATF_REQUIRE(lat.min <= lat.p50);
+	ATF_REQUIRE(lat.p50 <= lat.p99);
+	ATF_REQUIRE(lat.p99 <= lat.p999);
+	ATF_REQUIRE(lat.p999 <= lat.max);
+	ATF_REQUIRE_EQ(lat.p50.count(), bsd::nv_trace_percentile(
+		bsd::nv_trace_op::pack, 0.5).count());
+
+	// nothing else was traced.
+	ATF_REQUIRE_EQ(0, bsd::nv_trace_get(bsd::nv_trace_op::unpack).count);
+}
+
+TEST_CASE(nv_trace_disabled)
+{
+	auto nvl = bsd::nv_list();
+	nvl.add_number("key", 42);
+
+	bsd::nv_trace_reset();
+	ATF_REQUIRE_EQ(false, bsd::nv_trace_enabled());
+	(void)nvl.pack();
+	ATF_REQUIRE_EQ(0, bsd::nv_trace_get(bsd::nv_trace_op::pack).count);
+}
+
+TEST_CASE(nv_trace_hooks)
+{
+	auto events = std::vector<bsd::nv_trace_event>();
+	auto hooks = bsd::nv_trace_hooks{
+		.begin = [&] (auto const &ev) { events.push_back(ev); },
+		.end = [&] (auto const &ev) { events.push_back(ev); },
+	};
+
+	auto nvl = bsd::nv_list();
+	nvl.add_number("key", 42);
+
+	int fds[2];
+	auto ret = ::socketpair(AF_UNIX, SOCK_STREAM, 0, &fds[0]);
+	ATF_REQUIRE_EQ(0, ret);
+
+	bsd::nv_fd fd0(fds[0]);
+	bsd::nv_fd fd1(fds[1]);
+
+	bsd::nv_trace_set_hooks(&hooks);
+	nvl.send(fd0.get());
+	auto nvl2 = bsd::nv_list::recv(fd1.get());
+	bsd::nv_trace_set_hooks(nullptr);
+
+	ATF_REQUIRE_EQ(4, events.size());
+
+	ATF_REQUIRE(bsd::nv_trace_op::send == events[0].op);
+	ATF_REQUIRE_EQ(fd0.get(), events[0].fd);
+	ATF_REQUIRE_EQ(nvl.packed_size(), events[0].size);
+	ATF_REQUIRE(bsd::nv_trace_op::send == events[1].op);
+	ATF_REQUIRE_EQ(0, events[1].error);
+
+	// the size of a received nvlist is only known at the end.
+	ATF_REQUIRE(bsd::nv_trace_op::recv == events[2].op);
+	ATF_REQUIRE_EQ(fd1.get(), events[2].fd);
+	ATF_REQUIRE_EQ(0, events[2].size);
+	ATF_REQUIRE(bsd::nv_trace_op::recv == events[3].op);
+	ATF_REQUIRE_EQ(nvl2.packed_size(), events[3].size);
+
+	// once the hooks are removed, they are not called.
+	nvl.send(fd0.get());
+	ATF_REQUIRE_EQ(4, events.size());
+}
+
+TEST_CASE(nv_trace_hooks_error)
+{
+	auto errors = std::vector<int>();
+	auto hooks = bsd::nv_trace_hooks();
+	hooks.end = [&] (auto const &ev) { errors.push_back(ev.error); };
+
+	auto data = std::vector<std::byte>(16, std::byte{0xff});
+
+	bsd::nv_trace_set_hooks(&hooks);
+	ATF_REQUIRE_THROW(std::system_error,
+			  (void)bsd::nv_list::unpack(data));
+	bsd::nv_trace_set_hooks(nullptr);
+
+	ATF_REQUIRE_EQ(1, errors.size());
+	ATF_REQUIRE(errors[0] != 0);
+}
+
+ATF_INIT_TEST_CASES(tcs)
+{
+	ATF_ADD_TEST_CASE(tcs, nv_trace_histogram);
+	ATF_ADD_TEST_CASE(tcs, nv_trace_disabled);
+	ATF_ADD_TEST_CASE(tcs, nv_trace_hooks);
+	ATF_ADD_TEST_CASE(tcs, nv_trace_hooks_error);
+}
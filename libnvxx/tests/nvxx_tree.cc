@@ -0,0 +1,174 @@
+/*
+ * SPDX-License-Identifier: Unlicense OR MIT
+ * Refer to the file 'LICENSE' in the nvxx distribution for license terms.
+ */
+
+#include <algorithm>
+#include <vector>
+
+#include <atf-c++.hpp>
+
+#include "nvxx.h"
+
+#define TEST_CASE(name)				\
+	ATF_TEST_CASE_WITHOUT_HEAD(name)	\
+	ATF_TEST_CASE_BODY(name)
+
+using namespace std::literals;
+
+namespace {
+
+/*
+ * Build { "a": { "b": { "leaf": 1 }, "blob": <binary> }, "other": { } }
+ */
+bsd::nv_list
+make_nested()
+{
+	auto b = bsd::nv_list();
+	b.add_number("leaf", 1);
+
+	auto a = bsd::nv_list();
+	a.add_nvlist("b", b);
+	a.add_binary("blob", std::vector<std::byte>(4096, std::byte{0x5a}));
+
+	auto nvl = bsd::nv_list();
+	nvl.add_nvlist("a", a);
+	nvl.add_nvlist("other", bsd::nv_list());
+	return (nvl);
+}
+
+} // anonymous namespace
+
+TEST_CASE(nv_tree_import)
+{
+	auto tree = bsd::nv_tree(make_nested());
+	ATF_REQUIRE_EQ(2, tree.size());
+
+	auto a = tree.get_nvlist("a");
+	ATF_REQUIRE_EQ(1, a.get_nvlist("b").get_number("leaf"));
+	ATF_REQUIRE_EQ(4096, a.get_binary("blob").size());
+	ATF_REQUIRE_EQ(true, tree.get_nvlist("other").empty());
+	ATF_REQUIRE_THROW(bsd::nv_key_not_found, (void)tree.get_number("a"));
+}
+
+TEST_CASE(nv_tree_set_path)
+{
+	auto tree = bsd::nv_tree(make_nested());
+	auto updated = tree.set_number({"a", "b", "leaf"}, 2);
+
+	ATF_REQUIRE_EQ(1, tree.get_nvlist("a").get_nvlist("b")
+			      .get_number("leaf"));
+	ATF_REQUIRE_EQ(2, updated.get_nvlist("a").get_nvlist("b")
+			      .get_number("leaf"));
+
+	// nodes off the path are shared
+	ATF_REQUIRE_EQ(true, tree.get_nvlist("other")
+			      .same(updated.get_nvlist("other")));
+	ATF_REQUIRE_EQ(false, tree.get_nvlist("a")
+			      .same(updated.get_nvlist("a")));
+
+	// binary payloads are shared
+	ATF_REQUIRE_EQ(tree.get_nvlist("a").get_binary("blob").data(),
+		       updated.get_nvlist("a").get_binary("blob").data());
+}
+
+TEST_CASE(nv_tree_set_add)
+{
+	auto tree = bsd::nv_tree()
+		.set_string("string", "hello")
+		.set_bool("bool", true)
+		.set_nvlist("child", bsd::nv_tree())
+		.set_number({"child", "value"}, 42);
+
+	ATF_REQUIRE_EQ(3, tree.size());
+	ATF_REQUIRE_EQ("hello"sv, tree.get_string("string"));
+	ATF_REQUIRE_EQ(true, tree.get_bool("bool"));
+	ATF_REQUIRE_EQ(42, tree.get_nvlist("child").get_number("value"));
+
+	// replacing a value may change its type
+	auto replaced = tree.set_number("string", 1);
+	ATF_REQUIRE_EQ(3, replaced.size());
+	ATF_REQUIRE_EQ(1, replaced.get_number("string"));
+
+	ATF_REQUIRE_THROW(bsd::nv_key_not_found,
+			  (void)tree.set_number({"missing", "value"}, 1));
+	ATF_REQUIRE_THROW(bsd::nv_key_not_found,
+			  (void)tree.set_number({"string", "value"}, 1));
+}
+
+TEST_CASE(nv_tree_erase)
+{
+	auto tree = bsd::nv_tree(make_nested());
+	auto erased = tree.erase({"a", "b"});
+
+	ATF_REQUIRE_EQ(true, tree.get_nvlist("a").exists("b"));
+	ATF_REQUIRE_EQ(false, erased.get_nvlist("a").exists("b"));
+	ATF_REQUIRE_EQ(true, erased.get_nvlist("a").exists_type("blob", NV_TYPE_BINARY));
+
+	ATF_REQUIRE_THROW(bsd::nv_key_not_found, (void)tree.erase("missing"));
+}
+
+TEST_CASE(nv_tree_arrays)
+{
+	auto numbers = std::vector<std::uint64_t>{1, 2, 3};
+	auto strings = std::vector{"x"sv, "y"sv};
+	auto elems = std::vector{
+		bsd::nv_tree().set_number("index", 0),
+		bsd::nv_tree().set_number("index", 1),
+	};
+
+	auto tree = bsd::nv_tree()
+		.set_number_array("numbers", numbers)
+		.set_string_array("strings", strings)
+		.set_nvlist_array("elems", elems);
+
+	ATF_REQUIRE_EQ(true, std::ranges::equal(numbers,
+			tree.get_number_array("numbers")));
+	ATF_REQUIRE_EQ(true, std::ranges::equal(strings,
+			tree.get_string_array("strings")));
+
+	auto array = tree.get_nvlist_array("elems");
+	ATF_REQUIRE_EQ(2, array.size());
+	ATF_REQUIRE_EQ(1, array[1].get_number("index"));
+	ATF_REQUIRE_EQ(true, array[0].same(elems[0]));
+}
+
+TEST_CASE(nv_tree_pack)
+{
+	auto tree = bsd::nv_tree(make_nested()).set_number({"a", "b", "leaf"}, 3);
+
+	auto nvl = bsd::nv_list::unpack(tree.pack());
+	ATF_REQUIRE_EQ(3, nvl.get_nvlist("a").get_nvlist("b")
+			     .get_number("leaf"));
+	ATF_REQUIRE_EQ(4096, nvl.get_nvlist("a").get_binary("blob").size());
+
+	auto copy = tree.materialize();
+	ATF_REQUIRE_EQ(true, copy.exists_nvlist("other"));
+	ATF_REQUIRE_EQ(true, copy == nvl);
+}
+
+TEST_CASE(nv_tree_moved_from)
+{
+	auto tree = bsd::nv_tree(make_nested());
+	auto size = tree.size();
+
+	auto other = std::move(tree);
+	ATF_REQUIRE_EQ(size, tree.size());
+	ATF_REQUIRE_EQ(0, tree.flags());
+	ATF_REQUIRE_EQ(true, tree.same(other));
+
+	other = bsd::nv_tree();
+	tree = std::move(other);
+	ATF_REQUIRE_EQ(true, other.empty());
+}
+
+ATF_INIT_TEST_CASES(tcs)
+{
+	ATF_ADD_TEST_CASE(tcs, nv_tree_import);
+	ATF_ADD_TEST_CASE(tcs, nv_tree_set_path);
+	ATF_ADD_TEST_CASE(tcs, nv_tree_set_add);
+	ATF_ADD_TEST_CASE(tcs, nv_tree_erase);
+	ATF_ADD_TEST_CASE(tcs, nv_tree_arrays);
+	ATF_ADD_TEST_CASE(tcs, nv_tree_pack);
+	ATF_ADD_TEST_CASE(tcs, nv_tree_moved_from);
+}